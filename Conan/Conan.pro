@@ -9,6 +9,7 @@ VERSION = 1.0.2
 DEFINES += CONAN_DLL \
     CONAN_DLL_EXPORTS
 linux-g++: QMAKE_CXXFLAGS += -fvisibility=hidden -fvisibility-inlines-hidden
+unix:!macx: LIBS += -lrt
 DESTDIR = lib
 MOC_DIR = src
 RCC_DIR = src
@@ -21,7 +22,27 @@ SOURCES += src/ObjectUtility.cpp \
     src/ConanWidget.cpp \
     src/AboutDialog.cpp \
     src/ConanDebug.cpp \
-    src/KeyValueTableModel.cpp
+    src/KeyValueTableModel.cpp \
+    src/ConnectionGraph.cpp \
+    src/MethodTable.cpp \
+    src/MetaObjectCache.cpp \
+    src/DuplicateConnectionModel.cpp \
+    src/ObjectSearchIndex.cpp \
+    src/Clock.cpp \
+    src/SignalCapture.cpp \
+    src/SignalLogSink.cpp \
+    src/SignalLogFormat.cpp \
+    src/EmissionRate.cpp \
+    src/SignalTracer.cpp \
+    src/DurationHistogram.cpp \
+    src/SlotProfiler.cpp \
+    src/TraceRecorder.cpp \
+    src/SignalSampler.cpp \
+    src/SignalCondition.cpp \
+    src/ArgumentFormatter.cpp \
+    src/SignalEventStore.cpp \
+    src/SignalEventModel.cpp \
+    src/QueuedLatencyMonitor.cpp
 HEADERS += src/ConanDefines.h \
     src/ObjectUtility.h \
     src/SignalSpy.h \
@@ -33,6 +54,26 @@ HEADERS += src/ConanDefines.h \
     src/ObjectModel.h \
     src/ConanDebug.h \
     src/KeyValueTableModel.h \
+    src/ConnectionGraph.h \
+    src/MethodTable.h \
+    src/MetaObjectCache.h \
+    src/DuplicateConnectionModel.h \
+    src/ObjectSearchIndex.h \
+    src/Clock.h \
+    src/SignalCapture.h \
+    src/SignalLogSink.h \
+    src/SignalLogFormat.h \
+    src/EmissionRate.h \
+    src/SignalTracer.h \
+    src/DurationHistogram.h \
+    src/SlotProfiler.h \
+    src/TraceRecorder.h \
+    src/SignalSampler.h \
+    src/SignalCondition.h \
+    src/ArgumentFormatter.h \
+    src/SignalEventStore.h \
+    src/SignalEventModel.h \
+    src/QueuedLatencyMonitor.h \
     include/Conan.h
 FORMS += src/ConanWidget.ui \
     src/AboutDialog.ui
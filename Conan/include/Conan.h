@@ -26,6 +26,7 @@
 
 #include "../src/ConanWidget.h"
 #include "../src/AboutDialog.h"
+#include "../src/ArgumentFormatter.h"
 
 
 
@@ -66,7 +67,7 @@
     \section sec_usage Usage
     \code
     #include <Conan.h>          // checks for proper qt version and includes
-                                // the ConanWidget and AboutDialog
+                                // the ConanWidget, AboutDialog and ArgumentFormatter
 
     //Q_INIT_RESOURCE (Conan);  // necessary on some platforms when Conan
                                 // is build as a static library
@@ -85,7 +86,12 @@
     \li Back (Alt + Left) - Selects the previous object of the selection history in the \a Object \a Hierarchy tree view.
     \li Forward (Alt + Right) - Selects the next object of the selection history in the \a Object \a Hierarchy tree view.
     \li Find object (Ctrl + F) - Text field used to specify a search criteria that can be any part of an object's class
-        name, object name, or address. Press Enter/Return to perform the actual search.
+        name, object name, or address. The first matching object is selected while typing, and the number of matching
+        objects is displayed next to the find button. Press Enter/Return to select the next match. The search criteria
+        consists of one or more terms that must all match. A term can be limited to a single field by prefixing it with
+        \a class:, \a name:, \a address: or \a thread:, and it must match the complete field when it contains the
+        wildcards * or ?, e.g: \a class:QPushButton \a name:ok* \a thread:main. The thread of an object is matched by
+        the object name of its thread; the gui thread is called 'main' unless it has been named.
     \li Find Next (F3) - Finds and selects the next object that matches the current search criteria.
     \li Refresh objects (F5) - Refreshes the complete \a Object \a Hierarchy tree view.
     \li Discover objects - Discovers all top-level widgets and adds them to the \a Object \a Hierarchy tree view.
@@ -145,7 +151,9 @@
     The \a Object \a Hierarchy tree view displayes the complete object hierarchy of one or more root objects. For each
     object, it displays the class name, object name, and object address. Note that this view is static in that it
     presents a snapshot in time of these hierarchies. The \a Refresh button from the toolbar can be used to synchronize
-    the view with the current situation.
+    the view with the current situation. Refreshing only adds and removes the rows of objects that have been created or
+    destroyed, expanded and selected objects remain so. Alternatively, the \a Auto \a refresh \a objects option from
+    the context menu keeps the view up to date while objects are created and destroyed in the gui thread.
 
     Root objects can be added manually through \a ConanWidget::AddRootObject or automatically by using the \a Discover
     \a objects toolbar button. The \a Object \a Hierarchy tree view will make sure that each root object belongs to an
@@ -158,7 +166,16 @@
     \li Remove root object - Removes the current selected root object.
     \li Remove all root objects - Removes all root object.
     \li Refresh objects - Refreshes the complete \a Object \a Hierarchy tree view.
+    \li Auto refresh objects - Keeps the \a Object \a Hierarchy tree view up to date while objects are created and
+        destroyed.
     \li Discover objects - Discovers all top-level widgets and adds them to the \a Object \a Hierarchy tree view.
+    \li Spy all signals of object - Creates a signal spy for each signal of the current object.
+    \li Spy all signals of class - Creates a signal spy for each signal of every object in the \a Object \a Hierarchy
+        tree view whose class is the class of the current object.
+    \li Spy all signals of hierarchy - Creates a signal spy for each signal of the current object and all its
+        descendants.
+    \li Trace signals of hierarchy only - Limits signal tracing to the current object and all its descendants, see
+        \ref sec_log_options.
     \li Find duplicate connections - Scans the entire \a Object \a Hierarchy tree view for the next occurance of a
         duplicate connection.
     \li Export to XML - Exports the selected \a QObject hierarchy, inlcuding signal, slots and all active connection
@@ -202,6 +219,7 @@
     \li Object - The object to which the connected signal/slot belongs; class name and object name.
     \li Address - The address of the object to which the connected signal/slot belongs.
     \li Connection - The type of connection (direct, queued, blocking, auto); see Qt::ConnectionType.
+    \li Latency - The median and 99th percentile delivery latency of a queued connection, see below.
 
     Note that only connections between methods marked in code as signal or slot and processed by MOC are displayed.
     The conan::SignalSpy and QSignalSpy are examples of classes that have not been processed by MOC. They create
@@ -211,6 +229,13 @@
     \li Hide inactive methods - Hides all signals and slots that have no connections.
     \li Hide inherited methods - Hides all signals and slots that have been inherited.
 
+    The \a Measure \a queued \a latency option measures, for every connection that is queued, the time between the
+    emission of the signal and the moment the receiving thread starts to deliver the resulting QMetaCallEvent to the
+    slot. Emissions are recorded from the signal spy callback of Qt and matched in order with the deliveries, which are
+    observed through the event notify callback of Qt. The latency is aggregated per connection, shown in the \a Latency
+    column, and per receiving thread, shown next to the option. Deliveries for which no emission was recorded are
+    counted as unmatched. Note that, like the other views, the connection lists of the sender are read without locking.
+    \n\n
     A context menu with the following options is provided for both the \a Signals and the \a Slots view:
     \li Disconnect all - Disconnects all receivers from the selected signal, or all senders from the selected slot.
     \li Disconnect - Disconnects the selected connection.
@@ -225,29 +250,173 @@
     \image html SignalSpies.jpg "The Conan signal spy table"
     \n
     The \a Signal \a spies \a table lists all existing signal spies. A signal spy monitors all emissions of a single
-    signal. Each time it detects a signal emission, infomration about that signal emission is logged. For each signal
+    signal. All signal spies share a single conan::SignalSpy object, which connects each spied signal to an entry in a
+    compact table, so thousands of signals can be spied at once. Each time it detects a signal emission, infomration about that signal emission is logged. For each signal
     spy the following information is provided:
     \li Signature - The normalized signature of the signal; see QMetaObject::normalizedSignature.
     \li Object - The object to which the signal belongs; class name and object name.
     \li Address - The address of the object to which the signal belongs.
     \li Declared in - The QObject subclass that declares the signal.
+    \li Sampling - The sampling policy of the signal spy, see \ref sec_log_options.
+    \li Condition - The condition of the logged emissions of the signal spy, see below.
+    \li Emissions - The number of times the signal was emitted.
+    \li Rate 1s, 10s and 60s - The average number of logged emissions per second over the last 1, 10 and 60 seconds.
+    \li Peak rate - The highest number of logged emissions within a single second.
+    \li Interval p50 and p99 - The median and 99th percentile of the time between consecutive logged emissions, in ms.
+    \li Sampled out and Rate limited - The number of emissions dropped by the sampling policy of the signal spy.
+    \li Matches - The number of emissions that matched the condition of the signal spy.
+
+    The statistics are updated four times per second. When \a Top is checked, only the 20 signals with the highest
+    emission rate are listed, the busiest first; this quickly reveals emission storms that keep the gui thread busy.
 
     Existing signal spies can be removed through use of the context menu:
     \li Select all (Ctrl + A) - Selects all available signal spies.
+    \li Sampling... - Sets the sampling policy of all selected signal spies.
+    \li Trigger burst - Starts a burst of all selected signal spies whose sampling policy has a burst rule.
+    \li Condition... - Sets the condition of all selected signal spies.
     \li Delete (Del) - Deletes all selected signal spies.
 
+    A signal spy with a condition only logs the emissions whose arguments match the condition, and can trigger actions
+    when an emission matches, f.e: arg0>1000 arg1~^error do:snapshot
+    \li arg[n][operator][value] - Compares argument n with the value, using ==, !=, <, <=, >, >= or ~. Numeric
+    arguments are compared as numbers, QString and QByteArray arguments as text; ~ matches a regular expression.
+    \li do:start and do:stop - Resumes or pauses logging of all signal spies and of the tracer.
+    \li do:burst - Starts a burst of the global sampling policy.
+    \li do:snapshot - Exports all object hierarchies to conan_snapshot_[time].xml in the current directory.
+    \li do:dump - Writes the logs kept in memory to conan_log_[time].log in the current directory.
+    \n
+    Conditions are evaluated on the raw arguments of each emission, before any argument is converted, so rare events
+    can be caught in long running applications without logging anything else. Combined with \a Pause \a logging and
+    the \a Memory output, a condition can stop logging and dump the logs that led up to an event.
+
     <hr/><br/>
 
     \section sec_log_options Log options
     \image html LogOptions.jpg "The Conan signal spy log options"
     \n
-    The \a log \a options define what information is logged by each signal spy and how each log is formatted. Currently
-    all logging is performed through use of the \a qDebug function call. Two example logs are provided in the
-    conan::ConanWidget that reflect the current options.
+    The \a log \a options define what information is logged by each signal spy and how each log is formatted. Two
+    example logs are provided in the conan::ConanWidget that reflect the current options.
+    \n\n
+    The \a Format option overrides all other options with a template, in which each field is written as {name} or
+    {name:width}. Valid names are timestamp, object, address, signature, emitcount and arguments. A width pads or
+    truncates the field to a fixed number of characters, f.e: {timestamp} {object:30} #{emitcount:4} {arguments}
+    \n\n
+    Each signal emission is timestamped with a monotonic clock in nanoseconds. The \a Timestamp option shows the
+    timestamp in one of three formats:
+    \li Absolute - The wall clock time with microsecond resolution, f.e: 2011-03-31 01:53:37.123456
+    \li Relative - The seconds since the session started, with nanosecond resolution, f.e: 12.000250000
+    \li Delta - The seconds since the previous emission of the same signal, f.e: +0.000250000
+    \n
+    The wall clock time at which the session started is written once to each output, so that relative and delta
+    timestamps can be correlated with other logs.
+    \n\n
+    The \a Output option selects where logs are written to, see conan::ConanWidget::SetSignalLogOutput:
+    \li qDebug - Each log is written using the \a qDebug function call; this is the default.
+    \li Text file - Logs are appended to a text file in blocks. When the file exceeds 16 MB it is renamed to
+    [file].1 and a new file is started; at most 4 old files are kept.
+    \li Memory - The most recent 100000 logs are kept in memory, see conan::ConanWidget::GetSignalLogMessages.
+    \li Binary trace file - Each emission is written to a compact binary file. Object names, signatures and short
+    argument lists are stored once in a string table, and timestamps are stored as the difference with the previous
+    emission. The format is documented by the conan::BinaryTraceLogSink class.
     \n\n
     When the \a Arguments option is enabled, each argument used during a signal emission is converted to a string. If
     this is not possible, the type name of the argument's type is used instead. In case no type name is associated \a
     void is used. Type names can be registered using qRegisterMetaType.
+    \n\n
+    Arguments of the built-in number types, QChar, QString, QByteArray, QPoint, QPointF, QSize, QRect and QRectF are
+    formatted directly, without a QVariant conversion. A formatter for any other registered type can be added with
+    conan::ArgumentFormatter::Register, f.e. to show the values of custom types that QVariant can not convert:
+    \code
+    void FormatColor (int inType, const void* inArg, QString& outText) {
+        outText.append (static_cast <const MyColor*> (inArg)->Name ());
+    }
+    conan::ArgumentFormatter::Register (qRegisterMetaType <MyColor> ("MyColor"), FormatColor);
+    \endcode
+    \n\n
+    By default each signal emission is formatted and logged while the signal is being emitted, which delays the
+    emitting code. When \a Capture \a mode is enabled, a signal emission only copies its arguments and a timestamp into
+    a fixed size buffer. The buffer is formatted and logged every 100 ms. Emissions that do not fit in the buffer are
+    dropped. The average and maximum time spent within each spied signal emission, and the number of dropped
+    emissions, are shown next to the option.
+    \n\n
+    Signal spies can monitor signals that are emitted by any thread. Emissions from threads other than the gui thread
+    are always captured, regardless of the \a Capture \a mode option. Each thread captures into its own buffer without
+    locking, and the buffers of all threads are logged in timestamp order.
+    \n\n
+    When \a Trace \a all \a signals is enabled, the emissions of all signals of all objects in the application are
+    logged, without creating signal spies. Conan registers a callback with Qt that is called at the start of every
+    signal emission. The trace filter limits tracing to the emissions that match all of its fields, f.e:
+    class:QAbstractButton signal:*ed thread:main
+    \li class:name - The sender is an instance of the named class or of one of its subclasses.
+    \li signal:pattern - The name of the signal matches the wildcard pattern.
+    \li thread:name - The signal is emitted by the thread with the given object name, or by the gui thread for main.
+    \n
+    Fields can be repeated to accept alternatives. The filter is decided once per thread and per signal of each class,
+    before any arguments are copied, so filtered emissions stay cheap. Traced emissions are always captured and logged
+    every 100 ms. The number of traced and filtered emissions, and the average time tracing added to each, are shown
+    next to the filter.
+    \n\n
+    The \a Sampling option limits the logged emissions of all signal spies and of the tracer, each signal spy can have
+    a sampling policy of its own as well. A sampling policy consists of the following rules, f.e: every:10 rate:100
+    \li every:n - Only every n-th emission is logged.
+    \li rate:k - At most k emissions are logged per second.
+    \li burst:m - Only the first m emissions after each trigger are logged; \a Trigger \a burst starts a burst.
+    \n
+    Sampling is decided before any arguments are converted or copied, so dropped emissions stay cheap. Dropped
+    emissions are still counted in the \a Emissions column. The number of emissions dropped by the global policy is
+    shown next to the option. \a Pause \a logging stops logging of all signal spies and of the tracer, signal spy
+    conditions can pause and resume logging as well.
+    \n\n
+    The \a Signal \a log view lists the most recent emissions of all signal spies and of the tracer, regardless of
+    the selected output. It keeps up to 2 million emissions and 16 million argument characters in memory, after
+    which the oldest are discarded. The view only shows the emissions that match all of its filter fields: the
+    signal signature, the object name or address and the thread name match when they contain the text or match a
+    wildcard pattern, and the time is given as a range of seconds since the session start, f.e: 1.5-3. Filters are
+    matched once per signal spy and once per thread, so filtering stays fast while emissions are logged. \a Pause
+    \a view stops showing new emissions, without pausing logging. While the view is scrolled to the bottom, the
+    newest emission stays visible. Arguments are only shown when the \a Arguments option is enabled.
 
     \image html Output.jpg "Conan signal spy output"
+
+    <hr/><br/>
+
+    \section sec_duplicates Duplicate connections
+    The \a Duplicate \a connections tab lists every duplicate connection found in all object hierarchies of the
+    \a Object \a Hierarchy tree view. Press \a Scan \a all \a duplicates to scan all objects in a single pass; a
+    progress dialog allows the scan to be canceled, after which the duplicates found so far are listed. For each
+    duplicate connection the following information is provided:
+    \li Sender - The object that emits the signal; class name and object name.
+    \li Signal - The normalized signature of the signal.
+    \li Receiver - The object to which the connected signal/slot belongs; class name and object name.
+    \li Method - The normalized signature of the connected signal/slot.
+    \li Type - The type of connection (direct, queued, blocking, auto); see Qt::ConnectionType.
+    \li Count - The number of identical connections.
+
+    The table can be sorted by any column. Double click a duplicate connection to select its sender in the \a Object
+    \a Hierarchy tree view and expand the corresponding signal.
+
+    <hr/><br/>
+
+    \section sec_slot_profiler Slot profiler
+    The \a Slot \a profiler tab measures the execution time of every slot in the application that is invoked by a
+    direct connection, while \a Profile \a slots is checked. Slots invoked by queued connections are not measured.
+    Each invocation is attributed to the signal whose emission invoked it. By default each row lists a single slot;
+    when \a Group \a by \a signal is checked, each signal and slot pair is listed in a row of its own. For each row
+    the following information is provided:
+    \li Slot - The normalized signature of the slot.
+    \li Receiver - The class of the object to which the slot belongs.
+    \li Signal - The class of the sender and the signal that invoked the slot, only when grouped by signal.
+    \li Calls - The number of invocations.
+    \li Wall total, p50 and p99 - The total, median and 99th percentile of the wall clock time spent within the slot.
+    \li CPU total, p50 and p99 - The total, median and 99th percentile of the CPU time the invoking thread spent
+        within the slot.
+
+    Times include nested signal emissions and slots. The table is updated every second and can be sorted by any
+    column. \a Clear discards all measurements, and \a Export writes the table to a CSV file.
+    \n\n
+    \a Record \a trace records all signal emissions and all slots invoked by a direct connection to a file in the
+    Chrome Trace Event Format, which can be opened by chrome://tracing and Perfetto (https://ui.perfetto.dev). Each
+    emission and each slot is a slice on the timeline of the thread that executed it; slots are nested within the
+    emission that invoked them, and emissions caused by a slot are nested within that slot. Events are written to the
+    file every 100 ms, so long recordings are not kept in memory. Press the button again to stop recording.
 */
@@ -0,0 +1,296 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains ArgumentFormatter related definitions
+*/
+
+
+#include "ArgumentFormatter.h"
+#include "SignalLogFormat.h"
+#include <QtCore/QByteArray>
+#include <QtCore/QMetaType>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QPoint>
+#include <QtCore/QPointF>
+#include <QtCore/QRect>
+#include <QtCore/QRectF>
+#include <QtCore/QSize>
+#include <QtCore/QVariant>
+#include <float.h>
+
+
+namespace conan {
+
+    namespace /*unnamed*/ {
+
+        /*!
+            \brief Appends the given signed value.
+        */
+        void AppendSigned (qint64 inValue, QString& outText) {
+            if (inValue < 0) {
+                outText.append (QLatin1Char ('-'));
+                // avoid overflowing the most negative value
+                SignalLogFormat::AppendNumber (static_cast <quint64> (-(inValue + 1)) + 1, 1, outText);
+            }
+            else {
+                SignalLogFormat::AppendNumber (static_cast <quint64> (inValue), 1, outText);
+            }
+        }
+
+        /*!
+            \brief Appends the given floating point value with the given number of significant digits, like QString::number does.
+        */
+        void AppendReal (double inValue, int inPrecision, QString& outText) {
+            char digits [40];
+            qsnprintf (digits, sizeof (digits), "%.*g", inPrecision, inValue);
+            // the C library formats according to the locale of the application
+            for (char* digit = digits; *digit; ++digit) {
+                if (*digit == ',') {
+                    *digit = '.';
+                }
+            }
+            outText.append (QLatin1String (digits));
+        }
+
+        /*!
+            \brief Appends the given latin1 bytes without allocating a temporary string.
+        */
+        void AppendLatin1 (const char* inBytes, int inSize, QString& outText) {
+            int size = outText.size ();
+            outText.resize (size + inSize);
+            QChar* text = outText.data () + size;
+            for (int b=0; b<inSize; ++b) {
+                text [b] = QLatin1Char (inBytes [b]);
+            }
+        }
+
+        template <class T>
+        void FormatSigned (int, const void* inArg, QString& outText) {
+            AppendSigned (*static_cast <const T*> (inArg), outText);
+        }
+
+        template <class T>
+        void FormatUnsigned (int, const void* inArg, QString& outText) {
+            SignalLogFormat::AppendNumber (*static_cast <const T*> (inArg), 1, outText);
+        }
+
+        template <class T>
+        void FormatCharacter (int, const void* inArg, QString& outText) {
+            outText.append (QLatin1Char (*static_cast <const T*> (inArg)));
+        }
+
+        void FormatBool (int, const void* inArg, QString& outText) {
+            outText.append (QLatin1String (*static_cast <const bool*> (inArg) ? "true" : "false"));
+        }
+
+        void FormatDouble (int, const void* inArg, QString& outText) {
+            AppendReal (*static_cast <const double*> (inArg), DBL_DIG, outText);
+        }
+
+        void FormatFloat (int, const void* inArg, QString& outText) {
+            AppendReal (*static_cast <const float*> (inArg), FLT_DIG, outText);
+        }
+
+        void FormatChar (int, const void* inArg, QString& outText) {
+            outText.append (*static_cast <const QChar*> (inArg));
+        }
+
+        void FormatString (int, const void* inArg, QString& outText) {
+            outText.append (*static_cast <const QString*> (inArg));
+        }
+
+        void FormatByteArray (int, const void* inArg, QString& outText) {
+            const QByteArray& bytes = *static_cast <const QByteArray*> (inArg);
+            AppendLatin1 (bytes.constData (), bytes.size (), outText);
+        }
+
+        void FormatPoint (int, const void* inArg, QString& outText) {
+            const QPoint& point = *static_cast <const QPoint*> (inArg);
+            outText.append (QLatin1String ("QPoint("));
+            AppendSigned (point.x (), outText);
+            outText.append (QLatin1String (", "));
+            AppendSigned (point.y (), outText);
+            outText.append (QLatin1Char (')'));
+        }
+
+        void FormatPointF (int, const void* inArg, QString& outText) {
+            const QPointF& point = *static_cast <const QPointF*> (inArg);
+            outText.append (QLatin1String ("QPointF("));
+            AppendReal (point.x (), DBL_DIG, outText);
+            outText.append (QLatin1String (", "));
+            AppendReal (point.y (), DBL_DIG, outText);
+            outText.append (QLatin1Char (')'));
+        }
+
+        void FormatSize (int, const void* inArg, QString& outText) {
+            const QSize& size = *static_cast <const QSize*> (inArg);
+            outText.append (QLatin1String ("QSize("));
+            AppendSigned (size.width (), outText);
+            outText.append (QLatin1String (", "));
+            AppendSigned (size.height (), outText);
+            outText.append (QLatin1Char (')'));
+        }
+
+        void FormatRect (int, const void* inArg, QString& outText) {
+            const QRect& rect = *static_cast <const QRect*> (inArg);
+            outText.append (QLatin1String ("QRect("));
+            AppendSigned (rect.x (), outText);
+            outText.append (QLatin1Char (','));
+            AppendSigned (rect.y (), outText);
+            outText.append (QLatin1Char (' '));
+            AppendSigned (rect.width (), outText);
+            outText.append (QLatin1Char ('x'));
+            AppendSigned (rect.height (), outText);
+            outText.append (QLatin1Char (')'));
+        }
+
+        void FormatRectF (int, const void* inArg, QString& outText) {
+            const QRectF& rect = *static_cast <const QRectF*> (inArg);
+            outText.append (QLatin1String ("QRectF("));
+            AppendReal (rect.x (), DBL_DIG, outText);
+            outText.append (QLatin1Char (','));
+            AppendReal (rect.y (), DBL_DIG, outText);
+            outText.append (QLatin1Char (' '));
+            AppendReal (rect.width (), DBL_DIG, outText);
+            outText.append (QLatin1Char ('x'));
+            AppendReal (rect.height (), DBL_DIG, outText);
+            outText.append (QLatin1Char (')'));
+        }
+
+        /*!
+            \brief Formats any other type through QVariant, or by its type name when it can not be converted to a string.
+        */
+        void FormatVariant (int inType, const void* inArg, QString& outText) {
+            QVariant variant (inType, inArg);
+            if (variant.canConvert (QVariant::String)) {
+                outText.append (variant.toString ());
+            }
+            else {
+                outText.append (QLatin1String (QMetaType::typeName (inType)));
+            }
+        }
+
+        /*!
+            \brief Returns the built-in formatter of the given type.
+        */
+        ArgumentFormatter::Function BuiltInFormatter (int inType) {
+            switch (inType) {
+                case QMetaType::Bool:
+                    return FormatBool;
+                case QMetaType::Int:
+                    return FormatSigned <int>;
+                case QMetaType::UInt:
+                    return FormatUnsigned <uint>;
+                case QMetaType::LongLong:
+                    return FormatSigned <qlonglong>;
+                case QMetaType::ULongLong:
+                    return FormatUnsigned <qulonglong>;
+                case QMetaType::Double:
+                    return FormatDouble;
+                case QMetaType::Long:
+                    return FormatSigned <long>;
+                case QMetaType::Short:
+                    return FormatSigned <short>;
+                case QMetaType::Char:
+                    return FormatCharacter <char>;
+                case QMetaType::ULong:
+                    return FormatUnsigned <ulong>;
+                case QMetaType::UShort:
+                    return FormatUnsigned <ushort>;
+                case QMetaType::UChar:
+                    return FormatCharacter <uchar>;
+                case QMetaType::Float:
+                    return FormatFloat;
+                case QMetaType::QChar:
+                    return FormatChar;
+                case QMetaType::QString:
+                    return FormatString;
+                case QMetaType::QByteArray:
+                    return FormatByteArray;
+                case QMetaType::QPoint:
+                    return FormatPoint;
+                case QMetaType::QPointF:
+                    return FormatPointF;
+                case QMetaType::QSize:
+                    return FormatSize;
+                case QMetaType::QRect:
+                    return FormatRect;
+                case QMetaType::QRectF:
+                    return FormatRectF;
+                default:
+                    return FormatVariant;
+            }
+        }
+
+    } // unnamed namespace
+
+
+    // initialized at load time, function local statics are not thread safe with msvc
+    ArgumentFormatter ArgumentFormatter::sInstance;
+
+    ArgumentFormatter::ArgumentFormatter () :
+        mGeneration (0)
+    {}
+
+    /*!
+        \brief Registers the formatter of the given type, which replaces a previously registered or built-in formatter.
+    */
+    void ArgumentFormatter::Register (int inType, Function inFunction) {
+        if (!inFunction) {
+            Unregister (inType);
+            return;
+        }
+        ArgumentFormatter& registry = sInstance;
+        QMutexLocker locker (&registry.mMutex);
+        registry.mFunctions.insert (inType, inFunction);
+        registry.mGeneration.ref ();
+    }
+
+    /*!
+        \brief Removes the registered formatter of the given type, the built-in formatter is used again.
+    */
+    void ArgumentFormatter::Unregister (int inType) {
+        ArgumentFormatter& registry = sInstance;
+        QMutexLocker locker (&registry.mMutex);
+        if (registry.mFunctions.remove (inType)) {
+            registry.mGeneration.ref ();
+        }
+    }
+
+    /*!
+        \brief Returns the formatter of the given type: the registered formatter, or the built-in formatter, never 0.
+    */
+    ArgumentFormatter::Function ArgumentFormatter::Find (int inType) {
+        ArgumentFormatter& registry = sInstance;
+        QMutexLocker locker (&registry.mMutex);
+        return registry.mFunctions.value (inType, BuiltInFormatter (inType));
+    }
+
+    /*!
+        \brief Returns a number that changes each time a formatter is registered or unregistered.
+    */
+    int ArgumentFormatter::Generation () {
+        return sInstance.mGeneration;
+    }
+
+} // namespace conan
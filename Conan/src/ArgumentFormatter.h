@@ -0,0 +1,86 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains ArgumentFormatter related declarations
+*/
+
+
+#ifndef _ARGUMENTFORMATTER__17_10_26__23_18_45__H_
+#define _ARGUMENTFORMATTER__17_10_26__23_18_45__H_
+
+
+#include "ConanDefines.h"
+#include <QtCore/QAtomicInt>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+
+
+namespace conan {
+
+    /*!
+        \brief Formats the arguments of signal emissions for the signal spy log, keyed by QMetaType type.
+
+        The built-in scalar types, QChar, QString, QByteArray, QPoint, QPointF, QSize, QRect and
+        QRectF are formatted directly from the argument, without creating a QVariant or a
+        temporary string, so formatting does not allocate once the log buffer has grown. All
+        other types are converted through QVariant, or shown by their type name when they can
+        not be converted to a string.
+
+        Applications can register a formatter for their own value types, or replace the
+        formatter of a built-in type, f.e:
+        \code
+        void FormatColor (int inType, const void* inArg, QString& outText) {
+            outText.append (static_cast <const MyColor*> (inArg)->Name ());
+        }
+        conan::ArgumentFormatter::Register (qRegisterMetaType <MyColor> ("MyColor"), FormatColor);
+        \endcode
+
+        The signal logger looks up the formatters of each signal once, and again after a
+        formatter has been registered or unregistered. Formatters may be registered by any
+        thread, they are called by the thread of the signal logger.
+    */
+    class CONAN_API ArgumentFormatter {
+    public:
+        //! \brief Appends the text of the argument of the given QMetaType type, to which inArg points, to outText
+        typedef void (*Function) (int inType, const void* inArg, QString& outText);
+
+        static void Register (int inType, Function inFunction);
+        static void Unregister (int inType);
+        static Function Find (int inType);
+        static int Generation ();
+
+    private:
+        ArgumentFormatter ();
+
+        static ArgumentFormatter sInstance;     //!< The single registry, initialized at load time
+
+        QMutex mMutex;                          //!< Protects mFunctions
+        QHash <int, Function> mFunctions;       //!< map <type, registered formatter>
+        QAtomicInt mGeneration;                 //!< Incremented each time mFunctions changes
+    };
+
+} // namespace conan
+
+
+#endif //_ARGUMENTFORMATTER__17_10_26__23_18_45__H_
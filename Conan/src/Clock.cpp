@@ -0,0 +1,132 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains Clock related definitions
+*/
+
+
+#include "Clock.h"
+
+#if defined Q_OS_WIN
+#include <windows.h>
+#elif defined Q_OS_MAC
+#include <mach/mach.h>
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+
+namespace conan {
+
+    namespace /*unnamed*/ {
+
+        const qint64 kNanosecondsPerSecond = Q_INT64_C (1000000000);
+
+#if defined Q_OS_WIN
+        /*!
+            \brief Returns the number of performance counter ticks per second.
+        */
+        qint64 CounterFrequency () {
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency (&frequency);
+            return frequency.QuadPart;
+        }
+
+        // initialized at load time, function local statics are not thread safe with msvc
+        const qint64 sCounterFrequency = CounterFrequency ();
+#elif defined Q_OS_MAC
+        /*!
+            \brief Returns the conversion factor from mach absolute time units to nanoseconds.
+        */
+        mach_timebase_info_data_t Timebase () {
+            mach_timebase_info_data_t timebase;
+            mach_timebase_info (&timebase);
+            return timebase;
+        }
+
+        const mach_timebase_info_data_t sTimebase = Timebase ();
+#endif
+
+    } // unnamed namespace
+
+
+    /*!
+        \brief Returns the current time of the monotonic clock in nanoseconds.
+
+        The epoch of the clock is unspecified, only differences between two values are meaningful.
+    */
+    qint64 Clock::Now () {
+#if defined Q_OS_WIN
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter (&counter);
+        // split the conversion, counter * 10^9 overflows within minutes for high frequency counters
+        return (counter.QuadPart / sCounterFrequency) * kNanosecondsPerSecond +
+               (counter.QuadPart % sCounterFrequency) * kNanosecondsPerSecond / sCounterFrequency;
+#elif defined Q_OS_MAC
+        quint64 ticks = mach_absolute_time ();
+        if (sTimebase.numer == sTimebase.denom) {
+            return static_cast <qint64> (ticks);
+        }
+        return static_cast <qint64> ((ticks / sTimebase.denom) * sTimebase.numer +
+                                     (ticks % sTimebase.denom) * sTimebase.numer / sTimebase.denom);
+#else
+        timespec now;
+        clock_gettime (CLOCK_MONOTONIC, &now);
+        return static_cast <qint64> (now.tv_sec) * kNanosecondsPerSecond + now.tv_nsec;
+#endif
+    }
+
+    /*!
+        \brief Returns the CPU time consumed by the current thread in nanoseconds, both in user and in kernel mode.
+
+        Only differences between two values of the same thread are meaningful.
+    */
+    qint64 Clock::ThreadCpuNow () {
+#if defined Q_OS_WIN
+        FILETIME creation, exit, kernel, user;
+        if (!GetThreadTimes (GetCurrentThread (), &creation, &exit, &kernel, &user)) {
+            return 0;
+        }
+        // FILETIME counts 100 ns units
+        quint64 kernelTime = (static_cast <quint64> (kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+        quint64 userTime = (static_cast <quint64> (user.dwHighDateTime) << 32) | user.dwLowDateTime;
+        return static_cast <qint64> (kernelTime + userTime) * 100;
+#elif defined Q_OS_MAC
+        mach_port_t thread = mach_thread_self ();
+        thread_basic_info_data_t info;
+        mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+        kern_return_t result = thread_info (thread, THREAD_BASIC_INFO, reinterpret_cast <thread_info_t> (&info), &count);
+        mach_port_deallocate (mach_task_self (), thread);
+        if (result != KERN_SUCCESS) {
+            return 0;
+        }
+        return (static_cast <qint64> (info.user_time.seconds) + info.system_time.seconds) * kNanosecondsPerSecond +
+               (static_cast <qint64> (info.user_time.microseconds) + info.system_time.microseconds) * 1000;
+#else
+        timespec now;
+        clock_gettime (CLOCK_THREAD_CPUTIME_ID, &now);
+        return static_cast <qint64> (now.tv_sec) * kNanosecondsPerSecond + now.tv_nsec;
+#endif
+    }
+
+} // namespace conan
@@ -0,0 +1,55 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains Clock related declarations
+*/
+
+
+#ifndef _CLOCK__17_10_26__09_12_41__H_
+#define _CLOCK__17_10_26__09_12_41__H_
+
+
+#include "ConanDefines.h"
+
+
+namespace conan {
+
+    /*!
+        \brief A monotonic clock with nanosecond units.
+
+        QElapsedTimer is only available since Qt 4.7, and QTime and QDateTime follow the wall
+        clock with millisecond resolution at best. Clock reads the monotonic clock of the
+        platform directly, which is cheap enough to be read for every signal emission.
+
+        The CPU time of the current thread is read from the platform as well, its resolution
+        depends on the platform: 100 ns units on Windows and microseconds on Mac OS X.
+    */
+    class CONAN_LOCAL Clock {
+    public:
+        static qint64 Now ();
+        static qint64 ThreadCpuNow ();
+    };
+
+} // namespace conan
+
+
+#endif //_CLOCK__17_10_26__09_12_41__H_
@@ -25,8 +25,10 @@
 
 #include "ConanDebug.h"
 #include "ConnectionModel.h"
-#include "ObjectUtility.h"
+#include "QueuedLatencyMonitor.h"
+#include <QtCore/QCoreApplication>
 #include <QtCore/QObject>
+#include <QtCore/QTimer>
 #include <QtCore/QtDebug>
 
 
@@ -51,19 +53,48 @@ namespace conan {
         if (!gEnabled)
             return;
 
-        qDebug ()   << ObjectUtility::QualifiedName (inData.mMethod.mClass, inData.mMethod.mName)
-                    << inData.mMethod.mAddress
-                    << inData.mMethod.mSignature;
+        qDebug ()   << inData.mMethod.QualifiedName ()
+                    << inData.mMethod.Address ()
+                    << inData.mMethod.Signature ();
 
-        QString prefix = inData.mMethod.mMethodType == QMetaMethod::Signal ? "-->" : "<--";
+        QString prefix = inData.mMethod.MethodType () == QMetaMethod::Signal ? "-->" : "<--";
 
         foreach (const MethodData& method, inData.mConnections)
         {
             qDebug ()   << prefix
-                        << ObjectUtility::QualifiedName (method.mClass, method.mName)
-                        << method.mAddress
-                        << method.mSignature;
+                        << method.QualifiedName ()
+                        << method.Address ()
+                        << method.Signature ();
         }
     }
 
+    /*!
+        \brief Returns true when a queued emission and its delivery produce a latency in the given monitor.
+
+        The monitor must be enabled and the signal spy callbacks must be registered. A queued
+        connection is made between two temporary objects of the current thread, the signal is
+        emitted and the posted event is delivered immediately.
+        \param[in,out] ioMonitor The monitor, which is flushed
+    */
+    bool debug::CheckQueuedLatency (QueuedLatencyMonitor& ioMonitor) {
+        if (!ioMonitor.IsEnabled ()) {
+            return false;
+        }
+        QObject sender;
+        QTimer receiver;
+        if (!QObject::connect (&sender, SIGNAL (destroyed ()), &receiver, SLOT (stop ()), Qt::QueuedConnection)) {
+            return false;
+        }
+        // emits destroyed (), unlike destroyed (QObject*) it does not purge the connections of the sender
+        QMetaObject::invokeMethod (&sender, "destroyed", Qt::DirectConnection);
+        QCoreApplication::sendPostedEvents (&receiver, QEvent::MetaCall);
+        QObject::disconnect (&sender, 0, &receiver, 0);
+        ioMonitor.Flush ();
+
+        QueuedLatency latency;
+        int signal = sender.metaObject ()->indexOfSignal ("destroyed()");
+        int slot = receiver.metaObject ()->indexOfSlot ("stop()");
+        return ioMonitor.Latency (&sender, signal, &receiver, slot, latency) && latency.mLatencies.Count () == 1;
+    }
+
 } // namespace conan
@@ -34,12 +34,14 @@ class QObject;
 namespace conan {
 
     struct ConnectionData;
+    class QueuedLatencyMonitor;
 
     //! Contains helper functions for debugging Conan
     namespace debug {
         extern bool gEnabled;
         void Dump (QObject* inObject);
         void Dump (const ConnectionData& inData);
+        bool CheckQueuedLatency (QueuedLatencyMonitor& ioMonitor);
     } // namespace debug
 
 } // namespace conan
@@ -28,17 +28,36 @@
 #include "ConanDebug.h"
 #include "ConanWidget.h"
 #include "ConanWidget_p.h"
+#include "ConnectionGraph.h"
 #include "ConnectionModel.h"
+#include "DuplicateConnectionModel.h"
 #include "KeyValueTableModel.h"
+#include "MethodTable.h"
 #include "ObjectModel.h"
+#include "ObjectSearchIndex.h"
 #include "ObjectUtility.h"
+#include "QueuedLatencyMonitor.h"
+#include "SignalEventModel.h"
+#include "SignalEventStore.h"
+#include "SignalLogSink.h"
 #include "SignalSpy.h"
+#include "SignalTracer.h"
+#include "SlotProfiler.h"
+#include "TraceRecorder.h"
 #include "WaitCursor.h"
 #include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSet>
+#include <QtCore/QTextStream>
+#include <QtCore/QTimer>
 #include <QtGui/QFileDialog>
 #include <QtGui/QHeaderView>
+#include <QtGui/QInputDialog>
 #include <QtGui/QMenu>
 #include <QtGui/QMessageBox>
+#include <QtGui/QProgressDialog>
+#include <QtGui/QScrollBar>
 #include <QtGui/QStringListModel>
 #include <QtGui/QUndoStack>
 #include <QtXml/QXmlStreamWriter>
@@ -50,31 +69,41 @@ namespace conan {
     namespace /*unnamed*/ {
 
         /*!
-            \brief A command that finds an object by address, selects it and makes it current.
+            \brief A command that finds an object, selects it and makes it current.
 
+            The object is looked up in the object index of the model, so the item of a destroyed object
+            is still found by its former address.
             Note that during the first redo nothing is done, because this command is generated after an actual current index change.
         */
         class CONAN_LOCAL SelectObjectCommand : public QUndoCommand {
         public:
-            SelectObjectCommand (QItemSelectionModel* inSelectionModel, const QString& inOldAddress, const QString& inNewAddress) :
+            SelectObjectCommand (QItemSelectionModel* inSelectionModel, const QModelIndex& inOldIndex, const QModelIndex& inNewIndex) :
                 QUndoCommand ("select object"),
                 mSelectionModel (inSelectionModel),
-                mOldAddress (inOldAddress),
-                mNewAddress (inNewAddress),
+                mOldKey (0),
+                mNewKey (0),
                 mSkipFirstSelect (true)
-            {}
+            {
+                if (const ObjectModel* model = dynamic_cast <const ObjectModel*> (inSelectionModel->model ())) {
+                    mOldObject = const_cast <QObject*> (model->GetObject (inOldIndex));
+                    mOldKey = model->GetKey (inOldIndex);
+                    mNewObject = const_cast <QObject*> (model->GetObject (inNewIndex));
+                    mNewKey = model->GetKey (inNewIndex);
+                }
+            }
 
             virtual void undo () {
                 if (mSelectionModel && !mSkipFirstSelect) {
-                    if (const ObjectModel* model = dynamic_cast <const ObjectModel*> (mSelectionModel->model ())) {
-                        QModelIndex objectIndex = model->FindObject (MatchObjectByValue (mNewAddress));
+                    if (ObjectModel* model = dynamic_cast <ObjectModel*> (mSelectionModel->model ())) {
+                        QModelIndex objectIndex = model->GetIndex (mNewObject, mNewKey);
                         mSelectionModel->setCurrentIndex (objectIndex, QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
                     }
                 }
                 else {
                     mSkipFirstSelect = false;
                 }
-                qSwap (mOldAddress, mNewAddress);
+                qSwap (mOldObject, mNewObject);
+                qSwap (mOldKey, mNewKey);
             }
             virtual void redo () {
                 undo ();
@@ -82,8 +111,10 @@ namespace conan {
 
         private:
             QItemSelectionModel* mSelectionModel;   //! The selection model of an ObjectModel
-            QString mOldAddress;                    //! The address of the old current object
-            QString mNewAddress;                    //! The address of the new current object
+            QPointer <QObject> mOldObject;          //! The old current object
+            QPointer <QObject> mNewObject;          //! The new current object
+            const void* mOldKey;                    //! The address of the old current object
+            const void* mNewKey;                    //! The address of the new current object
             bool mSkipFirstSelect;                  //! Used to skip the first redo
         };
 
@@ -147,6 +178,53 @@ namespace conan {
                 outData [classInfo.name ()] = classInfo.value ();
             }
         }
+
+        /*!
+            \brief The signal begin callback of Qt, forwards each emission to the signal tracer, the trace recorder, the slot
+            profiler and the queued latency monitor.
+        */
+        void SignalBeginCallback (QObject* inSender, int inMethodIndex, void** inArgs) {
+            SignalTracer::SignalBegin (inSender, inMethodIndex, inArgs);
+            TraceRecorder::SignalBegin (inSender, inMethodIndex, inArgs);
+            SlotProfiler::SignalBegin (inSender, inMethodIndex, inArgs);
+            if (QueuedLatencyMonitor::IsActive ()) {
+                priv::RecordQueuedEmission (inSender, inMethodIndex);
+            }
+        }
+
+        /*!
+            \brief The signal end callback of Qt, forwards each emission to the slot profiler and the trace recorder.
+        */
+        void SignalEndCallback (QObject* inSender, int inMethodIndex) {
+            SlotProfiler::SignalEnd (inSender, inMethodIndex);
+            TraceRecorder::SignalEnd (inSender, inMethodIndex);
+        }
+
+        /*!
+            \brief The slot begin callback of Qt, forwards each invocation to the trace recorder and the slot profiler.
+        */
+        void SlotBeginCallback (QObject* inReceiver, int inMethodIndex, void** inArgs) {
+            TraceRecorder::SlotBegin (inReceiver, inMethodIndex, inArgs);
+            SlotProfiler::SlotBegin (inReceiver, inMethodIndex, inArgs);
+        }
+
+        /*!
+            \brief The slot end callback of Qt, forwards each invocation to the slot profiler and the trace recorder.
+        */
+        void SlotEndCallback (QObject* inReceiver, int inMethodIndex) {
+            SlotProfiler::SlotEnd (inReceiver, inMethodIndex);
+            TraceRecorder::SlotEnd (inReceiver, inMethodIndex);
+        }
+
+        /*!
+            \brief The event notify callback of Qt, forwards each queued slot invocation to the queued latency monitor.
+
+            Always returns false, so Qt delivers the event as usual.
+        */
+        bool EventNotifyCallback (void** inData) {
+            priv::RecordQueuedDelivery (reinterpret_cast <QObject*> (inData [0]), reinterpret_cast <QEvent*> (inData [1]));
+            return false;
+        }
     }
 
 
@@ -155,15 +233,24 @@ namespace conan {
 
     /*!
         \brief A unary function object that returns true when an ObjectItem has duplicate connections.
+
+        All visited objects share the same connection snapshot, so the connection lists of each
+        sender are walked only once during a search.
     */
     struct CONAN_LOCAL ContainsDuplicateConnections
     {
+        ContainsDuplicateConnections (ConnectionGraph* inGraph, MethodTable* inTable) :
+            mGraph (inGraph),
+            mTable (inTable)
+        {}
+
         bool operator () (const ObjectItem* inItem) {
             if (inItem) {
                 if (QObject* object = const_cast <QObject*> (inItem->Object ())) {
+                    priv::AddObjectToConnectionGraph (object, *mGraph);
                     // check signals
                     QVector <ConnectionData> signalData;
-                    priv::BuildSignalData (object, signalData);
+                    priv::BuildSignalData (object, *mGraph, *mTable, signalData);
                     foreach (const ConnectionData& signal, signalData) {
                         if (signal.ContainsDuplicateConnections ()) {
                             return true;
@@ -171,7 +258,7 @@ namespace conan {
                     }
                     // check slots
                     QVector <ConnectionData> slotData;
-                    priv::BuildSlotData (object, slotData);
+                    priv::BuildSlotData (object, *mGraph, *mTable, slotData);
                     foreach (const ConnectionData& slot, slotData) {
                         if (slot.ContainsDuplicateConnections ()) {
                             return true;
@@ -181,6 +268,35 @@ namespace conan {
             }
             return false;
         }
+
+        ConnectionGraph* mGraph;    //!< The connection snapshot shared by all visited objects
+        MethodTable* mTable;        //!< The object and method records shared by all visited objects
+    };
+
+
+    // --------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief A unary function object that collects the objects of all visited ObjectItems.
+
+        It never matches, so ObjectModel::FindObject visits every object exactly once, including
+        the objects of hierarchies that have not been expanded; no items are created for them.
+    */
+    struct CONAN_LOCAL CollectObjects
+    {
+        CollectObjects (QVector <QPointer <QObject> >* outObjects) :
+            mObjects (outObjects)
+        {}
+
+        bool operator () (const ObjectItem* inItem) {
+            if (inItem && inItem->Object ()) {
+                mObjects->push_back (const_cast <QObject*> (inItem->Object ()));
+            }
+            return false;
+        }
+
+        QVector <QPointer <QObject> >* mObjects;   //!< Receives the objects
     };
 
 
@@ -200,7 +316,21 @@ namespace conan {
         mInheritanceModel (0),
         mClassInfoModel (0),
         mSignalSpyModel (0),
+        mProxySignalSpyModel (0),
+        mSignalLogOutput (kDebugOutput),
+        mMemoryLogSink (0),
+        mSignalTracer (0),
+        mSignalEventStore (0),
+        mSignalEventModel (0),
+        mDuplicateModel (0),
+        mProxyDuplicateModel (0),
+        mSlotProfileModel (0),
+        mProxySlotProfileModel (0),
+        mTraceRecorder (0),
         mUndoStack (0),
+        mSearchTimer (0),
+        mQueuedLatencyMonitor (0),
+        mLatencyTimer (0),
         mBlockSelectionCommand (false)
     {
         mForm.setupUi (this);
@@ -210,10 +340,25 @@ namespace conan {
 
         InitObjectHierarchyTab ();
         InitSignalSpiesTab ();
+        InitDuplicatesTab ();
+        InitSlotProfilerTab ();
 
         SetHeaderResizeMode (QHeaderView::Interactive);
     }
 
+    /*!
+        \brief Stops tracing, profiling, recording and measuring, before the signal logger of the tracer is destroyed
+    */
+    ConanWidget::~ConanWidget () {
+        mSignalTracer->SetEnabled (false);
+        mSlotProfileModel->GetProfiler ().SetEnabled (false);
+        mTraceRecorder->Stop ();
+        mQueuedLatencyMonitor->SetEnabled (false);
+        UpdateSignalSpyCallbacks ();
+        delete mSignalTracer;
+        delete mQueuedLatencyMonitor;
+    }
+
     /*!
         \brief Initializes the \a Objects \a hierarchy tab
     */
@@ -223,6 +368,10 @@ namespace conan {
         mForm.objectTree->setModel (mObjectModel);
         mForm.objectTree->setSortingEnabled (true);
         mForm.objectTree->sortByColumn (ObjectModel::kObject, Qt::AscendingOrder);
+        // search while typing, but only after a short pause
+        mSearchTimer = new QTimer (this);
+        mSearchTimer->setSingleShot (true);
+        mSearchTimer->setInterval (150);
         // signal model and view
         mSignalModel = new ConnectionModel (this);
         mProxySignalModel = new ConnectionFilterProxyModel (this);
@@ -241,6 +390,14 @@ namespace conan {
         mForm.slotTree->setSortingEnabled (true);
         mForm.slotTree->sortByColumn (ConnectionModel::kAccess, Qt::AscendingOrder);
         mForm.slotTree->header ()->moveSection (ConnectionModel::kAccess, 0);
+        // queued connection latency, the column is shown once measured
+        mQueuedLatencyMonitor = new QueuedLatencyMonitor (this);
+        mSignalModel->SetLatencyMonitor (mQueuedLatencyMonitor);
+        mSlotModel->SetLatencyMonitor (mQueuedLatencyMonitor);
+        mForm.signalTree->setColumnHidden (ConnectionModel::kLatency, true);
+        mForm.slotTree->setColumnHidden (ConnectionModel::kLatency, true);
+        mLatencyTimer = new QTimer (this);
+        mLatencyTimer->setInterval (1000);
         // inheritance model and view
         mInheritanceModel = new QStringListModel (this);
         mForm.inheritanceList->setModel (mInheritanceModel);
@@ -286,21 +443,30 @@ namespace conan {
                  this, SLOT (SlotRequestConfirmation (const QString&, const QString&, bool&)));
         connect (mSlotModel, SIGNAL (SignalRequestConfirmation (const QString&, const QString&, bool&)),
                  this, SLOT (SlotRequestConfirmation (const QString&, const QString&, bool&)));
+        connect (mForm.measureLatencyCheckBox, SIGNAL (toggled (bool)), this, SLOT (SlotMeasureQueuedLatency (bool)));
+        connect (mLatencyTimer, SIGNAL (timeout ()), this, SLOT (SlotRefreshLatencies ()));
         connect (mUndoStack, SIGNAL (canUndoChanged (bool)), mForm.actionBack, SLOT (setEnabled (bool)));
         connect (mForm.actionBack, SIGNAL (triggered ()), mUndoStack, SLOT (undo ()));
         connect (mUndoStack, SIGNAL (canRedoChanged (bool)), mForm.actionForward, SLOT (setEnabled (bool)));
         connect (mForm.actionForward, SIGNAL (triggered ()), mUndoStack, SLOT (redo ()));
         connect (mForm.actionFind, SIGNAL (triggered ()), this, SLOT (SlotFindObject ()));
         connect (mForm.actionRefresh, SIGNAL (triggered ()), this, SLOT (SlotRefresh ()));
+        connect (mForm.actionAutoRefresh, SIGNAL (toggled (bool)), mObjectModel, SLOT (SlotSetAutoRefresh (bool)));
         connect (mForm.actionFocusFind, SIGNAL (triggered ()), mForm.findLineEdit, SLOT (setFocus ()));
         connect (mForm.actionFocusFind, SIGNAL (triggered ()), mForm.findLineEdit, SLOT (selectAll ()));
         connect (mForm.findLineEdit, SIGNAL (returnPressed ()), this, SLOT (SlotFindObject ()));
+        connect (mForm.findLineEdit, SIGNAL (textChanged (const QString&)), mSearchTimer, SLOT (start ()));
+        connect (mSearchTimer, SIGNAL (timeout ()), this, SLOT (SlotSearchObjects ()));
         connect (mForm.actionDiscover, SIGNAL (triggered ()), this, SLOT (SlotDiscoverObjects ()));
         connect (mForm.actionBug, SIGNAL (triggered ()), this, SLOT (SlotFindDuplicateConnection ()));
         connect (mForm.actionAboutConan, SIGNAL (triggered ()), this, SLOT (SlotAbout ()));
         connect (mForm.actionExport, SIGNAL (triggered ()), this, SLOT (SlotExportToXML ()));
         connect (mForm.actionRemoveRootObject, SIGNAL (triggered ()), this, SLOT (SlotRemoveRootObject ()));
         connect (mForm.actionRemoveAllRootObjects, SIGNAL (triggered ()), this, SLOT (SlotRemoveAllRootObjects ()));
+        connect (mForm.actionSpyObjectSignals, SIGNAL (triggered ()), this, SLOT (SlotSpyObjectSignals ()));
+        connect (mForm.actionSpyClassSignals, SIGNAL (triggered ()), this, SLOT (SlotSpyClassSignals ()));
+        connect (mForm.actionSpyHierarchySignals, SIGNAL (triggered ()), this, SLOT (SlotSpyHierarchySignals ()));
+        connect (mForm.actionTraceHierarchySignals, SIGNAL (toggled (bool)), this, SLOT (SlotTraceHierarchySignals (bool)));
         // add actions that have a shortcut
         addAction (mForm.actionBack);
         addAction (mForm.actionForward);
@@ -315,7 +481,7 @@ namespace conan {
     void ConanWidget::InitSignalSpiesTab () {
         // signal spy model and view
         mSignalSpyModel = new SignalSpyModel (this);
-        mProxySignalSpyModel = new QSortFilterProxyModel (this);
+        mProxySignalSpyModel = new SignalSpyFilterProxyModel (this);
         mProxySignalSpyModel->setDynamicSortFilter (true);
         mProxySignalSpyModel->setSourceModel (mSignalSpyModel);
         mForm.signalSpiesTableView->setModel (mProxySignalSpyModel);
@@ -324,10 +490,24 @@ namespace conan {
         mForm.signalSpiesTableView->verticalHeader ()->setResizeMode (QHeaderView::ResizeToContents);
         mForm.signalSpiesTableView->horizontalHeader ()->setHighlightSections (false);
         mForm.signalSpiesTableView->horizontalHeader ()->setMovable (true);
+        // signal tracer, logs to the same logger as the signal spies
+        mSignalTracer = new SignalTracer (&mSignalSpyModel->GetLogger (), this);
+        // log view, the store is kept when the log output changes
+        mSignalEventStore = new SignalEventStore ();
+        mSignalSpyModel->GetLogger ().AddSink (mSignalEventStore);
+        mSignalEventModel = new SignalEventModel (mSignalEventStore, this);
+        mForm.signalEventTableView->setModel (mSignalEventModel);
+        mForm.signalEventTableView->verticalHeader ()->hide ();
+        mForm.signalEventTableView->verticalHeader ()->setResizeMode (QHeaderView::Fixed);
+        mForm.signalEventTableView->verticalHeader ()->setDefaultSectionSize (mForm.signalEventTableView->fontMetrics ().height () + 4);
+        mForm.signalEventTableView->horizontalHeader ()->setHighlightSections (false);
+        mForm.signalEventTableView->horizontalHeader ()->setMovable (true);
+        mForm.signalEventTableView->horizontalHeader ()->setStretchLastSection (true);
         // connections
         connect (&mSignalSpyModel->GetLogger (), SIGNAL (SignalSpyLog (const QString&)),
                  this, SIGNAL (SignalSpyLog (const QString&)));
         connect (mForm.timestampCheckBox, SIGNAL (toggled (bool)), this, SLOT (SlotUpdateSignalLoggerOptions ()));
+        connect (mForm.timestampComboBox, SIGNAL (currentIndexChanged (int)), this, SLOT (SlotUpdateSignalLoggerOptions ()));
         connect (mForm.objectCheckBox, SIGNAL (toggled (bool)), this, SLOT (SlotUpdateSignalLoggerOptions ()));
         connect (mForm.addressCheckBox, SIGNAL (toggled (bool)), this, SLOT (SlotUpdateSignalLoggerOptions ()));
         connect (mForm.signatureCcheckBox, SIGNAL (toggled (bool)), this, SLOT (SlotUpdateSignalLoggerOptions ()));
@@ -335,10 +515,32 @@ namespace conan {
         connect (mForm.argumentsCheckBox, SIGNAL (toggled (bool)), this, SLOT (SlotUpdateSignalLoggerOptions ()));
         connect (mForm.prettyFormattingCheckBox, SIGNAL (toggled (bool)), this, SLOT (SlotUpdateSignalLoggerOptions ()));
         connect (mForm.separatorLineEdit, SIGNAL (textChanged (const QString&)), this, SLOT (SlotUpdateSignalLoggerOptions ()));
+        connect (mForm.formatLineEdit, SIGNAL (textChanged (const QString&)), this, SLOT (SlotUpdateSignalLoggerOptions ()));
+        connect (mForm.captureCheckBox, SIGNAL (toggled (bool)), this, SLOT (SlotUpdateSignalLoggerOptions ()));
+        connect (&mSignalSpyModel->GetLogger (), SIGNAL (SignalStatisticsChanged ()), this, SLOT (SlotUpdateSignalLoggerStatistics ()));
+        connect (mForm.logOutputComboBox, SIGNAL (activated (int)), this, SLOT (SlotSelectSignalLogOutput (int)));
+        connect (mForm.topSpiesCheckBox, SIGNAL (toggled (bool)), this, SLOT (SlotEnableTopSpies (bool)));
+        connect (mForm.traceCheckBox, SIGNAL (toggled (bool)), this, SLOT (SlotUpdateSignalTracer ()));
+        connect (mForm.traceFilterLineEdit, SIGNAL (editingFinished ()), this, SLOT (SlotUpdateSignalTracer ()));
+        connect (mSignalTracer, SIGNAL (SignalStatisticsChanged ()), this, SLOT (SlotUpdateSignalTracerStatistics ()));
+        connect (mForm.samplingLineEdit, SIGNAL (editingFinished ()), this, SLOT (SlotUpdateSamplingPolicy ()));
+        connect (mForm.triggerBurstToolButton, SIGNAL (clicked ()), this, SLOT (SlotTriggerBurst ()));
+        connect (mForm.pauseLoggingCheckBox, SIGNAL (toggled (bool)), this, SLOT (SlotPauseLogging (bool)));
+        connect (mSignalSpyModel, SIGNAL (SignalSpyTriggered (int, int)), this, SLOT (SlotSpyTriggered (int, int)));
+        connect (mForm.eventSignalFilterLineEdit, SIGNAL (editingFinished ()), this, SLOT (SlotUpdateSignalEventFilter ()));
+        connect (mForm.eventObjectFilterLineEdit, SIGNAL (editingFinished ()), this, SLOT (SlotUpdateSignalEventFilter ()));
+        connect (mForm.eventThreadFilterLineEdit, SIGNAL (editingFinished ()), this, SLOT (SlotUpdateSignalEventFilter ()));
+        connect (mForm.eventTimeFilterLineEdit, SIGNAL (editingFinished ()), this, SLOT (SlotUpdateSignalEventFilter ()));
+        connect (mForm.pauseEventsCheckBox, SIGNAL (toggled (bool)), this, SLOT (SlotPauseSignalEvents (bool)));
+        connect (mForm.clearEventsToolButton, SIGNAL (clicked ()), this, SLOT (SlotClearSignalEvents ()));
+        connect (mSignalEventModel, SIGNAL (SignalRowsChanged ()), this, SLOT (SlotSignalEventsChanged ()));
         connect (mForm.signalSpiesTableView, SIGNAL (customContextMenuRequested (const QPoint&)),
                  this, SLOT (SlotSpiesContextMenuRequested (const QPoint&)));
         connect (mForm.actionSelectAllSpies, SIGNAL (triggered ()), mForm.signalSpiesTableView, SLOT (selectAll ()));
         connect (mForm.actionDeleteSpies, SIGNAL (triggered ()), this, SLOT (SlotDeleteSpies ()));
+        connect (mForm.actionSetSpySampling, SIGNAL (triggered ()), this, SLOT (SlotSetSpySampling ()));
+        connect (mForm.actionTriggerSpyBurst, SIGNAL (triggered ()), this, SLOT (SlotTriggerSpyBurst ()));
+        connect (mForm.actionSetSpyCondition, SIGNAL (triggered ()), this, SLOT (SlotSetSpyCondition ()));
         // logger
         SlotUpdateSignalLoggerOptions ();
         // add actions that have a shortcut
@@ -346,6 +548,71 @@ namespace conan {
         mForm.signalSpiesTableView->addAction (mForm.actionDeleteSpies);
     }
 
+    /*!
+        \brief Initializes the \a Duplicate \a connections tab
+    */
+    void ConanWidget::InitDuplicatesTab () {
+        // duplicate connection model and view
+        mDuplicateModel = new DuplicateConnectionModel (this);
+        mProxyDuplicateModel = new QSortFilterProxyModel (this);
+        mProxyDuplicateModel->setSourceModel (mDuplicateModel);
+        mForm.duplicateTableView->setModel (mProxyDuplicateModel);
+        mForm.duplicateTableView->sortByColumn (DuplicateConnectionModel::kCount, Qt::DescendingOrder);
+        mForm.duplicateTableView->verticalHeader ()->hide ();
+        mForm.duplicateTableView->verticalHeader ()->setResizeMode (QHeaderView::ResizeToContents);
+        mForm.duplicateTableView->horizontalHeader ()->setHighlightSections (false);
+        mForm.duplicateTableView->horizontalHeader ()->setMovable (true);
+        mForm.scanDuplicatesToolButton->setDefaultAction (mForm.actionScanDuplicates);
+        // connections
+        connect (mForm.actionScanDuplicates, SIGNAL (triggered ()), this, SLOT (SlotScanDuplicateConnections ()));
+        connect (mForm.duplicateTableView, SIGNAL (doubleClicked (const QModelIndex&)),
+                 this, SLOT (SlotSelectDuplicateConnection (const QModelIndex&)));
+    }
+
+    /*!
+        \brief Initializes the \a Slot \a profiler tab
+    */
+    void ConanWidget::InitSlotProfilerTab () {
+        // slot profile model and view
+        mSlotProfileModel = new SlotProfileModel (this);
+        mProxySlotProfileModel = new QSortFilterProxyModel (this);
+        mProxySlotProfileModel->setDynamicSortFilter (true);
+        mProxySlotProfileModel->setSourceModel (mSlotProfileModel);
+        mForm.slotProfileTableView->setModel (mProxySlotProfileModel);
+        mForm.slotProfileTableView->sortByColumn (SlotProfileModel::kWallTotal, Qt::DescendingOrder);
+        mForm.slotProfileTableView->verticalHeader ()->hide ();
+        mForm.slotProfileTableView->verticalHeader ()->setResizeMode (QHeaderView::ResizeToContents);
+        mForm.slotProfileTableView->horizontalHeader ()->setHighlightSections (false);
+        mForm.slotProfileTableView->horizontalHeader ()->setMovable (true);
+        // connections
+        connect (mForm.profileSlotsCheckBox, SIGNAL (toggled (bool)), this, SLOT (SlotEnableSlotProfiler (bool)));
+        connect (mForm.groupBySignalCheckBox, SIGNAL (toggled (bool)), this, SLOT (SlotGroupSlotProfileBySignal (bool)));
+        connect (mForm.clearSlotProfileToolButton, SIGNAL (clicked ()), this, SLOT (SlotClearSlotProfile ()));
+        connect (mForm.exportSlotProfileToolButton, SIGNAL (clicked ()), this, SLOT (SlotExportSlotProfile ()));
+        // trace recorder
+        mTraceRecorder = new TraceRecorder (this);
+        connect (mForm.recordTraceToolButton, SIGNAL (toggled (bool)), this, SLOT (SlotRecordTrace (bool)));
+        connect (mTraceRecorder, SIGNAL (SignalEventsWritten ()), this, SLOT (SlotUpdateTraceRecorderStatus ()));
+    }
+
+    /*!
+        \brief Registers the callbacks of Qt that are needed by the signal tracer, the slot profiler, the trace recorder and
+        the queued latency monitor.
+
+        The callbacks are removed when they are all disabled, so Qt skips them entirely.
+    */
+    void ConanWidget::UpdateSignalSpyCallbacks () {
+        bool trace = mSignalTracer->IsEnabled ();
+        bool nested = mSlotProfileModel->GetProfiler ().IsEnabled () || mTraceRecorder->IsRecording ();
+        bool latency = mQueuedLatencyMonitor->IsEnabled ();
+        priv::SetSignalSpyCallbacks (
+            (trace || nested || latency) ? &SignalBeginCallback : 0,
+            nested ? &SignalEndCallback : 0,
+            nested ? &SlotBeginCallback : 0,
+            nested ? &SlotEndCallback : 0);
+        priv::SetEventNotifyCallback (latency ? &EventNotifyCallback : 0);
+    }
+
     /*!
         \brief Clears all views that show information about the current selected object.
     */
@@ -355,6 +622,15 @@ namespace conan {
         mClassInfoModel->SetClassInfo (QMap <QString, QString> ());
     }
 
+    /*!
+        \brief Reloads the signal, slot, inheritance and class info views of the current object.
+        The object tree keeps its current item during a refresh, so no current change is signaled.
+    */
+    void ConanWidget::ReloadCurrentObjectViews () {
+        QModelIndex current = mForm.objectTree->currentIndex ();
+        SlotCurrentObjectChanged (current, current);
+    }
+
     /*!
         \brief Shows the 'about' dialog
     */
@@ -378,8 +654,19 @@ namespace conan {
         mForm.actionRemoveAllRootObjects->setEnabled (mObjectModel->rowCount ());
         menu.addSeparator ();
         menu.addAction (mForm.actionRefresh);
+        menu.addAction (mForm.actionAutoRefresh);
         menu.addAction (mForm.actionDiscover);
         menu.addSeparator ();
+        menu.addAction (mForm.actionSpyObjectSignals);
+        menu.addAction (mForm.actionSpyClassSignals);
+        menu.addAction (mForm.actionSpyHierarchySignals);
+        bool hasObject = mObjectModel->GetObject (current);
+        mForm.actionSpyObjectSignals->setEnabled (hasObject);
+        mForm.actionSpyClassSignals->setEnabled (hasObject);
+        mForm.actionSpyHierarchySignals->setEnabled (hasObject);
+        menu.addAction (mForm.actionTraceHierarchySignals);
+        mForm.actionTraceHierarchySignals->setEnabled (hasObject || mForm.actionTraceHierarchySignals->isChecked ());
+        menu.addSeparator ();
         menu.addAction (mForm.actionBug);
         menu.addSeparator ();
         menu.addAction (mForm.actionExport);
@@ -389,6 +676,64 @@ namespace conan {
         menu.exec (pos);
     }
 
+    /*!
+        \brief Creates a signal spy for each signal of the current object.
+    */
+    void ConanWidget::SlotSpyObjectSignals () {
+        if (const QObject* object = mObjectModel->GetObject (mForm.objectTree->currentIndex ())) {
+            mSignalSpyModel->CreateSignalSpies (QList <const QObject*> () << object);
+        }
+    }
+
+    /*!
+        \brief Creates a signal spy for each signal of all objects in all object hierarchies
+        that have the same class as the current object.
+    */
+    void ConanWidget::SlotSpyClassSignals () {
+        const QObject* current = mObjectModel->GetObject (mForm.objectTree->currentIndex ());
+        if (!current) {
+            return;
+        }
+        WaitCursor wc;
+        QList <const QObject*> hierarchies;
+        for (int r=0; r<mObjectModel->rowCount (); ++r) {
+            ObjectUtility::CollectHierarchy (mObjectModel->GetObject (mObjectModel->index (r, 0)), hierarchies);
+        }
+        QList <const QObject*> instances;
+        foreach (const QObject* object, hierarchies) {
+            if (object->metaObject () == current->metaObject ()) {
+                instances.push_back (object);
+            }
+        }
+        mSignalSpyModel->CreateSignalSpies (instances);
+    }
+
+    /*!
+        \brief Creates a signal spy for each signal of the current object and all its descendants.
+    */
+    void ConanWidget::SlotSpyHierarchySignals () {
+        if (const QObject* object = mObjectModel->GetObject (mForm.objectTree->currentIndex ())) {
+            WaitCursor wc;
+            QList <const QObject*> objects;
+            ObjectUtility::CollectHierarchy (object, objects);
+            mSignalSpyModel->CreateSignalSpies (objects);
+        }
+    }
+
+    /*!
+        \brief Limits the signal tracer to the current object and all its descendants, or removes the limit.
+    */
+    void ConanWidget::SlotTraceHierarchySignals (bool inEnable) {
+        SignalTraceFilter filter = mSignalTracer->Filter ();
+        filter.mRoots.clear ();
+        if (inEnable) {
+            if (const QObject* object = mObjectModel->GetObject (mForm.objectTree->currentIndex ())) {
+                filter.mRoots.push_back (object);
+            }
+        }
+        mSignalTracer->SetFilter (filter);
+    }
+
     /*!
         \brief Asks for permission to remove the current selected root object.
     */
@@ -404,9 +749,8 @@ namespace conan {
                     "Are you sure you want to remove the following root object:\n\n" + conan::ObjectUtility::QualifiedName(object),
                     QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes))
             {
+                // the object tree selects another item, which reloads the views
                 mObjectModel->RemoveRootObject (object);
-                mSignalModel->SetData (QVector <ConnectionData> ());
-                ClearCurrentObjectViews ();
             }
         }
     }
@@ -454,7 +798,7 @@ namespace conan {
         QModelIndex objectIndex = mForm.objectTree->currentIndex ();
         QPointer <QObject> object = 0;
         if (methodData) {
-            object = methodData->mObject;
+            object = methodData->Object ();
         }
         else {
             object = const_cast <QObject*> (mObjectModel->GetObject (objectIndex));
@@ -524,8 +868,11 @@ namespace conan {
         if (object) {
             debug::Dump (object); // for debugging conan
 
-            priv::BuildSignalData (object, signalData);
-            priv::BuildSlotData (object, slotData);
+            ConnectionGraph graph;
+            MethodTable table;
+            priv::AddObjectToConnectionGraph (object, graph);
+            priv::BuildSignalData (object, graph, table, signalData);
+            priv::BuildSlotData (object, graph, table, slotData);
 
             BuildInheritanceData (object, inheritanceData);
             BuildClassInfoData (object, classInfoData);
@@ -542,11 +889,9 @@ namespace conan {
         if (!mBlockSelectionCommand) {
             // create a command to undo the current object change
             // but only when this change was not triggered by a command
-            QString previousAddress = mObjectModel->GetAddress (inPrevious);
-            QString currentAddress = mObjectModel->GetAddress (inCurrent);
             mUndoStack->beginMacro ("select");
             mUndoStack->push (new ToggleCommand (mBlockSelectionCommand));
-            mUndoStack->push (new SelectObjectCommand (mForm.objectTree->selectionModel (), previousAddress, currentAddress));
+            mUndoStack->push (new SelectObjectCommand (mForm.objectTree->selectionModel (), inPrevious, inCurrent));
             mUndoStack->push (new ToggleCommand (mBlockSelectionCommand));
             mUndoStack->endMacro ();
         }
@@ -576,7 +921,7 @@ namespace conan {
 
     /*!
         \brief Adds the object hierarchy defined by the given object to the object tree.
-        Note that the object hierarchy may be merged with an existing hierarchy, see RootItem::AddChild for details.
+        Note that the object hierarchy may be merged with an existing hierarchy, see ObjectModel::AddRootObject for details.
     */
     void ConanWidget::AddRootObject (const QObject* inObject) {
         if (mObjectModel) {
@@ -607,13 +952,9 @@ namespace conan {
         Note that currently only hierarchies starting with a QWidget are found.
     */
     void ConanWidget::DiscoverObjects () {
-        QString address = mObjectModel->GetAddress (mForm.objectTree->currentIndex ());
-
-        mObjectModel->DiscoverRootObjects ();
-        ClearCurrentObjectViews ();
-
         bool oldBlock = BlockSelectionCommand (true);
-        FindAndSelectObject (MatchObjectByValue (address));
+        mObjectModel->DiscoverRootObjects ();
+        ReloadCurrentObjectViews ();
         BlockSelectionCommand (oldBlock);
     }
 
@@ -626,29 +967,116 @@ namespace conan {
         mForm.signalTree->header ()->setResizeMode (mode);
         mForm.slotTree->header ()->setResizeMode (mode);
         mForm.signalSpiesTableView->horizontalHeader ()->setResizeMode (mode);
+        mForm.duplicateTableView->horizontalHeader ()->setResizeMode (mode);
+        mForm.slotProfileTableView->horizontalHeader ()->setResizeMode (mode);
 
         if (mode == QHeaderView::Interactive) {
             mForm.objectTree->header ()->resizeSections (QHeaderView::ResizeToContents);
             mForm.signalTree->header ()->resizeSections (QHeaderView::ResizeToContents);
             mForm.slotTree->header ()->resizeSections (QHeaderView::ResizeToContents);
             mForm.signalSpiesTableView->horizontalHeader ()->resizeSections (QHeaderView::ResizeToContents);
+            mForm.duplicateTableView->horizontalHeader ()->resizeSections (QHeaderView::ResizeToContents);
+            mForm.slotProfileTableView->horizontalHeader ()->resizeSections (QHeaderView::ResizeToContents);
+        }
+    }
+
+    /*!
+        \brief Selects the destination of all signal spy logs, returns false when the given file could not be opened.
+
+        Text files are appended to, binary trace files are overwritten. Logs are written in blocks,
+        at most every 100 ms. The previous destination is flushed and closed.
+    */
+    bool ConanWidget::SetSignalLogOutput (SignalLogOutput inOutput, const QString& inFileName) {
+        QScopedPointer <SignalLogSink> sink;
+        MemoryLogSink* memorySink = 0;
+        switch (inOutput) {
+            case kDebugOutput:
+                sink.reset (new DebugLogSink ());
+                break;
+            case kTextFileOutput: {
+                TextFileLogSink* fileSink = new TextFileLogSink (inFileName);
+                sink.reset (fileSink);
+                if (!fileSink->Open ()) {
+                    qWarning ("ConanWidget: Unable to open '%s': %s", qPrintable (inFileName), qPrintable (fileSink->ErrorString ()));
+                    return false;
+                }
+                break;
+            }
+            case kMemoryOutput:
+                memorySink = new MemoryLogSink ();
+                sink.reset (memorySink);
+                break;
+            case kBinaryTraceOutput: {
+                BinaryTraceLogSink* traceSink = new BinaryTraceLogSink (inFileName);
+                sink.reset (traceSink);
+                if (!traceSink->Open ()) {
+                    qWarning ("ConanWidget: Unable to open '%s': %s", qPrintable (inFileName), qPrintable (traceSink->ErrorString ()));
+                    return false;
+                }
+                break;
+            }
+            default:
+                return false;
+        }
+
+        SignalLogger& logger = mSignalSpyModel->GetLogger ();
+        logger.Flush ();
+        foreach (SignalLogSink* oldSink, logger.Sinks ()) {
+            if (oldSink != mSignalEventStore) {
+                logger.RemoveSink (oldSink);
+            }
+        }
+        logger.AddSink (sink.take ());
+        mMemoryLogSink = memorySink;
+        mSignalLogOutput = inOutput;
+        mForm.logOutputComboBox->setCurrentIndex (inOutput);
+        return true;
+    }
+
+    /*!
+        \brief Returns the destination of all signal spy logs.
+    */
+    ConanWidget::SignalLogOutput ConanWidget::GetSignalLogOutput () const {
+        return mSignalLogOutput;
+    }
+
+    /*!
+        \brief Returns the most recent signal spy logs, when logs are written to memory; see SetSignalLogOutput.
+    */
+    QStringList ConanWidget::GetSignalLogMessages () const {
+        if (mMemoryLogSink) {
+            mSignalSpyModel->GetLogger ().Flush ();
+            return mMemoryLogSink->Messages ();
+        }
+        return QStringList ();
+    }
+
+    /*!
+        \brief Writes the signal spy logs kept in memory to a UTF-8 text file, returns false when the file can not be opened.
+    */
+    bool ConanWidget::DumpSignalLog (const QString& inFileName) const {
+        QFile file (inFileName);
+        if (!file.open (QIODevice::WriteOnly | QIODevice::Text)) {
+            return false;
+        }
+        QTextStream stream (&file);
+        stream.setCodec ("UTF-8");
+        foreach (const QString& message, GetSignalLogMessages ()) {
+            stream << message << '\n';
         }
+        return true;
     }
 
     /*!
         \brief The complete object hierarchy is refreshed.
-        Resets all views, but keeps the current object selected.
+        The current object stays selected, its views are reloaded.
     */
     void ConanWidget::SlotRefresh () {
         WaitCursor wc;
 
-        QString address = mObjectModel->GetAddress (mForm.objectTree->currentIndex ());
-
-        mObjectModel->SlotRefresh ();
-        ClearCurrentObjectViews ();
-
         bool oldBlock = BlockSelectionCommand (true);
-        FindAndSelectObject (MatchObjectByValue (address));
+        mObjectModel->SlotRefresh ();
+        ReloadCurrentObjectViews ();
         BlockSelectionCommand (oldBlock);
     }
 
@@ -658,12 +1086,57 @@ namespace conan {
     void ConanWidget::SlotFindObject () {
         WaitCursor wc;
         QString text = mForm.findLineEdit->text ();
-        if (!FindAndSelectObject (MatchObjectByValue (text))) {
+        if (text.trimmed ().isEmpty ()) {
+            return;
+        }
+        // the match that was selected while typing is skipped, unless the search is still pending
+        if (!SearchAndSelectObject (!mSearchTimer->isActive ())) {
             wc.Disable ();
             QMessageBox::information (this, "No object found", "The following text could not be matched with an object:\n\n" + text);
         }
     }
 
+    /*!
+        \brief Selects the first object that matches the search text while it is being typed.
+    */
+    void ConanWidget::SlotSearchObjects () {
+        WaitCursor wc;
+        SearchAndSelectObject (false);
+    }
+
+    /*!
+        \brief Finds all objects that match the search text, and selects the first match starting at the current object.
+
+        The matches are in the order of the object tree, the search wraps. The number
+        of matches is displayed next to the find button.
+        \param[in] inSkipCurrent    When true, the current object is not selected again
+        \return                     True when a match was selected
+    */
+    bool ConanWidget::SearchAndSelectObject (bool inSkipCurrent) {
+        mSearchTimer->stop ();
+        QString text = mForm.findLineEdit->text ();
+        QVector <int> results = mObjectModel->FindObjects (ObjectQuery (text));
+        const ObjectSearchIndex& searchIndex = mObjectModel->SearchIndex ();
+        int current = searchIndex.EntryOf (mObjectModel->GetKey (mForm.objectTree->currentIndex ()));
+        int first = 0;
+        if (current >= 0) {
+            SearchEntrySorter sorter = mObjectModel->SearchOrder ();
+            QVector <int>::const_iterator it = inSkipCurrent ? qUpperBound (results.constBegin (), results.constEnd (), current, sorter)
+                                                             : qLowerBound (results.constBegin (), results.constEnd (), current, sorter);
+            first = it - results.constBegin ();
+        }
+        for (int r=0; r<results.size (); r++) {
+            int result = (first + r) % results.size ();
+            // the objects of matches that have been destroyed since the last refresh can not be selected
+            if (SelectObject (mObjectModel->GetIndex (searchIndex.Ancestors (results [result])))) {
+                mForm.findResultLabel->setText (QString ("%1 of %2").arg (result + 1).arg (results.size ()));
+                return true;
+            }
+        }
+        mForm.findResultLabel->setText (text.trimmed ().isEmpty () ? QString () : QString ("no matches"));
+        return false;
+    }
+
     /*!
         \brief Sets the selcection command block to \p inBlock and returns its previous value.
     */
@@ -678,7 +1151,6 @@ namespace conan {
         If the object cannot be found the user may choose to add the corresponding object hierarachy to the object tree.
     */
     void ConanWidget::SlotFindMethod (const QModelIndex& inProxyIndex) {
-        WaitCursor wc;
         // retrieve selected method
         const MethodData* methodData = 0;
         if (mForm.signalTree == sender ()) {
@@ -690,16 +1162,38 @@ namespace conan {
         if (!methodData) {
             return;
         }
+        SelectMethod (*methodData);
+    }
+
+    /*!
+        \brief Makes the object with the given index current, and scrolls it into view.
+        \return True when the index is valid
+    */
+    bool ConanWidget::SelectObject (const QModelIndex& inIndex) {
+        if (inIndex.isValid ()) {
+            mForm.objectTree->setCurrentIndex (inIndex);
+            mForm.objectTree->scrollTo (inIndex, QAbstractItemView::PositionAtCenter);
+            return true;
+        }
+        return false;
+    }
+
+    /*!
+        \brief Finds and selects the object that owns the given method, then selects the method in either the signal or slot view.
+        If the object cannot be found the user may choose to add the corresponding object hierarachy to the object tree.
+    */
+    void ConanWidget::SelectMethod (const MethodData& inMethod) {
+        WaitCursor wc;
         // find and select the corresponding object
-        MethodData methodCopy = *methodData;
-        if (!FindAndSelectObject (MatchObjectByValue (methodCopy.mAddress))) {
+        MethodData methodCopy = inMethod;
+        if (!SelectObject (mObjectModel->GetIndex (methodCopy.Object (), methodCopy.ObjectKey ()))) {
             wc.Disable ();
             QString question = QString (
                 "The following object could not be found: \n"
                 "%1 <%2> \n\n"
                 "Do you wish to add the corresponding object hierarchy?").
-                arg (ObjectUtility::QualifiedName (methodCopy.mClass, methodCopy.mName)).
-                arg (methodCopy.mAddress);
+                arg (methodCopy.QualifiedName ()).
+                arg (methodCopy.Address ());
             if (QMessageBox::No ==
                 QMessageBox::question (this, "No object found", question, QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes))
             {
@@ -708,7 +1202,7 @@ namespace conan {
             wc.Enable ();
             // locate the top level parent of the object
             QModelIndex index = mForm.objectTree->currentIndex ();
-            QPointer <QObject> object = methodCopy.mObject;
+            QPointer <QObject> object = methodCopy.Object ();
             if (object && object->parent ()) {
                 // locate top level parent
                 while (object->parent ()) {
@@ -718,13 +1212,13 @@ namespace conan {
             // add the hierarchy to the object tree
             mObjectModel->AddRootObject (object);
             // retry selecting the object
-            if (!FindAndSelectObject (MatchObjectByValue (methodCopy.mAddress))) {
+            if (!SelectObject (mObjectModel->GetIndex (methodCopy.Object (), methodCopy.ObjectKey ()))) {
                 return;
             }
         }
         // find the method in either the signal or slot view and expand it
-        if (methodCopy.mMethodType == QMetaMethod::Signal) {
-            QModelIndexList matchList = mSignalModel->match (mSignalModel->index (0, 0), Qt::DisplayRole, methodCopy.mSignature, 1, Qt::MatchFixedString);
+        if (methodCopy.MethodType () == QMetaMethod::Signal) {
+            QModelIndexList matchList = mSignalModel->match (mSignalModel->index (0, 0), Qt::DisplayRole, methodCopy.Signature (), 1, Qt::MatchFixedString);
             if (!matchList.isEmpty ()) {
                 QModelIndex connectionIndex = mProxySignalModel->mapFromSource (matchList.first ());
                 mForm.signalTree->setCurrentIndex (connectionIndex);
@@ -733,8 +1227,8 @@ namespace conan {
                 mForm.signalTree->scrollTo (connectionIndex, QAbstractItemView::PositionAtCenter);
             }
         }
-        else if (methodCopy.mMethodType == QMetaMethod::Slot) {
-            QModelIndexList matchList = mSlotModel->match (mSlotModel->index (0, 0), Qt::DisplayRole, methodCopy.mSignature, 1, Qt::MatchFixedString);
+        else if (methodCopy.MethodType () == QMetaMethod::Slot) {
+            QModelIndexList matchList = mSlotModel->match (mSlotModel->index (0, 0), Qt::DisplayRole, methodCopy.Signature (), 1, Qt::MatchFixedString);
             if (!matchList.isEmpty ()) {
                 QModelIndex connectionIndex = mProxySlotModel->mapFromSource (matchList.first ());
                 mForm.slotTree->setCurrentIndex (connectionIndex);
@@ -745,6 +1239,17 @@ namespace conan {
         }
     }
 
+    /*!
+        \brief Returns the rows of the signal spy model that are selected in the signal spies view.
+    */
+    QList <int> ConanWidget::SelectedSpyRows () const {
+        QList <int> rows;
+        foreach (const QModelIndex& index, mForm.signalSpiesTableView->selectionModel ()->selectedRows ()) {
+            rows.push_back (mProxySignalSpyModel->mapToSource (index).row ());
+        }
+        return rows;
+    }
+
     /*!
         \brief Finds and selects the next object the contains duplicate connections.
     */
@@ -795,7 +1300,9 @@ namespace conan {
             return;
         }
         // find another object with duplicate connections
-        if (!FindAndSelectObject (ContainsDuplicateConnections ())) {
+        ConnectionGraph graph;
+        MethodTable table;
+        if (!FindAndSelectObject (ContainsDuplicateConnections (&graph, &table))) {
             wc.Disable ();
             QMessageBox::information (this, "No object found", "No object with duplicate connections could be found");
         }
@@ -827,6 +1334,97 @@ namespace conan {
         }
     }
 
+    /*!
+        \brief Scans all object hierarchies for duplicate connections and lists them in the duplicate connections view.
+
+        Objects are processed in chunks. Between chunks the progress is updated, which allows the
+        user to cancel the scan; the duplicates found so far are still listed. The connection
+        snapshot is discarded after each chunk, because objects may be destroyed while events are
+        being processed.
+    */
+    void ConanWidget::SlotScanDuplicateConnections () {
+        static const int sChunkSize = 100;
+
+        // gather all objects once
+        QVector <QPointer <QObject> > objects;
+        mObjectModel->FindObject (CollectObjects (&objects));
+        QSet <const void*> treeObjects;
+        foreach (const QPointer <QObject>& object, objects) {
+            treeObjects.insert (object.data ());
+        }
+
+        QProgressDialog progress ("Scanning for duplicate connections...", "Cancel", 0, objects.size (), this);
+        progress.setWindowModality (Qt::WindowModal);
+        progress.setMinimumDuration (500);
+
+        // a single snapshot for all chunks, so each sender is walked only once; objects that are
+        // destroyed while the progress dialog processes events are removed before they are read
+        ConnectionGraph graph;
+        QVector <DuplicateConnection> duplicates;
+        MethodTable table;
+        bool canceled = false;
+        int objectCount = objects.size ();
+        for (int first=0; first<objectCount && !canceled; first+=sChunkSize) {
+            progress.setValue (first);
+            if (progress.wasCanceled ()) {
+                canceled = true;
+                break;
+            }
+            int last = qMin (first + sChunkSize, objectCount);
+            for (int o=first; o<last; o++) {
+                const QObject* object = objects [o];
+                if (!object) {
+                    continue;
+                }
+                graph.RemoveDestroyedObjects (object);
+                priv::AddObjectToConnectionGraph (object, graph);
+                // every connection from a sender in the tree is reported by its signal
+                QVector <ConnectionData> signalData;
+                priv::BuildSignalData (object, graph, table, signalData);
+                foreach (const ConnectionData& signal, signalData) {
+                    AppendDuplicateConnections (signal, duplicates);
+                }
+                // connections from senders outside of the tree are reported by their slot
+                QVector <ConnectionData> slotData;
+                priv::BuildSlotData (object, graph, table, slotData);
+                for (int s=0; s<slotData.size (); s++) {
+                    ConnectionData& slot = slotData [s];
+                    if (!slot.ContainsDuplicateConnections ()) {
+                        continue;
+                    }
+                    for (int c=slot.mConnections.size ()-1; c>=0; c--) {
+                        if (treeObjects.contains (slot.mConnections [c].ObjectKey ())) {
+                            slot.mConnections.remove (c);
+                        }
+                    }
+                    slot.UpdateDuplicateConnections ();
+                    AppendDuplicateConnections (slot, duplicates);
+                }
+            }
+        }
+        progress.setValue (objectCount);
+
+        mDuplicateModel->SetData (duplicates);
+        mForm.duplicateTableView->horizontalHeader ()->resizeSections (QHeaderView::ResizeToContents);
+        mForm.duplicatesLabel->setText (QString ("%1 duplicate connection(s) found in %2 object(s)%3")
+            .arg (duplicates.size ())
+            .arg (objectCount)
+            .arg (canceled ? " (scan canceled)" : ""));
+    }
+
+    /*!
+        \brief Selects the sender and signal of the duplicate connection at the given index in the object hierarchy tab.
+    */
+    void ConanWidget::SlotSelectDuplicateConnection (const QModelIndex& inProxyIndex) {
+        const DuplicateConnection* duplicate = mDuplicateModel->GetDuplicate (mProxyDuplicateModel->mapToSource (inProxyIndex));
+        if (!duplicate) {
+            return;
+        }
+        MethodData signal = duplicate->mSignal;
+        mForm.tabWidget->setCurrentWidget (mForm.objectTab);
+        SelectMethod (signal);
+    }
+
     /*!
         \brief Discovers exting object hierarchies and adds these to the object tree.
     */
@@ -842,9 +1440,17 @@ namespace conan {
         QMenu menu;
         menu.addAction (mForm.actionSelectAllSpies);
         menu.addSeparator ();
+        menu.addAction (mForm.actionSetSpySampling);
+        menu.addAction (mForm.actionTriggerSpyBurst);
+        menu.addAction (mForm.actionSetSpyCondition);
+        menu.addSeparator ();
         menu.addAction (mForm.actionDeleteSpies);
+        bool hasSelection = mForm.signalSpiesTableView->selectionModel ()->hasSelection ();
         mForm.actionSelectAllSpies->setEnabled (mSignalSpyModel->rowCount ());
-        mForm.actionDeleteSpies->setEnabled (mForm.signalSpiesTableView->selectionModel ()->hasSelection ());
+        mForm.actionSetSpySampling->setEnabled (hasSelection);
+        mForm.actionTriggerSpyBurst->setEnabled (hasSelection);
+        mForm.actionSetSpyCondition->setEnabled (hasSelection);
+        mForm.actionDeleteSpies->setEnabled (hasSelection);
         // show menu
         QPoint pos = mForm.signalSpiesTableView->mapToGlobal (inPos);
         menu.exec (pos);
@@ -856,6 +1462,7 @@ namespace conan {
     void ConanWidget::SlotUpdateSignalLoggerOptions () {
         SignalLogger& logger = mSignalSpyModel->GetLogger ();
         logger.mShowTimestamp = mForm.timestampCheckBox->isChecked ();
+        logger.mTimestampMode = static_cast <SignalLogger::TimestampModes> (mForm.timestampComboBox->currentIndex ());
         logger.mShowObject = mForm.objectCheckBox->isChecked ();
         logger.mShowAddress = mForm.addressCheckBox->isChecked ();
         logger.mShowSignature = mForm.signatureCcheckBox->isChecked ();
@@ -866,10 +1473,408 @@ namespace conan {
             mForm.separatorLineEdit->text ().isEmpty ()
             ? ' '
             : mForm.separatorLineEdit->text ().at (0);
+        logger.mFormatTemplate = mForm.formatLineEdit->text ().trimmed ();
+        logger.CompileFormat ();
+        logger.SetCaptureEnabled (mForm.captureCheckBox->isChecked ());
 
         mForm.signalLogLabel->setText (mSignalSpyModel->GetLogger ().GetExampleLog ());
     }
 
+    /*!
+        \brief Shows the time spent within spied signal emissions.
+    */
+    void ConanWidget::SlotUpdateSignalLoggerStatistics () {
+        const SignalLogger::Statistics& statistics = mSignalSpyModel->GetLogger ().GetStatistics ();
+        if (statistics.mSampledOut || statistics.mRateLimited) {
+            mForm.samplingStatisticsLabel->setText (QString ("%1 sampled out, %2 rate limited")
+                .arg (statistics.mSampledOut)
+                .arg (statistics.mRateLimited));
+        }
+        if (!statistics.mEmissions) {
+            mForm.captureStatisticsLabel->clear ();
+            return;
+        }
+        double averageCost = static_cast <double> (statistics.mTotalCost) / statistics.mEmissions / 1000.0;
+        QString text = QString ("%1 emissions, %2 us average, %3 us max")
+            .arg (statistics.mEmissions)
+            .arg (averageCost, 0, 'f', 2)
+            .arg (statistics.mMaxCost / 1000.0, 0, 'f', 2);
+        if (statistics.mDropped) {
+            text.append (QString (", %1 dropped").arg (statistics.mDropped));
+        }
+        mForm.captureStatisticsLabel->setText (text);
+    }
+
+    /*!
+        \brief Selects the signal log output chosen in the output combo box, file outputs ask for a file name.
+    */
+    void ConanWidget::SlotSelectSignalLogOutput (int inIndex) {
+        SignalLogOutput output = static_cast <SignalLogOutput> (inIndex);
+        QString fileName;
+        if (output == kTextFileOutput) {
+            fileName = QFileDialog::getSaveFileName (this, "Log to text file", QString (), "Log files (*.log *.txt)",
+                                                     0, QFileDialog::DontConfirmOverwrite);
+        }
+        else if (output == kBinaryTraceOutput) {
+            fileName = QFileDialog::getSaveFileName (this, "Log to binary trace file", QString (), "Trace files (*.trace)");
+        }
+
+        bool isFileOutput = (output == kTextFileOutput || output == kBinaryTraceOutput);
+        if (isFileOutput && fileName.isEmpty ()) {
+            mForm.logOutputComboBox->setCurrentIndex (mSignalLogOutput);
+            return;
+        }
+        if (!SetSignalLogOutput (output, fileName)) {
+            mForm.logOutputComboBox->setCurrentIndex (mSignalLogOutput);
+            QMessageBox::warning (this, "Log output", "The following file could not be opened:\n\n" + fileName);
+        }
+    }
+
+    /*!
+        \brief Shows only the busiest signal spies, sorted by their emission rate over the last second.
+    */
+    void ConanWidget::SlotEnableTopSpies (bool inEnable) {
+        mProxySignalSpyModel->SlotEnableTopMode (inEnable);
+        if (inEnable) {
+            mForm.signalSpiesTableView->sortByColumn (SignalSpyModel::kRate1s, Qt::DescendingOrder);
+        }
+    }
+
+    /*!
+        \brief Applies the trace filter, and enables or disables the signal tracer.
+    */
+    void ConanWidget::SlotUpdateSignalTracer () {
+        QString error;
+        SignalTraceFilter filter = SignalTraceFilter::Parse (mForm.traceFilterLineEdit->text (), &error);
+        if (error.isEmpty ()) {
+            filter.mRoots = mSignalTracer->Filter ().mRoots;
+            mSignalTracer->SetFilter (filter);
+        }
+
+        bool enable = mForm.traceCheckBox->isChecked ();
+        if (enable != mSignalTracer->IsEnabled ()) {
+            mSignalTracer->SetEnabled (enable);
+            UpdateSignalSpyCallbacks ();
+        }
+
+        if (error.isEmpty ()) {
+            SlotUpdateSignalTracerStatistics ();
+        }
+        else {
+            mForm.traceStatisticsLabel->setText (error);
+        }
+    }
+
+    /*!
+        \brief Shows the number of traced and filtered emissions, and the time the tracer added to each.
+    */
+    void ConanWidget::SlotUpdateSignalTracerStatistics () {
+        const SignalTracer::Statistics& statistics = mSignalTracer->GetStatistics ();
+        if (!statistics.mTraced && !statistics.mFiltered && !statistics.mOverflowed) {
+            mForm.traceStatisticsLabel->clear ();
+            return;
+        }
+        double tracedCost = statistics.mTraced ? static_cast <double> (statistics.mTracedCost) / statistics.mTraced / 1000.0 : 0.0;
+        double filteredCost = statistics.mFiltered ? static_cast <double> (statistics.mFilteredCost) / statistics.mFiltered / 1000.0 : 0.0;
+        QString text = QString ("%1 traced, %2 us average, %3 filtered, %4 us average")
+            .arg (statistics.mTraced)
+            .arg (tracedCost, 0, 'f', 2)
+            .arg (statistics.mFiltered)
+            .arg (filteredCost, 0, 'f', 2);
+        if (statistics.mDropped) {
+            text.append (QString (", %1 dropped").arg (statistics.mDropped));
+        }
+        if (statistics.mOverflowed) {
+            text.append (QString (", %1 not traced, too many signals").arg (statistics.mOverflowed));
+        }
+        mForm.traceStatisticsLabel->setText (text);
+    }
+
+    /*!
+        \brief Applies the sampling policy to the emissions of all spies and of the signal tracer.
+    */
+    void ConanWidget::SlotUpdateSamplingPolicy () {
+        QString error;
+        SamplingPolicy policy = SamplingPolicy::Parse (mForm.samplingLineEdit->text (), &error);
+        if (!error.isEmpty ()) {
+            mForm.samplingStatisticsLabel->setText (error);
+            return;
+        }
+        SignalSampler& sampler = mSignalSpyModel->GetLogger ().GetSampler ();
+        if (policy.ToString () != sampler.Policy ().ToString ()) {
+            sampler.SetPolicy (policy);
+        }
+        mForm.samplingStatisticsLabel->clear ();
+        SlotUpdateSignalLoggerStatistics ();
+    }
+
+    /*!
+        \brief Starts a burst of the sampling policy of all spies and of the signal tracer.
+    */
+    void ConanWidget::SlotTriggerBurst () {
+        mSignalSpyModel->GetLogger ().GetSampler ().Trigger ();
+    }
+
+    /*!
+        \brief Asks for the sampling policy of the selected signal spies.
+    */
+    void ConanWidget::SlotSetSpySampling () {
+        QList <int> rows = SelectedSpyRows ();
+        if (rows.isEmpty ()) {
+            return;
+        }
+        QString text = mSignalSpyModel->GetSamplingPolicy (rows.first ()).ToString ();
+        for (;;) {
+            bool ok = false;
+            text = QInputDialog::getText (this, "Sampling", "Sampling policy, f.e: every:10 rate:100 burst:50",
+                                          QLineEdit::Normal, text, &ok);
+            if (!ok) {
+                return;
+            }
+            QString error;
+            SamplingPolicy policy = SamplingPolicy::Parse (text, &error);
+            if (error.isEmpty ()) {
+                mSignalSpyModel->SetSamplingPolicy (rows, policy);
+                return;
+            }
+            QMessageBox::warning (this, "Sampling", error);
+        }
+    }
+
+    /*!
+        \brief Starts a burst of the sampling policy of the selected signal spies.
+    */
+    void ConanWidget::SlotTriggerSpyBurst () {
+        mSignalSpyModel->TriggerBurst (SelectedSpyRows ());
+    }
+
+    /*!
+        \brief Asks for the condition of the selected signal spies.
+    */
+    void ConanWidget::SlotSetSpyCondition () {
+        QList <int> rows = SelectedSpyRows ();
+        if (rows.isEmpty ()) {
+            return;
+        }
+        QString text = mSignalSpyModel->GetCondition (rows.first ());
+        for (;;) {
+            bool ok = false;
+            text = QInputDialog::getText (this, "Condition", "Condition, f.e: arg0>1000 arg1~^error do:snapshot do:dump",
+                                          QLineEdit::Normal, text, &ok);
+            if (!ok) {
+                return;
+            }
+            QString error;
+            if (mSignalSpyModel->SetCondition (rows, text, &error)) {
+                return;
+            }
+            QMessageBox::warning (this, "Condition", error);
+        }
+    }
+
+    /*!
+        \brief Pauses or resumes logging of all signal spies and of the signal tracer.
+    */
+    void ConanWidget::SlotPauseLogging (bool inPause) {
+        mSignalSpyModel->GetLogger ().SetLoggingEnabled (!inPause);
+    }
+
+    /*!
+        \brief Performs the actions triggered by the condition of a signal spy, that can not be performed by the emitting thread.
+
+        Object snapshots and log dumps are written to the current directory.
+    */
+    void ConanWidget::SlotSpyTriggered (int inRow, int inActions) {
+        // logging may have been paused or resumed by the emitting thread
+        mForm.pauseLoggingCheckBox->blockSignals (true);
+        mForm.pauseLoggingCheckBox->setChecked (!mSignalSpyModel->GetLogger ().IsLoggingEnabled ());
+        mForm.pauseLoggingCheckBox->blockSignals (false);
+
+        QDateTime now = QDateTime::currentDateTime ();
+        QString suffix = now.toString ("yyyyMMdd_hhmmss_zzz");
+        QStringList results;
+        if (inActions & SignalCondition::kStartLogging) {
+            results.push_back ("logging started");
+        }
+        if (inActions & SignalCondition::kStopLogging) {
+            results.push_back ("logging paused");
+        }
+        if (inActions & SignalCondition::kTriggerBurst) {
+            results.push_back ("burst started");
+        }
+        if (inActions & SignalCondition::kSnapshotObjects) {
+            QString fileName = QDir::current ().absoluteFilePath (QString ("conan_snapshot_%1.xml").arg (suffix));
+            QModelIndexList roots;
+            for (int r=0; r<mObjectModel->rowCount (); ++r) {
+                roots.push_back (mObjectModel->index (r, 0));
+            }
+            results.push_back (ExportToXML (fileName, roots)
+                ? "objects exported to " + QDir::toNativeSeparators (fileName)
+                : "unable to export objects to " + QDir::toNativeSeparators (fileName));
+        }
+        if (inActions & SignalCondition::kDumpLog) {
+            QString fileName = QDir::current ().absoluteFilePath (QString ("conan_log_%1.log").arg (suffix));
+            if (!mMemoryLogSink) {
+                results.push_back ("no log to dump, select the memory output");
+            }
+            else {
+                results.push_back (DumpSignalLog (fileName)
+                    ? "log dumped to " + QDir::toNativeSeparators (fileName)
+                    : "unable to dump log to " + QDir::toNativeSeparators (fileName));
+            }
+        }
+        QString signal = inRow >= 0
+            ? mSignalSpyModel->index (inRow, SignalSpyModel::kSignature).data ().toString ()
+            : QString ("Destroyed spy");
+        mForm.triggerStatusLabel->setText (QString ("%1 %2: %3")
+            .arg (now.toString ("hh:mm:ss"))
+            .arg (signal)
+            .arg (results.join (", ")));
+    }
+
+    /*!
+        \brief Shows the logged emissions that match the filter fields of the log view.
+
+        The time range is written as [from]-[to] in seconds since the session start, f.e: 1.5-3
+    */
+    void ConanWidget::SlotUpdateSignalEventFilter () {
+        SignalEventFilter filter;
+        filter.mSignal = mForm.eventSignalFilterLineEdit->text ();
+        filter.mObject = mForm.eventObjectFilterLineEdit->text ();
+        filter.mThread = mForm.eventThreadFilterLineEdit->text ();
+
+        QString range = mForm.eventTimeFilterLineEdit->text ().trimmed ();
+        if (!range.isEmpty ()) {
+            QStringList bounds = range.split ('-');
+            qint64 values [2] = { -1, -1 };
+            bool valid = bounds.size () <= 2;
+            for (int b=0; b<bounds.size () && valid; ++b) {
+                QString bound = bounds [b].trimmed ();
+                if (!bound.isEmpty ()) {
+                    values [b] = static_cast <qint64> (bound.toDouble (&valid) * 1000000000.0);
+                }
+            }
+            if (!valid) {
+                mForm.eventCountLabel->setText (QString ("Invalid time range '%1', expected [from]-[to] in seconds").arg (range));
+                return;
+            }
+            filter.mFrom = values [0];
+            filter.mTo = values [1];
+        }
+
+        const SignalEventFilter& current = mSignalEventModel->GetFilter ();
+        if (filter.mSignal != current.mSignal || filter.mObject != current.mObject || filter.mThread != current.mThread ||
+            filter.mFrom != current.mFrom || filter.mTo != current.mTo) {
+            WaitCursor wc;
+            mSignalEventModel->SetFilter (filter);
+        }
+        SlotSignalEventsChanged ();
+    }
+
+    /*!
+        \brief Stops or resumes showing new emissions in the log view, emissions are still stored while the view is paused.
+    */
+    void ConanWidget::SlotPauseSignalEvents (bool inPause) {
+        mSignalEventModel->SetPaused (inPause);
+    }
+
+    /*!
+        \brief Discards all emissions of the log view.
+    */
+    void ConanWidget::SlotClearSignalEvents () {
+        mSignalEventModel->Clear ();
+    }
+
+    /*!
+        \brief Shows the number of emissions in the log view, and keeps the newest emission visible when the view was scrolled to the bottom.
+    */
+    void ConanWidget::SlotSignalEventsChanged () {
+        const SignalEventStore& store = mSignalEventModel->GetStore ();
+        mForm.eventCountLabel->setText (QString ("%1 of %2 emissions shown")
+            .arg (mSignalEventModel->rowCount ())
+            .arg (store.End () - store.First ()));
+
+        // the scroll bar is updated when the view is laid out, after this call
+        const QScrollBar* scrollBar = mForm.signalEventTableView->verticalScrollBar ();
+        if (scrollBar->value () == scrollBar->maximum ()) {
+            mForm.signalEventTableView->scrollToBottom ();
+        }
+    }
+
+    /*!
+        \brief Starts or stops measuring the execution time of all slots.
+    */
+    void ConanWidget::SlotEnableSlotProfiler (bool inEnable) {
+        mSlotProfileModel->GetProfiler ().SetEnabled (inEnable);
+        UpdateSignalSpyCallbacks ();
+    }
+
+    /*!
+        \brief Lists each (signal, slot) pair in a row of its own, or each slot.
+    */
+    void ConanWidget::SlotGroupSlotProfileBySignal (bool inGroupBySignal) {
+        mSlotProfileModel->SetGroupBySignal (inGroupBySignal);
+    }
+
+    /*!
+        \brief Discards the measured slot execution times.
+    */
+    void ConanWidget::SlotClearSlotProfile () {
+        mSlotProfileModel->Clear ();
+    }
+
+    /*!
+        \brief Asks for a file name and writes the slot profile table to it as comma separated values.
+    */
+    void ConanWidget::SlotExportSlotProfile () {
+        QString fileName = QFileDialog::getSaveFileName (this, "Export slot profile", QString (), "CSV files (*.csv)");
+        if (fileName.isEmpty ()) {
+            return;
+        }
+        QFile file (fileName);
+        if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            QMessageBox::warning (this, "Export slot profile", "The following file could not be opened:\n\n" + fileName);
+            return;
+        }
+        QTextStream stream (&file);
+        mSlotProfileModel->Export (stream);
+    }
+
+    /*!
+        \brief Asks for a file name and starts recording a Chrome trace to it, or stops recording.
+    */
+    void ConanWidget::SlotRecordTrace (bool inRecord) {
+        if (inRecord == mTraceRecorder->IsRecording ()) {
+            return;
+        }
+        if (inRecord) {
+            QString fileName = QFileDialog::getSaveFileName (this, "Record trace", QString (), "Chrome trace files (*.json)");
+            if (fileName.isEmpty () || !mTraceRecorder->Start (fileName)) {
+                if (!fileName.isEmpty ()) {
+                    QMessageBox::warning (this, "Record trace", "The following file could not be opened:\n\n" + fileName);
+                }
+                mForm.recordTraceToolButton->setChecked (false);
+                return;
+            }
+        }
+        else {
+            mTraceRecorder->Stop ();
+        }
+        UpdateSignalSpyCallbacks ();
+        SlotUpdateTraceRecorderStatus ();
+    }
+
+    /*!
+        \brief Shows the trace file and the number of recorded events.
+    */
+    void ConanWidget::SlotUpdateTraceRecorderStatus () {
+        QString text = QString ("%1 events %2 %3")
+            .arg (mTraceRecorder->EventCount ())
+            .arg (mTraceRecorder->IsRecording () ? "recording to" : "recorded to")
+            .arg (QDir::toNativeSeparators (mTraceRecorder->FileName ()));
+        mForm.recordTraceLabel->setText (text);
+    }
+
     /*
         \brief Destroyes all signal spies that are selected in the signal spies table
     */
@@ -905,10 +1910,67 @@ namespace conan {
 
         WaitCursor wc;
 
-        QFile file (filename);
-        if (!file.open (QIODevice::WriteOnly)) {
+        if (!ExportToXML (filename, QModelIndexList () << currentIndex)) {
             QMessageBox::warning (this, "Export to XML failed", "Unable to open file " + filename);
-            return;
+        }
+    }
+
+    /*!
+        \brief Starts or stops measuring the delivery latency of all queued connections.
+
+        Starting discards the previous measurements, stopping keeps them visible.
+    */
+    void ConanWidget::SlotMeasureQueuedLatency (bool inEnable) {
+        if (inEnable) {
+            mQueuedLatencyMonitor->Clear ();
+            mForm.signalTree->setColumnHidden (ConnectionModel::kLatency, false);
+            mForm.slotTree->setColumnHidden (ConnectionModel::kLatency, false);
+            mLatencyTimer->start ();
+        }
+        else {
+            mLatencyTimer->stop ();
+        }
+        mQueuedLatencyMonitor->SetEnabled (inEnable);
+        UpdateSignalSpyCallbacks ();
+#ifndef QT_NO_DEBUG
+        if (inEnable && !debug::CheckQueuedLatency (*mQueuedLatencyMonitor)) {
+            qWarning ("ConanWidget: A queued emission and its delivery did not produce a latency.");
+        }
+#endif
+        SlotRefreshLatencies ();
+    }
+
+    /*!
+        \brief Updates the latency column of the signal and slot views, and the latency per receiving thread.
+    */
+    void ConanWidget::SlotRefreshLatencies () {
+        mQueuedLatencyMonitor->Flush ();
+        mSignalModel->RefreshLatencies ();
+        mSlotModel->RefreshLatencies ();
+
+        QStringList summaries;
+        QStringList details;
+        foreach (const QueuedLatencyMonitor::ThreadLatency& thread, mQueuedLatencyMonitor->ThreadLatencies ()) {
+            summaries << QString ("%1: %2").arg (thread.mThread, thread.mLatency.ToString ());
+            details << QString ("Thread %1\n%2").arg (thread.mThread, thread.mLatency.Details ());
+        }
+        summaries.sort ();
+        details.sort ();
+        if (quint64 dropped = mQueuedLatencyMonitor->DroppedCount ()) {
+            details << QString ("%1 emissions or deliveries were dropped").arg (dropped);
+        }
+        mForm.latencyLabel->setText (summaries.join ("; "));
+        mForm.latencyLabel->setToolTip (details.isEmpty () ?
+            QString ("The delivery latency of all queued connections per receiving thread") : details.join ("\n\n"));
+    }
+
+    /*!
+        \brief Exports the objects indentified by the given indices to an XML file, returns false when the file can not be opened.
+    */
+    bool ConanWidget::ExportToXML (const QString& inFileName, const QModelIndexList& inIndices) const {
+        QFile file (inFileName);
+        if (!file.open (QIODevice::WriteOnly)) {
+            return false;
         }
         QXmlStreamWriter writer (&file);
         writer.setAutoFormatting (true);
@@ -917,16 +1979,22 @@ namespace conan {
             writer.writeAttribute ("conan", CONAN_VERSION_STR);
             writer.writeAttribute ("qt", QT_VERSION_STR);
             writer.writeAttribute ("created", QDateTime::currentDateTime ().toString (Qt::ISODate));
-                ExportToXML (writer, currentIndex);
+                ConnectionGraph graph;
+                MethodTable table;
+                foreach (const QModelIndex& index, inIndices) {
+                    ExportToXML (writer, index, graph, table);
+                }
             writer.writeEndElement ();
         writer.writeEndDocument ();
         file.close ();
+        return true;
     }
 
     /*!
         \brief Exports the object indentified by the given index to XML.
+        All exported objects share the connection snapshot \p ioGraph and the records in \p ioTable.
     */
-    void ConanWidget::ExportToXML (QXmlStreamWriter& inWriter, const QModelIndex& inIndex) const {
+    void ConanWidget::ExportToXML (QXmlStreamWriter& inWriter, const QModelIndex& inIndex, ConnectionGraph& ioGraph, MethodTable& ioTable) const {
         inWriter.writeStartElement ("object");
         inWriter.writeAttribute ("name", mObjectModel->GetObjectName (inIndex));
         inWriter.writeAttribute ("class", mObjectModel->GetClass (inIndex));
@@ -936,8 +2004,10 @@ namespace conan {
             inWriter.writeAttribute ("destroyed", "true");
         }
         else {
+            priv::AddObjectToConnectionGraph (object, ioGraph);
+
             QVector <ConnectionData> signalData;
-            priv::BuildSignalData (object, signalData);
+            priv::BuildSignalData (object, ioGraph, ioTable, signalData);
 
             size_t signalDataCount = signalData.size ();
             for (size_t d=0; d<signalDataCount; d++) {
@@ -946,7 +2016,7 @@ namespace conan {
             }
 
             QVector <ConnectionData> slotData;
-            priv::BuildSlotData (object, slotData);
+            priv::BuildSlotData (object, ioGraph, ioTable, slotData);
 
             size_t slotDataCount = slotData.size ();
             for (size_t d=0; d<slotDataCount; d++) {
@@ -954,9 +2024,13 @@ namespace conan {
                 connectionData.ExportToXML(inWriter);
             }
         }
+        // export the hierarchies that have not been expanded as well
+        if (mObjectModel->canFetchMore (inIndex)) {
+            mObjectModel->fetchMore (inIndex);
+        }
         int rowCount = mObjectModel->rowCount (inIndex);
         for (int row=0; row<rowCount; row++) {
-            ExportToXML (inWriter, inIndex.child (row, 0));
+            ExportToXML (inWriter, inIndex.child (row, 0), ioGraph, ioTable);
         }
         inWriter.writeEndElement ();
     }
@@ -967,13 +2041,7 @@ namespace conan {
     template <typename Pred>
     bool ConanWidget::FindAndSelectObject (Pred inPred) {
         QModelIndex current = mForm.objectTree->currentIndex ();
-        QModelIndex result = mObjectModel->FindObject (inPred, current);
-        if (result.isValid ()) {
-            mForm.objectTree->setCurrentIndex (result);
-            mForm.objectTree->scrollTo (result, QAbstractItemView::PositionAtCenter);
-            return true;
-        }
-        return false;
+        return SelectObject (mObjectModel->FindObject (inPred, current));
     }
 
 } // namespace conan
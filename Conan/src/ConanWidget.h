@@ -30,22 +30,36 @@
 
 #include "ConanDefines.h"
 #include "ui_ConanWidget.h"
+#include <QtCore/QStringList>
 #include <QtGui/QWidget>
 
 
 class QSortFilterProxyModel;
 class QStringListModel;
+class QTimer;
 class QUndoStack;
 class QXmlStreamWriter;
 
 
 namespace conan {
     class ConnectionFilterProxyModel;
+    class ConnectionGraph;
     class ConnectionModel;
+    class DuplicateConnectionModel;
     class KeyValueTableModel;
+    class MemoryLogSink;
+    class MethodTable;
     class ObjectModel;
+    class QueuedLatencyMonitor;
+    class SignalEventModel;
+    class SignalEventStore;
+    class SignalSpyFilterProxyModel;
     class SignalSpyModel;
+    class SignalTracer;
+    class SlotProfileModel;
+    class TraceRecorder;
     struct ConnectionData;
+    struct MethodData;
 
 
     /*!
@@ -70,8 +84,18 @@ namespace conan {
         Q_CLASSINFO("Website", "http://sourceforge.net/projects/conanforqt")
         Q_CLASSINFO("License", "GPL")
 
+    public:
+        //! \brief The destinations to which signal spy logs can be written
+        typedef enum SIGNALLOGOUTPUTS {
+            kDebugOutput,           //!< qDebug calls, the default
+            kTextFileOutput,        //!< A text file, which is rotated when it exceeds 16 MB
+            kMemoryOutput,          //!< Memory, the most recent logs are kept, see GetSignalLogMessages
+            kBinaryTraceOutput      //!< A compact binary trace file
+        } SignalLogOutput;
+
     public:
         ConanWidget (QWidget* inParent = 0, Qt::WindowFlags inFlags = 0);
+        virtual ~ConanWidget ();
 
         QList <const QObject*> GetRootObjects () const;
         void AddRootObject (const QObject* inObject);
@@ -81,16 +105,30 @@ namespace conan {
 
         void SetHeaderResizeMode (QHeaderView::ResizeMode mode);
 
+        bool SetSignalLogOutput (SignalLogOutput inOutput, const QString& inFileName = QString ());
+        SignalLogOutput GetSignalLogOutput () const;
+        QStringList GetSignalLogMessages () const;
+
     private:
         void InitObjectHierarchyTab ();
         void InitSignalSpiesTab ();
+        void InitDuplicatesTab ();
+        void InitSlotProfilerTab ();
+        void UpdateSignalSpyCallbacks ();
         void ClearCurrentObjectViews ();
+        void ReloadCurrentObjectViews ();
 
         template <typename Pred>
         bool FindAndSelectObject (Pred inPred);
+        bool SelectObject (const QModelIndex& inIndex);
+        bool SearchAndSelectObject (bool inSkipCurrent);
         bool BlockSelectionCommand (bool inBlock);
+        void SelectMethod (const MethodData& inMethod);
+        QList <int> SelectedSpyRows () const;
 
-        void ExportToXML (QXmlStreamWriter& inWriter, const QModelIndex& inIndex) const;
+        bool ExportToXML (const QString& inFileName, const QModelIndexList& inIndices) const;
+        void ExportToXML (QXmlStreamWriter& inWriter, const QModelIndex& inIndex, ConnectionGraph& ioGraph, MethodTable& ioTable) const;
+        bool DumpSignalLog (const QString& inFileName) const;
 
     signals:
         //! \brief Subscribe to all signal spy log messages. Never ever connect a spy to this signal!!!
@@ -101,6 +139,7 @@ namespace conan {
         void SlotCurrentObjectChanged (const QModelIndex& inCurrent, const QModelIndex& inPrevious);
         void SlotRefresh ();
         void SlotFindObject ();
+        void SlotSearchObjects ();
         void SlotFindMethod (const QModelIndex& inProxyIndex);
         void SlotFindDuplicateConnection ();
         void SlotDiscoverObjects ();
@@ -108,10 +147,42 @@ namespace conan {
         void SlotRemoveRootObject ();
         void SlotRemoveAllRootObjects ();
         void SlotConnectionContextMenuRequested (const QPoint& inPos);
+        void SlotSpyObjectSignals ();
+        void SlotSpyClassSignals ();
+        void SlotSpyHierarchySignals ();
+        void SlotTraceHierarchySignals (bool inEnable);
         void SlotExportToXML ();
+        void SlotMeasureQueuedLatency (bool inEnable);
+        void SlotRefreshLatencies ();
+
+        void SlotScanDuplicateConnections ();
+        void SlotSelectDuplicateConnection (const QModelIndex& inProxyIndex);
 
         void SlotSpiesContextMenuRequested (const QPoint& inPos);
         void SlotUpdateSignalLoggerOptions ();
+        void SlotUpdateSignalLoggerStatistics ();
+        void SlotSelectSignalLogOutput (int inIndex);
+        void SlotEnableTopSpies (bool inEnable);
+        void SlotUpdateSignalTracer ();
+        void SlotUpdateSignalTracerStatistics ();
+        void SlotUpdateSamplingPolicy ();
+        void SlotTriggerBurst ();
+        void SlotSetSpySampling ();
+        void SlotTriggerSpyBurst ();
+        void SlotSetSpyCondition ();
+        void SlotPauseLogging (bool inPause);
+        void SlotSpyTriggered (int inRow, int inActions);
+        void SlotUpdateSignalEventFilter ();
+        void SlotPauseSignalEvents (bool inPause);
+        void SlotClearSignalEvents ();
+        void SlotSignalEventsChanged ();
+
+        void SlotEnableSlotProfiler (bool inEnable);
+        void SlotGroupSlotProfileBySignal (bool inGroupBySignal);
+        void SlotClearSlotProfile ();
+        void SlotExportSlotProfile ();
+        void SlotRecordTrace (bool inRecord);
+        void SlotUpdateTraceRecorderStatus ();
         void SlotDeleteSpies ();
 
         void SlotRequestConfirmation (const QString& title, const QString& message, bool& confirmed);
@@ -126,8 +197,21 @@ namespace conan {
         QStringListModel* mInheritanceModel;            //!< The model containing the inheritance data for the current object
         KeyValueTableModel* mClassInfoModel;            //!< The model containing the class info data for the current object
         SignalSpyModel* mSignalSpyModel;                //!< The model containing all signal spies
-        QSortFilterProxyModel* mProxySignalSpyModel;    //!< Provides sorting for the signal spy model
+        SignalSpyFilterProxyModel* mProxySignalSpyModel;//!< Provides sorting and filtering for the signal spy model
+        SignalLogOutput mSignalLogOutput;               //!< The destination of signal spy logs
+        MemoryLogSink* mMemoryLogSink;                  //!< The sink that keeps the logs in memory, owned by the signal logger
+        SignalTracer* mSignalTracer;                    //!< Traces the signal emissions of all objects to the signal logger
+        SignalEventStore* mSignalEventStore;            //!< Keeps the most recent signal emissions for the log view, owned by the signal logger
+        SignalEventModel* mSignalEventModel;            //!< The model of the log view
+        DuplicateConnectionModel* mDuplicateModel;      //!< The model containing the result of the last duplicate connection scan
+        QSortFilterProxyModel* mProxyDuplicateModel;    //!< Provides sorting for the duplicate connection model
+        SlotProfileModel* mSlotProfileModel;            //!< The model containing the measured slot execution times
+        QSortFilterProxyModel* mProxySlotProfileModel;  //!< Provides sorting for the slot profile model
+        TraceRecorder* mTraceRecorder;                  //!< Records signal emissions and slot invocations to a Chrome trace file
         QUndoStack* mUndoStack;                         //!< Object selection undo stack
+        QTimer* mSearchTimer;                           //!< Delays the search while the search text is being typed
+        QueuedLatencyMonitor* mQueuedLatencyMonitor;    //!< Measures the delivery latency of queued connections
+        QTimer* mLatencyTimer;                          //!< Refreshes the measured latencies while measuring
         bool mBlockSelectionCommand;                    //!< Used to prevent a selection command to generate a new selection command
     };
 
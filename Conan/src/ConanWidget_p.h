@@ -29,66 +29,25 @@
 #define _CONANWIDGET_P__09_12_08__12_00_55__H_
 
 
+#include "Clock.h"
+#include "ConnectionGraph.h"
 #include "ConnectionModel.h"
+#include "MetaObjectCache.h"
+#include "MethodTable.h"
 #include "ObjectUtility.h"
+#include "QueuedLatencyMonitor.h"
+#include <QtCore/QEvent>
 #include <QtCore/QMetaObject>
+#include <QtCore/QThread>
 #include <QtCore/QtDebug>
-#include <QtCore/QMap>
-#include <QtCore/QSet>
 #include <QtCore/QVector>
 
 // private Qt headers
 #include <private/qobject_p.h>
-#include <private/qmetaobject_p.h>
 
 
 namespace conan {
 
-    //! Contains helper methods
-    namespace /*unnamed*/ {
-
-        /*!
-            \brief For a given metaobject, compute the signal offset, and the method offset (including signals)
-
-            This function was copied directly from qobject.cpp
-        */
-        void computeOffsets(const QMetaObject *metaobject, int *signalOffset, int *methodOffset) {
-            *signalOffset = *methodOffset = 0;
-            const QMetaObject *m = metaobject->d.superdata;
-            while (m) {
-                const QMetaObjectPrivate *d = QMetaObjectPrivate::get(m);
-                *methodOffset += d->methodCount;
-                *signalOffset += (d->revision >= 4) ? d->signalCount : d->methodCount;
-                /*Before Qt 4.6 (revision 4), the signalCount information was not generated by moc.
-                so for compatibility we consider all the method as slot for old moc output*/
-                m = m->d.superdata;
-            }
-        }
-
-        /*!
-            \brief Compute the signal index offset
-
-            This function was copied directly from QObject::dumpObjectInfo() in qobject.cpp
-        */
-        void computeOffsets (const QObject* inObject, int& signal_index, int& offset, int& offsetToNextMetaObject) {
-            if (signal_index >= offsetToNextMetaObject) {
-                const QMetaObject *mo = inObject->metaObject();
-                int signalOffset, methodOffset;
-                computeOffsets(mo, &signalOffset, &methodOffset);
-                while (signalOffset > signal_index) {
-                    mo = mo->superClass();
-                    offsetToNextMetaObject = signalOffset;
-                    computeOffsets(mo, &signalOffset, &methodOffset);
-                }
-                offset = methodOffset - signalOffset;
-            }
-        }
-    }
-
-
-    // --------------------------------------------------------------------------------------------
-
-
     /*!
         \brief Qt version specific code
 
@@ -105,59 +64,25 @@ namespace conan {
     namespace priv {
 
         /*!
-            \brief Builds a list of all signals and their connections for the given object.
-            \param[in]  inObject        The object
-            \param[out] outConnections  Contains all the object's signals and their connections
+            \brief Walks the connection lists of the given sender and adds all its connections to the given snapshot.
+
+            The connection lists of a sender are walked only once per snapshot.
+            \param[in]      inSender    The sender
+            \param[in,out]  ioGraph     The connection snapshot
         */
-        void BuildSignalData (const QObject* inObject, QVector <ConnectionData>& outConnections) {
-            outConnections.clear ();
-            if (!inObject) {
-                return;
-            }
-            const QMetaObject* metaObject = inObject->metaObject ();
-            if (!metaObject) {
+        void AddSenderToConnectionGraph (const QObject* inSender, ConnectionGraph& ioGraph) {
+            if (!inSender || ioGraph.ContainsSender (inSender)) {
                 return;
             }
-            // map <signal signature, outConnections index>
-            QMap <QString, int> signalIndices;
-            QSet <QString> slotSignatures;
-            int signalIndex = 0;
-            // first gather all signals
-            while (metaObject) {
-                int offset = metaObject->methodOffset ();
-                int count = metaObject->methodCount ();
-                // only process those methods that are unique to the current metaObject
-                for (int m=count-1; m>=offset; m--) {
-                    QMetaMethod method = metaObject->method (m);
-                    if (method.methodType () == QMetaMethod::Slot) {
-                        slotSignatures.insert (method.signature ());
-                    }
-                    else if (method.methodType () == QMetaMethod::Signal) {
-                        MethodData methodData;
-                        methodData.mAccess = method.access ();
-                        methodData.mAddress = ObjectUtility::Address (inObject);
-                        methodData.mObject = const_cast <QObject*> (inObject);
-                        methodData.mName = ObjectUtility::Name (inObject);
-                        methodData.mClass = ObjectUtility::Class (inObject);
-                        methodData.mSignature = method.signature ();
-                        methodData.mSuperClass = metaObject->className ();
-                        methodData.mMethodType = method.methodType ();
-                        // store
-                        outConnections.push_back (ConnectionData (methodData));
-                        signalIndices [method.signature ()] = signalIndex++;
-                    }
-                }
-                metaObject = metaObject->superClass ();
-            }
+            ioGraph.AddSender (inSender);
 
             try {
-                if (QObjectPrivate* object_p = QObjectPrivate::get (const_cast <QObject*> (inObject))) {
+                if (QObjectPrivate* object_p = QObjectPrivate::get (const_cast <QObject*> (inSender))) {
 
                     if (!object_p->connectionLists)
                         return;
 
-                    int offset = 0;
-                    int offsetToNextMetaObject = 0;
+                    const MetaObjectInfo& info = MetaObjectCache::Get (inSender->metaObject ());
                     // QObjectConnectionListVector is declared in qobject.cpp,
                     // luckily it derives from QVector <QObjectPrivate::ConnectionList>
                     QVector <QObjectPrivate::ConnectionList>* connectionLists =
@@ -165,77 +90,118 @@ namespace conan {
 
                     // look for connections where this object is the sender
                     for (int signal_index = 0; signal_index < connectionLists->count (); ++signal_index) {
-                        computeOffsets (inObject, signal_index, offset, offsetToNextMetaObject);
-
-                        const QMetaMethod signal = inObject->metaObject ()->method (signal_index + offset);
-                        // find the connection index of the current signal
-                        if (signalIndices.find (signal.signature ()) == signalIndices.end ()) {
-                            // its probably a slot signature (dubious)
-                            if (slotSignatures.find (signal.signature ()) == slotSignatures.end ()) {
-                                // this should never happen
-                                qDebug () << "Found a signal with signature '" << signal.signature () << "' that could not be matched to any QMetaMethod.";
-                                Q_ASSERT (false);
-                            }
-                            continue;
-                        }
-                        int connectionIndex = signalIndices [signal.signature ()];
+                        int methodIndex = info.MethodIndexOfSignal (signal_index);
                         // find all receivers of the current signal
                         const QObjectPrivate::Connection *c = connectionLists->at (signal_index).first;
                         while (c) {
-                            if (!c->receiver) {
-                                // disconnected receiver
-                                c = c->nextConnectionList;
-                                continue;
-                            }
-                            const QMetaObject *receiverMetaObject = c->receiver->metaObject ();
-                            const QMetaMethod method = receiverMetaObject->method (c->method);
-
-                            if (!method.signature ()) {
-                                // this only occurs when c.receiver has not been moc'ed
-                                // i.e. SignalSpy or QSignalSpy
-                                c = c->nextConnectionList;
-                                continue;
-                            }
-
-                            MethodData slotData;
-                            slotData.mAccess = method.access ();
-                            slotData.mAddress = ObjectUtility::Address (c->receiver);
-                            slotData.mConnectionType = c->connectionType;
-                            slotData.mObject = c->receiver;
-                            slotData.mName = ObjectUtility::Name (c->receiver);
-                            slotData.mClass = ObjectUtility::Class (c->receiver);
-                            slotData.mSignature = method.signature ();
-                            slotData.mMethodType = method.methodType ();
-                            // locate the class from which the method originates
-                            int index = receiverMetaObject->indexOfMethod (method.signature ());
-                            while (receiverMetaObject) {
-                                int offset = receiverMetaObject->methodOffset ();
-                                int count = receiverMetaObject->methodCount ();
-                                if (offset <= index && index < count) {
-                                    slotData.mSuperClass = receiverMetaObject->className ();
-                                    break;
-                                }
-                                receiverMetaObject = receiverMetaObject->superClass ();
+                            if (c->receiver && methodIndex >= 0) {
+                                ioGraph.AddEdge (ConnectionEdge (inSender, methodIndex, c->receiver, c->method, c->connectionType));
                             }
-                            // store
-                            outConnections [connectionIndex].mConnections.push_back (slotData);
-
                             c = c->nextConnectionList;
                         }
                     }
                 }
             }
             catch (...) {
-                qDebug () << "Unable to process signal connections for object" << ObjectUtility::QualifiedName (inObject) << ObjectUtility::Address (inObject);
+                qDebug () << "Unable to process signal connections for object" << ObjectUtility::QualifiedName (inSender) << ObjectUtility::Address (inSender);
+            }
+        }
+
+        /*!
+            \brief Adds all connections to and from the given object to the given snapshot.
+
+            The connection lists of the object and of each of its senders are walked, unless they
+            are already part of the snapshot.
+            \param[in]      inObject    The object
+            \param[in,out]  ioGraph     The connection snapshot
+        */
+        void AddObjectToConnectionGraph (const QObject* inObject, ConnectionGraph& ioGraph) {
+            if (!inObject) {
+                return;
+            }
+            AddSenderToConnectionGraph (inObject, ioGraph);
+
+            try {
+                if (QObjectPrivate* object_p = QObjectPrivate::get (const_cast <QObject*> (inObject))) {
+                    // process all senders, each one is walked only once
+                    for (QObjectPrivate::Connection *s = object_p->senders; s; s = s->next) {
+                        AddSenderToConnectionGraph (s->sender, ioGraph);
+                    }
+                }
+            }
+            catch (...) {
+                qDebug () << "Unable to process slot connections for object" << ObjectUtility::QualifiedName (inObject) << ObjectUtility::Address (inObject);
+            }
+        }
+
+        /*!
+            \brief Builds a list of all signals and their connections for the given object.
+            \param[in]  inObject        The object
+            \param[in]  inGraph         A connection snapshot that contains \p inObject, see AddObjectToConnectionGraph
+            \param[in]  ioTable         Interns all object and method records
+            \param[out] outConnections  Contains all the object's signals and their connections
+        */
+        void BuildSignalData (const QObject* inObject, const ConnectionGraph& inGraph, MethodTable& ioTable, QVector <ConnectionData>& outConnections) {
+            outConnections.clear ();
+            if (!inObject) {
+                return;
+            }
+            const QMetaObject* metaObject = inObject->metaObject ();
+            if (!metaObject) {
+                return;
+            }
+            const MetaObjectInfo& info = MetaObjectCache::Get (metaObject);
+            ObjectRecordPtr objectRecord = ioTable.Object (inObject);
+            // first gather all signals, in the row order of the cached method table
+            foreach (int m, info.SignalMethods ()) {
+                outConnections.push_back (ConnectionData (MethodData (objectRecord, ioTable.Method (metaObject, m))));
+            }
+
+            // process all connections where this object is the sender
+            foreach (int e, inGraph.OutgoingEdges (inObject)) {
+                const ConnectionEdge& edge = inGraph.Edge (e);
+
+                // find the connection index of the current signal
+                int connectionIndex = info.SignalRow (edge.mSignalIndex);
+                if (connectionIndex < 0) {
+                    // its probably a slot (dubious)
+                    if (info.SlotRow (edge.mSignalIndex) < 0) {
+                        // this should never happen
+                        qDebug () << "Found a signal with index" << edge.mSignalIndex << "that could not be matched to any QMetaMethod.";
+                        Q_ASSERT (false);
+                    }
+                    continue;
+                }
+
+                const QMetaObject *receiverMetaObject = edge.mReceiver->metaObject ();
+                const QMetaMethod method = receiverMetaObject->method (edge.mMethodIndex);
+
+                if (!method.signature ()) {
+                    // this only occurs when the receiver has not been moc'ed
+                    // i.e. SignalSpy or QSignalSpy
+                    continue;
+                }
+
+                MethodData slotData (ioTable.Object (edge.mReceiver),
+                                     ioTable.Method (receiverMetaObject, edge.mMethodIndex),
+                                     edge.mConnectionType);
+                // store
+                outConnections [connectionIndex].mConnections.push_back (slotData);
+            }
+            // count duplicate connections once, while loading
+            for (int c=0; c<outConnections.size (); c++) {
+                outConnections [c].UpdateDuplicateConnections ();
             }
         }
 
         /*!
             \brief Builds a list of all slots and their connections for the given object.
             \param[in]  inObject        The object
+            \param[in]  inGraph         A connection snapshot that contains \p inObject, see AddObjectToConnectionGraph
+            \param[in]  ioTable         Interns all object and method records
             \param[out] outConnections  Contains all the object's slots and their connections
         */
-        void BuildSlotData (const QObject* inObject, QVector <ConnectionData>& outConnections) {
+        void BuildSlotData (const QObject* inObject, const ConnectionGraph& inGraph, MethodTable& ioTable, QVector <ConnectionData>& outConnections) {
             outConnections.clear ();
             if (!inObject) {
                 return;
@@ -244,92 +210,147 @@ namespace conan {
             if (!metaObject) {
                 return;
             }
-            // map <signature, index>
-            QMap <QString, int> slotIndices;
-            QSet <QString> signalSignatures;
-            int slotIndex = 0;
-            // first gather all slots
-            while (metaObject) {
-                int offset = metaObject->methodOffset ();
-                int count = metaObject->methodCount ();
-                // only process those methods that are unique to the current metaObject
-                for (int m=count-1; m>=offset; m--) {
-                    QMetaMethod method = metaObject->method (m);
-                    if (method.methodType () == QMetaMethod::Signal) {
-                        signalSignatures.insert (method.signature ());
-                    }
-                    else if (method.methodType () == QMetaMethod::Slot) {
-                        MethodData methodData;
-                        methodData.mAccess = method.access ();
-                        methodData.mAddress = ObjectUtility::Address (inObject);
-                        methodData.mObject = const_cast <QObject*> (inObject);
-                        methodData.mName = ObjectUtility::Name (inObject);
-                        methodData.mClass = ObjectUtility::Class (inObject);
-                        methodData.mSignature = method.signature ();
-                        methodData.mSuperClass = metaObject->className ();
-                        methodData.mMethodType = method.methodType ();
-                        // store
-                        outConnections.push_back (ConnectionData (methodData));
-                        slotIndices [method.signature ()] = slotIndex++;
+            const MetaObjectInfo& info = MetaObjectCache::Get (metaObject);
+            ObjectRecordPtr objectRecord = ioTable.Object (inObject);
+            // first gather all slots, in the row order of the cached method table
+            foreach (int m, info.SlotMethods ()) {
+                outConnections.push_back (ConnectionData (MethodData (objectRecord, ioTable.Method (metaObject, m))));
+            }
+
+            // process all connections where this object is the receiver
+            foreach (int e, inGraph.IncomingEdges (inObject)) {
+                const ConnectionEdge& edge = inGraph.Edge (e);
+
+                // locate existing connection data for the slot
+                int connectionIndex = info.SlotRow (edge.mMethodIndex);
+                if (connectionIndex < 0) {
+                    // its probably a signal->signal connection
+                    if (info.SignalRow (edge.mMethodIndex) < 0) {
+                        // this should never happen
+                        qDebug () << "Found a slot with index" << edge.mMethodIndex << "that could not be matched to any QMetaMethod.";
+                        Q_ASSERT (false);
                     }
+                    continue;
                 }
-                metaObject = metaObject->superClass ();
+
+                const QMetaObject *senderMetaObject = edge.mSender->metaObject ();
+                MethodData signalData (ioTable.Object (edge.mSender),
+                                       ioTable.Method (senderMetaObject, edge.mSignalIndex),
+                                       edge.mConnectionType);
+                // store, note that duplicate connections result in multiple edges
+                outConnections [connectionIndex].mConnections.push_back (signalData);
+            }
+            // count duplicate connections once, while loading
+            for (int c=0; c<outConnections.size (); c++) {
+                outConnections [c].UpdateDuplicateConnections ();
             }
+        }
 
-            try {
-                if (QObjectPrivate* object_p = QObjectPrivate::get (const_cast <QObject*> (inObject))) {
+        //! \brief The signature of the signal and slot begin callbacks, see SetSignalSpyCallbacks
+        typedef void (*BeginCallback) (QObject* inObject, int inMethodIndex, void** inArgs);
+        //! \brief The signature of the signal and slot end callbacks, see SetSignalSpyCallbacks
+        typedef void (*EndCallback) (QObject* inObject, int inMethodIndex);
 
-                    if (!object_p->senders)
-                        return;
+        /*!
+            \brief Registers the callbacks that Qt calls around every signal emission and around every slot
+            invoked by a direct connection, a callback is removed when 0.
 
-                    QSet <QPair <QObject*, int> > processedConnections;  // set <sender, slotIndex>
-                    
-                    // process all incomming signals
-                    for (QObjectPrivate::Connection *s = object_p->senders; s; s = s->next) {
-                        const QMetaMethod slot = inObject->metaObject ()->method (s->method);
-
-                        // locate existing connection data for the slot
-                        if (slotIndices.find (slot.signature ()) == slotIndices.end ()) {
-                            // its probably a signal->signal connection
-                            if (signalSignatures.find (slot.signature ()) == signalSignatures.end ()) {
-                                // this should never happen
-                                qDebug () << "Found a slot with signature '" << slot.signature () << "' that could not be matched to any QMetaMethod.";
-                                Q_ASSERT (false);
-                            }
-                            continue;
-                        }
-                        int connectionIndex = slotIndices [slot.signature ()];
-
-                        if (processedConnections.contains (qMakePair (s->sender, connectionIndex)))
-                            // we already processed all connections for this sender to the slot
-                            continue;
-                        processedConnections.insert (qMakePair (s->sender, connectionIndex));
-
-                        // build the senders signal data
-                        QVector <ConnectionData> senderConnections;
-                        BuildSignalData (s->sender, senderConnections);
-
-                        // process all senders signals
-                        for (int c = 0; c < senderConnections.size (); c++) {
-                            const ConnectionData& connectionData = senderConnections [c];
-                            // process all slots of the current signal
-                            for (int s = 0; s < connectionData.mConnections.size (); s++) {
-                                MethodData connectedSlot = connectionData.mConnections[s];
-                                // does it match the current slot
-                                if (connectedSlot.mObject == inObject && connectedSlot.mSignature == slot.signature ()) {
-                                    MethodData signalData (connectionData.mMethod);
-                                    signalData.mConnectionType = connectedSlot.mConnectionType;
-                                    // store
-                                    outConnections [connectionIndex].mConnections.push_back (signalData);
-                                }
-                                // continue, because there might be duplicate connections
-                            }
-                        }
-                    }
+            All callbacks are called by the emitting thread. The method index of a signal or slot
+            is the absolute method index, as returned by QMetaObject::indexOfMethod.
+        */
+        void SetSignalSpyCallbacks (BeginCallback inSignalBegin, EndCallback inSignalEnd, BeginCallback inSlotBegin, EndCallback inSlotEnd) {
+            QSignalSpyCallbackSet callbacks;
+            callbacks.signal_begin_callback = inSignalBegin;
+            callbacks.signal_end_callback = inSignalEnd;
+            callbacks.slot_begin_callback = inSlotBegin;
+            callbacks.slot_end_callback = inSlotEnd;
+            qt_register_signal_spy_callbacks (callbacks);
+        }
+
+        /*!
+            \brief Registers the given callback as event notify callback of Qt, the previous callback is removed; none when 0.
+
+            Qt calls the callback with {receiver, event, result} before it delivers any event, in
+            the thread of the receiver. The event is delivered as usual when the callback returns
+            false.
+        */
+        void SetEventNotifyCallback (qInternalCallback inCallback) {
+            static qInternalCallback sRegistered = 0;
+            if (inCallback == sRegistered) {
+                return;
+            }
+            if (sRegistered) {
+                QInternal::unregisterCallback (QInternal::EventNotifyCallback, sRegistered);
+            }
+            if (inCallback) {
+                QInternal::registerCallback (QInternal::EventNotifyCallback, inCallback);
+            }
+            sRegistered = inCallback;
+        }
+
+        //! The method index of QObject::destroyed (QObject*), initialized at load time
+        const int kDestroyedMethodIndex = QObject::staticMetaObject.indexOfSignal ("destroyed(QObject*)");
+
+        /*!
+            \brief Records the emission of the given signal for each of its connections that will be queued, see QueuedLatencyMonitor.
+
+            Mirrors the decision of QMetaObject::activate: queued and blocking queued connections
+            are always queued, auto connections when the sender or the receiver does not live in
+            the emitting thread. Called from the signal begin callback, so the connection lists
+            are walked without the lock of the sender, see the namespace description. The signal
+            index is resolved through the per thread front cache of MetaObjectCache. The destroyed
+            signal is recorded as well, so the connections of the sender are purged before its
+            address can be reused.
+            \param[in] inSender        The sender
+            \param[in] inMethodIndex   The method index of the emitted signal
+        */
+        void RecordQueuedEmission (const QObject* inSender, int inMethodIndex) {
+            if (inMethodIndex == kDestroyedMethodIndex) {
+                // the signal is emitted regardless of its connections while a spy callback is registered
+                QueuedLatencyMonitor::Destroyed (inSender);
+            }
+            QObjectPrivate* object_p = QObjectPrivate::get (const_cast <QObject*> (inSender));
+            if (!object_p || !object_p->connectionLists) {
+                return;
+            }
+            int signalIndex = MetaObjectCache::Get (inSender->metaObject ()).SignalIndexOfMethod (inMethodIndex);
+            QVector <QObjectPrivate::ConnectionList>* connectionLists =
+                reinterpret_cast <QVector <QObjectPrivate::ConnectionList>*> (object_p->connectionLists);
+            if (signalIndex < 0 || signalIndex >= connectionLists->count ()) {
+                return;
+            }
+            qint64 now = Clock::Now ();
+            const QThread* currentThread = QThread::currentThread ();
+            bool senderThread = inSender->thread () == currentThread;
+            for (const QObjectPrivate::Connection* c = connectionLists->at (signalIndex).first; c; c = c->nextConnectionList) {
+                if (!c->receiver) {
+                    continue;
+                }
+                bool queued = c->connectionType == Qt::QueuedConnection || c->connectionType == Qt::BlockingQueuedConnection ||
+                    (c->connectionType == Qt::AutoConnection && (!senderThread || c->receiver->thread () != currentThread));
+                if (queued) {
+                    // keyed by the method index, as QMetaCallEvent::signalId on the receiving side
+                    QueuedLatencyMonitor::Posted (QueuedLatencyMonitor::ConnectionKey (inSender, inMethodIndex, c->receiver, c->method), now);
                 }
             }
-            catch (...) {
-                qDebug () << "Unable to process slot connections for object" << ObjectUtility::QualifiedName (inObject) << ObjectUtility::Address (inObject);
+        }
+
+        /*!
+            \brief Records the delivery of the given event when it invokes a queued slot, see QueuedLatencyMonitor.
+
+            Invocations through QMetaObject::invokeMethod have no sender and are ignored. The sender
+            of the event is never dereferenced, as it may have been destroyed since the emission.
+            \param[in] inReceiver  The receiver of the event
+            \param[in] inEvent     The event that is about to be delivered
+        */
+        void RecordQueuedDelivery (const QObject* inReceiver, const QEvent* inEvent) {
+            if (inEvent->type () != QEvent::MetaCall) {
+                return;
+            }
+            const QMetaCallEvent* metaCall = static_cast <const QMetaCallEvent*> (inEvent);
+            if (metaCall->sender ()) {
+                // the signal id is the method index of the signal
+                QueuedLatencyMonitor::Delivered (QueuedLatencyMonitor::ConnectionKey (metaCall->sender (), metaCall->signalId (), inReceiver, metaCall->id ()));
             }
         }
     } // namespace priv
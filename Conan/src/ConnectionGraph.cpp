@@ -0,0 +1,238 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains ConnectionGraph related definitions
+*/
+
+
+#include "ConnectionGraph.h"
+#include <QtCore/QObject>
+
+
+namespace conan {
+
+    namespace /*unnamed*/ {
+        /*!
+            \brief Removes the given edges from the edge indices of the given object in a single pass, keeping the order of the others.
+        */
+        void RemoveEdgeIndices (QHash <const QObject*, QVector <int> >& ioIndices, const QObject* inObject, const QSet <int>& inEdges) {
+            QHash <const QObject*, QVector <int> >::iterator edges = ioIndices.find (inObject);
+            if (edges == ioIndices.end ()) {
+                return;
+            }
+            int kept = 0;
+            for (int i=0; i<edges->size (); ++i) {
+                int e = edges->at (i);
+                if (!inEdges.contains (e)) {
+                    (*edges) [kept++] = e;
+                }
+            }
+            edges->resize (kept);
+        }
+    } // unnamed namespace
+
+
+    ConnectionEdge::ConnectionEdge () :
+        mSender (0),
+        mSignalIndex (-1),
+        mReceiver (0),
+        mMethodIndex (-1),
+        mConnectionType (Qt::AutoConnection)
+    {}
+
+    ConnectionEdge::ConnectionEdge (const QObject* inSender, int inSignalIndex, const QObject* inReceiver, int inMethodIndex, uint inConnectionType) :
+        mSender (inSender),
+        mSignalIndex (inSignalIndex),
+        mReceiver (inReceiver),
+        mMethodIndex (inMethodIndex),
+        mConnectionType (inConnectionType)
+    {}
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Creates an empty snapshot.
+    */
+    ConnectionGraph::ConnectionGraph ()
+    {}
+
+    /*!
+        \brief Returns true when the connection lists of the given sender have already been walked.
+
+        Returns false when the walked sender has been destroyed since.
+    */
+    bool ConnectionGraph::ContainsSender (const QObject* inSender) const {
+        return mSenders.contains (inSender) && !IsDestroyed (inSender);
+    }
+
+    /*!
+        \brief Marks the connection lists of the given sender as walked.
+
+        The connections of a destroyed object at the same address are removed first.
+    */
+    void ConnectionGraph::AddSender (const QObject* inSender) {
+        if (IsDestroyed (inSender)) {
+            RemoveObject (inSender);
+        }
+        mSenders.insert (inSender);
+        Guard (inSender);
+    }
+
+    /*!
+        \brief Adds a single connection and indexes it by both its sender and its receiver.
+
+        The connections of a destroyed receiver at the same address are removed first.
+    */
+    void ConnectionGraph::AddEdge (const ConnectionEdge& inEdge) {
+        if (IsDestroyed (inEdge.mReceiver)) {
+            RemoveObject (inEdge.mReceiver);
+        }
+        Guard (inEdge.mSender);
+        Guard (inEdge.mReceiver);
+        int index = mEdges.size ();
+        mEdges.push_back (inEdge);
+        mOutgoing [inEdge.mSender].push_back (index);
+        mIncoming [inEdge.mReceiver].push_back (index);
+    }
+
+    /*!
+        \brief Removes all connections of the given object, its connection lists are walked again when it is added as sender.
+
+        The edge indices of each object it is connected with are rebuilt once, so removing an
+        object with many connections takes time linear in the number of affected edges.
+    */
+    void ConnectionGraph::RemoveObject (const QObject* inObject) {
+        QVector <int> outgoing = mOutgoing.take (inObject);
+        QVector <int> incoming = mIncoming.take (inObject);
+        QSet <int> removed;
+        removed.reserve (outgoing.size () + incoming.size ());
+        QSet <const QObject*> receivers;
+        QSet <const QObject*> senders;
+        foreach (int e, outgoing) {
+            removed.insert (e);
+            receivers.insert (mEdges [e].mReceiver);
+        }
+        foreach (int e, incoming) {
+            removed.insert (e);
+            senders.insert (mEdges [e].mSender);
+        }
+        foreach (const QObject* receiver, receivers) {
+            RemoveEdgeIndices (mIncoming, receiver, removed);
+        }
+        foreach (const QObject* sender, senders) {
+            RemoveEdgeIndices (mOutgoing, sender, removed);
+        }
+        mSenders.remove (inObject);
+        mGuards.remove (inObject);
+    }
+
+    /*!
+        \brief Removes the given object, or the objects it is connected with, when they were destroyed after they were added.
+
+        Visits only the connections of the given object, so a snapshot that is kept while events
+        are processed can be validated per object before it is read.
+    */
+    void ConnectionGraph::RemoveDestroyedObjects (const QObject* inObject) {
+        if (IsDestroyed (inObject)) {
+            RemoveObject (inObject);
+            return;
+        }
+        QSet <const QObject*> destroyed;
+        foreach (int e, mOutgoing.value (inObject)) {
+            if (IsDestroyed (mEdges [e].mReceiver)) {
+                destroyed.insert (mEdges [e].mReceiver);
+            }
+        }
+        foreach (int e, mIncoming.value (inObject)) {
+            if (IsDestroyed (mEdges [e].mSender)) {
+                destroyed.insert (mEdges [e].mSender);
+            }
+        }
+        foreach (const QObject* object, destroyed) {
+            RemoveObject (object);
+        }
+    }
+
+    /*!
+        \brief Removes all connections from the snapshot.
+    */
+    void ConnectionGraph::Clear () {
+        mEdges.clear ();
+        mOutgoing.clear ();
+        mIncoming.clear ();
+        mSenders.clear ();
+        mGuards.clear ();
+    }
+
+    /*!
+        \brief Returns true when the given object was added to the snapshot and has been destroyed since.
+
+        Also returns true when a new object was created at the address of the destroyed object.
+    */
+    bool ConnectionGraph::IsDestroyed (const QObject* inObject) const {
+        QHash <const QObject*, QPointer <QObject> >::const_iterator guard = mGuards.find (inObject);
+        return guard != mGuards.end () && guard.value ().data () != inObject;
+    }
+
+    /*!
+        \brief Guards the given object, unless it is already guarded.
+    */
+    void ConnectionGraph::Guard (const QObject* inObject) {
+        if (!mGuards.contains (inObject)) {
+            mGuards.insert (inObject, QPointer <QObject> (const_cast <QObject*> (inObject)));
+        }
+    }
+
+    /*!
+        \brief Returns the number of connections that were added to the snapshot, including those of removed objects.
+    */
+    int ConnectionGraph::EdgeCount () const {
+        return mEdges.size ();
+    }
+
+    /*!
+        \brief Returns the connection at the given index.
+        Performs no range checking!
+    */
+    const ConnectionEdge& ConnectionGraph::Edge (int inIndex) const {
+        return mEdges [inIndex];
+    }
+
+    /*!
+        \brief Returns the indices of all connections where the given object is the sender.
+    */
+    QVector <int> ConnectionGraph::OutgoingEdges (const QObject* inSender) const {
+        return mOutgoing.value (inSender);
+    }
+
+    /*!
+        \brief Returns the indices of all connections where the given object is the receiver.
+
+        Only connections from senders that have been added to the snapshot are returned.
+    */
+    QVector <int> ConnectionGraph::IncomingEdges (const QObject* inReceiver) const {
+        return mIncoming.value (inReceiver);
+    }
+
+} // namespace conan
@@ -0,0 +1,104 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains ConnectionGraph related declarations
+*/
+
+
+#ifndef _CONNECTIONGRAPH__17_10_26__10_12_31__H_
+#define _CONNECTIONGRAPH__17_10_26__10_12_31__H_
+
+
+#include "ConanDefines.h"
+#include <QtCore/QHash>
+#include <QtCore/QPointer>
+#include <QtCore/QSet>
+#include <QtCore/QVector>
+
+
+class QObject;
+
+
+namespace conan {
+
+    //! \brief Represents a single signal/slot connection between two objects
+    struct CONAN_LOCAL ConnectionEdge {
+        ConnectionEdge ();
+        ConnectionEdge (const QObject* inSender, int inSignalIndex, const QObject* inReceiver, int inMethodIndex, uint inConnectionType);
+
+        const QObject* mSender;     //!< The object that emits the signal
+        int mSignalIndex;           //!< The method index of the signal, relative to the sender's meta object
+        const QObject* mReceiver;   //!< The object that receives the signal
+        int mMethodIndex;           //!< The method index of the slot or signal, relative to the receiver's meta object
+        uint mConnectionType;       //!< auto, direct, queued, blocking
+    };
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief A snapshot of the signal/slot connections between objects.
+
+        The connection lists of each sender are walked at most once. Every connection found is
+        stored as a single ConnectionEdge that is indexed both by its sender and by its receiver,
+        so the signals and the slots of any object in the snapshot can be read without rescanning
+        other objects. Use priv::AddObjectToConnectionGraph to populate the snapshot.
+
+        Note that a snapshot is not updated when connections are made or broken, nor when objects
+        are destroyed. It should be built, used and discarded in one go. A snapshot that is kept
+        while events are processed must call RemoveDestroyedObjects before it reads the
+        connections of an object: every object in the snapshot is guarded, so objects that were
+        destroyed, or whose address was reused by a new object, are detected and removed.
+    */
+    class CONAN_LOCAL ConnectionGraph {
+    public:
+        ConnectionGraph ();
+
+        bool ContainsSender (const QObject* inSender) const;
+        void AddSender (const QObject* inSender);
+        void AddEdge (const ConnectionEdge& inEdge);
+        void RemoveObject (const QObject* inObject);
+        void RemoveDestroyedObjects (const QObject* inObject);
+        void Clear ();
+
+        bool IsDestroyed (const QObject* inObject) const;
+
+        int EdgeCount () const;
+        const ConnectionEdge& Edge (int inIndex) const;
+        QVector <int> OutgoingEdges (const QObject* inSender) const;
+        QVector <int> IncomingEdges (const QObject* inReceiver) const;
+
+    private:
+        void Guard (const QObject* inObject);
+
+        QVector <ConnectionEdge> mEdges;                        //!< All connections in the snapshot, including those of removed objects
+        QHash <const QObject*, QVector <int> > mOutgoing;       //!< map <sender, indices into mEdges>
+        QHash <const QObject*, QVector <int> > mIncoming;       //!< map <receiver, indices into mEdges>
+        QSet <const QObject*> mSenders;                         //!< Senders whose connection lists have been walked
+        QHash <const QObject*, QPointer <QObject> > mGuards;    //!< map <object, guard> for every sender and receiver
+    };
+
+} // namespace conan
+
+
+#endif //_CONNECTIONGRAPH__17_10_26__10_12_31__H_
@@ -26,7 +26,9 @@
 
 #include "ConnectionModel.h"
 #include "ObjectUtility.h"
+#include "QueuedLatencyMonitor.h"
 #include "WaitCursor.h"
+#include <QtCore/QHash>
 #include <QtGui/QApplication>
 #include <QtGui/QBrush>
 #include <QtGui/QFont>
@@ -96,76 +98,189 @@ namespace conan {
 
 
     MethodData::MethodData () :
-        mObject (0),
-        mConnectionType (Qt::AutoConnection),
-        mAccess (QMetaMethod::Public)
+        mConnectionType (Qt::AutoConnection)
     {}
 
+    MethodData::MethodData (const ObjectRecordPtr& inObject, const MethodRecordPtr& inMethod, uint inConnectionType) :
+        mObjectRecord (inObject),
+        mMethodRecord (inMethod),
+        mConnectionType (inConnectionType)
+    {}
+
+    /*!
+        \brief Two methods are considered equal when they share the object, the method index and the connection type.
+    */
     bool MethodData::operator!= (const MethodData& inSource) const {
-        return mObject != inSource.mObject ||
-               mSignature != inSource.mSignature ||
-               mAddress != inSource.mAddress ||
-               mName != inSource.mName ||
-               mClass != inSource.mClass ||
-               mSuperClass != inSource.mSuperClass ||
-               mConnectionType != inSource.mConnectionType ||
-               mAccess != inSource.mAccess ||
-               mMethodType != inSource.mMethodType;
+        return ObjectKey () != inSource.ObjectKey () ||
+               MethodIndex () != inSource.MethodIndex () ||
+               mConnectionType != inSource.mConnectionType;
     }
 
     bool MethodData::operator== (const MethodData& inSource) const {
         return !(*this != inSource);
     }
 
+    /*!
+        \brief Returns the object that owns the method, or 0 when it has been destroyed.
+    */
+    QObject* MethodData::Object () const {
+        return mObjectRecord ? mObjectRecord->mObject.data () : 0;
+    }
+
+    /*!
+        \brief Returns the address of the object that owns the method, it remains valid after the object has been destroyed.
+    */
+    const void* MethodData::ObjectKey () const {
+        return mObjectRecord ? mObjectRecord->mKey : 0;
+    }
+
+    /*!
+        \brief Returns the signal or slot method signature.
+    */
+    QString MethodData::Signature () const {
+        return mMethodRecord ? QString::fromLatin1 (mMethodRecord->mSignature) : QString ();
+    }
+
+    /*!
+        \brief Returns the address of the object that owns the method.
+    */
+    QString MethodData::Address () const {
+        return mObjectRecord ? mObjectRecord->Address () : QString ();
+    }
+
+    /*!
+        \brief Returns the object name of the object that owns the method.
+    */
+    QString MethodData::Name () const {
+        return mObjectRecord ? mObjectRecord->Name () : QString ();
+    }
+
+    /*!
+        \brief Returns the class name of the object that owns the method.
+    */
+    QString MethodData::Class () const {
+        return mObjectRecord ? mObjectRecord->Class () : QString ();
+    }
+
+    /*!
+        \brief Returns the qualified name of the object that owns the method: [class name] :: [object name]
+    */
+    QString MethodData::QualifiedName () const {
+        return mObjectRecord ? mObjectRecord->QualifiedName () : QString ();
+    }
+
+    /*!
+        \brief Returns the name of the class that declared the method.
+    */
+    QString MethodData::SuperClass () const {
+        return mMethodRecord ? QString::fromLatin1 (mMethodRecord->mSuperClass) : QString ();
+    }
+
+    /*!
+        \brief Returns the method index relative to the meta object of the object that owns the method.
+    */
+    int MethodData::MethodIndex () const {
+        return mMethodRecord ? mMethodRecord->mIndex : -1;
+    }
+
+    /*!
+        \brief Returns the method access: public, protected or private.
+    */
+    QMetaMethod::Access MethodData::Access () const {
+        return mMethodRecord ? mMethodRecord->mAccess : QMetaMethod::Public;
+    }
+
+    /*!
+        \brief Returns the method type: signal or slot.
+    */
+    QMetaMethod::MethodType MethodData::MethodType () const {
+        return mMethodRecord ? mMethodRecord->mMethodType : QMetaMethod::Method;
+    }
+
+    /*!
+        \brief Returns a hash value that is consistent with MethodData::operator==
+    */
+    uint qHash (const MethodData& inMethod) {
+        return ::qHash (inMethod.ObjectKey ()) ^ (uint (inMethod.MethodIndex ()) << 3) ^ inMethod.mConnectionType;
+    }
+
 
     // ------------------------------------------------------------------------------------------------
 
-    ConnectionData::ConnectionData ()
+    ConnectionData::ConnectionData () :
+        mContainsDuplicates (false)
     {}
 
     ConnectionData::ConnectionData (const MethodData& inMethod) :
-        mMethod (inMethod)
+        mMethod (inMethod),
+        mContainsDuplicates (false)
     {}
 
-    bool ConnectionData::ContainsDuplicateConnections () const {
+    /*!
+        \brief Counts the identical connections of each connected method.
+
+        Must be called whenever mConnections changes. All connections are hashed once, so this
+        is linear in the number of connections.
+    */
+    void ConnectionData::UpdateDuplicateConnections () {
+        mConnectionCounts.fill (1, mConnections.size ());
+        mContainsDuplicates = false;
         if (mConnections.size () < 2) {
-            return false;
+            return;
         }
+        QHash <MethodData, int> counts;
+        counts.reserve (mConnections.size ());
         foreach (const MethodData& data, mConnections) {
-            if (1 < CountConnections (data)) {
-                return true;
-            }
+            ++counts [data];
         }
-        return false;
+        if (counts.size () == mConnections.size ()) {
+            return;
+        }
+        mContainsDuplicates = true;
+        int connectionCount = mConnections.size ();
+        for (int c=0; c<connectionCount; c++) {
+            mConnectionCounts [c] = counts.value (mConnections [c]);
+        }
+    }
+
+    /*!
+        \brief Returns true when at least one method is connected more than once, see UpdateDuplicateConnections.
+    */
+    bool ConnectionData::ContainsDuplicateConnections () const {
+        return mContainsDuplicates;
     }
 
-    int ConnectionData::CountConnections (const MethodData& inMethod) const {
-        int count = 0;
-        qCount (mConnections, inMethod, count);
-        return count;
+    /*!
+        \brief Returns the number of connections identical to the connection at the given index, see UpdateDuplicateConnections.
+    */
+    int ConnectionData::CountConnections (int inConnection) const {
+        if (inConnection < 0 || inConnection >= mConnectionCounts.size ()) {
+            return 1;
+        }
+        return mConnectionCounts [inConnection];
     }
 
     /*!
         \brief Exports the connection data to XML.
     */
     void ConnectionData::ExportToXML (QXmlStreamWriter& inWriter) const {
-        inWriter.writeStartElement (MethodTypeToString(mMethod.mMethodType));
-        inWriter.writeAttribute ("signature", mMethod.mSignature);
-        inWriter.writeAttribute ("access", MethodAccessToString(mMethod.mAccess));
-        inWriter.writeAttribute ("declaredBy", mMethod.mSuperClass);
+        inWriter.writeStartElement (MethodTypeToString(mMethod.MethodType ()));
+        inWriter.writeAttribute ("signature", mMethod.Signature ());
+        inWriter.writeAttribute ("access", MethodAccessToString(mMethod.Access ()));
+        inWriter.writeAttribute ("declaredBy", mMethod.SuperClass ());
 
         size_t connectionCount = mConnections.size ();
         for (size_t c=0; c<connectionCount; c++) {
             const MethodData& connection = mConnections [c];
             inWriter.writeStartElement ("connection");
-            inWriter.writeAttribute ("methodType", MethodTypeToString(connection.mMethodType));
-            inWriter.writeAttribute ("signature", connection.mSignature);
-            inWriter.writeAttribute ("objectClass", connection.mClass);
-            inWriter.writeAttribute ("objectName", connection.mName);
-            inWriter.writeAttribute ("objectAddress", connection.mAddress);
+            inWriter.writeAttribute ("methodType", MethodTypeToString(connection.MethodType ()));
+            inWriter.writeAttribute ("signature", connection.Signature ());
+            inWriter.writeAttribute ("objectClass", connection.Class ());
+            inWriter.writeAttribute ("objectName", connection.Name ());
+            inWriter.writeAttribute ("objectAddress", connection.Address ());
             inWriter.writeAttribute ("connectionType", ConnectionTypeToString(connection.mConnectionType));
-            inWriter.writeAttribute ("access", MethodAccessToString(connection.mAccess));
-            inWriter.writeAttribute ("declaredBy", connection.mSuperClass);
+            inWriter.writeAttribute ("access", MethodAccessToString(connection.Access ()));
+            inWriter.writeAttribute ("declaredBy", connection.SuperClass ());
             inWriter.writeEndElement ();
         }
         inWriter.writeEndElement ();
@@ -175,7 +290,7 @@ namespace conan {
     // ------------------------------------------------------------------------------------------------
 
 
-    ConnectionModel::ConnectionModel (QObject* inParent) : QAbstractItemModel (inParent) {
+    ConnectionModel::ConnectionModel (QObject* inParent) : QAbstractItemModel (inParent), mLatencyMonitor (0) {
         setObjectName ("ConnectionModel");
     }
 
@@ -187,6 +302,27 @@ namespace conan {
         reset ();
     }
 
+    /*!
+        \brief Sets the monitor that provides the latency column, none when 0.
+    */
+    void ConnectionModel::SetLatencyMonitor (const QueuedLatencyMonitor* inMonitor) {
+        mLatencyMonitor = inMonitor;
+        RefreshLatencies ();
+    }
+
+    /*!
+        \brief Notifies the views that the latency of all connected methods may have changed.
+    */
+    void ConnectionModel::RefreshLatencies () {
+        for (int c=0; c<mConnections.size (); c++) {
+            int count = mConnections [c].mConnections.size ();
+            if (count) {
+                QModelIndex parentIndex = index (c, 0);
+                emit dataChanged (index (0, kLatency, parentIndex), index (count-1, kLatency, parentIndex));
+            }
+        }
+    }
+
     /*!
         \brief Disconnects the specified method.
         If the index corresponds to ConnectionData, al its children will be diconnected.
@@ -198,30 +334,31 @@ namespace conan {
         }
         else if (const ConnectionData* connectionData = GetConnectionData (inIndex)) {
             // disconnect all recievers from current signal
-            if (connectionData->mMethod.mMethodType == QMetaMethod::Signal) {
+            if (connectionData->mMethod.MethodType () == QMetaMethod::Signal) {
                 bool confirmed = true;
                 emit SignalRequestConfirmation (
                     "Disconnect", 
                     QString("Are you sure you want to disconnect" 
                             "\n\n<sender>   %1\n<signal>     %2"
                             "\n\nfrom all receivers?")
-                            .arg (conan::ObjectUtility::QualifiedName(connectionData->mMethod.mObject))
-                            .arg (connectionData->mMethod.mSignature),
+                            .arg (connectionData->mMethod.QualifiedName ())
+                            .arg (connectionData->mMethod.Signature ()),
                     confirmed);
 
                 if (confirmed) {
                     WaitCursor wc;
                     beginRemoveRows (inIndex, 0, connectionData->mConnections.size () - 1);
                     // disconnect
-                    disconnect (connectionData->mMethod.mObject,
-                                TO_SIGNAL(connectionData->mMethod.mSignature),
+                    disconnect (connectionData->mMethod.Object (),
+                                TO_SIGNAL(connectionData->mMethod.Signature ()),
                                 0, 0);
                     // update model
                     mConnections [inIndex.row ()].mConnections.clear ();
+                    mConnections [inIndex.row ()].UpdateDuplicateConnections ();
                     endRemoveRows ();
                 }
             }
-            else if (connectionData->mMethod.mMethodType == QMetaMethod::Slot) {
+            else if (connectionData->mMethod.MethodType () == QMetaMethod::Slot) {
                 // disconnect all signals from current slot
                 bool confirmed = true;
                 emit SignalRequestConfirmation (
@@ -229,8 +366,8 @@ namespace conan {
                     QString("Are you sure you want to disconnect" 
                             "\n\n<receiver>   %1\n<method>    %2"
                             "\n\nfrom all senders?")
-                            .arg (conan::ObjectUtility::QualifiedName(connectionData->mMethod.mObject))
-                            .arg (connectionData->mMethod.mSignature),
+                            .arg (connectionData->mMethod.QualifiedName ())
+                            .arg (connectionData->mMethod.Signature ()),
                     confirmed);
 
                 if (confirmed) {
@@ -238,13 +375,14 @@ namespace conan {
                     beginRemoveRows (inIndex, 0, connectionData->mConnections.size () - 1);
                     // disconnect
                     foreach (const MethodData& methodData, connectionData->mConnections) {
-                        disconnect (methodData.mObject,
-                                    TO_SIGNAL(methodData.mSignature),
-                                    connectionData->mMethod.mObject,
-                                    TO_SLOT (connectionData->mMethod.mSignature));
+                        disconnect (methodData.Object (),
+                                    TO_SIGNAL(methodData.Signature ()),
+                                    connectionData->mMethod.Object (),
+                                    TO_SLOT (connectionData->mMethod.Signature ()));
                     }
                     // update model
                     mConnections [inIndex.row ()].mConnections.clear ();
+                    mConnections [inIndex.row ()].UpdateDuplicateConnections ();
                     endRemoveRows ();
                 }
             }
@@ -260,11 +398,11 @@ namespace conan {
             const MethodData* receiverData = 0;
 
             // determine sender and receiver
-            if (methodData->mMethodType == QMetaMethod::Signal) {
+            if (methodData->MethodType () == QMetaMethod::Signal) {
                 senderData = methodData;
                 receiverData = &connectionData->mMethod;
             }
-            else if (methodData->mMethodType == QMetaMethod::Slot) {
+            else if (methodData->MethodType () == QMetaMethod::Slot) {
                 senderData = &connectionData->mMethod;
                 receiverData = methodData;
             }
@@ -275,26 +413,33 @@ namespace conan {
                             "\n\n<sender>   %1\n<signal>     %2"
                             "\n\nfrom"
                             "\n\n<receiver>   %3\n<method>    %4")
-                            .arg (conan::ObjectUtility::QualifiedName(senderData->mObject))
-                            .arg (senderData->mSignature)
-                            .arg (conan::ObjectUtility::QualifiedName(receiverData->mObject))
-                            .arg (receiverData->mSignature),
+                            .arg (senderData->QualifiedName ())
+                            .arg (senderData->Signature ())
+                            .arg (receiverData->QualifiedName ())
+                            .arg (receiverData->Signature ()),
                     confirmed);
 
             if (confirmed) {
                 WaitCursor wc;
                 beginRemoveRows (parent, inIndex.row (), inIndex.row ());
                 // disconnect
-                disconnect (senderData->mObject,
-                            TO_SIGNAL(senderData->mSignature),
-                            receiverData->mObject,
-                            receiverData->mMethodType == QMetaMethod::Slot
-                                ? TO_SLOT(receiverData->mSignature)
-                                : TO_SIGNAL(receiverData->mSignature));
+                disconnect (senderData->Object (),
+                            TO_SIGNAL(senderData->Signature ()),
+                            receiverData->Object (),
+                            receiverData->MethodType () == QMetaMethod::Slot
+                                ? TO_SLOT(receiverData->Signature ())
+                                : TO_SIGNAL(receiverData->Signature ()));
                                 
                 // update model
-                mConnections [parent.row ()].mConnections.remove (inIndex.row ());
+                ConnectionData& parentData = mConnections [parent.row ()];
+                parentData.mConnections.remove (inIndex.row ());
+                parentData.UpdateDuplicateConnections ();
                 endRemoveRows ();
+                // the remaining connections may no longer be duplicates
+                emit dataChanged (parent.sibling (parent.row (), 0), parent.sibling (parent.row (), kColumnCount - 1));
+                if (!parentData.mConnections.isEmpty ()) {
+                    emit dataChanged (index (0, 0, parent), index (parentData.mConnections.size () - 1, kColumnCount - 1, parent));
+                }
             }
         }
     }
@@ -341,25 +486,25 @@ namespace conan {
         if (inRole == Qt::DisplayRole || inRole == Qt::EditRole) {
             if (column == kSignature) {
                 if (const MethodData* methodData = GetMethodData (inIndex)) {
-                    return methodData->mSignature;
+                    return methodData->Signature ();
                 }
                 else if (const ConnectionData* connectionData = GetConnectionData (inIndex)) {
-                    return connectionData->mMethod.mSignature;
+                    return connectionData->mMethod.Signature ();
                 }
             }
             else if (column == kObject) {
                 if (const MethodData* methodData = GetMethodData (inIndex)) {
-                    return ObjectUtility::QualifiedName (methodData->mClass, methodData->mName);
+                    return methodData->QualifiedName ();
                 }
             }
             else if (column == kAddress) {
                 if (const MethodData* methodData = GetMethodData (inIndex)) {
-                    return methodData->mAddress;
+                    return methodData->Address ();
                 }
             }
             else if (column == kSuperClass) {
                 if (const ConnectionData* connectionData = GetConnectionData (inIndex)) {
-                    return connectionData->mMethod.mSuperClass;
+                    return connectionData->mMethod.SuperClass ();
                 }
             }
             else if (column == kConnectionType) {
@@ -367,6 +512,12 @@ namespace conan {
                     return ConnectionTypeToString (methodData->mConnectionType);
                 }
             }
+            else if (column == kLatency) {
+                QueuedLatency latency;
+                if (Latency (inIndex, latency)) {
+                    return latency.ToString ();
+                }
+            }
         }
         else if (inRole == Qt::BackgroundRole) {
             if (column != kAccess) {
@@ -378,26 +529,35 @@ namespace conan {
         else if (inRole == Qt::ToolTipRole) {
             const MethodData* methodData = GetMethodData (inIndex);
             const ConnectionData* connectionData = GetConnectionData (inIndex);
+            QueuedLatency latency;
 
             if (column == kAccess) {
                 QMetaMethod::Access access = QMetaMethod::Public;
                 if (methodData && GetConnectionData (inIndex.parent ())) {
-                    access = methodData->mAccess;
+                    access = methodData->Access ();
                 }
                 else if (connectionData) {
-                    access = connectionData->mMethod.mAccess;
+                    access = connectionData->mMethod.Access ();
                 }
                 return MethodAccessToString (access);
             }
+            else if (column == kLatency && Latency (inIndex, latency)) {
+                return latency.Details ();
+            }
             else if (ContainsDuplicateConnections (inIndex)) {
+                if (methodData && !connectionData) {
+                    if (const ConnectionData* parentData = GetConnectionData (inIndex.parent ())) {
+                        return QString ("Duplicate connections (%1)").arg (parentData->CountConnections (inIndex.row ()));
+                    }
+                }
                 return QString ("Duplicate connections");
             }
             else {
                 if (methodData) {
-                    return methodData->mSignature;
+                    return methodData->Signature ();
                 }
                 if (connectionData) {
-                    return connectionData->mMethod.mSignature;
+                    return connectionData->mMethod.Signature ();
                 }
             }
         }
@@ -405,7 +565,7 @@ namespace conan {
             if (column == kAccess) {
                 QMetaMethod::Access access = QMetaMethod::Public;
                 if (const ConnectionData* connectionData = GetConnectionData (inIndex)) {
-                    access = connectionData->mMethod.mAccess;
+                    access = connectionData->mMethod.Access ();
                 }
                 if (access == QMetaMethod::Protected) {
                     return QPixmap (":/icons/conan/key");
@@ -439,6 +599,8 @@ namespace conan {
                     return QString ("Connection");
                 case kAccess:
                     return QString ("");
+                case kLatency:
+                    return QString ("Latency");
             }
         }
         return QVariant();
@@ -506,11 +668,11 @@ namespace conan {
     */
     bool ConnectionModel::IsSignal (const QModelIndex& inIndex) const {
         if (const ConnectionData* connectionData = GetConnectionData (inIndex)) {
-            return connectionData->mMethod.mMethodType == QMetaMethod::Signal;
+            return connectionData->mMethod.MethodType () == QMetaMethod::Signal;
         }
         if (GetConnectionData (inIndex.parent ())) {
             if (const MethodData* methodData = GetMethodData (inIndex)) {
-                return methodData->mMethodType == QMetaMethod::Signal;
+                return methodData->MethodType () == QMetaMethod::Signal;
             }
         }
         return false;
@@ -526,9 +688,7 @@ namespace conan {
             return connectionData->ContainsDuplicateConnections ();
         }
         if (const ConnectionData* connectionData = GetConnectionData (inIndex.parent ())) {
-            if (const MethodData* methodData = GetMethodData (inIndex)) {
-                return 1 < connectionData->CountConnections (*methodData);
-            }
+            return 1 < connectionData->CountConnections (inIndex.row ());
         }
         return false;
     }
@@ -549,6 +709,25 @@ namespace conan {
         return -1;
     }
 
+    /*!
+        \brief Retrieves the delivery latency of the queued connection that corresponds to the given index.
+        \param[in]  inIndex     The model index of a connected method
+        \param[out] outLatency  The latency of the connection
+        \return                 Returns true when deliveries of the connection were measured; otherwise false.
+    */
+    bool ConnectionModel::Latency (const QModelIndex& inIndex, QueuedLatency& outLatency) const {
+        const MethodData* methodData = GetMethodData (inIndex);
+        const ConnectionData* parentData = GetConnectionData (inIndex.parent ());
+        if (!mLatencyMonitor || !methodData || !parentData) {
+            return false;
+        }
+        // the parent is the signal in the signal view and the slot in the slot view
+        bool parentIsSender = parentData->mMethod.MethodType () == QMetaMethod::Signal;
+        const MethodData& sender = parentIsSender ? parentData->mMethod : *methodData;
+        const MethodData& receiver = parentIsSender ? *methodData : parentData->mMethod;
+        return mLatencyMonitor->Latency (sender.ObjectKey (), sender.MethodIndex (), receiver.ObjectKey (), receiver.MethodIndex (), outLatency);
+    }
+
 
     // ------------------------------------------------------------------------------------------------
 
@@ -605,16 +784,16 @@ namespace conan {
                 QMetaMethod::Access leftAccess = QMetaMethod::Public;
                 QMetaMethod::Access rightAccess = QMetaMethod::Public;
                 if (const ConnectionData* leftConnection = model->GetConnectionData (inLeft)) {
-                    leftAccess = leftConnection->mMethod.mAccess;
+                    leftAccess = leftConnection->mMethod.Access ();
                 }
                 else if (const MethodData* leftMethod = model->GetMethodData (inLeft)) {
-                    leftAccess = leftMethod->mAccess;
+                    leftAccess = leftMethod->Access ();
                 }
                 if (const ConnectionData* rightConnection = model->GetConnectionData (inRight)) {
-                    rightAccess = rightConnection->mMethod.mAccess;
+                    rightAccess = rightConnection->mMethod.Access ();
                 }
                 else if (const MethodData* rightMethod = model->GetMethodData (inRight)) {
-                    rightAccess = rightMethod->mAccess;
+                    rightAccess = rightMethod->Access ();
                 }
                 if (leftAccess == rightAccess) {
                     QList <int> sortOrder;
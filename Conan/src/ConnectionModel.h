@@ -29,9 +29,9 @@
 
 
 #include "ConanDefines.h"
+#include "MethodTable.h"
 #include <QtCore/QAbstractItemModel>
 #include <QtCore/QMetaMethod>
-#include <QtCore/QPointer>
 #include <QtCore/QVector>
 #include <QtGui/QSortFilterProxyModel>
 
@@ -40,6 +40,8 @@ class QXmlStreamWriter;
 
 
 namespace conan {
+    class QueuedLatencyMonitor;
+    struct QueuedLatency;
 
     QString MethodAccessToString (QMetaMethod::Access inAccess);
     QString ConnectionTypeToString (uint inConnectionType);
@@ -47,24 +49,39 @@ namespace conan {
     // ------------------------------------------------------------------------------------------------
 
 
-    //! \brief Represents a single signal or slot
+    /*!
+        \brief Represents a single signal or slot
+
+        All object and method information is shared through interned records, see MethodTable.
+        A MethodData is therefore only a small tuple of two record references and a connection
+        type. Strings are formatted on request.
+    */
     struct CONAN_LOCAL MethodData {
         MethodData ();
+        MethodData (const ObjectRecordPtr& inObject, const MethodRecordPtr& inMethod, uint inConnectionType = Qt::AutoConnection);
 
         bool operator!= (const MethodData& inSource) const;
         bool operator== (const MethodData& inSource) const;
 
-        QPointer <QObject> mObject;             //!< The wrapped QObject, or 0 when it has been destroyed
-        QString mSignature;                     //!< signal or slot method signature
-        QString mAddress;                       //!< The address of mObject
-        QString mName;                          //!< The object name of mObject
-        QString mClass;                         //!< The class name of mObject
-        QString mSuperClass;                    //!< class that declared the method
+        QObject* Object () const;
+        const void* ObjectKey () const;
+        QString Signature () const;
+        QString Address () const;
+        QString Name () const;
+        QString Class () const;
+        QString QualifiedName () const;
+        QString SuperClass () const;
+        int MethodIndex () const;
+        QMetaMethod::Access Access () const;
+        QMetaMethod::MethodType MethodType () const;
+
+        ObjectRecordPtr mObjectRecord;          //!< The object that owns the method
+        MethodRecordPtr mMethodRecord;          //!< The signal or slot
         uint mConnectionType;                   //!< auto, direct, queued, blocking
-        QMetaMethod::Access mAccess;            //!< public, protected, private
-        QMetaMethod::MethodType mMethodType;    //!< signal, slot
     };
 
+    uint qHash (const MethodData& inMethod);
+
     // ------------------------------------------------------------------------------------------------
 
     //! \brief Represents a signal or slot and all connected methods
@@ -72,13 +89,16 @@ namespace conan {
         ConnectionData ();
         ConnectionData (const MethodData& inMethod);
 
+        void UpdateDuplicateConnections ();
         bool ContainsDuplicateConnections () const;
-        int CountConnections (const MethodData& inMethod) const;
+        int CountConnections (int inConnection) const;
 
         void ExportToXML (QXmlStreamWriter& inWriter) const;
 
         MethodData mMethod;                 //!< Signal or slot data
         QVector <MethodData> mConnections;  //!< All connected methods
+        QVector <int> mConnectionCounts;    //!< The number of identical connections for each entry in mConnections
+        bool mContainsDuplicates;           //!< True when at least one entry in mConnections occurs more than once
     };
 
 
@@ -103,6 +123,7 @@ namespace conan {
             kConnectionType,
             kSuperClass,
             kAccess,
+            kLatency,
             kColumnCount
         } Columns;
 
@@ -110,6 +131,8 @@ namespace conan {
         ConnectionModel (QObject* inParent = 0);
 
         void SetData (const QVector <ConnectionData>& inConnections);
+        void SetLatencyMonitor (const QueuedLatencyMonitor* inMonitor);
+        void RefreshLatencies ();
         
         void Disconnect (const QModelIndex& inIndex);
 
@@ -130,12 +153,14 @@ namespace conan {
 
     private:
         int Row (const ConnectionData* inConnectionData) const;
+        bool Latency (const QModelIndex& inIndex, QueuedLatency& outLatency) const;
 
     signals:
         void SignalRequestConfirmation (const QString& title, const QString& message, bool& confirmed);
 
     private:
-        QVector <ConnectionData> mConnections;  //!< The source data of the model
+        QVector <ConnectionData> mConnections;          //!< The source data of the model
+        const QueuedLatencyMonitor* mLatencyMonitor;    //!< Provides the latency of queued connections, or 0
     };
 
 
@@ -0,0 +1,180 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains DuplicateConnectionModel related definitions
+*/
+
+
+#include "DuplicateConnectionModel.h"
+#include <QtCore/QSet>
+
+
+namespace conan {
+
+    DuplicateConnection::DuplicateConnection () :
+        mCount (0)
+    {}
+
+    DuplicateConnection::DuplicateConnection (const MethodData& inSignal, const MethodData& inMethod, int inCount) :
+        mSignal (inSignal),
+        mMethod (inMethod),
+        mCount (inCount)
+    {}
+
+    /*!
+        \brief Appends every connection of \p inData that has been made more than once, each only once.
+
+        The connection counts of \p inData must be up to date, see ConnectionData::UpdateDuplicateConnections.
+    */
+    void AppendDuplicateConnections (const ConnectionData& inData, QVector <DuplicateConnection>& ioDuplicates) {
+        if (!inData.ContainsDuplicateConnections ()) {
+            return;
+        }
+        bool isSignal = inData.mMethod.MethodType () == QMetaMethod::Signal;
+        QSet <MethodData> reported;
+        int connectionCount = inData.mConnections.size ();
+        for (int c=0; c<connectionCount; c++) {
+            int count = inData.CountConnections (c);
+            const MethodData& connection = inData.mConnections [c];
+            if (count < 2 || reported.contains (connection)) {
+                continue;
+            }
+            reported.insert (connection);
+            if (isSignal) {
+                ioDuplicates.push_back (DuplicateConnection (inData.mMethod, connection, count));
+            }
+            else {
+                // keep the connection type with the receiving method
+                MethodData method = inData.mMethod;
+                method.mConnectionType = connection.mConnectionType;
+                ioDuplicates.push_back (DuplicateConnection (connection, method, count));
+            }
+        }
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    DuplicateConnectionModel::DuplicateConnectionModel (QObject* inParent) :
+        QAbstractTableModel (inParent)
+    {
+        setObjectName ("DuplicateConnectionModel");
+    }
+
+    /*!
+        \brief Resets the model with new source data.
+    */
+    void DuplicateConnectionModel::SetData (const QVector <DuplicateConnection>& inDuplicates) {
+        mDuplicates = inDuplicates;
+        reset ();
+    }
+
+    /*!
+        \brief Returns the duplicate connection for the given index, or 0 for an invalid index.
+    */
+    const DuplicateConnection* DuplicateConnectionModel::GetDuplicate (const QModelIndex& inIndex) const {
+        if (!inIndex.isValid () || inIndex.row () >= mDuplicates.size ()) {
+            return 0;
+        }
+        return &mDuplicates [inIndex.row ()];
+    }
+
+    /*!
+        \brief Returns the number of duplicate connections.
+    */
+    int DuplicateConnectionModel::rowCount (const QModelIndex& inParent) const {
+        return inParent.isValid () ? 0 : mDuplicates.size ();
+    }
+
+    /*!
+        \brief Returns the number of columns.
+    */
+    int DuplicateConnectionModel::columnCount (const QModelIndex& /*inParent*/) const {
+        return kColumnCount;
+    }
+
+    /*!
+        \brief Returns the data stored under the given role for the duplicate connection referred to by the index.
+    */
+    QVariant DuplicateConnectionModel::data (const QModelIndex& inIndex, int inRole) const {
+        const DuplicateConnection* duplicate = GetDuplicate (inIndex);
+        if (!duplicate) {
+            return QVariant ();
+        }
+        if (inRole == Qt::DisplayRole) {
+            switch (inIndex.column ()) {
+                case kSender:
+                    return duplicate->mSignal.QualifiedName ();
+                case kSignal:
+                    return duplicate->mSignal.Signature ();
+                case kReceiver:
+                    return duplicate->mMethod.QualifiedName ();
+                case kMethod:
+                    return duplicate->mMethod.Signature ();
+                case kConnectionType:
+                    return ConnectionTypeToString (duplicate->mMethod.mConnectionType);
+                case kCount:
+                    return duplicate->mCount;
+                default:
+                    return QVariant ();
+            }
+        }
+        else if (inRole == Qt::ToolTipRole) {
+            switch (inIndex.column ()) {
+                case kSender:
+                    return duplicate->mSignal.Address ();
+                case kReceiver:
+                    return duplicate->mMethod.Address ();
+                default:
+                    return QVariant ();
+            }
+        }
+        return QVariant ();
+    }
+
+    /*!
+        \brief Returns the data for the given role and section in the header with the specified orientation.
+    */
+    QVariant DuplicateConnectionModel::headerData (int inSection, Qt::Orientation inOrientation, int inRole) const {
+        if (inOrientation == Qt::Horizontal && inRole == Qt::DisplayRole) {
+            switch (inSection) {
+                case kSender:
+                    return QString ("Sender");
+                case kSignal:
+                    return QString ("Signal");
+                case kReceiver:
+                    return QString ("Receiver");
+                case kMethod:
+                    return QString ("Method");
+                case kConnectionType:
+                    return QString ("Type");
+                case kCount:
+                    return QString ("Count");
+                default:
+                    return QVariant ();
+            }
+        }
+        return QVariant ();
+    }
+
+} // namespace conan
@@ -0,0 +1,93 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains DuplicateConnectionModel related declarations
+*/
+
+
+#ifndef _DUPLICATECONNECTIONMODEL__17_10_26__15_40_12__H_
+#define _DUPLICATECONNECTIONMODEL__17_10_26__15_40_12__H_
+
+
+#include "ConanDefines.h"
+#include "ConnectionModel.h"
+#include <QtCore/QAbstractTableModel>
+#include <QtCore/QVector>
+
+
+namespace conan {
+
+    //! \brief Represents a single connection that has been made more than once
+    struct CONAN_LOCAL DuplicateConnection {
+        DuplicateConnection ();
+        DuplicateConnection (const MethodData& inSignal, const MethodData& inMethod, int inCount);
+
+        MethodData mSignal;     //!< The sender and its signal
+        MethodData mMethod;     //!< The receiver, its slot or signal, and the connection type
+        int mCount;             //!< The number of identical connections
+    };
+
+    void AppendDuplicateConnections (const ConnectionData& inData, QVector <DuplicateConnection>& ioDuplicates);
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief A read-only table model that lists duplicate connections, one row per duplicated connection.
+
+        Numeric columns return numbers, so the model can be sorted by a QSortFilterProxyModel.
+    */
+    class CONAN_LOCAL DuplicateConnectionModel : public QAbstractTableModel
+    {
+    public:
+        //! DuplicateConnectionModel columns
+        typedef enum COLUMNS {
+            kSender,
+            kSignal,
+            kReceiver,
+            kMethod,
+            kConnectionType,
+            kCount,
+            kColumnCount
+        } Columns;
+
+    public:
+        DuplicateConnectionModel (QObject* inParent = 0);
+
+        void SetData (const QVector <DuplicateConnection>& inDuplicates);
+        const DuplicateConnection* GetDuplicate (const QModelIndex& inIndex) const;
+
+        // qt overrides
+        virtual int rowCount (const QModelIndex& inParent = QModelIndex ()) const;
+        virtual int columnCount (const QModelIndex& inParent = QModelIndex ()) const;
+        virtual QVariant data (const QModelIndex& inIndex, int inRole = Qt::DisplayRole) const;
+        virtual QVariant headerData (int inSection, Qt::Orientation inOrientation, int inRole = Qt::DisplayRole) const;
+
+    private:
+        QVector <DuplicateConnection> mDuplicates;  //!< The source data of the model
+    };
+
+} // namespace conan
+
+
+#endif //_DUPLICATECONNECTIONMODEL__17_10_26__15_40_12__H_
@@ -0,0 +1,124 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains DurationHistogram related definitions
+*/
+
+
+#include "DurationHistogram.h"
+
+
+namespace conan {
+
+    namespace /*unnamed*/ {
+        const int kMinDurationBits = 6;     //!< Durations below 2^6 ns share the first bucket
+    } // unnamed namespace
+
+    /*!
+        \brief Creates an empty histogram.
+    */
+    DurationHistogram::DurationHistogram () :
+        mCount (0)
+    {
+        for (int b=0; b<kBucketCount; ++b) {
+            mBuckets [b] = 0;
+        }
+    }
+
+    /*!
+        \brief Counts a single duration in ns, negative durations are counted as 0.
+    */
+    void DurationHistogram::Add (qint64 inDuration) {
+        ++mBuckets [Bucket (static_cast <quint64> (qMax <qint64> (inDuration, 0)))];
+        ++mCount;
+    }
+
+    /*!
+        \brief Adds all durations of the given histogram to this histogram.
+    */
+    void DurationHistogram::Merge (const DurationHistogram& inOther) {
+        for (int b=0; b<kBucketCount; ++b) {
+            mBuckets [b] += inOther.mBuckets [b];
+        }
+        mCount += inOther.mCount;
+    }
+
+    /*!
+        \brief Returns the number of durations.
+    */
+    quint64 DurationHistogram::Count () const {
+        return mCount;
+    }
+
+    /*!
+        \brief Returns the given percentile (0 - 100) of the durations in ns, or -1 when the histogram is empty.
+    */
+    qint64 DurationHistogram::Percentile (int inPercentile) const {
+        if (mCount == 0) {
+            return -1;
+        }
+        // the rank of the percentile, rounded up
+        quint64 rank = qMax <quint64> (1, (mCount * qBound (0, inPercentile, 100) + 99) / 100);
+        quint64 count = 0;
+        for (int b=0; b<kBucketCount; ++b) {
+            count += mBuckets [b];
+            if (count >= rank) {
+                return BucketDuration (b);
+            }
+        }
+        return BucketDuration (kBucketCount - 1);
+    }
+
+    /*!
+        \brief Returns the bucket of the given duration in ns.
+
+        Each power of two is split into four buckets by the two bits below the most significant bit.
+    */
+    int DurationHistogram::Bucket (quint64 inDuration) {
+        int bits = 0;
+        for (int shift=32; shift>0; shift/=2) {
+            if (inDuration >> (bits + shift)) {
+                bits += shift;
+            }
+        }
+        // bits is the index of the most significant bit
+        if (bits < kMinDurationBits) {
+            return 0;
+        }
+        int bucket = 1 + (bits - kMinDurationBits) * 4 + static_cast <int> ((inDuration >> (bits - 2)) & 3);
+        return qMin (bucket, static_cast <int> (kBucketCount) - 1);
+    }
+
+    /*!
+        \brief Returns the middle of the given bucket in ns.
+    */
+    qint64 DurationHistogram::BucketDuration (int inBucket) {
+        if (inBucket == 0) {
+            return Q_INT64_C (1) << (kMinDurationBits - 1);
+        }
+        int bits = kMinDurationBits + (inBucket - 1) / 4;
+        qint64 quarter = Q_INT64_C (1) << (bits - 2);
+        return (4 + (inBucket - 1) % 4) * quarter + quarter / 2;
+    }
+
+} // namespace conan
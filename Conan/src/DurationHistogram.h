@@ -0,0 +1,67 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains DurationHistogram related declarations
+*/
+
+
+#ifndef _DURATIONHISTOGRAM__17_10_26__20_11_37__H_
+#define _DURATIONHISTOGRAM__17_10_26__20_11_37__H_
+
+
+#include "ConanDefines.h"
+
+
+namespace conan {
+
+    /*!
+        \brief A logarithmic histogram of durations in nanoseconds.
+
+        Each power of two is split into four buckets, so percentiles are accurate to within
+        12.5%. Durations below 64 ns share the first bucket. Adding a duration takes constant
+        time and does not allocate, histograms can be merged.
+    */
+    class CONAN_LOCAL DurationHistogram {
+    public:
+        static const int kBucketCount = 128;    //!< The number of buckets
+
+        DurationHistogram ();
+
+        void Add (qint64 inDuration);
+        void Merge (const DurationHistogram& inOther);
+
+        quint64 Count () const;
+        qint64 Percentile (int inPercentile) const;
+
+    private:
+        static int Bucket (quint64 inDuration);
+        static qint64 BucketDuration (int inBucket);
+
+        quint32 mBuckets [kBucketCount];        //!< The number of durations per bucket, see Bucket
+        quint64 mCount;                         //!< The number of durations in mBuckets
+    };
+
+} // namespace conan
+
+
+#endif //_DURATIONHISTOGRAM__17_10_26__20_11_37__H_
@@ -0,0 +1,120 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains EmissionRate related definitions
+*/
+
+
+#include "EmissionRate.h"
+
+
+namespace conan {
+
+    namespace /*unnamed*/ {
+        const qint64 kNanosecondsPerSecond = Q_INT64_C (1000000000);
+    } // unnamed namespace
+
+    /*!
+        \brief Creates statistics without emissions.
+    */
+    EmissionRate::EmissionRate () :
+        mCount (0),
+        mLastSecond (-1),
+        mPeakRate (0),
+        mPreviousTimestamp (-1)
+    {
+        for (int s=0; s<kSecondCount; ++s) {
+            mSeconds [s] = 0;
+        }
+    }
+
+    /*!
+        \brief Counts a single emission with the given monotonic timestamp, see Clock::Now.
+
+        Emissions are expected in timestamp order, an emission older than the rate windows is
+        only counted in the totals.
+    */
+    void EmissionRate::Add (qint64 inTimestamp) {
+        ++mCount;
+
+        qint64 second = inTimestamp / kNanosecondsPerSecond;
+        if (second > mLastSecond) {
+            // clear the seconds that passed without emissions
+            qint64 first = qMax (mLastSecond + 1, second - kSecondCount + 1);
+            for (qint64 s=first; s<=second; ++s) {
+                mSeconds [s % kSecondCount] = 0;
+            }
+            mLastSecond = second;
+        }
+        if (second > mLastSecond - kSecondCount) {
+            quint32& count = mSeconds [second % kSecondCount];
+            ++count;
+            mPeakRate = qMax (mPeakRate, count);
+        }
+
+        if (mPreviousTimestamp >= 0 && inTimestamp >= mPreviousTimestamp) {
+            mIntervals.Add (inTimestamp - mPreviousTimestamp);
+        }
+        mPreviousTimestamp = qMax (mPreviousTimestamp, inTimestamp);
+    }
+
+    /*!
+        \brief Returns the total number of emissions.
+    */
+    quint64 EmissionRate::Count () const {
+        return mCount;
+    }
+
+    /*!
+        \brief Returns the average number of emissions per second within the given number of
+        complete seconds before the given monotonic timestamp, see Clock::Now.
+
+        The window is limited to kSecondCount seconds.
+    */
+    double EmissionRate::Rate (int inSeconds, qint64 inNow) const {
+        inSeconds = qBound (1, inSeconds, static_cast <int> (kSecondCount));
+        qint64 now = inNow / kNanosecondsPerSecond;
+        quint64 count = 0;
+        qint64 first = qMax <qint64> (qMax (now - inSeconds, mLastSecond - kSecondCount + 1), 0);
+        for (qint64 s=first; s<now && s<=mLastSecond; ++s) {
+            count += mSeconds [s % kSecondCount];
+        }
+        return static_cast <double> (count) / inSeconds;
+    }
+
+    /*!
+        \brief Returns the highest number of emissions within a single second.
+    */
+    quint32 EmissionRate::PeakRate () const {
+        return mPeakRate;
+    }
+
+    /*!
+        \brief Returns the given percentile (0 - 100) of the times between consecutive emissions
+        in ns, or -1 when the signal was emitted less than twice.
+    */
+    qint64 EmissionRate::IntervalPercentile (int inPercentile) const {
+        return mIntervals.Percentile (inPercentile);
+    }
+
+} // namespace conan
@@ -0,0 +1,76 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains EmissionRate related declarations
+*/
+
+
+#ifndef _EMISSIONRATE__17_10_26__18_04_52__H_
+#define _EMISSIONRATE__17_10_26__18_04_52__H_
+
+
+#include "ConanDefines.h"
+#include "DurationHistogram.h"
+
+
+namespace conan {
+
+    /*!
+        \brief Rolling emission rate and inter-arrival time statistics of a single signal.
+
+        Emissions are counted per second of the monotonic clock, see Clock::Now, in a ring of
+        kSecondCount counters. The rate over a window is the number of emissions within the
+        most recent complete seconds of the window, divided by its length. The peak rate is
+        the highest number of emissions within a single second.
+
+        The times between consecutive emissions are counted in a DurationHistogram, which covers
+        all emissions since the statistics were created.
+
+        Adding an emission takes constant time and does not allocate.
+    */
+    class CONAN_LOCAL EmissionRate {
+    public:
+        static const int kSecondCount = 60;             //!< The length of the longest rate window, in seconds
+
+        EmissionRate ();
+
+        void Add (qint64 inTimestamp);
+
+        quint64 Count () const;
+        double Rate (int inSeconds, qint64 inNow) const;
+        quint32 PeakRate () const;
+        qint64 IntervalPercentile (int inPercentile) const;
+
+    private:
+        quint64 mCount;                                 //!< The number of emissions
+        qint64 mLastSecond;                             //!< The most recent second that has been counted, or -1
+        quint32 mSeconds [kSecondCount];                //!< The number of emissions per second, indexed by second modulo kSecondCount
+        quint32 mPeakRate;                              //!< The highest number of emissions within a single second
+        qint64 mPreviousTimestamp;                      //!< The timestamp of the most recent emission, or -1
+        DurationHistogram mIntervals;                   //!< The inter-arrival time histogram
+    };
+
+} // namespace conan
+
+
+#endif //_EMISSIONRATE__17_10_26__18_04_52__H_
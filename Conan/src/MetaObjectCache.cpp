@@ -0,0 +1,207 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains MetaObjectCache related definitions
+*/
+
+
+#include "MetaObjectCache.h"
+#include <QtCore/QMetaMethod>
+#include <QtCore/QMetaObject>
+#include <QtCore/QMutexLocker>
+
+
+namespace conan {
+
+    /*!
+        \brief Computes the method tables of the given meta object.
+    */
+    MetaObjectInfo::MetaObjectInfo (const QMetaObject* inMetaObject) :
+        mClassName (inMetaObject->className ()),
+        mMethodCount (inMetaObject->methodCount ())
+    {
+        mRows.fill (-1, mMethodCount);
+        mDeclaringClasses.fill (0, mMethodCount);
+        mMethodToSignal.fill (-1, mMethodCount);
+
+        // signal and slot rows, the most derived class first
+        QVector <const QMetaObject*> hierarchy;
+        for (const QMetaObject* metaObject = inMetaObject; metaObject; metaObject = metaObject->superClass ()) {
+            hierarchy.push_back (metaObject);
+            for (int m=metaObject->methodCount ()-1; m>=metaObject->methodOffset (); m--) {
+                mDeclaringClasses [m] = metaObject;
+                QMetaMethod::MethodType methodType = inMetaObject->method (m).methodType ();
+                if (methodType == QMetaMethod::Signal) {
+                    mRows [m] = mSignalMethods.size ();
+                    mSignalMethods.push_back (m);
+                }
+                else if (methodType == QMetaMethod::Slot) {
+                    mRows [m] = mSlotMethods.size ();
+                    mSlotMethods.push_back (m);
+                }
+            }
+        }
+
+        // signal indices as used by the connection lists of an object, the base class first;
+        // moc lists the signals of a class before all its other methods
+        for (int h=hierarchy.size ()-1; h>=0; h--) {
+            const QMetaObject* metaObject = hierarchy [h];
+            // before Qt 4.6 (revision 4) moc did not generate the signal count,
+            // so Qt considers all methods of such a class to be signals
+            bool allMethods = metaObject->d.data [0] < 4;
+            for (int m=metaObject->methodOffset (); m<metaObject->methodCount (); m++) {
+                if (allMethods || inMetaObject->method (m).methodType () == QMetaMethod::Signal) {
+                    mMethodToSignal [m] = mSignalToMethod.size ();
+                    mSignalToMethod.push_back (m);
+                }
+            }
+        }
+    }
+
+    /*!
+        \brief Returns true when the tables were computed for the given meta object.
+
+        Meta objects that are created at runtime can be destroyed, after which their address may
+        be reused by a different class.
+    */
+    bool MetaObjectInfo::IsValidFor (const QMetaObject* inMetaObject) const {
+        return mClassName == inMetaObject->className () && mMethodCount == inMetaObject->methodCount ();
+    }
+
+    /*!
+        \brief Returns the method index of each signal, in row order.
+    */
+    const QVector <int>& MetaObjectInfo::SignalMethods () const {
+        return mSignalMethods;
+    }
+
+    /*!
+        \brief Returns the method index of each slot, in row order.
+    */
+    const QVector <int>& MetaObjectInfo::SlotMethods () const {
+        return mSlotMethods;
+    }
+
+    /*!
+        \brief Returns the row of the signal with the given method index, or -1 when the method is not a signal.
+    */
+    int MetaObjectInfo::SignalRow (int inMethodIndex) const {
+        if (inMethodIndex < 0 || inMethodIndex >= mMethodCount) {
+            return -1;
+        }
+        int row = mRows [inMethodIndex];
+        return (row >= 0 && row < mSignalMethods.size () && mSignalMethods [row] == inMethodIndex) ? row : -1;
+    }
+
+    /*!
+        \brief Returns the row of the slot with the given method index, or -1 when the method is not a slot.
+    */
+    int MetaObjectInfo::SlotRow (int inMethodIndex) const {
+        if (inMethodIndex < 0 || inMethodIndex >= mMethodCount) {
+            return -1;
+        }
+        int row = mRows [inMethodIndex];
+        return (row >= 0 && row < mSlotMethods.size () && mSlotMethods [row] == inMethodIndex) ? row : -1;
+    }
+
+    /*!
+        \brief Converts a signal index, as used by the connection lists of an object, to a method index.
+        Returns -1 for an invalid signal index.
+    */
+    int MetaObjectInfo::MethodIndexOfSignal (int inSignalIndex) const {
+        if (inSignalIndex < 0 || inSignalIndex >= mSignalToMethod.size ()) {
+            return -1;
+        }
+        return mSignalToMethod [inSignalIndex];
+    }
+
+    /*!
+        \brief Converts the method index of a signal to its signal index, as used by the connection lists of an object.
+        Returns -1 when the method has no signal index.
+    */
+    int MetaObjectInfo::SignalIndexOfMethod (int inMethodIndex) const {
+        if (inMethodIndex < 0 || inMethodIndex >= mMethodCount) {
+            return -1;
+        }
+        return mMethodToSignal [inMethodIndex];
+    }
+
+    /*!
+        \brief Returns the meta object of the class that declares the method with the given index.
+    */
+    const QMetaObject* MetaObjectInfo::DeclaringClass (int inMethodIndex) const {
+        if (inMethodIndex < 0 || inMethodIndex >= mMethodCount) {
+            return 0;
+        }
+        return mDeclaringClasses [inMethodIndex];
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    // initialized at load time, function local statics are not thread safe with msvc
+    MetaObjectCache MetaObjectCache::sInstance;
+
+    MetaObjectCache::MetaObjectCache ()
+    {}
+
+    MetaObjectCache::~MetaObjectCache () {
+        qDeleteAll (mInfos);
+        qDeleteAll (mRetired);
+    }
+
+    /*!
+        \brief Returns the method tables of the given meta object, they are computed on first use.
+
+        The front cache of the calling thread is consulted first, without locking.
+    */
+    const MetaObjectInfo& MetaObjectCache::Get (const QMetaObject* inMetaObject) {
+        Q_ASSERT (inMetaObject);
+        if (!sInstance.mFrontCache.hasLocalData ()) {
+            sInstance.mFrontCache.setLocalData (new FrontCache ());
+        }
+        const MetaObjectInfo*& info = (*sInstance.mFrontCache.localData ()) [inMetaObject];
+        if (!info || !info->IsValidFor (inMetaObject)) {
+            info = &sInstance.Lookup (inMetaObject);
+        }
+        return *info;
+    }
+
+    /*!
+        \brief Returns the shared method tables of the given meta object, under the lock of the cache.
+    */
+    const MetaObjectInfo& MetaObjectCache::Lookup (const QMetaObject* inMetaObject) {
+        QMutexLocker locker (&mMutex);
+        MetaObjectInfo*& info = mInfos [inMetaObject];
+        if (info && !info->IsValidFor (inMetaObject)) {
+            // keep the stale tables alive, they may still be referenced
+            mRetired.push_back (info);
+            info = 0;
+        }
+        if (!info) {
+            info = new MetaObjectInfo (inMetaObject);
+        }
+        return *info;
+    }
+
+} // namespace conan
@@ -0,0 +1,112 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains MetaObjectCache related declarations
+*/
+
+
+#ifndef _METAOBJECTCACHE__17_10_26__14_21_05__H_
+#define _METAOBJECTCACHE__17_10_26__14_21_05__H_
+
+
+#include "ConanDefines.h"
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QVector>
+
+
+struct QMetaObject;
+
+
+namespace conan {
+
+    /*!
+        \brief Precomputed method tables of a single QMetaObject.
+
+        Signals and slots are listed in row order: the methods of the most derived class first,
+        and within each class in reverse declaration order. All lookups are array indexing.
+    */
+    class CONAN_LOCAL MetaObjectInfo {
+    public:
+        MetaObjectInfo (const QMetaObject* inMetaObject);
+
+        bool IsValidFor (const QMetaObject* inMetaObject) const;
+
+        const QVector <int>& SignalMethods () const;
+        const QVector <int>& SlotMethods () const;
+
+        int SignalRow (int inMethodIndex) const;
+        int SlotRow (int inMethodIndex) const;
+        int MethodIndexOfSignal (int inSignalIndex) const;
+        int SignalIndexOfMethod (int inMethodIndex) const;
+        const QMetaObject* DeclaringClass (int inMethodIndex) const;
+
+    private:
+        const char* mClassName;                         //!< Used to detect a reused meta object address
+        int mMethodCount;                               //!< Used to detect a reused meta object address
+        QVector <int> mSignalMethods;                   //!< The method index of each signal row
+        QVector <int> mSlotMethods;                     //!< The method index of each slot row
+        QVector <int> mRows;                            //!< map <method index, signal or slot row>, -1 for other methods
+        QVector <int> mSignalToMethod;                  //!< map <signal index, method index>
+        QVector <int> mMethodToSignal;                  //!< map <method index, signal index>, -1 for other methods
+        QVector <const QMetaObject*> mDeclaringClasses; //!< map <method index, declaring meta object>
+    };
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief A process wide cache of MetaObjectInfo, keyed by meta object.
+
+        Meta objects generated by moc never change, so the tables of each class are computed
+        once and reused for every object of that class. Each thread looks up the tables in a
+        front cache of its own without locking, only the first lookup of a class per thread is
+        serialized by a mutex. The returned tables are immutable, and are never destroyed before
+        the cache, so they may be read without locking.
+    */
+    class CONAN_LOCAL MetaObjectCache {
+    public:
+        static const MetaObjectInfo& Get (const QMetaObject* inMetaObject);
+
+    private:
+        MetaObjectCache ();
+        ~MetaObjectCache ();
+
+        const MetaObjectInfo& Lookup (const QMetaObject* inMetaObject);
+
+        typedef QHash <const QMetaObject*, const MetaObjectInfo*> FrontCache;
+
+        static MetaObjectCache sInstance;                       //!< The single cache, initialized at load time
+
+        QMutex mMutex;                                          //!< Guards mInfos and mRetired
+        QHash <const QMetaObject*, MetaObjectInfo*> mInfos;     //!< map <meta object, tables>
+        QList <MetaObjectInfo*> mRetired;                       //!< Tables of meta objects that no longer exist
+        QThreadStorage <FrontCache*> mFrontCache;               //!< The tables used by the current thread
+    };
+
+} // namespace conan
+
+
+#endif //_METAOBJECTCACHE__17_10_26__14_21_05__H_
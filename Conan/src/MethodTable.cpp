@@ -0,0 +1,156 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains MethodTable related definitions
+*/
+
+
+#include "MetaObjectCache.h"
+#include "MethodTable.h"
+#include "ObjectUtility.h"
+#include <QtCore/QMetaObject>
+#include <QtCore/QObject>
+
+
+namespace conan {
+
+    /*!
+        \brief Creates a record for the given object.
+    */
+    ObjectRecord::ObjectRecord (const QObject* inObject) :
+        mObject (const_cast <QObject*> (inObject)),
+        mKey (inObject),
+        mClass (inObject && inObject->metaObject () ? inObject->metaObject ()->className () : ""),
+        mName (inObject ? inObject->objectName () : QString ())
+    {}
+
+    /*!
+        \brief Creates a record that does not refer to an actual object, f.e. logs.
+    */
+    ObjectRecord::ObjectRecord (const char* inClass, const QString& inName, const QString& inAddress) :
+        mObject (0),
+        mKey (0),
+        mClass (inClass),
+        mName (inName),
+        mAddress (inAddress)
+    {}
+
+    /*!
+        \brief Returns the address of the object, formatted on first use.
+    */
+    QString ObjectRecord::Address () const {
+        if (mAddress.isNull ()) {
+            mAddress = ObjectUtility::Address (static_cast <const QObject*> (mKey));
+        }
+        return mAddress;
+    }
+
+    /*!
+        \brief Returns the object name, or 'unnamed' when the object has no name.
+    */
+    QString ObjectRecord::Name () const {
+        return mName.isEmpty () ? QString ("unnamed") : mName;
+    }
+
+    /*!
+        \brief Returns the class name of the object.
+    */
+    QString ObjectRecord::Class () const {
+        return QString::fromLatin1 (mClass);
+    }
+
+    /*!
+        \brief Returns the qualified name of the object: [class name] :: [object name]
+    */
+    QString ObjectRecord::QualifiedName () const {
+        return ObjectUtility::QualifiedName (Class (), Name ());
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Creates a record that does not refer to an actual method, f.e. logs.
+    */
+    MethodRecord::MethodRecord () :
+        mIndex (-1),
+        mSignature (""),
+        mSuperClass (""),
+        mAccess (QMetaMethod::Public),
+        mMethodType (QMetaMethod::Method)
+    {}
+
+    /*!
+        \brief Creates a record for the method with the given index.
+    */
+    MethodRecord::MethodRecord (const QMetaObject* inMetaObject, int inMethodIndex) :
+        mIndex (inMethodIndex),
+        mSignature (""),
+        mSuperClass (""),
+        mAccess (QMetaMethod::Public),
+        mMethodType (QMetaMethod::Method)
+    {
+        if (const QMetaObject* declaringClass = MetaObjectCache::Get (inMetaObject).DeclaringClass (inMethodIndex)) {
+            mSuperClass = declaringClass->className ();
+        }
+        QMetaMethod method = inMetaObject->method (inMethodIndex);
+        if (method.signature ()) {
+            mSignature = method.signature ();
+            mAccess = method.access ();
+            mMethodType = method.methodType ();
+        }
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    MethodTable::MethodTable ()
+    {}
+
+    /*!
+        \brief Returns the record for the given object, the record is created on first use.
+
+        A new record is created when the object of the existing record has been destroyed, as a
+        new object may have been created at the same address.
+    */
+    ObjectRecordPtr MethodTable::Object (const QObject* inObject) {
+        ObjectRecordPtr& record = mObjects [inObject];
+        if (!record || record->mObject != inObject) {
+            record = ObjectRecordPtr (new ObjectRecord (inObject));
+        }
+        return record;
+    }
+
+    /*!
+        \brief Returns the record for the method with the given index, the record is created on first use.
+    */
+    MethodRecordPtr MethodTable::Method (const QMetaObject* inMetaObject, int inMethodIndex) {
+        MethodRecordPtr& record = mMethods [qMakePair (inMetaObject, inMethodIndex)];
+        if (!record) {
+            record = MethodRecordPtr (new MethodRecord (inMetaObject, inMethodIndex));
+        }
+        return record;
+    }
+
+} // namespace conan
@@ -0,0 +1,116 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains MethodTable related declarations
+*/
+
+
+#ifndef _METHODTABLE__17_10_26__11_02_47__H_
+#define _METHODTABLE__17_10_26__11_02_47__H_
+
+
+#include "ConanDefines.h"
+#include <QtCore/QHash>
+#include <QtCore/QMetaMethod>
+#include <QtCore/QPair>
+#include <QtCore/QPointer>
+#include <QtCore/QSharedData>
+#include <QtCore/QString>
+
+
+namespace conan {
+
+    /*!
+        \brief Information about a single object that is shared by all signals, slots and connections of that object.
+
+        Only the object name is copied during construction, which is cheap because QString is
+        implicitly shared. The address is formatted on first use.
+    */
+    struct CONAN_LOCAL ObjectRecord : public QSharedData {
+        ObjectRecord (const QObject* inObject);
+        ObjectRecord (const char* inClass, const QString& inName, const QString& inAddress);
+
+        QString Address () const;
+        QString Name () const;
+        QString Class () const;
+        QString QualifiedName () const;
+
+        QPointer <QObject> mObject;             //!< The wrapped QObject, or 0 when it has been destroyed
+        const void* mKey;                       //!< The address of mObject, remains valid after mObject has been destroyed
+        const char* mClass;                     //!< The class name of mObject, points into static moc data
+        QString mName;                          //!< The object name of mObject
+        mutable QString mAddress;               //!< The formatted address of mObject, created on first use
+    };
+
+    typedef QExplicitlySharedDataPointer <ObjectRecord> ObjectRecordPtr;
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Information about a single signal or slot of a class that is shared by all its connections.
+
+        All strings point into static moc data, so creating a record allocates no strings.
+    */
+    struct CONAN_LOCAL MethodRecord : public QSharedData {
+        MethodRecord ();
+        MethodRecord (const QMetaObject* inMetaObject, int inMethodIndex);
+
+        int mIndex;                             //!< The absolute method index, as passed to QMetaObject::method
+        const char* mSignature;                 //!< signal or slot method signature
+        const char* mSuperClass;                //!< class that declared the method
+        QMetaMethod::Access mAccess;            //!< public, protected, private
+        QMetaMethod::MethodType mMethodType;    //!< signal, slot
+    };
+
+    typedef QExplicitlySharedDataPointer <MethodRecord> MethodRecordPtr;
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Interns object and method records while building connection data.
+
+        Every object is represented by a single ObjectRecord and every (meta object, method index)
+        pair by a single MethodRecord, no matter how many connections refer to them. Records are
+        reference counted and outlive the table that created them.
+    */
+    class CONAN_LOCAL MethodTable {
+    public:
+        MethodTable ();
+
+        ObjectRecordPtr Object (const QObject* inObject);
+        MethodRecordPtr Method (const QMetaObject* inMetaObject, int inMethodIndex);
+
+    private:
+        typedef QPair <const QMetaObject*, int> MethodKey;
+
+        QHash <const QObject*, ObjectRecordPtr> mObjects;   //!< map <object, record>
+        QHash <MethodKey, MethodRecordPtr> mMethods;        //!< map <(meta object, method index), record>
+    };
+
+} // namespace conan
+
+
+#endif //_METHODTABLE__17_10_26__11_02_47__H_
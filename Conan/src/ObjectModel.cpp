@@ -26,6 +26,9 @@
 
 #include "ObjectModel.h"
 #include "ObjectUtility.h"
+#include <QtCore/QEvent>
+#include <QtCore/QVarLengthArray>
+#include <QtCore/QtConcurrentMap>
 #include <QtGui/QApplication>
 #include <QtGui/QClipboard>
 #include <QtGui/QDesktopWidget>
@@ -35,20 +38,51 @@
 
 
 namespace conan {
+
+    namespace /*unnamed*/ {
+
+        //! Displayed for objects without a name; not a function static, items are sorted by multiple threads
+        const QString sUnnamed ("unnamed");
+
+        //! The number of items from which SortItems sorts in parallel
+        const int kParallelSortItemCount = 4096;
+
+        /*!
+            \brief Sorts the children of a single item, see ObjectModel::SortItems.
+        */
+        struct CONAN_LOCAL SortTask {
+            SortTask (ObjectItem* inItem, const ObjectItemSorter& inSorter) :
+                mItem (inItem),
+                mSorter (inSorter)
+            {}
+
+            ObjectItem* mItem;
+            ObjectItemSorter mSorter;
+        };
+
+        void RunSortTask (SortTask& ioTask) {
+            ioTask.mItem->SortChildren (ioTask.mSorter);
+        }
+
+    } // unnamed namespace
+
+
     /*!
-        \brief Constructs an item for the given object and all its children.
+        \brief Constructs an item for the given object, child items are created by FetchChildren.
     */
     ObjectItem::ObjectItem (const QObject* inObject, const ObjectItem* inParent) :
-        mParent (inParent), mObject (const_cast <QObject*> (inObject))
+        mParent (inParent),
+        mRow (-1),
+        mFetched (inObject == 0),
+        mObject (const_cast <QObject*> (inObject)),
+        mKey (inObject),
+        mClassName (0)
     {
         if (mObject) {
             // ensure we can stil display the item after its QObject has been destroyed
-            mAddress = ObjectUtility::Address (mObject);
-            mName = ObjectUtility::Name (mObject);
-            mClass = ObjectUtility::Class (mObject);
-            // recursively process all children
-            foreach (const QObject* object, mObject->children ()) {
-                mChildren.push_back (new ObjectItem (object, this));
+            mName = mObject->objectName ();
+            if (const QMetaObject* metaObject = mObject->metaObject ()) {
+                mClassName = metaObject->className ();
             }
         }
     }
@@ -66,6 +100,7 @@ namespace conan {
     void ObjectItem::Reset () {
         mObject = 0;
         mParent = 0;
+        mFetched = true;
         foreach (const ObjectItem* item, mChildren) {
             delete item;
         }
@@ -76,16 +111,14 @@ namespace conan {
         \brief Returns the index of this item at its parent.
     */
     int ObjectItem::Index () const {
-        return mParent ? mParent->ChildIndex (this) : -1;
+        return mParent ? mRow : -1;
     }
 
     /*!
         \brief Returns the index of the given object if it is a child; otherwise -1.
     */
     int ObjectItem::ChildIndex (const ObjectItem* inChild) const {
-        // perform a non-recursive search
-        int index = qFind (mChildren.begin (), mChildren.end (), inChild) - mChildren.begin ();
-        return index < static_cast <int> (mChildren.size ()) ? index : -1;
+        return (inChild && inChild->mParent == this) ? inChild->mRow : -1;
     }
 
     /*!
@@ -95,6 +128,103 @@ namespace conan {
         return static_cast <int> (mChildren.size ());
     }
 
+    /*!
+        \brief Returns true when the child items have been created.
+    */
+    bool ObjectItem::IsFetched () const {
+        return mFetched;
+    }
+
+    /*!
+        \brief Returns true when the item has child items, or when the wrapped object has children for which no items have been created yet.
+    */
+    bool ObjectItem::HasChildren () const {
+        if (mFetched) {
+            return !mChildren.isEmpty ();
+        }
+        return mObject && !mObject->children ().isEmpty ();
+    }
+
+    /*!
+        \brief Returns the number of child items that FetchChildren will create.
+    */
+    int ObjectItem::UnfetchedChildCount () const {
+        if (mFetched || !mObject) {
+            return 0;
+        }
+        return mObject->children ().size ();
+    }
+
+    /*!
+        \brief Creates an item for each child of the wrapped object, their children are not created.
+    */
+    void ObjectItem::FetchChildren () {
+        if (mFetched) {
+            return;
+        }
+        mFetched = true;
+        if (mObject) {
+            const QObjectList& children = mObject->children ();
+            mChildren.reserve (children.size ());
+            foreach (const QObject* object, children) {
+                mChildren.push_back (new ObjectItem (object, this));
+            }
+            UpdateRows (0);
+        }
+    }
+
+    /*!
+        \brief Inserts the given item as child at the given index, the item becomes a child of this item.
+    */
+    void ObjectItem::InsertChild (int inIndex, ObjectItem* inChild) {
+        inChild->mParent = this;
+        mChildren.insert (inIndex, inChild);
+        UpdateRows (inIndex);
+    }
+
+    /*!
+        \brief Moves the child item at index \p inFrom to index \p inTo.
+    */
+    void ObjectItem::MoveChild (int inFrom, int inTo) {
+        ObjectItem* item = mChildren [inFrom];
+        mChildren.remove (inFrom);
+        mChildren.insert (inTo, item);
+        UpdateRows (qMin (inFrom, inTo));
+    }
+
+    /*!
+        \brief Removes the child item at the given index and returns it, the caller takes ownership.
+    */
+    ObjectItem* ObjectItem::TakeChild (int inIndex) {
+        ObjectItem* item = mChildren [inIndex];
+        mChildren.remove (inIndex);
+        item->mParent = 0;
+        item->mRow = -1;
+        UpdateRows (inIndex);
+        return item;
+    }
+
+    /*!
+        \brief Stores the index of each child item, starting at the given index.
+    */
+    void ObjectItem::UpdateRows (int inFrom) {
+        int childCount = mChildren.size ();
+        for (int c=inFrom; c<childCount; c++) {
+            mChildren [c]->mRow = c;
+        }
+    }
+
+    /*!
+        \brief Copies the current object name of the wrapped object, returns true when it has changed.
+    */
+    bool ObjectItem::UpdateName () {
+        if (mObject && mObject->objectName () != mName) {
+            mName = mObject->objectName ();
+            return true;
+        }
+        return false;
+    }
+
     /*!
         \brief Returns the parent item.
     */
@@ -118,23 +248,43 @@ namespace conan {
     }
 
     /*!
-        \brief Returns the object name of the wrapped object
+        \brief Returns the address of the wrapped object, which remains valid after the object has been destroyed.
+    */
+    const void* ObjectItem::Key () const {
+        return mKey;
+    }
+
+    /*!
+        \brief Returns the object name of the wrapped object, or 'unnamed' when it has no name
     */
     const QString& ObjectItem::Name () const {
-        return mName;
+        return (mName.isEmpty () && mKey) ? sUnnamed : mName;
     }
 
     /*!
         \brief Returns the class name of the wrapped object
     */
     const QString& ObjectItem::Class () const {
+        if (mClass.isNull () && mClassName) {
+            mClass = QString::fromLatin1 (mClassName);
+        }
         return mClass;
     }
 
+    /*!
+        \brief Returns the class name of the wrapped object, which points into static moc data
+    */
+    const char* ObjectItem::ClassName () const {
+        return mClassName;
+    }
+
     /*!
         \brief Returns the object address of the wrapped object
     */
     const QString& ObjectItem::Address () const {
+        if (mAddress.isNull () && mKey) {
+            mAddress = ObjectUtility::Address (static_cast <const QObject*> (mKey));
+        }
         return mAddress;
     }
 
@@ -151,21 +301,27 @@ namespace conan {
     }
 
     /*!
-        \brief Creates and adds an item hierarchy that wraps the object hierarchy defined by the given object.
-
-        When the object is already part of an existing hierarchy nothing is done.
-        In case the object shares a mutual parent with an existing hierarchy, that hierarchy is
-        replaced with the hierarchy starting at that mutual parent.
+        \brief Returns true when the given object is part of any of the object hierarchies.
     */
-    void RootItem::AddChild (const QObject* inObject) {
-        if (!inObject) {
-            return;
-        }
-        // is the object known
-        if (Find (MatchObjectByValue (ObjectUtility::Address (inObject)))) {
-            return;
+    bool RootItem::Contains (const QObject* inObject) const {
+        for (const QObject* object = inObject; object; object = object->parent ()) {
+            if (FindChild (object) != -1) {
+                return true;
+            }
         }
-        // is the object part of same object hierarchy as any of the existing children
+        return false;
+    }
+
+    /*!
+        \brief Finds the hierarchy that should be merged with the hierarchy of the given object.
+
+        In case the object shares a mutual parent with an existing hierarchy, that hierarchy should
+        be replaced with the hierarchy starting at that mutual parent.
+        \param[in]  inObject   The object whose hierarchy is added
+        \param[out] outParent  The object at which the merged hierarchy starts
+        \return                The index of the child item to replace; otherwise -1
+    */
+    int RootItem::FindMergeableChild (const QObject* inObject, const QObject** outParent) const {
         for (int c=0; c<mChildren.size (); c++) {
             if (const QObject* object = mChildren [c]->Object ()) {
                 const QObject* parent = object->parent ();
@@ -179,31 +335,24 @@ namespace conan {
                 }
                 // check if the object has a mutual parent with a child
                 if (parent) {
-                    // replace the child with the found parent
-                    ObjectItem* item = mChildren [c];
-                    delete item;
-                    item = new ObjectItem (parent, this);
-                    mChildren [c] = item;
-                    return;
+                    (*outParent) = parent;
+                    return c;
                 }
             }
         }
-        ObjectItem* item = new ObjectItem (inObject, this);
-        mChildren.push_back (item);
+        return -1;
     }
 
     /*!
-      \brief Deletes and removes the item hierarchy that wraps the object hierarchy defined by the given object.
+        \brief Returns the index of the child item that wraps the given object; otherwise -1.
     */
-    void RootItem::RemoveChild (const QObject* inObject) {
-        for (QVector <ObjectItem*>::iterator it = mChildren.begin(); it != mChildren.end(); ++it) {
-            ObjectItem* item = *it;
-            if (item->Object() == inObject) {
-                mChildren.erase(it);
-                delete item;
-                return;
+    int RootItem::FindChild (const QObject* inObject) const {
+        for (int c=0; c<mChildren.size (); c++) {
+            if (mChildren [c]->Object () == inObject) {
+                return c;
             }
         }
+        return -1;
     }
 
     /*!
@@ -217,32 +366,89 @@ namespace conan {
     // ------------------------------------------------------------------------------------------------
 
 
+    /*!
+        \brief Returns true when the first entry is shown before the second entry in the view.
+    */
+    bool SearchEntrySorter::operator () (int inEntry1, int inEntry2) const {
+        if (inEntry1 == inEntry2) {
+            return false;
+        }
+        QVarLengthArray <int, 32> path1;
+        for (int e=inEntry1; e>=0; e=mIndex->Parent (e)) {
+            path1.append (e);
+        }
+        QVarLengthArray <int, 32> path2;
+        for (int e=inEntry2; e>=0; e=mIndex->Parent (e)) {
+            path2.append (e);
+        }
+        // skip the common ancestors, starting at the root entries
+        int p1 = path1.size () - 1;
+        int p2 = path2.size () - 1;
+        while (p1 >= 0 && p2 >= 0 && path1 [p1] == path2 [p2]) {
+            p1--;
+            p2--;
+        }
+        if (p1 < 0 || p2 < 0) {
+            // an ancestor is shown before its descendants
+            return p1 < 0;
+        }
+        int entry1 = path1 [p1];
+        int entry2 = path2 [p2];
+        return mSorter.Less (mIndex->Key (entry1), mIndex->ClassName (entry1), mIndex->Name (entry1),
+                             mIndex->Key (entry2), mIndex->ClassName (entry2), mIndex->Name (entry2));
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
     ObjectModel::ObjectModel (QObject* inParent) :
         QAbstractItemModel (inParent),
         mRoot (0),
         mSortColumn (kObject),
-        mSortOrder (Qt::AscendingOrder)
+        mSortOrder (Qt::AscendingOrder),
+        mSearchIndexValid (false),
+        mAutoRefresh (false)
     {
         setObjectName ("ObjectModel");
         mRoot = new RootItem ();
         connect (this, SIGNAL (modelReset ()), this, SLOT (SlotSort ()));
+
+        // objects are often created in bursts, f.e. when a dialog is constructed
+        mAutoRefreshTimer.setSingleShot (true);
+        mAutoRefreshTimer.setInterval (100);
+        connect (&mAutoRefreshTimer, SIGNAL (timeout ()), this, SLOT (SlotRefreshChangedObjects ()));
     }
 
 
     /*!
         \brief Adds the object hierarchy of \p inObject to the model.
+
+        When the object is already part of an existing hierarchy nothing is done.
+        In case the object shares a mutual parent with an existing hierarchy, that hierarchy is
+        replaced with the hierarchy starting at that mutual parent.
     */
     void ObjectModel::AddRootObject (const QObject* inObject) {
-        mRoot->AddChild (inObject);
-        reset ();
+        if (!inObject || mRoot->Contains (inObject)) {
+            return;
+        }
+        const QObject* parent = 0;
+        int row = mRoot->FindMergeableChild (inObject, &parent);
+        if (row != -1) {
+            RemoveItem (mRoot, row);
+            inObject = parent;
+        }
+        InsertItem (mRoot, new ObjectItem (inObject, mRoot));
     }
 
     /*!
         \brief Removes the object hierarchy of \p inObject from the model.
     */
     void ObjectModel::RemoveRootObject (const QObject* inObject) {
-        mRoot->RemoveChild (inObject);
-        reset ();
+        int row = mRoot->FindChild (inObject);
+        if (row != -1) {
+            RemoveItem (mRoot, row);
+        }
     }
 
     /*!
@@ -250,9 +456,20 @@ namespace conan {
     */
     void ObjectModel::RemoveAllRootObjects () {
         mRoot->RemoveAllChildren ();
+        mItems.clear ();
+        mChangedObjects.clear ();
+        mSearchIndex.Clear ();
+        mSearchIndexValid = true;
         reset ();
     }
 
+    /*!
+        \brief Returns true when the model tracks object creation and destruction, see SlotSetAutoRefresh.
+    */
+    bool ObjectModel::IsAutoRefreshEnabled () const {
+        return mAutoRefresh;
+    }
+
     /*!
         \brief Returns the number of rows under the given parent.
     */
@@ -350,6 +567,325 @@ namespace conan {
         return QModelIndex ();
     }
 
+    /*!
+        \brief Returns true when the item with the given index has children, even if their items have not been created yet.
+    */
+    bool ObjectModel::hasChildren (const QModelIndex& inParent) const {
+        if (const ObjectItem* item = GetItem (inParent)) {
+            return item->HasChildren ();
+        }
+        return false;
+    }
+
+    /*!
+        \brief Returns true when the child items of the item with the given index have not been created yet.
+    */
+    bool ObjectModel::canFetchMore (const QModelIndex& inParent) const {
+        if (const ObjectItem* item = GetItem (inParent)) {
+            return !item->IsFetched ();
+        }
+        return false;
+    }
+
+    /*!
+        \brief Creates the child items of the item with the given index.
+    */
+    void ObjectModel::fetchMore (const QModelIndex& inParent) {
+        FetchChildren (GetItem (inParent));
+    }
+
+    /*!
+        \brief Creates and sorts the child items of the given item, and notifies the views.
+    */
+    void ObjectModel::FetchChildren (const ObjectItem* inItem) {
+        if (!inItem || inItem->IsFetched ()) {
+            return;
+        }
+        ObjectItem* item = const_cast <ObjectItem*> (inItem);
+        QModelIndex parent;
+        if (item != mRoot) {
+            parent = createIndex (item->Index (), 0, item);
+        }
+        int count = item->UnfetchedChildCount ();
+        if (count > 0) {
+            beginInsertRows (parent, 0, count - 1);
+        }
+        item->FetchChildren ();
+        item->Sort (ObjectItemSorter (mSortOrder, mSortColumn == kAddress));
+        int childCount = item->ChildCount ();
+        for (int c=0; c<childCount; c++) {
+            AddToIndex (item->Child (c));
+        }
+        if (count > 0) {
+            endInsertRows ();
+        }
+    }
+
+    /*!
+        \brief Creates the items for the given objects, each object must be a child of the previous one.
+        \param[in] inItem   The item that wraps the parent of the first object
+        \param[in] inPath   The objects, see ObjectItem::Find
+        \return             The item that wraps the last object, or the last item that could be created
+    */
+    const ObjectItem* ObjectModel::FetchPath (const ObjectItem* inItem, const QVector <const QObject*>& inPath) {
+        const ObjectItem* item = inItem;
+        foreach (const QObject* object, inPath) {
+            FetchChildren (item);
+            const ObjectItem* child = FindItem (object);
+            if (!child || child->Parent () != item) {
+                break;
+            }
+            item = child;
+        }
+        return item;
+    }
+
+    /*!
+        \brief Returns the index of the given item, or an invalid index for the root item.
+    */
+    QModelIndex ObjectModel::IndexOf (const ObjectItem* inItem) const {
+        if (!inItem || inItem == mRoot) {
+            return QModelIndex ();
+        }
+        return createIndex (inItem->Index (), 0, const_cast <ObjectItem*> (inItem));
+    }
+
+    /*!
+        \brief Returns the item that wraps the given object; otherwise 0.
+        The object is not dereferenced, so it may have been destroyed.
+    */
+    ObjectItem* ObjectModel::FindItem (const QObject* inObject) const {
+        ObjectItem* item = mItems.value (inObject);
+        // a destroyed object's address may have been reused by a new object
+        return (item && item->Object () == inObject) ? item : 0;
+    }
+
+    /*!
+        \brief Adds the given item to the object index.
+    */
+    void ObjectModel::AddToIndex (const ObjectItem* inItem) {
+        mItems.insert (inItem->Key (), const_cast <ObjectItem*> (inItem));
+    }
+
+    /*!
+        \brief Removes the given item and all its children from the object index.
+    */
+    void ObjectModel::RemoveFromIndex (const ObjectItem* inItem) {
+        QHash <const void*, ObjectItem*>::iterator it = mItems.find (inItem->Key ());
+        // the address may have been reused by an object with a newer item
+        if (it != mItems.end () && it.value () == inItem) {
+            mItems.erase (it);
+        }
+        int childCount = inItem->ChildCount ();
+        for (int c=0; c<childCount; c++) {
+            RemoveFromIndex (inItem->Child (c));
+        }
+    }
+
+    /*!
+        \brief Inserts the given item at its sorted position among the children of \p inParent.
+    */
+    void ObjectModel::InsertItem (ObjectItem* inParent, ObjectItem* inChild) {
+        int row = inParent->SortedIndex (inChild, ObjectItemSorter (mSortOrder, mSortColumn == kAddress));
+        beginInsertRows (IndexOf (inParent), row, row);
+        inParent->InsertChild (row, inChild);
+        AddToIndex (inChild);
+        endInsertRows ();
+        if (mSearchIndexValid) {
+            mSearchIndex.Insert (inChild->Object (), inParent == mRoot ? 0 : inParent->Key ());
+        }
+    }
+
+    /*!
+        \brief Removes and destroys the child item at the given row of \p inParent.
+    */
+    void ObjectModel::RemoveItem (ObjectItem* inParent, int inRow) {
+        beginRemoveRows (IndexOf (inParent), inRow, inRow);
+        ObjectItem* item = inParent->TakeChild (inRow);
+        RemoveFromIndex (item);
+        if (mSearchIndexValid) {
+            mSearchIndex.Remove (item->Key ());
+        }
+        delete item;
+        endRemoveRows ();
+    }
+
+    /*!
+        \brief Updates the name of the given item, and moves the item when its sorted position has changed.
+    */
+    void ObjectModel::UpdateItem (ObjectItem* inItem) {
+        if (!inItem->UpdateName ()) {
+            return;
+        }
+        QModelIndex index = IndexOf (inItem);
+        emit dataChanged (index, index.sibling (index.row (), kColumnCount - 1));
+
+        ObjectItem* parent = const_cast <ObjectItem*> (inItem->Parent ());
+        int from = index.row ();
+        int to = parent->SortedIndex (inItem, ObjectItemSorter (mSortOrder, mSortColumn == kAddress));
+        if (from != to) {
+            // the destination is specified as the row before which the item is moved
+            QModelIndex parentIndex = IndexOf (parent);
+            beginMoveRows (parentIndex, from, from, parentIndex, to > from ? to + 1 : to);
+            parent->MoveChild (from, to);
+            endMoveRows ();
+        }
+    }
+
+    /*!
+        \brief Synchronizes the child items of the given item with the current children of its object.
+
+        Items are inserted for new child objects, and removed for destroyed child objects and for
+        objects that have been moved to another parent. The children of the child items are not
+        synchronized.
+    */
+    void ObjectModel::SynchronizeChildren (ObjectItem* inItem) {
+        const QObject* object = inItem->Object ();
+        if (!object || !inItem->IsFetched ()) {
+            return;
+        }
+        const QObjectList& children = object->children ();
+        QSet <const QObject*> newChildren;
+        newChildren.reserve (children.size ());
+        foreach (const QObject* child, children) {
+            newChildren.insert (child);
+        }
+        for (int c=inItem->ChildCount ()-1; c>=0; c--) {
+            const QObject* child = inItem->Child (c)->Object ();
+            if (!child || !newChildren.remove (child)) {
+                RemoveItem (inItem, c);
+            }
+        }
+        // only the objects without an item remain
+        if (!newChildren.isEmpty ()) {
+            foreach (const QObject* child, children) {
+                if (newChildren.contains (child)) {
+                    InsertItem (inItem, new ObjectItem (child, inItem));
+                }
+            }
+        }
+    }
+
+    /*!
+        \brief Synchronizes the given item and all its created children with the current object hierarchy.
+        Items whose children have not been created yet are skipped. The names of all items are updated.
+    */
+    void ObjectModel::Synchronize (ObjectItem* inItem) {
+        if (!inItem->IsFetched ()) {
+            return;
+        }
+        if (inItem == mRoot) {
+            // root objects are not children of an item, only remove the destroyed ones
+            for (int c=inItem->ChildCount ()-1; c>=0; c--) {
+                if (!inItem->Child (c)->Object ()) {
+                    RemoveItem (inItem, c);
+                }
+            }
+        }
+        else {
+            SynchronizeChildren (inItem);
+        }
+        // copy the children, updating an item may move it
+        QVector <ObjectItem*> items;
+        int childCount = inItem->ChildCount ();
+        items.reserve (childCount);
+        for (int c=0; c<childCount; c++) {
+            items.push_back (const_cast <ObjectItem*> (inItem->Child (c)));
+        }
+        foreach (ObjectItem* item, items) {
+            UpdateItem (item);
+            Synchronize (item);
+        }
+    }
+
+    /*!
+        \brief Returns the index of the item that wraps the given object.
+
+        The items of the object and its parents are created when needed, provided that the object
+        is part of one of the object hierarchies. The item of a destroyed object can still be found
+        by its former address, until the next refresh removes it.
+        \param[in] inObject The object, or 0 when it has been destroyed
+        \param[in] inKey    (optional) The address of the object, required when it has been destroyed
+        \return             The index of the item; otherwise an invalid index
+    */
+    QModelIndex ObjectModel::GetIndex (const QObject* inObject, const void* inKey) {
+        if (!inObject) {
+            // the object can not be dereferenced, only an existing item can be found
+            return IndexOf (mItems.value (inKey));
+        }
+        if (const ObjectItem* item = FindItem (inObject)) {
+            return IndexOf (item);
+        }
+        // create the items between the closest ancestor that has an item and the object
+        QVector <const QObject*> path (1, inObject);
+        for (const QObject* parent = inObject->parent (); parent; parent = parent->parent ()) {
+            if (const ObjectItem* parentItem = FindItem (parent)) {
+                const ObjectItem* item = FetchPath (parentItem, path);
+                return item->Object () == inObject ? IndexOf (item) : QModelIndex ();
+            }
+            path.prepend (parent);
+        }
+        return QModelIndex ();
+    }
+
+    /*!
+        \brief Returns the index of the item that wraps the first of the given objects.
+
+        The items between the closest object that has an item and the first object are created.
+        The objects are not dereferenced, so they may have been destroyed.
+        \param[in] inAncestors  An object followed by all its parents, see ObjectSearchIndex::Ancestors
+        \return                 The index of the item; otherwise an invalid index
+    */
+    QModelIndex ObjectModel::GetIndex (const QVector <const QObject*>& inAncestors) {
+        for (int a=0; a<inAncestors.size (); a++) {
+            if (const ObjectItem* item = FindItem (inAncestors [a])) {
+                QVector <const QObject*> path;
+                for (int p=a-1; p>=0; p--) {
+                    path.push_back (inAncestors [p]);
+                }
+                const ObjectItem* result = FetchPath (item, path);
+                return result->Key () == inAncestors.first () ? IndexOf (result) : QModelIndex ();
+            }
+        }
+        return QModelIndex ();
+    }
+
+    /*!
+        \brief Returns the search index of all object hierarchies.
+
+        The index is built on first use, and then updated together with the items, see
+        SlotRefresh and SlotRefreshChangedObjects. It is only rebuilt when an update fails.
+    */
+    const ObjectSearchIndex& ObjectModel::SearchIndex () {
+        if (!mSearchIndexValid) {
+            mSearchIndex.Clear ();
+            int childCount = mRoot->ChildCount ();
+            for (int c=0; c<childCount; c++) {
+                if (const QObject* object = mRoot->Child (c)->Object ()) {
+                    mSearchIndex.AddHierarchy (object);
+                }
+            }
+            mSearchIndexValid = true;
+        }
+        return mSearchIndex;
+    }
+
+    /*!
+        \brief Returns the entries of the search index of all objects that match the given query, in the order of the view.
+    */
+    QVector <int> ObjectModel::FindObjects (const ObjectQuery& inQuery) {
+        QVector <int> results = SearchIndex ().Find (inQuery);
+        qSort (results.begin (), results.end (), SearchOrder ());
+        return results;
+    }
+
+    /*!
+        \brief Returns a function object that sorts the entries of the search index in the order of the view.
+    */
+    SearchEntrySorter ObjectModel::SearchOrder () {
+        return SearchEntrySorter (SearchIndex (), ObjectItemSorter (mSortOrder, mSortColumn == kAddress));
+    }
+
     /*!
         \brief Returns the item referred to by the given index.
     */
@@ -368,27 +904,92 @@ namespace conan {
         return item ? item->Object () : 0;
     }
 
+    /*!
+        \brief Returns the address of the object wrapped by the item with the given index, which remains valid after the object has been destroyed.
+    */
+    const void* ObjectModel::GetKey (const QModelIndex& inIndex) const {
+        const ObjectItem* item = GetItem (inIndex);
+        return item ? item->Key () : 0;
+    }
+
     /*!
         \brief The complete object hierarchy is refreshed.
-        Note the modelReset signal is emitted.
+        Only the rows of new, destroyed and renamed objects change; all other items are kept.
     */
     void ObjectModel::SlotRefresh () {
-        // store current root objects
-        QVector <QPointer <QObject> > rootObjects;
+        // a complete refresh includes all pending changes
+        mChangedObjects.clear ();
+        Synchronize (mRoot);
         int childCount = mRoot->ChildCount ();
-        for (int c=0; c<childCount; c++) {
-            const ObjectItem* item = mRoot->Child (c);
-            if (QObject* object = const_cast <QObject*> (item->Object ())) {
-                rootObjects.push_back (object);
+        for (int c=0; c<childCount && mSearchIndexValid; c++) {
+            if (const QObject* object = mRoot->Child (c)->Object ()) {
+                mSearchIndexValid = mSearchIndex.Synchronize (object);
             }
         }
-        // destroy item hierarchy
-        mRoot->RemoveAllChildren ();
-        // restore previous root objects
-        foreach (const QObject* object, rootObjects) {
-            mRoot->AddChild (object);
+    }
+
+    /*!
+        \brief Enables or disables tracking of object creation and destruction.
+
+        When enabled, the child added and removed events of all objects that live in the gui
+        thread are observed through an application event filter. The hierarchies of objects
+        living in other threads are only updated by SlotRefresh.
+    */
+    void ObjectModel::SlotSetAutoRefresh (bool inEnabled) {
+        if (inEnabled == mAutoRefresh) {
+            return;
+        }
+        mAutoRefresh = inEnabled;
+        if (QCoreApplication* application = QCoreApplication::instance ()) {
+            if (mAutoRefresh) {
+                application->installEventFilter (this);
+            }
+            else {
+                application->removeEventFilter (this);
+            }
+        }
+        if (!mAutoRefresh) {
+            mAutoRefreshTimer.stop ();
+            mChangedObjects.clear ();
+        }
+    }
+
+    /*!
+        \brief Collects the objects whose children have changed, see SlotSetAutoRefresh.
+
+        The child may still be under construction or destruction when the event is received, so
+        the change is applied later by SlotRefreshChangedObjects.
+    */
+    bool ObjectModel::eventFilter (QObject* inObject, QEvent* inEvent) {
+        QEvent::Type type = inEvent->type ();
+        if (mAutoRefresh && (type == QEvent::ChildAdded || type == QEvent::ChildRemoved)) {
+            if (!mChangedObjects.contains (inObject)) {
+                mChangedObjects.insert (inObject, inObject);
+            }
+            if (!mAutoRefreshTimer.isActive ()) {
+                mAutoRefreshTimer.start ();
+            }
+        }
+        return QAbstractItemModel::eventFilter (inObject, inEvent);
+    }
+
+    /*!
+        \brief Synchronizes the items of the objects whose children have changed since the last call.
+    */
+    void ObjectModel::SlotRefreshChangedObjects () {
+        QHash <const QObject*, QPointer <QObject> > changedObjects = mChangedObjects;
+        mChangedObjects.clear ();
+        QHash <const QObject*, QPointer <QObject> >::const_iterator it;
+        for (it = changedObjects.constBegin (); it != changedObjects.constEnd (); ++it) {
+            // changed objects may have been destroyed, FindItem does not dereference them
+            if (ObjectItem* item = FindItem (it.key ())) {
+                SynchronizeChildren (item);
+            }
+            // the changes may be part of hierarchies that have not been expanded
+            if (mSearchIndexValid && it.value ()) {
+                mSearchIndexValid = mSearchIndex.SynchronizeChildren (it.value ());
+            }
         }
-        reset ();
     }
 
     /*!
@@ -396,60 +997,86 @@ namespace conan {
     */
     void ObjectModel::SlotSort () {
         emit layoutAboutToBeChanged ();
-        // for each persistent index store the corresponding object address
         QModelIndexList persistentIndices = persistentIndexList ();
-        QStringList addresses;
-        foreach (QModelIndex index, persistentIndices) {
-            const QObject* object = GetObject (index);
-            addresses.append (ObjectUtility::Address (object));
-        }
         // perform the actual sorting
-        mRoot->Sort (ObjectItemSorter (mSortOrder, mSortColumn == kAddress));
-        // update each persistent index
-        foreach (QModelIndex from, persistentIndices) {
-            int newRow = FindObject (MatchObjectByValue (addresses.front ())).row ();
-            QModelIndex to = index (newRow, from.column (), from.parent ());
-            changePersistentIndex (from, to);
-            addresses.pop_front ();
+        SortItems ();
+        // each index refers to its item, which knows its new row
+        QModelIndexList newIndices;
+        foreach (const QModelIndex& from, persistentIndices) {
+            const ObjectItem* item = GetItem (from);
+            newIndices.append (createIndex (item->Index (), from.column (), const_cast <ObjectItem*> (item)));
         }
+        changePersistentIndexList (persistentIndices, newIndices);
         emit layoutChanged ();
     }
 
+    /*!
+        \brief Sorts all created items using the current sort settings.
+
+        The children of each item are sorted independently of all other items, so large trees are
+        sorted by the global thread pool. The stored rows are updated while sorting.
+    */
+    void ObjectModel::SortItems () {
+        ObjectItemSorter sorter (mSortOrder, mSortColumn == kAddress);
+        QList <SortTask> tasks;
+        int itemCount = 0;
+        QVector <ObjectItem*> items (1, mRoot);
+        while (!items.isEmpty ()) {
+            ObjectItem* item = items.back ();
+            items.pop_back ();
+            int childCount = item->ChildCount ();
+            if (childCount > 1) {
+                tasks.append (SortTask (item, sorter));
+            }
+            for (int c=0; c<childCount; c++) {
+                items.push_back (const_cast <ObjectItem*> (item->Child (c)));
+            }
+            itemCount += childCount;
+        }
+        if (itemCount < kParallelSortItemCount) {
+            for (int t=0; t<tasks.size (); t++) {
+                RunSortTask (tasks [t]);
+            }
+        }
+        else {
+            QtConcurrent::blockingMap (tasks, RunSortTask);
+        }
+    }
+
     /*!
         \brief Finds all top level widgets and adds them to the model.
-        Note the modelReset signal is emitted.
+        Existing hierarchies are kept, unless they are merged into the hierarchy of their top level parent.
     */
     void ObjectModel::DiscoverRootObjects () {
-        // discover top level parents of all current root objects
+        // discover top level parents of all current root objects, and remove destroyed root objects
         QVector <QPointer <QObject> > rootObjects;
-        int childCount = mRoot->ChildCount ();
-        for (int c=0; c<childCount; c++) {
+        for (int c=mRoot->ChildCount ()-1; c>=0; c--) {
             if (const QObject* object = mRoot->Child (c)->Object ()) {
                 const QObject* parent = ObjectUtility::TopLevelParent (object);
                 rootObjects.push_back (const_cast <QObject*> (parent));
             }
+            else {
+                RemoveItem (mRoot, c);
+            }
         }
-        // destroy item hierarchy
-        mRoot->RemoveAllChildren ();
         // add the discovered top level parents
         foreach (const QObject* object, rootObjects) {
-            mRoot->AddChild (object);
+            AddRootObject (object);
         }
         // add various static objects
-        mRoot->AddChild (QCoreApplication::instance ());
-        mRoot->AddChild (QApplication::desktop ());
-        mRoot->AddChild (QApplication::clipboard ());
-        mRoot->AddChild (QApplication::style ());
+        AddRootObject (QCoreApplication::instance ());
+        AddRootObject (QApplication::desktop ());
+        AddRootObject (QApplication::clipboard ());
+        AddRootObject (QApplication::style ());
 
         // add all top level widgets retrieved from the application
         if (qApp) {
             QWidgetList widgets = qApp->topLevelWidgets ();
             foreach (const QWidget* widget, widgets) {
-                mRoot->AddChild (widget);
+                AddRootObject (widget);
             }
-            mRoot->AddChild (qApp->inputContext ());
-        }        
-        reset ();
+            AddRootObject (qApp->inputContext ());
+        }
     }
 
     /*!
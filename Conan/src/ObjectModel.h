@@ -29,8 +29,13 @@
 
 
 #include "ConanDefines.h"
+#include "ObjectSearchIndex.h"
 #include <QtCore/QAbstractItemModel>
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
 #include <QtCore/QPointer>
+#include <QtCore/QSet>
+#include <QtCore/QTimer>
 #include <QtCore/QVector>
 #include <QtCore/QtAlgorithms>
 
@@ -48,6 +53,11 @@ namespace conan {
 
     /*!
         \brief Used to wrap QObjects for use in a ObjectModel.
+
+        Child items are created on demand, see FetchChildren. Only the object name is copied during
+        construction; the class name and address strings are created when they are first used.
+        Each item stores its index at its parent, which is kept up to date when children are
+        inserted, removed, moved and sorted.
     */
     class CONAN_LOCAL ObjectItem {
 
@@ -59,45 +69,91 @@ namespace conan {
         int ChildIndex (const ObjectItem* inChild) const;
         int ChildCount () const;
 
+        bool IsFetched () const;
+        bool HasChildren () const;
+        int UnfetchedChildCount () const;
+        void FetchChildren ();
+
+        void InsertChild (int inIndex, ObjectItem* inChild);
+        void MoveChild (int inFrom, int inTo);
+        ObjectItem* TakeChild (int inIndex);
+        bool UpdateName ();
+
         const ObjectItem* Parent () const;
         const ObjectItem* Child (int inIndex) const;
         const QObject* Object () const;
+        const void* Key () const;
 
         const QString& Name () const;
         const QString& Class () const;
+        const char* ClassName () const;
         const QString& Address () const;
 
         template <typename Pred>
-        const ObjectItem* Find (Pred inPred, const ObjectItem* inStartItem=0, bool* inActive=0) const;
+        const ObjectItem* Find (Pred inPred, const ObjectItem* inStartItem=0, bool* inActive=0, QVector <const QObject*>* outPath=0) const;
 
         template <typename Pred>
         void Sort (Pred inPred);
 
+        template <typename Pred>
+        void SortChildren (Pred inPred);
+
+        template <typename Pred>
+        int SortedIndex (const ObjectItem* inItem, Pred inPred) const;
+
     protected:
         void Reset ();
+        void UpdateRows (int inFrom);
+
+    private:
+        template <typename Pred>
+        static bool FindInObjectTree (Pred& inPred, const QObject* inObject, QVector <const QObject*>& ioPath);
 
     protected:
         const ObjectItem* mParent;
         QVector <ObjectItem*> mChildren;
+        int mRow;                               //!< The index of this item at mParent
+        bool mFetched;                          //!< True when the child items have been created
         QPointer <QObject> mObject;             //!< The wrapped QObject, or 0 when it has been destroyed
-        QString mAddress;                       //!< The address of mObject
+        const void* mKey;                       //!< The address of mObject, remains valid after mObject has been destroyed
+        const char* mClassName;                 //!< The class name of mObject, points into static moc data
         QString mName;                          //!< The object name of mObject
-        QString mClass;                         //!< The class name of mObject
+        mutable QString mAddress;               //!< The address of mObject, created on first use
+        mutable QString mClass;                 //!< The class name of mObject, created on first use
     };
 
     /*!
         \brief Starts a recursive search for an item whose name, class or address matches a given value.
+
+        Object hierarchies whose items have not been created yet are searched as well, using
+        temporary items. When the match is found in such a hierarchy, the closest existing item is
+        returned and \p outPath receives the objects from that item down to the match; see
+        ObjectModel::FindObject.
         \param[in] inPred       A unary predicate function object that defines the matching criterion
         \param[in] inStartItem  (optional) The item at which the search starts or stops; depends on \p inActive
         \param[in] inActive     (optional) When false the search starts at \p inStartItem; otherwise the search stops at \p inStartItem
+        \param[out] outPath     (optional) The objects between the returned item and the actual match
         \return                 The item that matches \p inValue; otherwise 0
     */
     template <typename Pred>
-    const ObjectItem* ObjectItem::Find (Pred inPred, const ObjectItem* inStartItem, bool* inActive) const {
+    const ObjectItem* ObjectItem::Find (Pred inPred, const ObjectItem* inStartItem, bool* inActive, QVector <const QObject*>* outPath) const {
         if (inActive && inStartItem == this) {
             // (de)active the actual matching when the startItem has been encountered
             (*inActive) = !(*inActive);
         }
+        if (!mFetched) {
+            // the start item always exists, so an inactive search can skip the whole object hierarchy
+            if (mObject && (!inActive || (*inActive))) {
+                QVector <const QObject*> path;
+                if (FindInObjectTree (inPred, mObject, path)) {
+                    if (outPath) {
+                        (*outPath) = path;
+                    }
+                    return this;
+                }
+            }
+            return 0;
+        }
         foreach (const ObjectItem* item, mChildren) {
             if (!inActive || (*inActive)) {
                 if (inPred (item)) {
@@ -105,26 +161,79 @@ namespace conan {
                 }
             }
             // recurse
-            if (const ObjectItem* child = item->Find (inPred, inStartItem, inActive)) {
+            if (const ObjectItem* child = item->Find (inPred, inStartItem, inActive, outPath)) {
                 return child;
             }
         }
         return 0;
     }
 
+    /*!
+        \brief Searches the children of the given object recursively, without creating any permanent items.
+        \param[in]      inPred  A unary predicate function object that defines the matching criterion
+        \param[in]      inObject The object whose children are searched
+        \param[in,out]  ioPath  The objects from the first child of \p inObject down to the match
+        \return                 True when a match was found
+    */
+    template <typename Pred>
+    bool ObjectItem::FindInObjectTree (Pred& inPred, const QObject* inObject, QVector <const QObject*>& ioPath) {
+        foreach (const QObject* object, inObject->children ()) {
+            ioPath.push_back (object);
+            ObjectItem item (object);
+            if (inPred (&item)) {
+                return true;
+            }
+            if (FindInObjectTree (inPred, object, ioPath)) {
+                return true;
+            }
+            ioPath.pop_back ();
+        }
+        return false;
+    }
+
     /*!
         \brief Sort all children recursively.
         \param[in] inPred   A binary predicate function object that defines the comparison criterion
     */
     template <typename Pred>
     void ObjectItem::Sort (Pred inPred) {
-        qSort (mChildren.begin (), mChildren.end (), inPred);
+        SortChildren (inPred);
 
         foreach (ObjectItem* item, mChildren) {
             item->Sort (inPred);
         }
     }
 
+    /*!
+        \brief Sort the direct children only.
+        \param[in] inPred   A binary predicate function object that defines the comparison criterion
+    */
+    template <typename Pred>
+    void ObjectItem::SortChildren (Pred inPred) {
+        qSort (mChildren.begin (), mChildren.end (), inPred);
+        UpdateRows (0);
+    }
+
+    /*!
+        \brief Returns the index at which the given item belongs, among all children except the item itself.
+        \param[in] inItem   The item, which may or may not be a child
+        \param[in] inPred   A binary predicate function object that defines the comparison criterion
+    */
+    template <typename Pred>
+    int ObjectItem::SortedIndex (const ObjectItem* inItem, Pred inPred) const {
+        // the children are sorted, so all children that precede the item come first
+        int index = 0;
+        foreach (const ObjectItem* item, mChildren) {
+            if (item != inItem) {
+                if (!inPred (item, inItem)) {
+                    break;
+                }
+                index++;
+            }
+        }
+        return index;
+    }
+
 
     // ------------------------------------------------------------------------------------------------
 
@@ -137,8 +246,9 @@ namespace conan {
 
     public:
         RootItem ();
-        void AddChild (const QObject* inObject);
-        void RemoveChild (const QObject* inObject);
+        bool Contains (const QObject* inObject) const;
+        int FindMergeableChild (const QObject* inObject, const QObject** outParent) const;
+        int FindChild (const QObject* inObject) const;
         void RemoveAllChildren ();
     };
 
@@ -146,32 +256,13 @@ namespace conan {
     // ------------------------------------------------------------------------------------------------
 
 
-     /*!
-        \brief A unary function object that defines a matching criteria for ObjectItem
-        \param[in] inValue          Defines the value that is macthed to the class, name, address of an ObjectItem
-    */
-    struct CONAN_LOCAL MatchObjectByValue
-    {
-        MatchObjectByValue (const QString& inValue) :
-            mValue (inValue)
-        {}
-
-        bool operator () (const ObjectItem* inItem) {
-            return (inItem && (
-                        inItem->Name ().contains (mValue, Qt::CaseInsensitive) ||
-                        inItem->Class ().contains (mValue, Qt::CaseInsensitive) ||
-                        inItem->Address ().contains (mValue, Qt::CaseInsensitive)));
-        }
-
-        QString mValue;
-    };
-
-
-    // ----------------------------------------------------------------------------------------
-
-
     /*!
         \brief A binary function object that defines a sorting criteria for ObjectItem: class, name, address
+
+        Only the keys that each item captured during construction are compared: the class name in
+        the moc data, the object name and the object address. Addresses are formatted with a fixed
+        width, so comparing them as integers yields the same order as comparing the address strings.
+        No strings are created while sorting, and the function object may be used from any thread.
         \param[in] inOrder          Defines the sortorder, either ascending or descending
         \param[in] inAddressFirst   When true items are first sorted by address, then by class and name
     */
@@ -182,29 +273,31 @@ namespace conan {
             mSortOrder (inOrder)
         {}
 
-        bool operator () (const ObjectItem* inItem1, const ObjectItem* inItem2) {
-            if (mAddressFirst && inItem1->Address () != inItem2->Address ()) {
-                return mSortOrder == Qt::AscendingOrder ?
-                    inItem1->Address () < inItem2->Address () :
-                inItem1->Address () > inItem2->Address ();
+        bool operator () (const ObjectItem* inItem1, const ObjectItem* inItem2) const {
+            return Less (inItem1->Key (), inItem1->ClassName (), inItem1->Name (), inItem2->Key (), inItem2->ClassName (), inItem2->Name ());
+        }
+
+        bool Less (const void* inKey1, const char* inClass1, const QString& inName1, const void* inKey2, const char* inClass2, const QString& inName2) const {
+            bool ascending = mSortOrder == Qt::AscendingOrder;
+            if (!ascending) {
+                qSwap (inKey1, inKey2);
+                qSwap (inClass1, inClass2);
             }
-            if (inItem1->Class () == inItem2->Class ()) {
-                if (inItem1->Name () == inItem2->Name ()) {
-                    return mSortOrder == Qt::AscendingOrder ?
-                        inItem1->Address () < inItem2->Address () :
-                    inItem1->Address () > inItem2->Address ();
-                }
-                else {
-                    return mSortOrder == Qt::AscendingOrder ?
-                        inItem1->Name () < inItem2->Name () :
-                    inItem1->Name () > inItem2->Name ();
-                }
+            const QString& name1 = ascending ? inName1 : inName2;
+            const QString& name2 = ascending ? inName2 : inName1;
+            quintptr address1 = reinterpret_cast <quintptr> (inKey1);
+            quintptr address2 = reinterpret_cast <quintptr> (inKey2);
+            if (mAddressFirst && address1 != address2) {
+                return address1 < address2;
+            }
+            int classOrder = qstrcmp (inClass1, inClass2);
+            if (classOrder != 0) {
+                return classOrder < 0;
             }
-            else {
-                return mSortOrder == Qt::AscendingOrder ?
-                    inItem1->Class () < inItem2->Class () :
-                inItem1->Class () > inItem2->Class ();
+            if (name1 != name2) {
+                return name1 < name2;
             }
+            return address1 < address2;
         }
 
         bool mAddressFirst;
@@ -212,16 +305,43 @@ namespace conan {
     };
 
 
+    /*!
+        \brief A binary function object that sorts the entries of an ObjectSearchIndex in the order of the view.
+
+        An entry is placed before its descendants, and the entries of siblings are compared with
+        the same criteria as their items, see ObjectItemSorter. Only the keys stored in the index
+        are compared, no object is dereferenced.
+    */
+    struct CONAN_LOCAL SearchEntrySorter
+    {
+        SearchEntrySorter (const ObjectSearchIndex& inIndex, const ObjectItemSorter& inSorter) :
+            mIndex (&inIndex),
+            mSorter (inSorter)
+        {}
+
+        bool operator () (int inEntry1, int inEntry2) const;
+
+        const ObjectSearchIndex* mIndex;
+        ObjectItemSorter mSorter;
+    };
+
+
     // --------------------------------------------------------------------------------------------
 
 
     /*!
         \brief A read-only model for displaying one or more object hierarchies.
 
-        Note that this model is static. It does not update automatically when objects are created
+        By default this model is static. It does not update automatically when objects are created
         or destroyed. However, it does detect when objects are destroyed and marks the corresponding
         items disabled and non-selectable. The function SlotRefresh is provided to manually update
-        all object hierarchies.
+        all object hierarchies. Updates are incremental: existing items are kept, so expanded and
+        selected items remain so, and only the rows of added and removed objects are inserted or
+        removed.
+
+        When auto refresh is enabled, child added and removed events of objects living in the gui
+        thread are tracked through an application event filter. Changes are collected and applied
+        together once control returns to the event loop.
     */
     class CONAN_LOCAL ObjectModel : public QAbstractItemModel
     {
@@ -241,11 +361,18 @@ namespace conan {
         void RemoveRootObject (const QObject* inObject);
         void RemoveAllRootObjects ();
         void DiscoverRootObjects ();
+        bool IsAutoRefreshEnabled () const;
 
         template <typename Pred>
-        QModelIndex FindObject (Pred inPred, const QModelIndex& inStart = QModelIndex ()) const;
+        QModelIndex FindObject (Pred inPred, const QModelIndex& inStart = QModelIndex ());
+        QModelIndex GetIndex (const QObject* inObject, const void* inKey = 0);
+        QModelIndex GetIndex (const QVector <const QObject*>& inAncestors);
+        const ObjectSearchIndex& SearchIndex ();
+        QVector <int> FindObjects (const ObjectQuery& inQuery);
+        SearchEntrySorter SearchOrder ();
 
         const QObject* GetObject (const QModelIndex& inIndex) const;
+        const void* GetKey (const QModelIndex& inIndex) const;
         QString GetClass (const QModelIndex& inIndex) const;
         QString GetObjectName (const QModelIndex& inIndex) const;
         QString GetAddress (const QModelIndex& inIndex) const;
@@ -258,40 +385,73 @@ namespace conan {
         virtual QVariant headerData (int inSection, Qt::Orientation inOrientation, int inRole = Qt::DisplayRole) const;
         virtual QModelIndex index (int inRow, int inColumn, const QModelIndex& inParent = QModelIndex ()) const;
         virtual QModelIndex parent (const QModelIndex& inIndex) const;
+        virtual bool hasChildren (const QModelIndex& inParent = QModelIndex ()) const;
+        virtual bool canFetchMore (const QModelIndex& inParent) const;
+        virtual void fetchMore (const QModelIndex& inParent);
         virtual void sort (int inColumn, Qt::SortOrder inOrder = Qt::AscendingOrder);
 
+    protected:
+        virtual bool eventFilter (QObject* inObject, QEvent* inEvent);
+
     private:
         const ObjectItem* GetItem (const QModelIndex& inIndex) const;
+        void FetchChildren (const ObjectItem* inItem);
+        const ObjectItem* FetchPath (const ObjectItem* inItem, const QVector <const QObject*>& inPath);
+        QModelIndex IndexOf (const ObjectItem* inItem) const;
+        ObjectItem* FindItem (const QObject* inObject) const;
+        void AddToIndex (const ObjectItem* inItem);
+        void RemoveFromIndex (const ObjectItem* inItem);
+        void InsertItem (ObjectItem* inParent, ObjectItem* inChild);
+        void RemoveItem (ObjectItem* inParent, int inRow);
+        void UpdateItem (ObjectItem* inItem);
+        void SynchronizeChildren (ObjectItem* inItem);
+        void Synchronize (ObjectItem* inItem);
+        void SortItems ();
 
     public slots:
         void SlotRefresh ();
+        void SlotSetAutoRefresh (bool inEnabled);
 
     private slots:
         void SlotSort ();
+        void SlotRefreshChangedObjects ();
 
     private:
-        RootItem* mRoot;            //!< The root item of the model that contains all object hierarchies
-        int mSortColumn;            //!< The primary sort column
-        Qt::SortOrder mSortOrder;   //!< The current sort order (ascending or descending)
+        RootItem* mRoot;                            //!< The root item of the model that contains all object hierarchies
+        int mSortColumn;                            //!< The primary sort column
+        Qt::SortOrder mSortOrder;                   //!< The current sort order (ascending or descending)
+        QHash <const void*, ObjectItem*> mItems;    //!< map <object address, item> of all created items
+        ObjectSearchIndex mSearchIndex;             //!< All objects of all hierarchies, built on first use and then updated with the items
+        bool mSearchIndexValid;                     //!< False when mSearchIndex has to be rebuilt
+        bool mAutoRefresh;                          //!< When true child events are tracked, see SlotSetAutoRefresh
+        QHash <const QObject*, QPointer <QObject> > mChangedObjects;    //!< map <address, object> of the objects whose children changed since the last auto refresh
+        QTimer mAutoRefreshTimer;                   //!< Collects child events into a single auto refresh
     };
 
     /*!
         \brief Finds the object whose class, name or address matches the given value.
+
+        Object hierarchies that have not been expanded are searched as well. The items between
+        the closest existing item and the found object are created.
         \param[in] inPred   A unary predicate function object that defines the matching criterion
         \param[in] inStart  The item to start searching from (note that the search wraps)
         \return             The item that wraps the found object
     */
     template <typename Pred>
-    QModelIndex ObjectModel::FindObject (Pred inPred, const QModelIndex& inStart) const {
+    QModelIndex ObjectModel::FindObject (Pred inPred, const QModelIndex& inStart) {
         const ObjectItem* startItem = GetItem (inStart);
         bool active = false;
+        QVector <const QObject*> path;
         // find starting from startItem
-        const ObjectItem* result = mRoot->Find (inPred, startItem, &active);
+        const ObjectItem* result = mRoot->Find (inPred, startItem, &active, &path);
         if (!result) {
             // wrap search
             active = true;
             // find untill startItem
-            result = mRoot->Find (inPred, startItem, &active);
+            result = mRoot->Find (inPred, startItem, &active, &path);
+        }
+        if (result && !path.isEmpty ()) {
+            result = FetchPath (result, path);
         }
         QModelIndex modelIndex;
         if (result)  {
@@ -0,0 +1,662 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains ObjectSearchIndex related definitions
+*/
+
+
+#include "ObjectSearchIndex.h"
+#include "ObjectUtility.h"
+#include <QtCore/QMetaObject>
+#include <QtCore/QObject>
+#include <QtCore/QPair>
+#include <QtCore/QThread>
+#include <QtCore/QtAlgorithms>
+
+
+namespace conan {
+
+    namespace /*unnamed*/ {
+
+        /*!
+            \brief Returns the trigram that starts at the given character.
+        */
+        quint64 TrigramKey (const QChar* inChars) {
+            return (quint64 (inChars [0].unicode ()) << 32) | (quint64 (inChars [1].unicode ()) << 16) | quint64 (inChars [2].unicode ());
+        }
+
+        /*!
+            \brief Returns the entries that are part of both sorted lists.
+        */
+        QVector <int> Intersect (const QVector <int>& inList1, const QVector <int>& inList2) {
+            QVector <int> result;
+            int i1 = 0;
+            int i2 = 0;
+            while (i1 < inList1.size () && i2 < inList2.size ()) {
+                if (inList1 [i1] < inList2 [i2]) {
+                    i1++;
+                }
+                else if (inList2 [i2] < inList1 [i1]) {
+                    i2++;
+                }
+                else {
+                    result.push_back (inList1 [i1]);
+                    i1++;
+                    i2++;
+                }
+            }
+            return result;
+        }
+
+        /*!
+            \brief Returns the entries that are part of either sorted list.
+        */
+        QVector <int> Unite (const QVector <int>& inList1, const QVector <int>& inList2) {
+            QVector <int> result;
+            result.reserve (inList1.size () + inList2.size ());
+            int i1 = 0;
+            int i2 = 0;
+            while (i1 < inList1.size () || i2 < inList2.size ()) {
+                if (i2 == inList2.size () || (i1 < inList1.size () && inList1 [i1] < inList2 [i2])) {
+                    result.push_back (inList1 [i1++]);
+                }
+                else if (i1 == inList1.size () || inList2 [i2] < inList1 [i1]) {
+                    result.push_back (inList2 [i2++]);
+                }
+                else {
+                    result.push_back (inList1 [i1]);
+                    i1++;
+                    i2++;
+                }
+            }
+            return result;
+        }
+
+        /*!
+            \brief Returns the class name of the given object, which points into static moc data.
+        */
+        const char* ClassNameOf (const QObject* inObject) {
+            const QMetaObject* metaObject = inObject->metaObject ();
+            return metaObject ? metaObject->className () : "";
+        }
+
+        /*!
+            \brief Returns the thread field of an object in the given thread, the names are cached in the given map.
+        */
+        QString ThreadField (const QThread* inThread, QHash <const QThread*, QString>& ioThreadNames) {
+            QHash <const QThread*, QString>::const_iterator it = ioThreadNames.find (inThread);
+            if (it == ioThreadNames.end ()) {
+                it = ioThreadNames.insert (inThread, ObjectUtility::ThreadName (inThread).toLower ());
+            }
+            return it.value ();
+        }
+
+    } // unnamed namespace
+
+
+    /*!
+        \brief Constructs an empty term that matches nothing.
+    */
+    ObjectQuery::Term::Term () :
+        mField (kAnyField),
+        mWildcard (false)
+    {}
+
+    /*!
+        \brief Returns true when the given field value, in lower case, matches this term.
+    */
+    bool ObjectQuery::Term::Matches (const QString& inValue) const {
+        return mWildcard ? mPattern.exactMatch (inValue) : inValue.contains (mValue);
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Parses the given query text, see ObjectQuery for the syntax.
+    */
+    ObjectQuery::ObjectQuery (const QString& inText) {
+        static const char* sFieldNames [kFieldCount] = { "class", "name", "address", "thread" };
+
+        QStringList tokens = inText.split (QRegExp ("\\s+"), QString::SkipEmptyParts);
+        foreach (const QString& token, tokens) {
+            Term term;
+            term.mValue = token.toLower ();
+            // class names may contain colons as well, so only known field names are recognized
+            int colon = token.indexOf (':');
+            if (colon > 0) {
+                QString fieldName = term.mValue.left (colon);
+                for (int f=0; f<kFieldCount; f++) {
+                    if (fieldName == sFieldNames [f]) {
+                        term.mField = f;
+                        term.mValue = term.mValue.mid (colon + 1);
+                        break;
+                    }
+                }
+            }
+            if (term.mValue.isEmpty ()) {
+                continue;
+            }
+            term.mWildcard = term.mValue.contains ('*') || term.mValue.contains ('?');
+            if (term.mWildcard) {
+                term.mPattern = QRegExp (term.mValue, Qt::CaseInsensitive, QRegExp::Wildcard);
+            }
+            // character sets have no literal parts that can be looked up
+            if (!term.mValue.contains ('[')) {
+                term.mLiterals = term.mValue.split (QRegExp ("[*?]"), QString::SkipEmptyParts);
+            }
+            mTerms.push_back (term);
+        }
+    }
+
+    /*!
+        \brief Returns true when the query contains no terms.
+    */
+    bool ObjectQuery::IsEmpty () const {
+        return mTerms.isEmpty ();
+    }
+
+    /*!
+        \brief Returns the terms of the query.
+    */
+    const QVector <ObjectQuery::Term>& ObjectQuery::Terms () const {
+        return mTerms;
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    ObjectSearchIndex::ObjectSearchIndex () :
+        mRemovedCount (0)
+    {}
+
+    /*!
+        \brief Removes all entries.
+    */
+    void ObjectSearchIndex::Clear () {
+        mEntries.clear ();
+        mEntryIndex.clear ();
+        for (int f=0; f<ObjectQuery::kFieldCount; f++) {
+            mTrigrams [f].clear ();
+        }
+        mRemovedCount = 0;
+    }
+
+    /*!
+        \brief Adds the given object and all its descendants to the index, unless the object is already part of it.
+    */
+    void ObjectSearchIndex::AddHierarchy (const QObject* inRoot) {
+        if (!inRoot || mEntryIndex.contains (inRoot)) {
+            return;
+        }
+        ThreadNames threadNames;
+        AddSubtree (inRoot, -1, threadNames);
+    }
+
+    /*!
+        \brief Adds the given object and all its descendants below the entry of the given parent.
+
+        Nothing is done when the parent is not part of the index, or when the object already is.
+        An entry of a destroyed object at the same address is replaced.
+        \param[in] inObject     The object
+        \param[in] inParent     The parent, never dereferenced; or 0 to add the object as root
+    */
+    void ObjectSearchIndex::Insert (const QObject* inObject, const void* inParent) {
+        if (!inObject) {
+            return;
+        }
+        int parent = inParent ? EntryOf (inParent) : -1;
+        if (inParent && parent < 0) {
+            return;
+        }
+        int entry = EntryOf (inObject);
+        if (entry >= 0) {
+            if (mEntries [entry].mParent == parent && IsEntryOf (entry, inObject)) {
+                return;
+            }
+            RemoveSubtree (entry);
+        }
+        ThreadNames threadNames;
+        AddSubtree (inObject, parent, threadNames);
+        Compact ();
+    }
+
+    /*!
+        \brief Removes the entries of the given object and all its descendants, the object is never dereferenced.
+    */
+    void ObjectSearchIndex::Remove (const void* inObject) {
+        int entry = EntryOf (inObject);
+        if (entry >= 0) {
+            RemoveSubtree (entry);
+            Compact ();
+        }
+    }
+
+    /*!
+        \brief Compares the child entries of the given object with its current children.
+
+        Subtrees are added for new children, and removed for children that were destroyed or
+        moved to another parent. The children of the remaining children are not compared.
+        \return False when the entry at the address of the object belongs to a destroyed object,
+                f.e. because its removal was not tracked; the index should then be rebuilt
+    */
+    bool ObjectSearchIndex::SynchronizeChildren (const QObject* inObject) {
+        int entry = EntryOf (inObject);
+        if (entry < 0) {
+            return true;
+        }
+        if (!IsEntryOf (entry, inObject)) {
+            return false;
+        }
+        ThreadNames threadNames;
+        SynchronizeEntry (entry, inObject, false, threadNames);
+        Compact ();
+        return true;
+    }
+
+    /*!
+        \brief Compares the entries of the given hierarchy with the current objects, the hierarchy is added when needed.
+
+        Only the entries of new, destroyed, moved and renamed objects are changed, the strings and
+        trigrams of all other objects are kept.
+        \return False when the entry at the address of the root belongs to a destroyed object; the
+                index should then be rebuilt
+    */
+    bool ObjectSearchIndex::Synchronize (const QObject* inRoot) {
+        int entry = EntryOf (inRoot);
+        if (entry < 0) {
+            AddHierarchy (inRoot);
+            return true;
+        }
+        if (!IsEntryOf (entry, inRoot)) {
+            return false;
+        }
+        ThreadNames threadNames;
+        SynchronizeEntry (entry, inRoot, true, threadNames);
+        Compact ();
+        return true;
+    }
+
+    /*!
+        \brief Adds the given object and all its descendants, in depth first order.
+        \return The entry of the object
+    */
+    int ObjectSearchIndex::AddSubtree (const QObject* inRoot, int inParent, ThreadNames& ioThreadNames) {
+        int root = mEntries.size ();
+        // the children are pushed in reverse order, so they are popped in their actual order
+        QVector <QPair <const QObject*, int> > objects;
+        objects.push_back (qMakePair (inRoot, inParent));
+        while (!objects.isEmpty ()) {
+            QPair <const QObject*, int> object = objects.back ();
+            objects.pop_back ();
+            int entry = AddEntry (object.first, object.second, ioThreadNames);
+            const QObjectList& children = object.first->children ();
+            for (int c=children.size ()-1; c>=0; c--) {
+                objects.push_back (qMakePair (static_cast <const QObject*> (children [c]), entry));
+            }
+        }
+        return root;
+    }
+
+    /*!
+        \brief Adds a single object as child of the given entry.
+        \return The entry of the object
+    */
+    int ObjectSearchIndex::AddEntry (const QObject* inObject, int inParent, ThreadNames& ioThreadNames) {
+        int entryIndex = mEntries.size ();
+        mEntries.push_back (Entry ());
+        Entry& entry = mEntries.back ();
+        entry.mObject = inObject;
+        entry.mParent = inParent;
+        entry.mClassName = ClassNameOf (inObject);
+        entry.mThread = inObject->thread ();
+        entry.mName = inObject->objectName ();
+        entry.mFields [ObjectQuery::kClass] = QString::fromLatin1 (entry.mClassName).toLower ();
+        entry.mFields [ObjectQuery::kName] = ObjectUtility::Name (inObject).toLower ();
+        entry.mFields [ObjectQuery::kAddress] = ObjectUtility::Address (inObject).toLower ();
+        entry.mFields [ObjectQuery::kThread] = ThreadField (entry.mThread, ioThreadNames);
+        if (inParent >= 0) {
+            mEntries [inParent].mChildren.push_back (entryIndex);
+        }
+        mEntryIndex.insert (inObject, entryIndex);
+        for (int f=0; f<ObjectQuery::kFieldCount; f++) {
+            AddTrigrams (entryIndex, f);
+        }
+        return entryIndex;
+    }
+
+    /*!
+        \brief Marks the given entry and the entries of all its descendants as removed.
+
+        The trigram lists still refer to removed entries, but Find skips them.
+    */
+    void ObjectSearchIndex::RemoveSubtree (int inEntry) {
+        int parent = mEntries [inEntry].mParent;
+        if (parent >= 0) {
+            QVector <int>& siblings = mEntries [parent].mChildren;
+            int sibling = siblings.indexOf (inEntry);
+            if (sibling >= 0) {
+                siblings.remove (sibling);
+            }
+        }
+        QVector <int> entries (1, inEntry);
+        while (!entries.isEmpty ()) {
+            Entry& entry = mEntries [entries.back ()];
+            int entryIndex = entries.back ();
+            entries.pop_back ();
+            entries += entry.mChildren;
+            // the address may have been reused by an object with a newer entry
+            QHash <const void*, int>::iterator it = mEntryIndex.find (entry.mObject);
+            if (it != mEntryIndex.end () && it.value () == entryIndex) {
+                mEntryIndex.erase (it);
+            }
+            entry.mObject = 0;
+            entry.mChildren.clear ();
+            entry.mName.clear ();
+            for (int f=0; f<ObjectQuery::kFieldCount; f++) {
+                entry.mFields [f].clear ();
+            }
+            ++mRemovedCount;
+        }
+    }
+
+    /*!
+        \brief Returns true when the given entry was created for the given object, and not for a destroyed object at the same address.
+    */
+    bool ObjectSearchIndex::IsEntryOf (int inEntry, const QObject* inObject) const {
+        const Entry& entry = mEntries [inEntry];
+        if (entry.mObject != inObject || entry.mClassName != ClassNameOf (inObject)) {
+            return false;
+        }
+        return entry.mParent < 0 || mEntries [entry.mParent].mObject == inObject->parent ();
+    }
+
+    /*!
+        \brief Updates the name and thread of the given entry, and compares its child entries with the current children of the object.
+        \param[in]      inEntry         The entry of the object
+        \param[in]      inObject        The object, which must be alive
+        \param[in]      inRecursive     When true the entries of the remaining children are compared as well
+        \param[in,out]  ioThreadNames   The names of the threads in lower case
+    */
+    void ObjectSearchIndex::SynchronizeEntry (int inEntry, const QObject* inObject, bool inRecursive, ThreadNames& ioThreadNames) {
+        QString name = inObject->objectName ();
+        if (name != mEntries [inEntry].mName) {
+            mEntries [inEntry].mName = name;
+            SetField (inEntry, ObjectQuery::kName, ObjectUtility::Name (inObject).toLower ());
+        }
+        const QThread* thread = inObject->thread ();
+        if (thread != mEntries [inEntry].mThread) {
+            mEntries [inEntry].mThread = thread;
+            SetField (inEntry, ObjectQuery::kThread, ThreadField (thread, ioThreadNames));
+        }
+
+        // match the current children with the child entries by address
+        QHash <const void*, int> childEntries;
+        foreach (int c, mEntries [inEntry].mChildren) {
+            childEntries.insert (mEntries [c].mObject, c);
+        }
+        QVector <QPair <int, const QObject*> > remaining;
+        foreach (const QObject* child, inObject->children ()) {
+            QHash <const void*, int>::iterator it = childEntries.find (child);
+            if (it != childEntries.end ()) {
+                int childEntry = it.value ();
+                childEntries.erase (it);
+                if (mEntries [childEntry].mClassName == ClassNameOf (child)) {
+                    remaining.push_back (qMakePair (childEntry, child));
+                    continue;
+                }
+                // a new object at the address of a destroyed child
+                RemoveSubtree (childEntry);
+            }
+            AddSubtree (child, inEntry, ioThreadNames);
+        }
+        // the children that were destroyed or moved to another parent
+        foreach (int c, childEntries) {
+            RemoveSubtree (c);
+        }
+        if (inRecursive) {
+            for (int r=0; r<remaining.size (); r++) {
+                SynchronizeEntry (remaining [r].first, remaining [r].second, true, ioThreadNames);
+            }
+        }
+    }
+
+    /*!
+        \brief Changes a field of the given entry and adds its new trigrams.
+
+        The trigrams of the previous value are kept, Find verifies all candidates anyway.
+    */
+    void ObjectSearchIndex::SetField (int inEntry, int inField, const QString& inValue) {
+        mEntries [inEntry].mFields [inField] = inValue;
+        AddTrigrams (inEntry, inField);
+    }
+
+    /*!
+        \brief Adds the given entry to the trigram lists of each trigram of the given field, the lists remain sorted.
+    */
+    void ObjectSearchIndex::AddTrigrams (int inEntry, int inField) {
+        const QString& value = mEntries [inEntry].mFields [inField];
+        const QChar* chars = value.constData ();
+        for (int c=0; c+2<value.size (); c++) {
+            QVector <int>& entries = mTrigrams [inField][TrigramKey (chars + c)];
+            // new entries are appended, and a trigram may occur more than once in a single value
+            if (entries.isEmpty () || entries.back () < inEntry) {
+                entries.push_back (inEntry);
+            }
+            else {
+                QVector <int>::iterator it = qLowerBound (entries.begin (), entries.end (), inEntry);
+                if (*it != inEntry) {
+                    entries.insert (it, inEntry);
+                }
+            }
+        }
+    }
+
+    /*!
+        \brief Drops the removed entries and rebuilds the trigram lists, once most of the entries have been removed.
+
+        The stored fields are reused, no object is dereferenced.
+    */
+    void ObjectSearchIndex::Compact () {
+        if (mRemovedCount < kMinCompactCount || mRemovedCount * 2 <= mEntries.size ()) {
+            return;
+        }
+        // the entries keep their relative order, so the trigram lists remain sorted
+        QVector <int> newIndices (mEntries.size (), -1);
+        QVector <Entry> entries;
+        entries.reserve (mEntries.size () - mRemovedCount);
+        for (int e=0; e<mEntries.size (); e++) {
+            if (mEntries [e].mObject) {
+                newIndices [e] = entries.size ();
+                entries.push_back (mEntries [e]);
+            }
+        }
+        mEntries = entries;
+        mRemovedCount = 0;
+        mEntryIndex.clear ();
+        for (int f=0; f<ObjectQuery::kFieldCount; f++) {
+            mTrigrams [f].clear ();
+        }
+        for (int e=0; e<mEntries.size (); e++) {
+            Entry& entry = mEntries [e];
+            // the parent and the children of an entry are never removed before the entry itself
+            entry.mParent = entry.mParent >= 0 ? newIndices [entry.mParent] : -1;
+            for (int c=0; c<entry.mChildren.size (); c++) {
+                entry.mChildren [c] = newIndices [entry.mChildren [c]];
+            }
+            mEntryIndex.insert (entry.mObject, e);
+            for (int f=0; f<ObjectQuery::kFieldCount; f++) {
+                AddTrigrams (e, f);
+            }
+        }
+    }
+
+    /*!
+        \brief Returns the entry of the given object; otherwise -1.
+    */
+    int ObjectSearchIndex::EntryOf (const void* inObject) const {
+        return mEntryIndex.value (inObject, -1);
+    }
+
+    /*!
+        \brief Returns the entry of the parent of the given entry, or -1 for a root entry.
+        Performs no range checking!
+    */
+    int ObjectSearchIndex::Parent (int inEntry) const {
+        return mEntries [inEntry].mParent;
+    }
+
+    /*!
+        \brief Returns the address of the object of the given entry, or 0 when the entry has been removed.
+        Performs no range checking!
+    */
+    const void* ObjectSearchIndex::Key (int inEntry) const {
+        return mEntries [inEntry].mObject;
+    }
+
+    /*!
+        \brief Returns the class name of the object of the given entry, which points into static moc data.
+        Performs no range checking!
+    */
+    const char* ObjectSearchIndex::ClassName (int inEntry) const {
+        return mEntries [inEntry].mClassName;
+    }
+
+    /*!
+        \brief Returns the object name of the object of the given entry.
+        Performs no range checking!
+    */
+    const QString& ObjectSearchIndex::Name (int inEntry) const {
+        return mEntries [inEntry].mName;
+    }
+
+    /*!
+        \brief Returns the object of the given entry, followed by all its parents up to the root object.
+        Note that the objects may have been destroyed since they were indexed.
+    */
+    QVector <const QObject*> ObjectSearchIndex::Ancestors (int inEntry) const {
+        QVector <const QObject*> ancestors;
+        for (int e=inEntry; e>=0 && e<mEntries.size (); e=mEntries [e].mParent) {
+            ancestors.push_back (mEntries [e].mObject);
+        }
+        return ancestors;
+    }
+
+    /*!
+        \brief Returns the entries of all objects that match the given query, in ascending order.
+    */
+    QVector <int> ObjectSearchIndex::Find (const ObjectQuery& inQuery) const {
+        QVector <int> result;
+        if (inQuery.IsEmpty ()) {
+            return result;
+        }
+        const QVector <ObjectQuery::Term>& terms = inQuery.Terms ();
+        // narrow down the entries that need verification using the trigrams of all terms
+        bool restricted = false;
+        QVector <int> candidates;
+        foreach (const ObjectQuery::Term& term, terms) {
+            QVector <int> termCandidates;
+            if (FindCandidates (term, termCandidates)) {
+                candidates = restricted ? Intersect (candidates, termCandidates) : termCandidates;
+                restricted = true;
+            }
+        }
+        int count = restricted ? candidates.size () : mEntries.size ();
+        for (int c=0; c<count; c++) {
+            int entryIndex = restricted ? candidates [c] : c;
+            const Entry& entry = mEntries [entryIndex];
+            if (!entry.mObject) {
+                continue;
+            }
+            bool matches = true;
+            for (int t=0; t<terms.size () && matches; t++) {
+                matches = Matches (entry, terms [t]);
+            }
+            if (matches) {
+                result.push_back (entryIndex);
+            }
+        }
+        return result;
+    }
+
+    /*!
+        \brief Finds the entries that may match the given term.
+        \return False when the term has too few literal characters to be looked up, any entry may match
+    */
+    bool ObjectSearchIndex::FindCandidates (const ObjectQuery::Term& inTerm, QVector <int>& outCandidates) const {
+        if (inTerm.mField != ObjectQuery::kAnyField) {
+            return FindCandidates (inTerm.mField, inTerm.mLiterals, outCandidates);
+        }
+        // a plain value matches the class name, object name or address
+        const int fields [] = { ObjectQuery::kClass, ObjectQuery::kName, ObjectQuery::kAddress };
+        outCandidates.clear ();
+        for (int f=0; f<3; f++) {
+            QVector <int> fieldCandidates;
+            if (!FindCandidates (fields [f], inTerm.mLiterals, fieldCandidates)) {
+                return false;
+            }
+            outCandidates = Unite (outCandidates, fieldCandidates);
+        }
+        return true;
+    }
+
+    /*!
+        \brief Finds the entries whose field contains all trigrams of the given literals.
+        \return False when the literals contain no trigrams, any entry may match
+    */
+    bool ObjectSearchIndex::FindCandidates (int inField, const QStringList& inLiterals, QVector <int>& outCandidates) const {
+        const Trigrams& trigrams = mTrigrams [inField];
+        bool restricted = false;
+        foreach (const QString& literal, inLiterals) {
+            const QChar* chars = literal.constData ();
+            for (int c=0; c+2<literal.size (); c++) {
+                Trigrams::const_iterator it = trigrams.find (TrigramKey (chars + c));
+                if (it == trigrams.end ()) {
+                    outCandidates.clear ();
+                    return true;
+                }
+                outCandidates = restricted ? Intersect (outCandidates, it.value ()) : it.value ();
+                restricted = true;
+                if (outCandidates.isEmpty ()) {
+                    return true;
+                }
+            }
+        }
+        return restricted;
+    }
+
+    /*!
+        \brief Returns true when the given entry matches the given term.
+    */
+    bool ObjectSearchIndex::Matches (const Entry& inEntry, const ObjectQuery::Term& inTerm) const {
+        if (inTerm.mField != ObjectQuery::kAnyField) {
+            return inTerm.Matches (inEntry.mFields [inTerm.mField]);
+        }
+        return
+            inTerm.Matches (inEntry.mFields [ObjectQuery::kClass]) ||
+            inTerm.Matches (inEntry.mFields [ObjectQuery::kName]) ||
+            inTerm.Matches (inEntry.mFields [ObjectQuery::kAddress]);
+    }
+
+} // namespace conan
@@ -0,0 +1,172 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains ObjectSearchIndex related declarations
+*/
+
+
+#ifndef _OBJECTSEARCHINDEX__17_10_26__16_42_18__H_
+#define _OBJECTSEARCHINDEX__17_10_26__16_42_18__H_
+
+
+#include "ConanDefines.h"
+#include <QtCore/QHash>
+#include <QtCore/QRegExp>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+
+class QObject;
+class QThread;
+
+
+namespace conan {
+
+    /*!
+        \brief A parsed object search query.
+
+        A query consists of terms separated by white space. A term either has the form field:value,
+        where field is one of class, name, address or thread, or it is a plain value that matches
+        the class name, object name or address. Values match case insensitively anywhere within
+        the field, unless they contain the wildcards * or ?, in which case the complete field must
+        match. An object matches when all terms match, f.e: class:QPushButton name:ok* thread:worker
+    */
+    class CONAN_LOCAL ObjectQuery {
+    public:
+        typedef enum FIELDS {
+            kClass,
+            kName,
+            kAddress,
+            kThread,
+            kFieldCount,
+            kAnyField = kFieldCount
+        } Fields;
+
+        /*!
+            \brief A single field:value term.
+        */
+        struct CONAN_LOCAL Term {
+            Term ();
+            bool Matches (const QString& inValue) const;
+
+            int mField;                 //!< One of Fields
+            QString mValue;             //!< The value in lower case
+            bool mWildcard;             //!< When true mPattern must match the complete field
+            QRegExp mPattern;           //!< The wildcard pattern, only used when mWildcard is true
+            QStringList mLiterals;      //!< The parts of mValue that contain no wildcards
+        };
+
+    public:
+        ObjectQuery (const QString& inText = QString ());
+
+        bool IsEmpty () const;
+        const QVector <Term>& Terms () const;
+
+    private:
+        QVector <Term> mTerms;
+    };
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief A trigram index over the class name, object name, address and thread of every object in one or more object hierarchies.
+
+        Each field is stored in lower case, together with a map from each of its trigrams (three
+        consecutive characters) to the objects whose field contains that trigram. A query only
+        verifies the objects that contain all trigrams of its terms, so it does not visit the
+        complete hierarchy. Terms with less than three literal characters are verified against
+        all objects, which is still a linear scan over a flat array.
+
+        The index is updated incrementally: Insert and Remove apply the changes that ObjectModel
+        makes to its items, and SynchronizeChildren and Synchronize compare the entries with the
+        current children of live objects. New entries are appended and removed entries are only
+        marked, so the trigram lists stay sorted; candidates are always verified against the
+        current fields. The entries are compacted once most of them have been removed.
+
+        Objects are never dereferenced after they have been added, unless they are passed in.
+        Entries are not stored in any particular order, see ObjectModel::FindObjects for the
+        order of the view.
+    */
+    class CONAN_LOCAL ObjectSearchIndex {
+    public:
+        static const int kMinCompactCount = 1024;   //!< The minimum number of removed entries before the entries are compacted
+
+        ObjectSearchIndex ();
+
+        void Clear ();
+        void AddHierarchy (const QObject* inRoot);
+        void Insert (const QObject* inObject, const void* inParent);
+        void Remove (const void* inObject);
+        bool SynchronizeChildren (const QObject* inObject);
+        bool Synchronize (const QObject* inRoot);
+
+        int EntryOf (const void* inObject) const;
+        int Parent (int inEntry) const;
+        const void* Key (int inEntry) const;
+        const char* ClassName (int inEntry) const;
+        const QString& Name (int inEntry) const;
+        QVector <const QObject*> Ancestors (int inEntry) const;
+
+        QVector <int> Find (const ObjectQuery& inQuery) const;
+
+    private:
+        /*!
+            \brief The searchable fields of a single object.
+        */
+        struct CONAN_LOCAL Entry {
+            const QObject* mObject;                     //!< The object, never dereferenced; 0 when the entry has been removed
+            int mParent;                                //!< The entry of the parent object, or -1 for a root object
+            QVector <int> mChildren;                    //!< The entries of the child objects
+            const char* mClassName;                     //!< The class name in the moc data, used to detect a reused address
+            const QThread* mThread;                     //!< The thread of the object, never dereferenced
+            QString mName;                              //!< The object name, as sorted by the view
+            QString mFields [ObjectQuery::kFieldCount]; //!< The fields in lower case, see ObjectQuery::Fields
+        };
+
+        typedef QHash <quint64, QVector <int> > Trigrams;
+        typedef QHash <const QThread*, QString> ThreadNames;
+
+        int AddSubtree (const QObject* inRoot, int inParent, ThreadNames& ioThreadNames);
+        int AddEntry (const QObject* inObject, int inParent, ThreadNames& ioThreadNames);
+        void RemoveSubtree (int inEntry);
+        bool IsEntryOf (int inEntry, const QObject* inObject) const;
+        void SynchronizeEntry (int inEntry, const QObject* inObject, bool inRecursive, ThreadNames& ioThreadNames);
+        void SetField (int inEntry, int inField, const QString& inValue);
+        void AddTrigrams (int inEntry, int inField);
+        void Compact ();
+        bool FindCandidates (const ObjectQuery::Term& inTerm, QVector <int>& outCandidates) const;
+        bool FindCandidates (int inField, const QStringList& inLiterals, QVector <int>& outCandidates) const;
+        bool Matches (const Entry& inEntry, const ObjectQuery::Term& inTerm) const;
+
+        QVector <Entry> mEntries;                       //!< All entries, including removed ones
+        QHash <const void*, int> mEntryIndex;           //!< map <object, entry> of all entries that have not been removed
+        Trigrams mTrigrams [ObjectQuery::kFieldCount];  //!< map <trigram, entries in ascending order> for each field
+        int mRemovedCount;                              //!< The number of removed entries in mEntries
+    };
+
+} // namespace conan
+
+
+#endif //_OBJECTSEARCHINDEX__17_10_26__16_42_18__H_
@@ -24,7 +24,9 @@
 */
 
 #include "ObjectUtility.h"
+#include <QtCore/QCoreApplication>
 #include <QtCore/QObject>
+#include <QtCore/QThread>
 
 
 namespace conan {
@@ -66,6 +68,20 @@ namespace conan {
         return inObject;
     }
 
+    /*!
+        \brief Appends the given object and all its descendants, in depth first order.
+        \param[in] inObject        The root of the hierarchy
+        \param[out] outObjects     The list to which the objects are appended
+    */
+    void ObjectUtility::CollectHierarchy (const QObject* inObject, QList <const QObject*>& outObjects) {
+        if (inObject) {
+            outObjects.push_back (inObject);
+            foreach (const QObject* child, inObject->children ()) {
+                CollectHierarchy (child, outObjects);
+            }
+        }
+    }
+
     /*!
         \brief Determines the name of the given object.
         \param[in] inObject        The object
@@ -124,4 +140,24 @@ namespace conan {
         return QString ("0x%1").arg (reinterpret_cast <quintptr> (inObject), sizeof(quintptr)*2, 16, QChar('0'));
     }
 
+    /*!
+        \brief Determines the display name of the given thread.
+        \param[in] inThread        The thread
+        \return                    The object name of the thread, 'main' for the thread of the application, or its address
+    */
+    QString ObjectUtility::ThreadName (const QThread* inThread) {
+        if (!inThread) {
+            return QString ();
+        }
+        QString name = inThread->objectName ();
+        if (!name.isEmpty ()) {
+            return name;
+        }
+        const QCoreApplication* application = QCoreApplication::instance ();
+        if (application && application->thread () == inThread) {
+            return "main";
+        }
+        return Address (inThread);
+    }
+
 } // namespace conan
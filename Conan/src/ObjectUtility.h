@@ -28,8 +28,12 @@
 #define _OBJECTUTILITY__05_01_09__11_40_36__H_
 
 
+#include <QtCore/QList>
+
+
 class QObject;
 class QString;
+class QThread;
 
 
 namespace conan {
@@ -38,12 +42,14 @@ namespace conan {
     namespace ObjectUtility {
         const QObject* FindMutualParent (const QObject* inObject1, const QObject* inObject2);
         const QObject* TopLevelParent (const QObject* inObject);
+        void CollectHierarchy (const QObject* inObject, QList <const QObject*>& outObjects);
 
         QString Name (const QObject* inObject);
         QString Class (const QObject* inObject);
         QString QualifiedName (const QObject* inObject);
         QString QualifiedName (const QString& inClass, const QString& inName);
         QString Address (const QObject* inObject);
+        QString ThreadName (const QThread* inThread);
     }    // namespace ObjectUtility
 
 } // namespace conan
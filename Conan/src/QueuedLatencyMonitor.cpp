@@ -0,0 +1,533 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains QueuedLatencyMonitor related definitions
+*/
+
+
+#include "Clock.h"
+#include "ObjectUtility.h"
+#include "QueuedLatencyMonitor.h"
+#include <QtCore/QMutexLocker>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+
+
+namespace conan {
+
+    namespace /*unnamed*/ {
+        /*!
+            \brief Formats the given latency in ns as micro or milliseconds.
+        */
+        QString FormatLatency (qint64 inLatency) {
+            if (inLatency < 1000000) {
+                return QString ("%1 us").arg (inLatency / 1000.0, 0, 'f', 1);
+            }
+            return QString ("%1 ms").arg (inLatency / 1000000.0, 0, 'f', 2);
+        }
+    } // unnamed namespace
+
+
+    /*!
+        \brief Creates empty statistics.
+    */
+    QueuedLatency::QueuedLatency () :
+        mUnmatched (0),
+        mMax (0)
+    {}
+
+    /*!
+        \brief Counts a single delivery with the given latency in ns.
+    */
+    void QueuedLatency::Add (qint64 inLatency) {
+        mLatencies.Add (inLatency);
+        mMax = qMax (mMax, inLatency);
+    }
+
+    /*!
+        \brief Returns the median and 99th percentile latency and the number of deliveries, f.e: p50 12.5 us, p99 1.20 ms (42)
+    */
+    QString QueuedLatency::ToString () const {
+        QString text;
+        if (mLatencies.Count ()) {
+            text = QString ("p50 %1, p99 %2 (%3)")
+                .arg (FormatLatency (mLatencies.Percentile (50)))
+                .arg (FormatLatency (mLatencies.Percentile (99)))
+                .arg (mLatencies.Count ());
+        }
+        if (mUnmatched) {
+            text += QString (text.isEmpty () ? "%1 unmatched" : ", %1 unmatched").arg (mUnmatched);
+        }
+        return text;
+    }
+
+    /*!
+        \brief Returns all statistics on separate lines, f.e. for a tool tip.
+    */
+    QString QueuedLatency::Details () const {
+        QStringList lines;
+        lines << QString ("%1 deliveries, %2 unmatched").arg (mLatencies.Count ()).arg (mUnmatched);
+        if (mLatencies.Count ()) {
+            lines << QString ("p50 %1").arg (FormatLatency (mLatencies.Percentile (50)));
+            lines << QString ("p90 %1").arg (FormatLatency (mLatencies.Percentile (90)));
+            lines << QString ("p99 %1").arg (FormatLatency (mLatencies.Percentile (99)));
+            lines << QString ("max %1").arg (FormatLatency (mMax));
+        }
+        return lines.join ("\n");
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Creates a key for the given connection.
+    */
+    QueuedLatencyMonitor::ConnectionKey::ConnectionKey (const void* inSender, int inSignal, const void* inReceiver, int inSlot) :
+        mSender (inSender),
+        mSignal (inSignal),
+        mReceiver (inReceiver),
+        mSlot (inSlot)
+    {}
+
+    bool QueuedLatencyMonitor::ConnectionKey::operator== (const ConnectionKey& inOther) const {
+        return mSender == inOther.mSender && mSignal == inOther.mSignal && mReceiver == inOther.mReceiver && mSlot == inOther.mSlot;
+    }
+
+    /*!
+        \brief Returns a hash value for the given connection key.
+    */
+    uint qHash (const QueuedLatencyMonitor::ConnectionKey& inConnection) {
+        return ::qHash (inConnection.mSender) ^ (::qHash (inConnection.mReceiver) << 1) ^
+            (uint (inConnection.mSignal) << 16) ^ uint (inConnection.mSlot);
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Creates an empty buffer of the given thread, all records are allocated up front.
+
+        Must be called by the given thread, so its name can be read safely.
+    */
+    QueuedLatencyMonitor::ThreadBuffer::ThreadBuffer (const QThread* inThread) :
+        mRecords (new Record [kBufferCapacity]),
+        mPushed (0),
+        mPopped (0),
+        mDropped (0),
+        mOrphaned (0),
+        mThread (inThread),
+        mThreadName (ObjectUtility::ThreadName (inThread))
+    {}
+
+    /*!
+        \brief Copies the record into the buffer, may only be called by the producer. Returns false when the buffer is full.
+    */
+    bool QueuedLatencyMonitor::ThreadBuffer::Push (const Record& inRecord) {
+        unsigned pushed = static_cast <unsigned> (int (mPushed));
+        unsigned popped = static_cast <unsigned> (mPopped.fetchAndAddAcquire (0));
+        if (pushed - popped >= static_cast <unsigned> (kBufferCapacity)) {
+            mDropped.ref ();
+            return false;
+        }
+        mRecords [pushed & (kBufferCapacity - 1)] = inRecord;
+        // publish the record
+        mPushed.fetchAndStoreRelease (static_cast <int> (pushed + 1));
+        return true;
+    }
+
+    /*!
+        \brief Returns the oldest record, or 0 when the buffer is empty. May only be called by the consumer.
+    */
+    const QueuedLatencyMonitor::Record* QueuedLatencyMonitor::ThreadBuffer::Front () const {
+        return Count () ? &mRecords [static_cast <unsigned> (int (mPopped)) & (kBufferCapacity - 1)] : 0;
+    }
+
+    /*!
+        \brief Releases the oldest record, may only be called by the consumer.
+    */
+    void QueuedLatencyMonitor::ThreadBuffer::Pop () {
+        if (Count ()) {
+            mPopped.fetchAndStoreRelease (static_cast <int> (static_cast <unsigned> (int (mPopped)) + 1));
+        }
+    }
+
+    /*!
+        \brief Returns the number of records that have been pushed but not popped yet.
+    */
+    int QueuedLatencyMonitor::ThreadBuffer::Count () const {
+        unsigned pushed = static_cast <unsigned> (const_cast <QAtomicInt&> (mPushed).fetchAndAddAcquire (0));
+        unsigned popped = static_cast <unsigned> (int (mPopped));
+        return static_cast <int> (pushed - popped);
+    }
+
+    QueuedLatencyMonitor::ThreadState::ThreadState (const ThreadBufferPtr& inBuffer) :
+        mBuffer (inBuffer)
+    {}
+
+    /*!
+        \brief Called when the thread finishes, the monitor removes the buffer once it has been drained.
+    */
+    QueuedLatencyMonitor::ThreadState::~ThreadState () {
+        mBuffer->mOrphaned.fetchAndStoreRelease (1);
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    QAtomicPointer <QueuedLatencyMonitor> QueuedLatencyMonitor::sEnabledMonitor;
+    // initialized at load time, function local statics are not thread safe with msvc
+    QMutex QueuedLatencyMonitor::sMutex;
+    QList <QueuedLatencyMonitor::ThreadBufferPtr> QueuedLatencyMonitor::sBuffers;
+    QThreadStorage <QueuedLatencyMonitor::ThreadState*> QueuedLatencyMonitor::sThreadState;
+
+    QueuedLatencyMonitor::QueuedLatencyMonitor (QObject* inParent) :
+        QObject (inParent),
+        mDrainTimer (this),
+        mDropped (0)
+    {
+        setObjectName ("QueuedLatencyMonitor");
+        connect (&mDrainTimer, SIGNAL (timeout ()), this, SLOT (SlotDrain ()));
+    }
+
+    /*!
+        \brief Disables the monitor, the callbacks only refer to the shared buffers.
+    */
+    QueuedLatencyMonitor::~QueuedLatencyMonitor () {
+        SetEnabled (false);
+    }
+
+    /*!
+        \brief Starts or stops measuring, enabling this monitor disables any other monitor.
+
+        Records that were left in the buffers by a previous monitor are discarded when measuring
+        starts, the buffers are drained when measuring stops. Note that the signal begin callback
+        and the event notify callback of Qt must be registered as well, see
+        ConanWidget::UpdateSignalSpyCallbacks.
+    */
+    void QueuedLatencyMonitor::SetEnabled (bool inEnabled) {
+        if (inEnabled) {
+            if (!IsEnabled ()) {
+                Discard ();
+                sEnabledMonitor.fetchAndStoreOrdered (this);
+            }
+            mDrainTimer.start (kDrainInterval);
+        }
+        else {
+            mDrainTimer.stop ();
+            if (sEnabledMonitor.testAndSetOrdered (this, 0)) {
+                Drain ();
+            }
+        }
+    }
+
+    /*!
+        \brief Returns true when this monitor receives the callbacks.
+    */
+    bool QueuedLatencyMonitor::IsEnabled () const {
+        return sEnabledMonitor == this;
+    }
+
+    /*!
+        \brief Discards all measured latencies and all undelivered emissions, and all records that have not been drained when the monitor is enabled.
+
+        Events that are still queued are no longer matched and are not counted.
+    */
+    void QueuedLatencyMonitor::Clear () {
+        if (IsEnabled ()) {
+            Discard ();
+        }
+        mPending.clear ();
+        mConnections.clear ();
+        mObjectConnections.clear ();
+        mLatencies.clear ();
+        mThreads.clear ();
+        mDropped = 0;
+    }
+
+    /*!
+        \brief Processes all records of all threads when the monitor is enabled, see Drain.
+    */
+    void QueuedLatencyMonitor::Flush () {
+        if (IsEnabled ()) {
+            Drain ();
+        }
+    }
+
+    /*!
+        \brief Processes all records of all threads, merged in timestamp order.
+
+        Only the records with a timestamp before the call are processed: a delivery can then
+        never be processed before the emission that caused it, because the emitting thread
+        records the emission before the event is posted. Buffers of finished threads are removed
+        once they have been drained.
+    */
+    void QueuedLatencyMonitor::Drain () {
+        qint64 horizon = Clock::Now ();
+        QList <ThreadBufferPtr> buffers;
+        {
+            QMutexLocker locker (&sMutex);
+            buffers = sBuffers;
+        }
+        // the orphaned state must be read before the counts, so no records can follow
+        QVector <bool> orphaned (buffers.size ());
+        QVector <int> remaining (buffers.size ());
+        for (int b=0; b<buffers.size (); ++b) {
+            orphaned [b] = buffers [b]->mOrphaned.fetchAndAddAcquire (0) != 0;
+            remaining [b] = buffers [b]->Count ();
+            mDropped += buffers [b]->mDropped.fetchAndStoreRelaxed (0);
+        }
+        // merge the buffers, each buffer is already in timestamp order
+        forever {
+            int next = -1;
+            for (int b=0; b<buffers.size (); ++b) {
+                if (remaining [b] && buffers [b]->Front ()->mTimestamp < horizon &&
+                    (next < 0 || buffers [b]->Front ()->mTimestamp < buffers [next]->Front ()->mTimestamp)) {
+                    next = b;
+                }
+            }
+            if (next < 0) {
+                break;
+            }
+            ThreadBuffer& buffer = *buffers [next];
+            Process (buffer, *buffer.Front ());
+            buffer.Pop ();
+            --remaining [next];
+        }
+
+        // remove the drained buffers of finished threads
+        QMutexLocker locker (&sMutex);
+        for (int b=0; b<buffers.size (); ++b) {
+            if (orphaned [b] && !buffers [b]->Count ()) {
+                sBuffers.removeAll (buffers [b]);
+            }
+        }
+    }
+
+    /*!
+        \brief Retrieves the latency of the given connection, returns false when none of its deliveries were measured.
+        \param[in]  inSender            The sender, never dereferenced
+        \param[in]  inSignalMethodIndex The method index of the signal
+        \param[in]  inReceiver          The receiver, never dereferenced
+        \param[in]  inSlotMethodIndex   The method index of the slot
+        \param[out] outLatency          The latency of the connection
+    */
+    bool QueuedLatencyMonitor::Latency (const void* inSender, int inSignalMethodIndex, const void* inReceiver, int inSlotMethodIndex, QueuedLatency& outLatency) const {
+        QHash <ConnectionKey, QueuedLatency>::const_iterator latency = mLatencies.find (ConnectionKey (inSender, inSignalMethodIndex, inReceiver, inSlotMethodIndex));
+        if (latency == mLatencies.end ()) {
+            return false;
+        }
+        outLatency = latency.value ();
+        return true;
+    }
+
+    /*!
+        \brief Returns the latency of all queued connections per receiving thread.
+    */
+    QList <QueuedLatencyMonitor::ThreadLatency> QueuedLatencyMonitor::ThreadLatencies () const {
+        return mThreads.values ();
+    }
+
+    /*!
+        \brief Returns the number of records that were dropped because the buffer of their thread was full.
+    */
+    quint64 QueuedLatencyMonitor::DroppedCount () const {
+        return mDropped;
+    }
+
+    /*!
+        \brief Returns true when any monitor is enabled, so emissions must be recorded.
+    */
+    bool QueuedLatencyMonitor::IsActive () {
+        return sEnabledMonitor != 0;
+    }
+
+    /*!
+        \brief Records the emission of a signal for a connection that will be queued, called by the emitting thread.
+        \param[in] inConnection     The connection
+        \param[in] inTimestamp      The monotonic time of the emission, see Clock::Now
+    */
+    void QueuedLatencyMonitor::Posted (const ConnectionKey& inConnection, qint64 inTimestamp) {
+        Record record;
+        record.mType = Record::kPosted;
+        record.mConnection = inConnection;
+        record.mTimestamp = inTimestamp;
+        Push (record);
+    }
+
+    /*!
+        \brief Records the delivery of a queued slot invocation, called by the receiving thread.
+        \param[in] inConnection     The connection
+    */
+    void QueuedLatencyMonitor::Delivered (const ConnectionKey& inConnection) {
+        Record record;
+        record.mType = Record::kDelivered;
+        record.mConnection = inConnection;
+        record.mTimestamp = Clock::Now ();
+        Push (record);
+    }
+
+    /*!
+        \brief Records the destruction of an object, called by the destroying thread from the destroyed signal of the object.
+    */
+    void QueuedLatencyMonitor::Destroyed (const void* inObject) {
+        Record record;
+        record.mType = Record::kDestroyed;
+        record.mConnection = ConnectionKey (inObject);
+        record.mTimestamp = Clock::Now ();
+        Push (record);
+    }
+
+    /*!
+        \brief Processes the buffers periodically while the monitor is enabled.
+    */
+    void QueuedLatencyMonitor::SlotDrain () {
+        Flush ();
+    }
+
+    /*!
+        \brief Pushes the record into the buffer of the current thread while a monitor is enabled.
+
+        The monitor itself is never dereferenced, it may be destroyed concurrently.
+    */
+    void QueuedLatencyMonitor::Push (const Record& inRecord) {
+        if (IsActive ()) {
+            LocalBuffer ().Push (inRecord);
+        }
+    }
+
+    /*!
+        \brief Returns the buffer of the current thread, it is created on first use.
+    */
+    QueuedLatencyMonitor::ThreadBuffer& QueuedLatencyMonitor::LocalBuffer () {
+        if (!sThreadState.hasLocalData ()) {
+            ThreadBufferPtr buffer (new ThreadBuffer (QThread::currentThread ()));
+            {
+                QMutexLocker locker (&sMutex);
+                sBuffers.push_back (buffer);
+            }
+            sThreadState.setLocalData (new ThreadState (buffer));
+        }
+        return *sThreadState.localData ()->mBuffer;
+    }
+
+    /*!
+        \brief Pops all records from the buffers of all threads, and resets their dropped counts.
+
+        Must only be called by the thread of the monitor that drains the buffers.
+    */
+    void QueuedLatencyMonitor::Discard () {
+        QList <ThreadBufferPtr> buffers;
+        {
+            QMutexLocker locker (&sMutex);
+            buffers = sBuffers;
+        }
+        foreach (const ThreadBufferPtr& buffer, buffers) {
+            while (buffer->Count ()) {
+                buffer->Pop ();
+            }
+            buffer->mDropped.fetchAndStoreRelaxed (0);
+        }
+    }
+
+    /*!
+        \brief Applies a single record of the given buffer.
+
+        Deliveries of connections without any undelivered emission are ignored, their events were
+        posted before the monitor was enabled or cleared, unless the connection was measured
+        before, in which case the delivery is counted as unmatched.
+    */
+    void QueuedLatencyMonitor::Process (const ThreadBuffer& inBuffer, const Record& inRecord) {
+        const ConnectionKey& connection = inRecord.mConnection;
+        switch (inRecord.mType) {
+            case Record::kPosted: {
+                if (!mConnections.contains (connection)) {
+                    mConnections.insert (connection);
+                    mObjectConnections [connection.mSender].insert (connection);
+                    mObjectConnections [connection.mReceiver].insert (connection);
+                }
+                QQueue <qint64>& pending = mPending [connection];
+                if (pending.size () < kMaxPending) {
+                    pending.enqueue (inRecord.mTimestamp);
+                }
+                break;
+            }
+            case Record::kDelivered: {
+                if (!mConnections.contains (connection)) {
+                    return;
+                }
+                QueuedLatency& latency = mLatencies [connection];
+                ThreadLatency& threadLatency = mThreads [inBuffer.mThread];
+                if (threadLatency.mThread.isNull ()) {
+                    threadLatency.mThread = inBuffer.mThreadName;
+                }
+                QHash <ConnectionKey, QQueue <qint64> >::iterator pending = mPending.find (connection);
+                if (pending == mPending.end ()) {
+                    ++latency.mUnmatched;
+                    ++threadLatency.mLatency.mUnmatched;
+                    return;
+                }
+                qint64 elapsed = inRecord.mTimestamp - pending->dequeue ();
+                latency.Add (elapsed);
+                threadLatency.mLatency.Add (elapsed);
+                if (pending->isEmpty ()) {
+                    mPending.erase (pending);
+                }
+                break;
+            }
+            case Record::kDestroyed:
+                Purge (connection.mSender);
+                break;
+        }
+    }
+
+    /*!
+        \brief Discards the undelivered emissions and the latencies of all connections of the given destroyed object.
+    */
+    void QueuedLatencyMonitor::Purge (const void* inObject) {
+        QHash <const void*, QSet <ConnectionKey> >::iterator connections = mObjectConnections.find (inObject);
+        if (connections == mObjectConnections.end ()) {
+            return;
+        }
+        QSet <ConnectionKey> purged = connections.value ();
+        mObjectConnections.erase (connections);
+        foreach (const ConnectionKey& connection, purged) {
+            mPending.remove (connection);
+            mLatencies.remove (connection);
+            mConnections.remove (connection);
+            // the other side of the connection may still be alive
+            const void* other = connection.mSender == inObject ? connection.mReceiver : connection.mSender;
+            connections = mObjectConnections.find (other);
+            if (connections != mObjectConnections.end ()) {
+                connections->remove (connection);
+                if (connections->isEmpty ()) {
+                    mObjectConnections.erase (connections);
+                }
+            }
+        }
+    }
+
+} // namespace conan
@@ -0,0 +1,234 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains QueuedLatencyMonitor related declarations
+*/
+
+
+#ifndef _QUEUEDLATENCYMONITOR__17_10_27__00_12_31__H_
+#define _QUEUEDLATENCYMONITOR__17_10_27__00_12_31__H_
+
+
+#include "DurationHistogram.h"
+#include <QtCore/QAtomicInt>
+#include <QtCore/QAtomicPointer>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QQueue>
+#include <QtCore/QScopedArrayPointer>
+#include <QtCore/QSet>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QString>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QTimer>
+
+
+class QThread;
+
+
+namespace conan {
+
+    /*!
+        \brief The delivery latency statistics of a single queued connection, or of all queued connections to the objects of a thread.
+
+        The latency of an emission is the time between the emission of the signal and the
+        moment the receiving thread starts to deliver the resulting QMetaCallEvent.
+    */
+    struct CONAN_LOCAL QueuedLatency {
+        QueuedLatency ();
+
+        void Add (qint64 inLatency);
+        QString ToString () const;
+        QString Details () const;
+
+        quint64 mUnmatched;             //!< The number of deliveries for which no emission was recorded
+        qint64 mMax;                    //!< The highest latency, in ns
+        DurationHistogram mLatencies;   //!< The latency of each delivery
+    };
+
+
+    // --------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Measures the time between the emission of a signal and the delivery of each of its queued slot invocations.
+
+        Qt does not call the slot callbacks for slots that are invoked by a queued connection,
+        instead it posts a QMetaCallEvent to the thread of the receiver. Each emission is recorded
+        by Posted, from the signal begin callback, for every connection of the signal that will be
+        queued. Each delivery is recorded by Delivered, from the event notify callback of Qt, on
+        the receiving thread. Events of a single connection are delivered in the order in which
+        they were posted, so both are matched first in, first out per (sender, signal, receiver,
+        slot) connection, see priv::RecordQueuedEmission and priv::RecordQueuedDelivery. Both
+        sides identify the signal by its method index, as QMetaCallEvent::signalId does.
+
+        The callbacks never take a lock: each thread pushes its records into its own lock free
+        ring buffer, which is created on its first record. The thread of the monitor drains all
+        buffers at a fixed cadence and merges them in timestamp order, so all statistics are only
+        used by the thread of the monitor. A record that does not fit in its buffer is dropped.
+        The buffers belong to a registry that is shared by all monitors and lives until the
+        process exits, so a callback that races with the destruction of the enabled monitor
+        never refers to the monitor itself.
+
+        Objects are never dereferenced, as senders may be destroyed before their events are
+        delivered. Instead the destroyed signal of each object is recorded by Destroyed, and the
+        connections of a destroyed object are discarded, so an object at a reused address starts
+        without statistics. Only the connections with undelivered emissions are kept, at most
+        kMaxPending emissions per connection, f.e. for a receiver whose thread has no event loop.
+        Emissions whose arguments could not be queued, or whose record was dropped, can shift the
+        matching of later deliveries of that connection. Only one monitor can be enabled at a time.
+    */
+    class CONAN_LOCAL QueuedLatencyMonitor : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        static const int kMaxPending = 4096;        //!< The maximum number of undelivered emissions per connection
+        static const int kBufferCapacity = 8192;    //!< The number of records in the buffer of each thread
+        static const int kDrainInterval = 100;      //!< The interval in ms at which the buffers are drained
+
+        /*!
+            \brief Identifies a connection, the sender and receiver are never dereferenced.
+        */
+        struct CONAN_LOCAL ConnectionKey {
+            ConnectionKey (const void* inSender = 0, int inSignal = -1, const void* inReceiver = 0, int inSlot = -1);
+            bool operator== (const ConnectionKey& inOther) const;
+
+            const void* mSender;        //!< The sender
+            int mSignal;                //!< The method index of the signal
+            const void* mReceiver;      //!< The receiver
+            int mSlot;                  //!< The method index of the slot
+        };
+
+        /*!
+            \brief The latency of all queued connections to the objects of a single thread.
+        */
+        struct CONAN_LOCAL ThreadLatency {
+            QString mThread;            //!< The name of the thread, see ObjectUtility::ThreadName
+            QueuedLatency mLatency;     //!< The latency of all its deliveries
+        };
+
+    public:
+        QueuedLatencyMonitor (QObject* inParent = 0);
+        virtual ~QueuedLatencyMonitor ();
+
+        void SetEnabled (bool inEnabled);
+        bool IsEnabled () const;
+        void Clear ();
+        void Flush ();
+
+        bool Latency (const void* inSender, int inSignalMethodIndex, const void* inReceiver, int inSlotMethodIndex, QueuedLatency& outLatency) const;
+        QList <ThreadLatency> ThreadLatencies () const;
+        quint64 DroppedCount () const;
+
+        static bool IsActive ();
+        static void Posted (const ConnectionKey& inConnection, qint64 inTimestamp);
+        static void Delivered (const ConnectionKey& inConnection);
+        static void Destroyed (const void* inObject);
+
+    private slots:
+        void SlotDrain ();
+
+    private:
+        Q_DISABLE_COPY (QueuedLatencyMonitor)
+
+        /*!
+            \brief A single posted emission, delivery or destroyed object, as recorded by the callbacks.
+        */
+        struct CONAN_LOCAL Record {
+            enum Type {
+                kPosted,
+                kDelivered,
+                kDestroyed
+            };
+
+            Type mType;                 //!< The kind of record
+            ConnectionKey mConnection;  //!< The connection, or the destroyed object as sender
+            qint64 mTimestamp;          //!< The time of the record, see Clock::Now
+        };
+
+        /*!
+            \brief The lock free single producer, single consumer ring buffer of a single thread.
+
+            The producer publishes a record by incrementing the push counter with release
+            semantics, after the record has been written completely. The consumer releases a
+            record the same way through the pop counter, see SignalCapture.
+        */
+        struct CONAN_LOCAL ThreadBuffer {
+            ThreadBuffer (const QThread* inThread);
+
+            bool Push (const Record& inRecord);
+            const Record* Front () const;
+            void Pop ();
+            int Count () const;
+
+            QScopedArrayPointer <Record> mRecords;  //!< The preallocated records, kBufferCapacity is a power of two
+            QAtomicInt mPushed;                     //!< The number of pushed records, only written by the producer
+            QAtomicInt mPopped;                     //!< The number of popped records, only written by the consumer
+            QAtomicInt mDropped;                    //!< The number of records that did not fit since the last drain
+            QAtomicInt mOrphaned;                   //!< Non zero when the producer will not push any more records
+            const QThread* mThread;                 //!< The producing thread, never dereferenced by the consumer
+            QString mThreadName;                    //!< The name of the producing thread, see ObjectUtility::ThreadName
+        };
+
+        typedef QSharedPointer <ThreadBuffer> ThreadBufferPtr;
+
+        /*!
+            \brief Owns the reference of a thread to its buffer, orphans the buffer when the thread finishes.
+        */
+        struct CONAN_LOCAL ThreadState {
+            ThreadState (const ThreadBufferPtr& inBuffer);
+            ~ThreadState ();
+
+            ThreadBufferPtr mBuffer;    //!< The buffer, shared with the monitor which drains it
+        };
+
+        static void Push (const Record& inRecord);
+        static ThreadBuffer& LocalBuffer ();
+        static void Discard ();
+        void Drain ();
+        void Process (const ThreadBuffer& inBuffer, const Record& inRecord);
+        void Purge (const void* inObject);
+
+        static QAtomicPointer <QueuedLatencyMonitor> sEnabledMonitor;   //!< The monitor that drains the buffers, or 0; never dereferenced by the callbacks
+        static QMutex sMutex;                                           //!< Protects sBuffers
+        static QList <ThreadBufferPtr> sBuffers;                        //!< The buffers of all threads
+        static QThreadStorage <ThreadState*> sThreadState;              //!< The buffer of the current thread
+
+        QTimer mDrainTimer;                                 //!< Periodically drains sBuffers
+        QHash <ConnectionKey, QQueue <qint64> > mPending;   //!< map <connection, time of undelivered emissions>, without empty queues
+        QSet <ConnectionKey> mConnections;                  //!< All connections with a posted emission since they were purged
+        QHash <const void*, QSet <ConnectionKey> > mObjectConnections;  //!< map <sender or receiver, connections>
+        QHash <ConnectionKey, QueuedLatency> mLatencies;    //!< map <connection, latency>
+        QHash <const QThread*, ThreadLatency> mThreads;     //!< map <receiving thread, latency>
+        quint64 mDropped;                                   //!< The number of dropped records
+    };
+
+    uint qHash (const QueuedLatencyMonitor::ConnectionKey& inConnection);
+
+} // namespace conan
+
+
+#endif //_QUEUEDLATENCYMONITOR__17_10_27__00_12_31__H_
@@ -0,0 +1,212 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains SignalCapture related definitions
+*/
+
+
+#include "Clock.h"
+#include "SignalCapture.h"
+#include <QtCore/QMetaType>
+#include <string.h>
+
+
+namespace conan {
+
+    namespace /*unnamed*/ {
+
+        /*!
+            \brief Returns the size of the given type when it can be copied into a record, 0 otherwise.
+
+            Only built-in types without constructors qualify, copying these with memcpy is safe.
+        */
+        int InlineSize (int inType) {
+            switch (inType) {
+                case QMetaType::Bool:           return sizeof (bool);
+                case QMetaType::Int:            return sizeof (int);
+                case QMetaType::UInt:           return sizeof (uint);
+                case QMetaType::LongLong:       return sizeof (qlonglong);
+                case QMetaType::ULongLong:      return sizeof (qulonglong);
+                case QMetaType::Double:         return sizeof (double);
+                case QMetaType::Long:           return sizeof (long);
+                case QMetaType::Short:          return sizeof (short);
+                case QMetaType::Char:           return sizeof (char);
+                case QMetaType::ULong:          return sizeof (ulong);
+                case QMetaType::UShort:         return sizeof (ushort);
+                case QMetaType::UChar:          return sizeof (uchar);
+                case QMetaType::Float:          return sizeof (float);
+                case QMetaType::VoidStar:
+                case QMetaType::QObjectStar:
+                case QMetaType::QWidgetStar:    return sizeof (void*);
+                default:                        return 0;
+            }
+        }
+
+        /*!
+            \brief Returns the smallest power of two that is not less than the given capacity.
+        */
+        unsigned RoundUpToPowerOfTwo (int inCapacity) {
+            unsigned capacity = 1;
+            while (capacity < static_cast <unsigned> (qMax (1, inCapacity))) {
+                capacity <<= 1;
+            }
+            return capacity;
+        }
+
+    } // unnamed namespace
+
+
+    /*!
+        \brief Creates a buffer that holds at least the given number of records, all records are allocated up front.
+
+        The capacity is rounded up to a power of two, so the push and pop counters can wrap around.
+    */
+    SignalCapture::SignalCapture (int inCapacity) :
+        mRecords (new Record [RoundUpToPowerOfTwo (inCapacity)]),
+        mMask (RoundUpToPowerOfTwo (inCapacity) - 1),
+        mPushed (0),
+        mPopped (0),
+        mDropped (0),
+        mOrphaned (0)
+    {}
+
+    /*!
+        \brief Sets the name of the producing thread, must be called before the buffer is shared with the consumer.
+    */
+    void SignalCapture::SetThreadName (const QString& inName) {
+        mThreadName = inName;
+    }
+
+    /*!
+        \brief Returns the name of the producing thread, see ObjectUtility::ThreadName.
+    */
+    const QString& SignalCapture::ThreadName () const {
+        return mThreadName;
+    }
+
+    /*!
+        \brief Copies a signal emission into the buffer, may only be called by the producer.
+
+        The arguments are passed as received by qt_metacall, without the return value, their
+        types are given by inArgTypes. Returns false when the buffer is full, in which case the
+        emission is dropped.
+    */
+    bool SignalCapture::Push (int inSpyId, unsigned inEmitCount, qint64 inTimestamp, const QVector <int>& inArgTypes, void** inArgs) {
+        unsigned pushed = static_cast <unsigned> (int (mPushed));
+        unsigned popped = static_cast <unsigned> (mPopped.fetchAndAddAcquire (0));
+        if (pushed - popped > mMask) {
+            mDropped.ref ();
+            return false;
+        }
+        Record& record = mRecords [pushed & mMask];
+        record.mSpyId = inSpyId;
+        record.mEmitCount = inEmitCount;
+        record.mTimestamp = inTimestamp;
+        int argCount = qMin (inArgTypes.size (), static_cast <int> (kMaxArgs));
+        for (int i=0; i<argCount; ++i) {
+            int type = inArgTypes [i];
+            if (int size = InlineSize (type)) {
+                memcpy (&record.mInline [i], inArgs [i], size);
+                record.mArgs [i] = &record.mInline [i];
+            }
+            else if (type != QMetaType::Void) {
+                record.mArgs [i] = QMetaType::construct (type, inArgs [i]);
+            }
+            else {
+                record.mArgs [i] = 0;
+            }
+        }
+        record.mCost = Clock::Now () - inTimestamp;
+        // publish the record
+        mPushed.fetchAndStoreRelease (static_cast <int> (pushed + 1));
+        return true;
+    }
+
+    /*!
+        \brief Returns the oldest record, or 0 when the buffer is empty. May only be called by the consumer.
+    */
+    const SignalCapture::Record* SignalCapture::Front () const {
+        return Count () ? &mRecords [static_cast <unsigned> (int (mPopped)) & mMask] : 0;
+    }
+
+    /*!
+        \brief Removes the oldest record and destroys its arguments, which have the given types.
+        May only be called by the consumer.
+    */
+    void SignalCapture::Pop (const QVector <int>& inArgTypes) {
+        if (!Count ()) {
+            return;
+        }
+        unsigned popped = static_cast <unsigned> (int (mPopped));
+        Record& record = mRecords [popped & mMask];
+        int argCount = qMin (inArgTypes.size (), static_cast <int> (kMaxArgs));
+        for (int i=0; i<argCount; ++i) {
+            if (record.mArgs [i] && record.mArgs [i] != &record.mInline [i]) {
+                QMetaType::destroy (inArgTypes [i], record.mArgs [i]);
+            }
+            record.mArgs [i] = 0;
+        }
+        // hand the record back to the producer
+        mPopped.fetchAndStoreRelease (static_cast <int> (popped + 1));
+    }
+
+    /*!
+        \brief Returns the number of emissions that were dropped since the previous call, because the buffer was full.
+    */
+    int SignalCapture::TakeDroppedCount () {
+        return mDropped.fetchAndStoreRelaxed (0);
+    }
+
+    /*!
+        \brief Returns the number of records in the buffer, as seen by the consumer.
+    */
+    int SignalCapture::Count () const {
+        unsigned pushed = static_cast <unsigned> (mPushed.fetchAndAddAcquire (0));
+        unsigned popped = static_cast <unsigned> (int (mPopped));
+        return static_cast <int> (pushed - popped);
+    }
+
+    /*!
+        \brief Returns the maximum number of records in the buffer.
+    */
+    int SignalCapture::Capacity () const {
+        return static_cast <int> (mMask + 1);
+    }
+
+    /*!
+        \brief Marks the buffer as orphaned, the producer may not push any more records after this call.
+    */
+    void SignalCapture::SetOrphaned () {
+        mOrphaned.fetchAndStoreRelease (1);
+    }
+
+    /*!
+        \brief Returns true when the producer will not push any more records.
+
+        All records that were pushed before the buffer was orphaned are visible once this returns true.
+    */
+    bool SignalCapture::IsOrphaned () const {
+        return mOrphaned.fetchAndAddAcquire (0) != 0;
+    }
+
+} // namespace conan
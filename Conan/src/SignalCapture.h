@@ -0,0 +1,109 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains SignalCapture related declarations
+*/
+
+
+#ifndef _SIGNALCAPTURE__17_10_26__09_31_05__H_
+#define _SIGNALCAPTURE__17_10_26__09_31_05__H_
+
+
+#include "ConanDefines.h"
+#include <QtCore/QAtomicInt>
+#include <QtCore/QScopedArrayPointer>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+
+namespace conan {
+
+    /*!
+        \brief A preallocated ring buffer of raw signal emissions.
+
+        Each record holds the id of the spy that captured the emission, its emit count, a
+        monotonic timestamp and a copy of each argument. Arguments of small built-in types
+        are copied into the record itself, all other arguments are copied with
+        QMetaType::construct. Formatting the arguments is left to the consumer of the buffer,
+        so capturing an emission costs a few copies and never formats a string.
+
+        The buffer does not grow: an emission that does not fit is dropped and counted.
+
+        The buffer is a lock free single producer, single consumer queue: one thread may push
+        records while another thread reads and pops them. The producer publishes a record by
+        incrementing the push counter with release semantics, after the record has been
+        written completely. The consumer releases a record the same way through the pop counter.
+    */
+    class CONAN_LOCAL SignalCapture {
+    public:
+        static const int kMaxArgs = 10;             //!< The maximum number of signal arguments supported by Qt
+        static const int kDefaultCapacity = 8192;   //!< The default number of records
+
+        /*!
+            \brief A single captured signal emission.
+        */
+        struct CONAN_LOCAL Record {
+            int mSpyId;                 //!< The id of the spy that captured the emission
+            unsigned mEmitCount;        //!< The emit count of the signal, including this emission
+            qint64 mTimestamp;          //!< The time of the emission, see Clock::Now
+            qint64 mCost;               //!< The time spent capturing the emission, in ns
+            void* mArgs [kMaxArgs];     //!< The copied arguments
+            qint64 mInline [kMaxArgs];  //!< Storage for arguments that are copied into the record
+        };
+
+    public:
+        SignalCapture (int inCapacity = kDefaultCapacity);
+
+        void SetThreadName (const QString& inName);
+        const QString& ThreadName () const;
+
+        // producer
+        bool Push (int inSpyId, unsigned inEmitCount, qint64 inTimestamp, const QVector <int>& inArgTypes, void** inArgs);
+
+        // consumer
+        const Record* Front () const;
+        void Pop (const QVector <int>& inArgTypes);
+        int TakeDroppedCount ();
+
+        int Count () const;
+        int Capacity () const;
+
+        void SetOrphaned ();
+        bool IsOrphaned () const;
+
+    private:
+        Q_DISABLE_COPY (SignalCapture)
+
+        QScopedArrayPointer <Record> mRecords;  //!< The preallocated records
+        const unsigned mMask;                   //!< The capacity minus one, the capacity is a power of two
+        mutable QAtomicInt mPushed;             //!< The number of pushed records, only written by the producer
+        mutable QAtomicInt mPopped;             //!< The number of popped records, only written by the consumer
+        QAtomicInt mDropped;                    //!< The number of emissions that did not fit since the last TakeDroppedCount
+        mutable QAtomicInt mOrphaned;           //!< Non zero when the producer will not push any more records
+        QString mThreadName;                    //!< The name of the producing thread, set before the buffer is shared
+    };
+
+} // namespace conan
+
+
+#endif //_SIGNALCAPTURE__17_10_26__09_31_05__H_
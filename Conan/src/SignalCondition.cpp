@@ -0,0 +1,286 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains SignalCondition related definitions
+*/
+
+
+#include "SignalCondition.h"
+#include <QtCore/QMetaType>
+#include <QtCore/QStringList>
+
+
+namespace conan {
+
+    namespace /*unnamed*/ {
+
+        /*!
+            \brief Returns true when arguments of the given type are compared as numbers.
+        */
+        bool IsNumeric (int inType) {
+            switch (inType) {
+                case QMetaType::Bool:
+                case QMetaType::Int:
+                case QMetaType::UInt:
+                case QMetaType::LongLong:
+                case QMetaType::ULongLong:
+                case QMetaType::Double:
+                case QMetaType::Long:
+                case QMetaType::Short:
+                case QMetaType::Char:
+                case QMetaType::ULong:
+                case QMetaType::UShort:
+                case QMetaType::UChar:
+                case QMetaType::Float:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        /*!
+            \brief Returns the value of a numeric argument, see IsNumeric.
+        */
+        double NumericValue (int inType, const void* inArg) {
+            switch (inType) {
+                case QMetaType::Bool:
+                    return *static_cast <const bool*> (inArg) ? 1 : 0;
+                case QMetaType::Int:
+                    return *static_cast <const int*> (inArg);
+                case QMetaType::UInt:
+                    return *static_cast <const uint*> (inArg);
+                case QMetaType::LongLong:
+                    return static_cast <double> (*static_cast <const qlonglong*> (inArg));
+                case QMetaType::ULongLong:
+                    return static_cast <double> (*static_cast <const qulonglong*> (inArg));
+                case QMetaType::Double:
+                    return *static_cast <const double*> (inArg);
+                case QMetaType::Long:
+                    return *static_cast <const long*> (inArg);
+                case QMetaType::Short:
+                    return *static_cast <const short*> (inArg);
+                case QMetaType::Char:
+                    return *static_cast <const char*> (inArg);
+                case QMetaType::ULong:
+                    return *static_cast <const ulong*> (inArg);
+                case QMetaType::UShort:
+                    return *static_cast <const ushort*> (inArg);
+                case QMetaType::UChar:
+                    return *static_cast <const uchar*> (inArg);
+                case QMetaType::Float:
+                    return *static_cast <const float*> (inArg);
+                default:
+                    return 0;
+            }
+        }
+
+        /*!
+            \brief Returns the three way comparison of two values: negative, zero or positive.
+        */
+        template <class T>
+        int Compare (const T& inLeft, const T& inRight) {
+            return inLeft < inRight ? -1 : (inRight < inLeft ? 1 : 0);
+        }
+
+    } // unnamed namespace
+
+
+    SignalCondition::SignalCondition () :
+        mActions (0)
+    {}
+
+    /*!
+        \brief Parses the given text into a condition for a signal with the given argument types.
+
+        Returns an empty condition and sets \a outError when the text is invalid, when an
+        argument does not exist, or when the type of an argument can not be compared.
+    */
+    SignalCondition SignalCondition::Parse (const QString& inText, const QVector <int>& inArgTypes, QString* outError) {
+        SignalCondition condition;
+        QRegExp predicate ("arg(\\d+)(==|!=|<=|>=|=|<|>|~)(.+)");
+        foreach (const QString& text, inText.split (QRegExp ("\\s+"), QString::SkipEmptyParts)) {
+            QString error;
+            if (text.startsWith ("do:")) {
+                QString action = text.mid (3).toLower ();
+                if (action == "start") {
+                    condition.mActions |= kStartLogging;
+                }
+                else if (action == "stop") {
+                    condition.mActions |= kStopLogging;
+                }
+                else if (action == "burst") {
+                    condition.mActions |= kTriggerBurst;
+                }
+                else if (action == "snapshot") {
+                    condition.mActions |= kSnapshotObjects;
+                }
+                else if (action == "dump") {
+                    condition.mActions |= kDumpLog;
+                }
+                else {
+                    error = QString ("Unknown action '%1', expected start, stop, burst, snapshot or dump").arg (action);
+                }
+            }
+            else if (predicate.exactMatch (text)) {
+                Term term;
+                term.mArgument = predicate.cap (1).toInt ();
+                QString op = predicate.cap (2);
+                QString value = predicate.cap (3);
+                term.mOperator =
+                    (op == "==" || op == "=") ? kEqual :
+                    op == "!=" ? kNotEqual :
+                    op == "<" ? kLess :
+                    op == "<=" ? kLessOrEqual :
+                    op == ">" ? kGreater :
+                    op == ">=" ? kGreaterOrEqual :
+                    kMatches;
+                term.mType = term.mArgument < inArgTypes.size () ? inArgTypes [term.mArgument] : QMetaType::Void;
+                term.mNumber = 0;
+                if (term.mArgument >= inArgTypes.size ()) {
+                    error = QString ("The signal has no argument %1").arg (term.mArgument);
+                }
+                else if (IsNumeric (term.mType)) {
+                    bool ok = false;
+                    term.mNumber = value.toDouble (&ok);
+                    if (term.mOperator == kMatches) {
+                        error = QString ("Argument %1 is a number, ~ only applies to text").arg (term.mArgument);
+                    }
+                    else if (!ok) {
+                        error = QString ("Argument %1 is a number, expected a number instead of '%2'").arg (term.mArgument).arg (value);
+                    }
+                }
+                else if (term.mType == QMetaType::QString || term.mType == QMetaType::QByteArray) {
+                    term.mText = value;
+                    term.mBytes = value.toLatin1 ();
+                    if (term.mOperator == kMatches) {
+                        term.mPattern = QRegExp (value, Qt::CaseSensitive, QRegExp::RegExp2);
+                        if (!term.mPattern.isValid ()) {
+                            error = QString ("Invalid regular expression '%1': %2").arg (value).arg (term.mPattern.errorString ());
+                        }
+                    }
+                }
+                else {
+                    error = QString ("Argument %1 of type %2 can not be compared")
+                        .arg (term.mArgument)
+                        .arg (QLatin1String (QMetaType::typeName (term.mType)));
+                }
+                condition.mTerms.push_back (term);
+            }
+            else {
+                error = QString ("Expected arg[n][operator][value] or do:[action] instead of '%1'").arg (text);
+            }
+            if (!error.isEmpty ()) {
+                if (outError) {
+                    *outError = error;
+                }
+                return SignalCondition ();
+            }
+        }
+        condition.mText = inText.simplified ();
+        if (outError) {
+            outError->clear ();
+        }
+        return condition;
+    }
+
+    /*!
+        \brief Returns the condition in the format accepted by Parse.
+    */
+    QString SignalCondition::ToString () const {
+        return mText;
+    }
+
+    /*!
+        \brief Returns true when the condition has neither predicate terms nor actions.
+    */
+    bool SignalCondition::IsEmpty () const {
+        return mTerms.isEmpty () && !mActions;
+    }
+
+    /*!
+        \brief Returns the actions that are triggered by a matching emission, a combination of Actions.
+    */
+    int SignalCondition::GetActions () const {
+        return mActions;
+    }
+
+    /*!
+        \brief Returns true when the given arguments of an emission match all predicate terms.
+    */
+    bool SignalCondition::Matches (void** inArgs) const {
+        int termCount = mTerms.size ();
+        for (int t=0; t<termCount; ++t) {
+            const Term& term = mTerms [t];
+            if (!Matches (term, inArgs [term.mArgument])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*!
+        \brief Returns true when the given argument matches the given predicate term.
+    */
+    bool SignalCondition::Matches (const Term& inTerm, const void* inArg) const {
+        if (!inArg) {
+            return false;
+        }
+        int order = 0;
+        if (inTerm.mType == QMetaType::QString) {
+            const QString& text = *static_cast <const QString*> (inArg);
+            if (inTerm.mOperator == kMatches) {
+                // QRegExp keeps the state of the last match, so each match uses its own copy
+                QRegExp pattern (inTerm.mPattern);
+                return pattern.indexIn (text) >= 0;
+            }
+            order = Compare (text, inTerm.mText);
+        }
+        else if (inTerm.mType == QMetaType::QByteArray) {
+            const QByteArray& bytes = *static_cast <const QByteArray*> (inArg);
+            if (inTerm.mOperator == kMatches) {
+                QRegExp pattern (inTerm.mPattern);
+                return pattern.indexIn (QString::fromLatin1 (bytes.constData (), bytes.size ())) >= 0;
+            }
+            order = Compare (bytes, inTerm.mBytes);
+        }
+        else {
+            order = Compare (NumericValue (inTerm.mType, inArg), inTerm.mNumber);
+        }
+        switch (inTerm.mOperator) {
+            case kEqual:
+                return order == 0;
+            case kNotEqual:
+                return order != 0;
+            case kLess:
+                return order < 0;
+            case kLessOrEqual:
+                return order <= 0;
+            case kGreater:
+                return order > 0;
+            case kGreaterOrEqual:
+                return order >= 0;
+            default:
+                return false;
+        }
+    }
+
+} // namespace conan
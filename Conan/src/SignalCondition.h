@@ -0,0 +1,110 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains SignalCondition related declarations
+*/
+
+
+#ifndef _SIGNALCONDITION__17_10_26__22_31_07__H_
+#define _SIGNALCONDITION__17_10_26__22_31_07__H_
+
+
+#include "ConanDefines.h"
+#include <QtCore/QByteArray>
+#include <QtCore/QRegExp>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+
+namespace conan {
+
+    /*!
+        \brief A predicate on the arguments of a signal emission, and the actions triggered by the emissions that match.
+
+        A condition consists of terms separated by white space. A predicate term has the form
+        arg[n][operator][value], where n is the index of the argument and operator is one of
+        ==, !=, <, <=, >, >= or ~. Numeric arguments are compared as numbers, QString and
+        QByteArray arguments are compared as text; ~ matches text against a regular expression,
+        which may not contain white space, use \\s instead. An emission matches when all
+        predicate terms match, a condition without predicate terms matches all emissions.
+
+        An action term has the form do:action, see Actions, f.e: arg0>1000 do:snapshot do:dump
+
+        A condition is parsed against the argument types of a single signal, so it is evaluated
+        on the raw arguments of an emission, without converting them to a QVariant or a string.
+        A condition is immutable once parsed, Matches can be called by any thread.
+    */
+    class CONAN_LOCAL SignalCondition {
+    public:
+        //! \brief The actions that are triggered by a matching emission
+        typedef enum ACTIONS {
+            kStartLogging = 1,      //!< do:start, resumes logging of all spies and of the tracer
+            kStopLogging = 2,       //!< do:stop, pauses logging of all spies and of the tracer, after logging the matching emission
+            kTriggerBurst = 4,      //!< do:burst, starts a burst of the sampling policy of the logger, see SignalSampler
+            kSnapshotObjects = 8,   //!< do:snapshot, exports all object hierarchies to an XML file
+            kDumpLog = 16           //!< do:dump, writes the logs kept in memory to a text file
+        } Actions;
+
+        SignalCondition ();
+
+        static SignalCondition Parse (const QString& inText, const QVector <int>& inArgTypes, QString* outError = 0);
+        QString ToString () const;
+        bool IsEmpty () const;
+        int GetActions () const;
+
+        bool Matches (void** inArgs) const;
+
+    private:
+        typedef enum OPERATORS {
+            kEqual,
+            kNotEqual,
+            kLess,
+            kLessOrEqual,
+            kGreater,
+            kGreaterOrEqual,
+            kMatches
+        } Operators;
+
+        /*!
+            \brief A single predicate term.
+        */
+        struct CONAN_LOCAL Term {
+            int mArgument;          //!< The index of the argument
+            int mType;              //!< The QMetaType type of the argument
+            int mOperator;          //!< One of Operators
+            double mNumber;         //!< The value of numeric arguments
+            QString mText;          //!< The value of QString arguments
+            QByteArray mBytes;      //!< The value of QByteArray arguments
+            QRegExp mPattern;       //!< The regular expression of kMatches
+        };
+
+        bool Matches (const Term& inTerm, const void* inArg) const;
+
+        QVector <Term> mTerms;      //!< The predicate terms
+        int mActions;               //!< A combination of Actions
+        QString mText;              //!< The parsed text
+    };
+
+} // namespace conan
+
+
+#endif //_SIGNALCONDITION__17_10_26__22_31_07__H_
@@ -0,0 +1,245 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains SignalEventModel related definitions
+*/
+
+
+#include "SignalEventModel.h"
+#include <QtCore/QtAlgorithms>
+
+
+namespace conan {
+
+    /*!
+        \brief Creates a model that shows all events of the given store.
+    */
+    SignalEventModel::SignalEventModel (SignalEventStore* inStore, QObject* inParent) :
+        QAbstractTableModel (inParent),
+        mStore (inStore),
+        mFiltered (false),
+        mPaused (false),
+        mFirst (inStore->First ()),
+        mEnd (inStore->End ()),
+        mHead (0)
+    {
+        setObjectName ("SignalEventModel");
+        connect (&mRefreshTimer, SIGNAL (timeout ()), this, SLOT (SlotRefresh ()));
+        mRefreshTimer.start (kRefreshInterval);
+    }
+
+    const SignalEventStore& SignalEventModel::GetStore () const {
+        return *mStore;
+    }
+
+    /*!
+        \brief Shows the available events that match the given filter.
+    */
+    void SignalEventModel::SetFilter (const SignalEventFilter& inFilter) {
+        beginResetModel ();
+        mFilter = inFilter;
+        mFiltered = !inFilter.IsEmpty ();
+        mFirst = mStore->First ();
+        mEnd = mStore->End ();
+        mRows.clear ();
+        mHead = 0;
+        if (mFiltered) {
+            mRows = mStore->Find (mFilter, mFirst);
+        }
+        endResetModel ();
+        emit SignalRowsChanged ();
+    }
+
+    const SignalEventFilter& SignalEventModel::GetFilter () const {
+        return mFilter;
+    }
+
+    /*!
+        \brief Stops or resumes refreshing the rows, the store keeps receiving events while the model is paused.
+    */
+    void SignalEventModel::SetPaused (bool inPaused) {
+        mPaused = inPaused;
+        if (!mPaused) {
+            SlotRefresh ();
+        }
+    }
+
+    bool SignalEventModel::IsPaused () const {
+        return mPaused;
+    }
+
+    /*!
+        \brief Discards all events of the store.
+    */
+    void SignalEventModel::Clear () {
+        mStore->Clear ();
+        SetFilter (mFilter);
+    }
+
+    /*!
+        \brief Returns the number of the event in the given row, see SignalEventStore.
+    */
+    qint64 SignalEventModel::Event (int inRow) const {
+        return mFiltered ? mRows [mHead + inRow] : mFirst + inRow;
+    }
+
+    int SignalEventModel::rowCount (const QModelIndex& inParent) const {
+        if (inParent.isValid ()) {
+            return 0;
+        }
+        return mFiltered ? mRows.size () - mHead : static_cast <int> (mEnd - mFirst);
+    }
+
+    int SignalEventModel::columnCount (const QModelIndex& /*inParent*/) const {
+        return kColumnCount;
+    }
+
+    QVariant SignalEventModel::data (const QModelIndex& inIndex, int inRole) const {
+        if (!inIndex.isValid () || inIndex.row () >= rowCount ()) {
+            return QVariant ();
+        }
+        qint64 event = Event (inIndex.row ());
+        if (inRole == Qt::DisplayRole || inRole == Qt::ToolTipRole) {
+            if (!mStore->Contains (event)) {
+                return inIndex.column () == kArguments ? QString ("(discarded)") : QVariant ();
+            }
+            switch (inIndex.column ()) {
+                case kTime:
+                    return QString::number (mStore->Time (event) / 1000000000.0, 'f', 9);
+                case kThread:
+                    return mStore->Thread (event);
+                case kObject:
+                    return mStore->Object (event);
+                case kAddress:
+                    return mStore->Address (event);
+                case kSignature:
+                    return mStore->Signature (event);
+                case kEmitCount:
+                    return mStore->EmitCount (event);
+                case kArguments:
+                    return mStore->Arguments (event);
+                default:
+                    return QVariant ();
+            }
+        }
+        if (inRole == Qt::TextAlignmentRole && (inIndex.column () == kTime || inIndex.column () == kEmitCount)) {
+            return int (Qt::AlignRight | Qt::AlignVCenter);
+        }
+        return QVariant ();
+    }
+
+    QVariant SignalEventModel::headerData (int inSection, Qt::Orientation inOrientation, int inRole) const {
+        if (inOrientation == Qt::Horizontal && inRole == Qt::DisplayRole) {
+            switch (inSection) {
+                case kTime:
+                    return QString ("Time (s)");
+                case kThread:
+                    return QString ("Thread");
+                case kObject:
+                    return QString ("Object");
+                case kAddress:
+                    return QString ("Address");
+                case kSignature:
+                    return QString ("Signature");
+                case kEmitCount:
+                    return QString ("Emit count");
+                case kArguments:
+                    return QString ("Arguments");
+                default:
+                    return QVariant ();
+            }
+        }
+        if (inOrientation == Qt::Horizontal && inRole == Qt::ToolTipRole && inSection == kTime) {
+            return QString ("The time of the emission since the session start");
+        }
+        return QVariant ();
+    }
+
+    /*!
+        \brief Removes the rows of discarded events and appends the rows of new events that match the filter.
+    */
+    void SignalEventModel::SlotRefresh () {
+        if (mPaused) {
+            return;
+        }
+        bool changed = false;
+
+        // the discarded events are the oldest, so their rows are at the top
+        qint64 first = mStore->First ();
+        int removed = 0;
+        if (mFiltered) {
+            removed = static_cast <int> (qLowerBound (mRows.constBegin () + mHead, mRows.constEnd (), first) - (mRows.constBegin () + mHead));
+        }
+        else {
+            removed = static_cast <int> (qMin (qMax (first, mFirst), mEnd) - mFirst);
+        }
+        if (removed > 0) {
+            beginRemoveRows (QModelIndex (), 0, removed - 1);
+            if (mFiltered) {
+                mHead += removed;
+                if (mHead >= 1024 && mHead * 2 >= mRows.size ()) {
+                    mRows.remove (0, mHead);
+                    mHead = 0;
+                }
+            }
+            else {
+                mFirst += removed;
+            }
+            endRemoveRows ();
+            changed = true;
+        }
+
+        qint64 end = mStore->End ();
+        if (end > mEnd) {
+            int count = rowCount ();
+            if (mFiltered) {
+                QVector <qint64> events = mStore->Find (mFilter, mEnd);
+                mEnd = end;
+                if (!events.isEmpty ()) {
+                    beginInsertRows (QModelIndex (), count, count + events.size () - 1);
+                    mRows += events;
+                    endInsertRows ();
+                    changed = true;
+                }
+            }
+            else {
+                // all rows have been removed when the store discarded events that were never shown
+                qint64 from = qMax (mEnd, first);
+                if (end > from) {
+                    beginInsertRows (QModelIndex (), count, count + static_cast <int> (end - from) - 1);
+                    mFirst = count ? mFirst : from;
+                    mEnd = end;
+                    endInsertRows ();
+                    changed = true;
+                }
+                else {
+                    mFirst = mEnd = end;
+                }
+            }
+        }
+
+        if (changed) {
+            emit SignalRowsChanged ();
+        }
+    }
+
+} // namespace conan
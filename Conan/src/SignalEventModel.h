@@ -0,0 +1,111 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains SignalEventModel related declarations
+*/
+
+
+#ifndef _SIGNALEVENTMODEL__17_10_26__23_58_40__H_
+#define _SIGNALEVENTMODEL__17_10_26__23_58_40__H_
+
+
+#include "ConanDefines.h"
+#include "SignalEventStore.h"
+#include <QtCore/QAbstractTableModel>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
+
+
+namespace conan {
+
+    /*!
+        \brief Presents the events of a SignalEventStore that match a filter, the oldest first.
+
+        The model only keeps the numbers of the matching events; without a filter it only keeps
+        the range of shown events. All fields are read from the store when a row is shown, so
+        a view with uniform row heights only visits the visible rows.
+
+        The model periodically removes the rows of the events that the store discarded and
+        appends the rows of new events, which are matched against the filter once. While the
+        model is paused the rows are not refreshed, rows of discarded events remain and show
+        no data.
+    */
+    class CONAN_LOCAL SignalEventModel : public QAbstractTableModel
+    {
+        Q_OBJECT
+
+    public:
+        typedef enum COLUMNS {
+            kTime,
+            kThread,
+            kObject,
+            kAddress,
+            kSignature,
+            kEmitCount,
+            kArguments,
+            kColumnCount
+        } Columns;
+
+        static const int kRefreshInterval = 250;    //!< The interval in ms at which new events are shown
+
+    public:
+        SignalEventModel (SignalEventStore* inStore, QObject* inParent = 0);
+
+        const SignalEventStore& GetStore () const;
+
+        void SetFilter (const SignalEventFilter& inFilter);
+        const SignalEventFilter& GetFilter () const;
+        void SetPaused (bool inPaused);
+        bool IsPaused () const;
+        void Clear ();
+
+        qint64 Event (int inRow) const;
+
+        // qt overrides
+        virtual int rowCount (const QModelIndex& inParent = QModelIndex ()) const;
+        virtual int columnCount (const QModelIndex& inParent = QModelIndex ()) const;
+        virtual QVariant data (const QModelIndex& inIndex, int inRole) const;
+        virtual QVariant headerData (int inSection, Qt::Orientation inOrientation, int inRole = Qt::DisplayRole) const;
+
+    signals:
+        //! \brief Emitted after rows have been added or removed.
+        void SignalRowsChanged ();
+
+    private slots:
+        void SlotRefresh ();
+
+    private:
+        SignalEventStore* mStore;       //!< The events, owned by the signal logger
+        SignalEventFilter mFilter;      //!< Selects the shown events
+        bool mFiltered;                 //!< False when mFilter is empty, in which case mRows is not used
+        bool mPaused;                   //!< True when the rows are not refreshed
+        qint64 mFirst;                  //!< The first shown event, when mFiltered is false
+        qint64 mEnd;                    //!< The end of the events that have been matched against the filter
+        QVector <qint64> mRows;         //!< The shown events starting at mHead, when mFiltered is true
+        int mHead;                      //!< The index in mRows of the first row
+        QTimer mRefreshTimer;           //!< Periodically refreshes the rows
+    };
+
+} // namespace conan
+
+
+#endif //_SIGNALEVENTMODEL__17_10_26__23_58_40__H_
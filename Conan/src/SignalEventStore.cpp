@@ -0,0 +1,451 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains SignalEventStore related definitions
+*/
+
+
+#include "ConnectionModel.h"
+#include "SignalEventStore.h"
+#include <QtCore/QRegExp>
+#include <QtCore/QtAlgorithms>
+
+
+namespace conan {
+
+    namespace /*unnamed*/ {
+
+        /*!
+            \brief A single text field of a SignalEventFilter.
+        */
+        struct TextPattern {
+            TextPattern (const QString& inText) :
+                mText (inText.trimmed ()),
+                mWildcard (mText.contains ('*') || mText.contains ('?')),
+                mPattern (mText, Qt::CaseInsensitive, QRegExp::Wildcard)
+            {}
+
+            bool IsEmpty () const {
+                return mText.isEmpty ();
+            }
+
+            bool Matches (const QString& inText) const {
+                if (mText.isEmpty ()) {
+                    return true;
+                }
+                return mWildcard ? mPattern.exactMatch (inText) : inText.contains (mText, Qt::CaseInsensitive);
+            }
+
+            QString mText;      //!< The trimmed field
+            bool mWildcard;     //!< When true mPattern must match the complete text
+            QRegExp mPattern;   //!< The wildcard pattern, only used when mWildcard is true
+        };
+
+    } // unnamed namespace
+
+
+    /*!
+        \brief Creates an empty filter, which matches all events.
+    */
+    SignalEventFilter::SignalEventFilter () :
+        mFrom (-1),
+        mTo (-1)
+    {}
+
+    /*!
+        \brief Returns true when the filter matches all events.
+    */
+    bool SignalEventFilter::IsEmpty () const {
+        return mSignal.trimmed ().isEmpty () && mObject.trimmed ().isEmpty () && mThread.trimmed ().isEmpty () && mFrom < 0 && mTo < 0;
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    SignalEventStore::Postings::Postings () :
+        mHead (0)
+    {}
+
+    /*!
+        \brief Appends an event number, which must be greater than all event numbers in the list.
+    */
+    void SignalEventStore::Postings::Append (qint64 inEvent) {
+        mEvents.push_back (inEvent);
+    }
+
+    /*!
+        \brief Removes the oldest event number, the list is compacted when more than half of it has been removed.
+    */
+    void SignalEventStore::Postings::RemoveFirst () {
+        Q_ASSERT (mHead < mEvents.size ());
+        ++mHead;
+        if (mHead >= 1024 && mHead * 2 >= mEvents.size ()) {
+            mEvents.remove (0, mHead);
+            mHead = 0;
+        }
+    }
+
+    /*!
+        \brief Returns the number of event numbers that are not less than inFrom.
+    */
+    int SignalEventStore::Postings::Count (qint64 inFrom) const {
+        return static_cast <int> (mEvents.constEnd () - qLowerBound (mEvents.constBegin () + mHead, mEvents.constEnd (), inFrom));
+    }
+
+    /*!
+        \brief Appends all event numbers that are not less than inFrom to the given list.
+    */
+    void SignalEventStore::Postings::CopyTo (qint64 inFrom, QVector <qint64>& ioEvents) const {
+        QVector <qint64>::const_iterator it = qLowerBound (mEvents.constBegin () + mHead, mEvents.constEnd (), inFrom);
+        for (; it != mEvents.constEnd (); ++it) {
+            ioEvents.push_back (*it);
+        }
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Creates a store that keeps the given number of most recent events and argument characters.
+
+        The memory is allocated as events are written, up to the given capacities.
+    */
+    SignalEventStore::SignalEventStore (int inCapacity, int inTextCapacity) :
+        mCapacity (qMax (1, inCapacity)),
+        mTextCapacity (qMax (1, inTextCapacity)),
+        mSessionStart (0),
+        mFirst (0),
+        mEnd (0),
+        mTextEnd (0)
+    {}
+
+    /*!
+        \brief Stores the session start, all times are relative to the session start.
+    */
+    void SignalEventStore::WriteSessionStart (const QDateTime&, qint64 inTimestamp) {
+        mSessionStart = inTimestamp;
+    }
+
+    /*!
+        \brief Stores a signal emission, the oldest event is discarded when the store is full.
+    */
+    void SignalEventStore::Write (const SignalLogEntry& inEntry) {
+        if (inEntry.mSpyId < 0 || !inEntry.mSignalData) {
+            return;
+        }
+        if (mEnd - mFirst == mCapacity) {
+            RemoveFirst ();
+        }
+
+        if (inEntry.mSpyId >= mSpies.size ()) {
+            mSpies.resize (inEntry.mSpyId + 1);
+        }
+        Spy& spy = mSpies [inEntry.mSpyId];
+        if (spy.mObject.isNull ()) {
+            spy.mObject = inEntry.mSignalData->QualifiedName ();
+            spy.mAddress = inEntry.mSignalData->Address ();
+            spy.mSignature = inEntry.mSignalData->Signature ();
+        }
+        int thread = ThreadId (inEntry.mThread ? *inEntry.mThread : QString ());
+        qint64 argumentStart = mTextEnd;
+        AppendText (inEntry.mArguments);
+
+        // the columns grow until they reach the capacity
+        int slot = Slot (mEnd);
+        if (slot == mTimestamps.size ()) {
+            mTimestamps.push_back (inEntry.mTimestamp);
+            mSpyIds.push_back (inEntry.mSpyId);
+            mEmitCounts.push_back (inEntry.mEmitCount);
+            mThreadIds.push_back (static_cast <quint16> (thread));
+            mArgumentStarts.push_back (argumentStart);
+        }
+        else {
+            mTimestamps [slot] = inEntry.mTimestamp;
+            mSpyIds [slot] = inEntry.mSpyId;
+            mEmitCounts [slot] = inEntry.mEmitCount;
+            mThreadIds [slot] = static_cast <quint16> (thread);
+            mArgumentStarts [slot] = argumentStart;
+        }
+        spy.mEvents.Append (mEnd);
+        mThreads [thread].mEvents.Append (mEnd);
+        ++mEnd;
+    }
+
+    /*!
+        \brief Discards all events, the numbers of later events continue where the discarded events ended.
+    */
+    void SignalEventStore::Clear () {
+        mFirst = mEnd;
+        for (int s=0; s<mSpies.size (); ++s) {
+            mSpies [s].mEvents = Postings ();
+        }
+        for (int t=0; t<mThreads.size (); ++t) {
+            mThreads [t].mEvents = Postings ();
+        }
+    }
+
+    int SignalEventStore::Capacity () const {
+        return mCapacity;
+    }
+
+    /*!
+        \brief Returns the number of the oldest available event.
+    */
+    qint64 SignalEventStore::First () const {
+        return mFirst;
+    }
+
+    /*!
+        \brief Returns the number of the next event, which is one past the newest available event.
+    */
+    qint64 SignalEventStore::End () const {
+        return mEnd;
+    }
+
+    /*!
+        \brief Returns the monotonic timestamp of the session start, see Clock::Now.
+    */
+    qint64 SignalEventStore::SessionStart () const {
+        return mSessionStart;
+    }
+
+    /*!
+        \brief Returns true when the event with the given number is available.
+    */
+    bool SignalEventStore::Contains (qint64 inEvent) const {
+        return inEvent >= mFirst && inEvent < mEnd;
+    }
+
+    /*!
+        \brief Returns the time of the given event in ns since the session start, or 0 when the event is not available.
+    */
+    qint64 SignalEventStore::Time (qint64 inEvent) const {
+        return Contains (inEvent) ? mTimestamps [Slot (inEvent)] - mSessionStart : 0;
+    }
+
+    /*!
+        \brief Returns the emit count of the given event, or 0 when the event is not available.
+    */
+    unsigned SignalEventStore::EmitCount (qint64 inEvent) const {
+        return Contains (inEvent) ? mEmitCounts [Slot (inEvent)] : 0;
+    }
+
+    /*!
+        \brief Returns the name of the thread that emitted the given event.
+    */
+    QString SignalEventStore::Thread (qint64 inEvent) const {
+        return Contains (inEvent) ? mThreads [mThreadIds [Slot (inEvent)]].mName : QString ();
+    }
+
+    /*!
+        \brief Returns the qualified name of the object that emitted the given event.
+    */
+    QString SignalEventStore::Object (qint64 inEvent) const {
+        return Contains (inEvent) ? mSpies [mSpyIds [Slot (inEvent)]].mObject : QString ();
+    }
+
+    /*!
+        \brief Returns the address of the object that emitted the given event.
+    */
+    QString SignalEventStore::Address (qint64 inEvent) const {
+        return Contains (inEvent) ? mSpies [mSpyIds [Slot (inEvent)]].mAddress : QString ();
+    }
+
+    /*!
+        \brief Returns the signature of the signal of the given event.
+    */
+    QString SignalEventStore::Signature (qint64 inEvent) const {
+        return Contains (inEvent) ? mSpies [mSpyIds [Slot (inEvent)]].mSignature : QString ();
+    }
+
+    /*!
+        \brief Returns the formatted arguments of the given event.
+
+        Returns '(discarded)' when the arguments have been overwritten by the arguments of
+        newer events.
+    */
+    QString SignalEventStore::Arguments (qint64 inEvent) const {
+        if (!Contains (inEvent)) {
+            return QString ();
+        }
+        qint64 start = mArgumentStarts [Slot (inEvent)];
+        qint64 end = inEvent + 1 < mEnd ? mArgumentStarts [Slot (inEvent + 1)] : mTextEnd;
+        if (start < mTextEnd - mTextCapacity) {
+            return QString ("(discarded)");
+        }
+        int position = static_cast <int> (start % mTextCapacity);
+        int length = static_cast <int> (end - start);
+        if (position + length <= mTextCapacity) {
+            return mText.mid (position, length);
+        }
+        return mText.mid (position) + mText.left (position + length - mTextCapacity);
+    }
+
+    /*!
+        \brief Returns the numbers of all available events from inFrom onwards that match the given filter, in ascending order.
+
+        The text fields of the filter are matched once per spy and once per thread. When the
+        filter has a signal, object or thread field, only the events of the matching spies or
+        the matching threads are visited, whichever are fewer. Otherwise all events are visited,
+        to match their time.
+    */
+    QVector <qint64> SignalEventStore::Find (const SignalEventFilter& inFilter, qint64 inFrom) const {
+        QVector <qint64> events;
+        qint64 from = qMax (inFrom, mFirst);
+        if (from >= mEnd) {
+            return events;
+        }
+
+        TextPattern signal (inFilter.mSignal);
+        TextPattern object (inFilter.mObject);
+        TextPattern thread (inFilter.mThread);
+
+        bool spyFiltered = !signal.IsEmpty () || !object.IsEmpty ();
+        QVector <bool> spyMatches;
+        int spyEvents = 0;
+        if (spyFiltered) {
+            spyMatches.fill (false, mSpies.size ());
+            for (int s=0; s<mSpies.size (); ++s) {
+                const Spy& spy = mSpies [s];
+                if (!spy.mObject.isNull () && signal.Matches (spy.mSignature) && (object.Matches (spy.mObject) || object.Matches (spy.mAddress))) {
+                    spyMatches [s] = true;
+                    spyEvents += spy.mEvents.Count (from);
+                }
+            }
+        }
+
+        bool threadFiltered = !thread.IsEmpty ();
+        QVector <bool> threadMatches;
+        int threadEvents = 0;
+        if (threadFiltered) {
+            threadMatches.fill (false, mThreads.size ());
+            for (int t=0; t<mThreads.size (); ++t) {
+                if (thread.Matches (mThreads [t].mName)) {
+                    threadMatches [t] = true;
+                    threadEvents += mThreads [t].mEvents.Count (from);
+                }
+            }
+        }
+
+        // collect the candidates from the most selective index
+        QVector <qint64> candidates;
+        bool scanAll = false;
+        if (spyFiltered && (!threadFiltered || spyEvents <= threadEvents)) {
+            candidates.reserve (spyEvents);
+            for (int s=0; s<mSpies.size (); ++s) {
+                if (spyMatches [s]) {
+                    mSpies [s].mEvents.CopyTo (from, candidates);
+                }
+            }
+            qSort (candidates);
+        }
+        else if (threadFiltered) {
+            candidates.reserve (threadEvents);
+            for (int t=0; t<mThreads.size (); ++t) {
+                if (threadMatches [t]) {
+                    mThreads [t].mEvents.CopyTo (from, candidates);
+                }
+            }
+            qSort (candidates);
+        }
+        else {
+            scanAll = true;
+        }
+
+        int count = scanAll ? static_cast <int> (mEnd - from) : candidates.size ();
+        for (int c=0; c<count; ++c) {
+            qint64 event = scanAll ? from + c : candidates [c];
+            int slot = Slot (event);
+            if ((spyFiltered && !spyMatches [mSpyIds [slot]]) || (threadFiltered && !threadMatches [mThreadIds [slot]])) {
+                continue;
+            }
+            qint64 time = mTimestamps [slot] - mSessionStart;
+            if ((inFilter.mFrom >= 0 && time < inFilter.mFrom) || (inFilter.mTo >= 0 && time > inFilter.mTo)) {
+                continue;
+            }
+            events.push_back (event);
+        }
+        return events;
+    }
+
+    /*!
+        \brief Returns the index in the columns of the given event.
+    */
+    int SignalEventStore::Slot (qint64 inEvent) const {
+        return static_cast <int> (inEvent % mCapacity);
+    }
+
+    /*!
+        \brief Returns the id of the thread with the given name, the thread is added on first use.
+    */
+    int SignalEventStore::ThreadId (const QString& inName) {
+        QHash <QString, int>::const_iterator it = mThreadIndex.find (inName);
+        if (it != mThreadIndex.end ()) {
+            return it.value ();
+        }
+        if (mThreads.size () == kMaxThreadCount) {
+            return kMaxThreadCount - 1;
+        }
+        ThreadInfo thread;
+        thread.mName = inName;
+        mThreads.push_back (thread);
+        mThreadIndex.insert (inName, mThreads.size () - 1);
+        return mThreads.size () - 1;
+    }
+
+    /*!
+        \brief Discards the oldest event.
+    */
+    void SignalEventStore::RemoveFirst () {
+        int slot = Slot (mFirst);
+        mSpies [mSpyIds [slot]].mEvents.RemoveFirst ();
+        mThreads [mThreadIds [slot]].mEvents.RemoveFirst ();
+        ++mFirst;
+    }
+
+    /*!
+        \brief Appends the given arguments to the text ring, truncated to kMaxArgumentsLength characters.
+
+        The text grows until it reaches its capacity, after which the oldest characters are
+        overwritten.
+    */
+    void SignalEventStore::AppendText (const QString& inText) {
+        const QChar* data = inText.constData ();
+        int length = qMin (qMin (inText.size (), static_cast <int> (kMaxArgumentsLength)), mTextCapacity);
+        while (length > 0) {
+            int position = static_cast <int> (mTextEnd % mTextCapacity);
+            int count = qMin (length, mTextCapacity - position);
+            if (position == mText.size ()) {
+                mText.append (QString::fromRawData (data, count));
+            }
+            else {
+                mText.replace (position, count, data, count);
+            }
+            data += count;
+            length -= count;
+            mTextEnd += count;
+        }
+    }
+
+} // namespace conan
@@ -0,0 +1,178 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains SignalEventStore related declarations
+*/
+
+
+#ifndef _SIGNALEVENTSTORE__17_10_26__23_51_12__H_
+#define _SIGNALEVENTSTORE__17_10_26__23_51_12__H_
+
+
+#include "ConanDefines.h"
+#include "SignalLogSink.h"
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+
+namespace conan {
+
+    /*!
+        \brief Selects the events of a SignalEventStore.
+
+        The signal field matches the signature, the object field matches the qualified object
+        name or the address, and the thread field matches the thread name. A field matches case
+        insensitively anywhere within the text, unless it contains the wildcards * or ?, in which
+        case the complete text must match. Empty fields match all events.
+
+        The time range is given in ns since the session start, a negative bound is open.
+    */
+    struct CONAN_LOCAL SignalEventFilter {
+        SignalEventFilter ();
+
+        bool IsEmpty () const;
+
+        QString mSignal;        //!< Matches the signature
+        QString mObject;        //!< Matches the qualified object name or address
+        QString mThread;        //!< Matches the thread name
+        qint64 mFrom;           //!< The first time in ns since the session start, or -1
+        qint64 mTo;             //!< The last time in ns since the session start, or -1
+    };
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Keeps the most recent signal emissions in memory, in a column per field.
+
+        Each field of an event is stored in its own array: the timestamp, spy id, emit count,
+        thread and the start of its arguments. The object, address and signature are stored
+        once per spy, and each thread name once per thread. The formatted arguments of all
+        events are appended to a single text buffer, the arguments of an event end where the
+        arguments of the next event start. Both the columns and the text buffer are rings of a
+        fixed capacity: they grow until they are full, after which the oldest events and the
+        oldest arguments are overwritten. An event therefore takes about 40 bytes plus its
+        arguments, and the memory used by the store is bounded by its capacities.
+
+        Events are numbered in the order in which they are written, numbers are never reused,
+        not even by Clear. Events from First up to End are available.
+
+        The events of each spy and of each thread are indexed by an ascending list of event
+        numbers. Find matches the signal, object and thread fields of a filter once per spy and
+        once per thread, and only visits the events of the matching spies or threads.
+
+        The store is a SignalLogSink, so it is written by the thread of the SignalLogger. It
+        must be read by that thread as well.
+    */
+    class CONAN_LOCAL SignalEventStore : public SignalLogSink {
+    public:
+        static const int kDefaultCapacity = 2 * 1024 * 1024;        //!< The default number of events kept
+        static const int kDefaultTextCapacity = 16 * 1024 * 1024;   //!< The default number of argument characters kept
+        static const int kMaxArgumentsLength = 1024;                //!< The number of characters after which arguments are truncated
+        static const int kMaxThreadCount = 0xffff;                  //!< The number of distinct thread names, later threads share the last name
+
+        SignalEventStore (int inCapacity = kDefaultCapacity, int inTextCapacity = kDefaultTextCapacity);
+
+        virtual void WriteSessionStart (const QDateTime& inWallClock, qint64 inTimestamp);
+        virtual void Write (const SignalLogEntry& inEntry);
+
+        void Clear ();
+        int Capacity () const;
+        qint64 First () const;
+        qint64 End () const;
+        qint64 SessionStart () const;
+
+        bool Contains (qint64 inEvent) const;
+        qint64 Time (qint64 inEvent) const;
+        unsigned EmitCount (qint64 inEvent) const;
+        QString Thread (qint64 inEvent) const;
+        QString Object (qint64 inEvent) const;
+        QString Address (qint64 inEvent) const;
+        QString Signature (qint64 inEvent) const;
+        QString Arguments (qint64 inEvent) const;
+
+        QVector <qint64> Find (const SignalEventFilter& inFilter, qint64 inFrom) const;
+
+    private:
+        /*!
+            \brief An ascending list of event numbers, from which the oldest numbers are removed.
+        */
+        struct CONAN_LOCAL Postings {
+            Postings ();
+
+            void Append (qint64 inEvent);
+            void RemoveFirst ();
+            int Count (qint64 inFrom) const;
+            void CopyTo (qint64 inFrom, QVector <qint64>& ioEvents) const;
+
+            QVector <qint64> mEvents;   //!< The event numbers, starting at mHead
+            int mHead;                  //!< The index of the first event number in mEvents
+        };
+
+        /*!
+            \brief The constant fields of the events of a single spy.
+        */
+        struct CONAN_LOCAL Spy {
+            QString mObject;            //!< The qualified object name, null until the first event
+            QString mAddress;           //!< The address of the object
+            QString mSignature;         //!< The signal signature
+            Postings mEvents;           //!< The events of the spy
+        };
+
+        /*!
+            \brief A distinct emitting thread.
+        */
+        struct CONAN_LOCAL ThreadInfo {
+            QString mName;              //!< The name of the thread, see ObjectUtility::ThreadName
+            Postings mEvents;           //!< The events emitted by the thread
+        };
+
+        int Slot (qint64 inEvent) const;
+        int ThreadId (const QString& inName);
+        void RemoveFirst ();
+        void AppendText (const QString& inText);
+
+        const int mCapacity;                    //!< The maximum number of events
+        const int mTextCapacity;                //!< The maximum number of argument characters
+        qint64 mSessionStart;                   //!< The monotonic timestamp of the session start, see Clock::Now
+        qint64 mFirst;                          //!< The number of the oldest available event
+        qint64 mEnd;                            //!< The number of the next event
+        qint64 mTextEnd;                        //!< The number of argument characters ever written
+
+        QVector <qint64> mTimestamps;           //!< The timestamp of each event, see Clock::Now
+        QVector <int> mSpyIds;                  //!< The spy id of each event, an index in mSpies
+        QVector <unsigned> mEmitCounts;         //!< The emit count of each event
+        QVector <quint16> mThreadIds;           //!< The thread of each event, an index in mThreads
+        QVector <qint64> mArgumentStarts;       //!< The position in the argument text at which the arguments of each event start, counted like mTextEnd
+        QString mText;                          //!< The arguments of all events, a ring of mTextCapacity characters
+
+        QVector <Spy> mSpies;                   //!< All spies, indexed by spy id
+        QVector <ThreadInfo> mThreads;          //!< All threads, indexed by thread id
+        QHash <QString, int> mThreadIndex;      //!< map <thread name, thread id>
+    };
+
+} // namespace conan
+
+
+#endif //_SIGNALEVENTSTORE__17_10_26__23_51_12__H_
@@ -0,0 +1,247 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains SignalLogFormat related definitions
+*/
+
+
+#include "SignalLogFormat.h"
+
+
+namespace conan {
+
+    namespace /*unnamed*/ {
+
+        const char* sFieldNames [SignalLogFormat::kFieldCount] = {
+            "timestamp", "object", "address", "signature", "emitcount", "arguments"
+        };
+
+    } // unnamed namespace
+
+
+    /*!
+        \brief Creates an empty format.
+    */
+    SignalLogFormat::SignalLogFormat () {
+        Clear ();
+    }
+
+    /*!
+        \brief Removes all fields.
+    */
+    void SignalLogFormat::Clear () {
+        mFields.clear ();
+        mPadding.clear ();
+        for (int f=0; f<kFieldCount; ++f) {
+            mUsedFields [f] = false;
+        }
+    }
+
+    /*!
+        \brief Appends a field, preceded by the given prefix.
+
+        An optional field is skipped together with its prefix when its value is empty.
+    */
+    void SignalLogFormat::AddField (int inField, const QString& inPrefix, int inWidth, bool inOptional) {
+        Q_ASSERT (inField >= 0 && inField <= kNoField);
+        Field field;
+        field.mField = inField;
+        field.mPrefix = inPrefix;
+        field.mWidth = qMax (0, inWidth);
+        field.mOptional = inOptional;
+        mFields.push_back (field);
+        if (inField != kNoField) {
+            mUsedFields [inField] = true;
+        }
+        if (field.mWidth > mPadding.size ()) {
+            mPadding.fill (' ', field.mWidth);
+        }
+    }
+
+    /*!
+        \brief Appends constant text.
+    */
+    void SignalLogFormat::AddText (const QString& inText) {
+        if (!inText.isEmpty ()) {
+            AddField (kNoField, inText);
+        }
+    }
+
+    /*!
+        \brief Replaces all fields by those of the given template, see SignalLogFormat for the syntax.
+
+        Returns false when the template is invalid, in which case the format is empty and the
+        reason is stored in outError.
+    */
+    bool SignalLogFormat::Parse (const QString& inTemplate, QString* outError) {
+        Clear ();
+        QString text;
+        int pos = 0;
+        while (pos < inTemplate.size ()) {
+            QChar c = inTemplate [pos];
+            if ((c == '{' || c == '}') && pos + 1 < inTemplate.size () && inTemplate [pos + 1] == c) {
+                text.append (c);
+                pos += 2;
+                continue;
+            }
+            if (c == '}') {
+                if (outError) {
+                    *outError = QString ("unmatched } at position %1").arg (pos + 1);
+                }
+                Clear ();
+                return false;
+            }
+            if (c != '{') {
+                text.append (c);
+                ++pos;
+                continue;
+            }
+
+            int end = inTemplate.indexOf ('}', pos);
+            if (end < 0) {
+                if (outError) {
+                    *outError = QString ("unmatched { at position %1").arg (pos + 1);
+                }
+                Clear ();
+                return false;
+            }
+            QString spec = inTemplate.mid (pos + 1, end - pos - 1);
+            QString name = spec.section (':', 0, 0).trimmed ().toLower ();
+            int width = kDynamicWidth;
+            bool isValid = true;
+            if (spec.contains (':')) {
+                width = spec.section (':', 1).trimmed ().toInt (&isValid);
+                isValid = isValid && width >= 0;
+            }
+            int field = kNoField;
+            for (int f=0; f<kFieldCount; ++f) {
+                if (name == sFieldNames [f]) {
+                    field = f;
+                    break;
+                }
+            }
+            if (field == kNoField || !isValid) {
+                if (outError) {
+                    *outError = QString ("invalid field {%1}").arg (spec);
+                }
+                Clear ();
+                return false;
+            }
+            AddField (field, text, width);
+            text.clear ();
+            pos = end + 1;
+        }
+        AddText (text);
+        return true;
+    }
+
+    /*!
+        \brief Returns true when the format has no fields.
+    */
+    bool SignalLogFormat::IsEmpty () const {
+        return mFields.isEmpty ();
+    }
+
+    /*!
+        \brief Returns true when the given field is part of the format, so its value must be provided.
+    */
+    bool SignalLogFormat::UsesField (int inField) const {
+        return inField >= 0 && inField < kFieldCount && mUsedFields [inField];
+    }
+
+    /*!
+        \brief Formats a log message into the given buffer, replacing its contents.
+
+        inValues contains the value of each used field, except kEmitCount which is formatted
+        from inEmitCount. The capacity of the buffer is kept, so formatting into the same
+        buffer does not allocate once it is large enough.
+    */
+    void SignalLogFormat::Format (const QString* const inValues [kFieldCount], unsigned inEmitCount, QString& outMessage) const {
+        outMessage.resize (0);
+        for (int f=0; f<mFields.size (); ++f) {
+            const Field& field = mFields [f];
+            if (field.mField == kNoField) {
+                outMessage.append (field.mPrefix);
+            }
+            else if (field.mField == kEmitCount) {
+                outMessage.append (field.mPrefix);
+                int maxDigits = field.mWidth != kDynamicWidth ? field.mWidth : 20;
+                int length = AppendNumber (inEmitCount, 1, outMessage, maxDigits);
+                if (field.mWidth > length) {
+                    outMessage.append (QStringRef (&mPadding, 0, field.mWidth - length));
+                }
+            }
+            else {
+                const QString& value = *inValues [field.mField];
+                if (field.mOptional && value.isEmpty ()) {
+                    continue;
+                }
+                outMessage.append (field.mPrefix);
+                AppendField (field, value, outMessage);
+            }
+        }
+    }
+
+    /*!
+        \brief Appends the decimal digits of the given value without allocating, and returns the number of digits appended.
+
+        The value is padded with leading zeros to at least inMinDigits digits. At most inMaxDigits
+        digits are appended, the least significant digits are truncated.
+    */
+    int SignalLogFormat::AppendNumber (quint64 inValue, int inMinDigits, QString& outText, int inMaxDigits) {
+        char digits [24];
+        char* begin = digits + sizeof (digits) - 1;
+        *begin = '\0';
+        do {
+            *--begin = char ('0' + inValue % 10);
+            inValue /= 10;
+        } while (inValue);
+        while (begin > digits && digits + sizeof (digits) - 1 - begin < inMinDigits) {
+            *--begin = '0';
+        }
+        int length = static_cast <int> (digits + sizeof (digits) - 1 - begin);
+        if (length > inMaxDigits) {
+            length = qMax (0, inMaxDigits);
+            begin [length] = '\0';
+        }
+        outText.append (QLatin1String (begin));
+        return length;
+    }
+
+    /*!
+        \brief Appends the given value, padded or truncated to the width of the field.
+    */
+    void SignalLogFormat::AppendField (const Field& inField, const QString& inValue, QString& outMessage) const {
+        if (inField.mWidth == kDynamicWidth) {
+            outMessage.append (inValue);
+        }
+        else if (inValue.size () >= inField.mWidth) {
+            outMessage.append (QStringRef (&inValue, 0, inField.mWidth));
+        }
+        else {
+            outMessage.append (inValue);
+            outMessage.append (QStringRef (&mPadding, 0, inField.mWidth - inValue.size ()));
+        }
+    }
+
+} // namespace conan
@@ -0,0 +1,103 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains SignalLogFormat related declarations
+*/
+
+
+#ifndef _SIGNALLOGFORMAT__17_10_26__13_20_37__H_
+#define _SIGNALLOGFORMAT__17_10_26__13_20_37__H_
+
+
+#include "ConanDefines.h"
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+
+namespace conan {
+
+    /*!
+        \brief A compiled signal spy log format.
+
+        A format is a list of fields, each preceded by a constant prefix, f.e. a separator. The
+        format is compiled once, whenever the log options change, so formatting a log message
+        only appends strings to a reusable buffer: it does not test options, build separators
+        or allocate padding.
+
+        A format can also be parsed from a template, in which each field is written as {name}
+        or {name:width}, f.e: "{timestamp} {object:30} #{emitcount:4} {arguments}". Valid names
+        are timestamp, object, address, signature, emitcount and arguments. A width pads or
+        truncates the field to a fixed number of characters. Use {{ and }} for literal braces.
+    */
+    class CONAN_LOCAL SignalLogFormat {
+    public:
+        typedef enum FIELDS {
+            kTimestamp,
+            kObject,
+            kAddress,
+            kSignature,
+            kEmitCount,
+            kArguments,
+            kFieldCount,
+            kNoField = kFieldCount
+        } Fields;
+
+        static const int kDynamicWidth = 0;     //!< Indicates a dynamic field width
+
+    public:
+        SignalLogFormat ();
+
+        void Clear ();
+        void AddField (int inField, const QString& inPrefix, int inWidth = kDynamicWidth, bool inOptional = false);
+        void AddText (const QString& inText);
+        bool Parse (const QString& inTemplate, QString* outError = 0);
+
+        bool IsEmpty () const;
+        bool UsesField (int inField) const;
+
+        void Format (const QString* const inValues [kFieldCount], unsigned inEmitCount, QString& outMessage) const;
+
+        static int AppendNumber (quint64 inValue, int inMinDigits, QString& outText, int inMaxDigits = 20);
+
+    private:
+        /*!
+            \brief A single field of the format.
+        */
+        struct CONAN_LOCAL Field {
+            int mField;         //!< One of Fields, kNoField only appends the prefix
+            QString mPrefix;    //!< The text that precedes the field
+            int mWidth;         //!< The fixed width of the field, or kDynamicWidth
+            bool mOptional;     //!< When true, an empty field is skipped together with its prefix
+        };
+
+        void AppendField (const Field& inField, const QString& inValue, QString& outMessage) const;
+
+        QVector <Field> mFields;            //!< The fields in output order
+        QString mPadding;                   //!< Spaces, at least as many as the largest fixed width
+        bool mUsedFields [kFieldCount];     //!< Indicates which fields are used by the format
+    };
+
+} // namespace conan
+
+
+#endif //_SIGNALLOGFORMAT__17_10_26__13_20_37__H_
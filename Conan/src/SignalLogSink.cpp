@@ -0,0 +1,352 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains SignalLogSink related definitions
+*/
+
+
+#include "Clock.h"
+#include "ConnectionModel.h"
+#include "SignalLogSink.h"
+#include <QtCore/QDateTime>
+#include <QtCore/QtDebug>
+
+
+namespace conan {
+
+    SignalLogSink::~SignalLogSink ()
+    {}
+
+    /*!
+        \brief Writes the wall clock time at the given monotonic timestamp, see Clock::Now.
+
+        The logger calls this once, before any emission is written, so that timestamps can be
+        correlated with other logs. By default a message is written with spy id -1.
+    */
+    void SignalLogSink::WriteSessionStart (const QDateTime& inWallClock, qint64 inTimestamp) {
+        SignalLogEntry entry;
+        entry.mSpyId = -1;
+        entry.mSignalData = 0;
+        entry.mEmitCount = 0;
+        entry.mThread = 0;
+        entry.mTimestamp = inTimestamp;
+        entry.mMessage = QString ("Session started at %1.%2, monotonic clock %3 ns")
+            .arg (inWallClock.toString (Qt::ISODate).replace ('T', ' '))
+            .arg (inWallClock.time ().msec (), 3, 10, QChar ('0'))
+            .arg (inTimestamp);
+        Write (entry);
+    }
+
+    /*!
+        \brief Writes all buffered output, does nothing by default.
+    */
+    void SignalLogSink::Flush ()
+    {}
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Writes the log message using qDebug.
+    */
+    void DebugLogSink::Write (const SignalLogEntry& inEntry) {
+        qDebug () << inEntry.mMessage;
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Creates a sink for the given file, call Open before use.
+    */
+    TextFileLogSink::TextFileLogSink (const QString& inFileName, qint64 inMaxFileSize, int inMaxOldFiles) :
+        mFile (inFileName),
+        mMaxFileSize (inMaxFileSize),
+        mMaxOldFiles (inMaxOldFiles),
+        mFileSize (0)
+    {
+        mBuffer.reserve (kBufferSize);
+    }
+
+    TextFileLogSink::~TextFileLogSink () {
+        Flush ();
+    }
+
+    /*!
+        \brief Opens the file for appending, returns false when the file could not be opened.
+    */
+    bool TextFileLogSink::Open () {
+        // binary mode, so the buffered size equals the number of bytes written on windows as well
+        if (!mFile.open (QIODevice::WriteOnly | QIODevice::Append)) {
+            return false;
+        }
+        mFileSize = mFile.size ();
+        return true;
+    }
+
+    /*!
+        \brief Returns a description of the last file error.
+    */
+    QString TextFileLogSink::ErrorString () const {
+        return mFile.errorString ();
+    }
+
+    /*!
+        \brief Appends the log message to the buffer, the buffer is written when it is full.
+    */
+    void TextFileLogSink::Write (const SignalLogEntry& inEntry) {
+        QByteArray line = inEntry.mMessage.toUtf8 ();
+        line.append ('\n');
+        if (mMaxOldFiles > 0 && mFileSize + line.size () > mMaxFileSize && mFileSize > 0) {
+            Rotate ();
+        }
+        mBuffer.append (line);
+        mFileSize += line.size ();
+        if (mBuffer.size () >= kBufferSize) {
+            Flush ();
+        }
+    }
+
+    /*!
+        \brief Writes the buffer to the file.
+    */
+    void TextFileLogSink::Flush () {
+        if (mBuffer.isEmpty ()) {
+            return;
+        }
+        if (mFile.isOpen ()) {
+            mFile.write (mBuffer);
+            mFile.flush ();
+        }
+        // a qt 4 QByteArray releases its memory when it is resized to 0, so the next block is reserved up front
+        mBuffer.resize (0);
+        mBuffer.reserve (kBufferSize);
+    }
+
+    /*!
+        \brief Renames the current file and all kept old files, and starts a new file.
+    */
+    void TextFileLogSink::Rotate () {
+        if (!mFile.isOpen ()) {
+            return;
+        }
+        Flush ();
+        mFile.close ();
+
+        QString fileName = mFile.fileName ();
+        QFile::remove (QString ("%1.%2").arg (fileName).arg (mMaxOldFiles));
+        for (int i=mMaxOldFiles-1; i>0; --i) {
+            QFile::rename (QString ("%1.%2").arg (fileName).arg (i), QString ("%1.%2").arg (fileName).arg (i+1));
+        }
+        QFile::rename (fileName, fileName + ".1");
+
+        mFile.open (QIODevice::WriteOnly | QIODevice::Truncate);
+        mFileSize = 0;
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Creates a sink that keeps the given number of most recent messages.
+    */
+    MemoryLogSink::MemoryLogSink (int inCapacity) :
+        mMessages (qMax (1, inCapacity))
+    {}
+
+    /*!
+        \brief Stores the log message, the oldest message is discarded when the sink is full.
+    */
+    void MemoryLogSink::Write (const SignalLogEntry& inEntry) {
+        mMessages.append (inEntry.mMessage);
+    }
+
+    /*!
+        \brief Returns all stored messages, the oldest first.
+    */
+    QStringList MemoryLogSink::Messages () const {
+        QStringList messages;
+        for (int i=mMessages.firstIndex (); i<=mMessages.lastIndex (); ++i) {
+            messages.push_back (mMessages.at (i));
+        }
+        return messages;
+    }
+
+    /*!
+        \brief Discards all stored messages.
+    */
+    void MemoryLogSink::Clear () {
+        mMessages.clear ();
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Creates a sink for the given file, call Open before use.
+    */
+    BinaryTraceLogSink::BinaryTraceLogSink (const QString& inFileName) :
+        mFile (inFileName),
+        mPreviousTimestamp (0)
+    {
+        mBuffer.reserve (kBufferSize);
+    }
+
+    BinaryTraceLogSink::~BinaryTraceLogSink () {
+        Flush ();
+    }
+
+    /*!
+        \brief Creates the file and writes the header, returns false when the file could not be created.
+    */
+    bool BinaryTraceLogSink::Open () {
+        if (!mFile.open (QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+        QDateTime now = QDateTime::currentDateTime ();
+        mPreviousTimestamp = Clock::Now ();
+        qint64 header [2] = { now.toTime_t () * Q_INT64_C (1000) + now.time ().msec (), mPreviousTimestamp };
+
+        mBuffer.append ("CONANTRC", 8);
+        mBuffer.append (char (1));
+        for (int h=0; h<2; ++h) {
+            for (int b=0; b<8; ++b) {
+                mBuffer.append (char ((static_cast <quint64> (header [h]) >> (8 * b)) & 0xff));
+            }
+        }
+        return true;
+    }
+
+    /*!
+        \brief Returns a description of the last file error.
+    */
+    QString BinaryTraceLogSink::ErrorString () const {
+        return mFile.errorString ();
+    }
+
+    /*!
+        \brief Does nothing, the header of the trace already anchors its timestamps to the wall clock.
+    */
+    void BinaryTraceLogSink::WriteSessionStart (const QDateTime&, qint64)
+    {}
+
+    /*!
+        \brief Appends an emission record to the buffer, preceded by the strings and spy it refers to.
+    */
+    void BinaryTraceLogSink::Write (const SignalLogEntry& inEntry) {
+        if (!mSpies.contains (inEntry.mSpyId)) {
+            int object = StringId (inEntry.mSignalData->QualifiedName ());
+            int address = StringId (inEntry.mSignalData->Address ());
+            int signature = StringId (inEntry.mSignalData->Signature ());
+            mBuffer.append (char (kSpyRecord));
+            WriteVarInt (inEntry.mSpyId);
+            WriteVarInt (object);
+            WriteVarInt (address);
+            WriteVarInt (signature);
+            mSpies.insert (inEntry.mSpyId);
+        }
+
+        int arguments = -1;
+        if (inEntry.mArguments.size () <= kMaxInternedArgumentsLength &&
+            (mStrings.size () < kMaxStringCount || mStrings.contains (inEntry.mArguments))) {
+            arguments = StringId (inEntry.mArguments);
+        }
+        qint64 delta = inEntry.mTimestamp - mPreviousTimestamp;
+        mPreviousTimestamp = inEntry.mTimestamp;
+
+        mBuffer.append (char (kEmissionRecord));
+        WriteVarInt (inEntry.mSpyId);
+        WriteVarInt ((static_cast <quint64> (delta) << 1) ^ static_cast <quint64> (delta >> 63));
+        WriteVarInt (inEntry.mEmitCount);
+        if (arguments >= 0) {
+            WriteVarInt (arguments + 1);
+        }
+        else {
+            WriteVarInt (0);
+            WriteString (inEntry.mArguments);
+        }
+
+        if (mBuffer.size () >= kBufferSize) {
+            Flush ();
+        }
+    }
+
+    /*!
+        \brief Writes the buffer to the file.
+    */
+    void BinaryTraceLogSink::Flush () {
+        if (mBuffer.isEmpty ()) {
+            return;
+        }
+        if (mFile.isOpen ()) {
+            mFile.write (mBuffer);
+            mFile.flush ();
+        }
+        // a qt 4 QByteArray releases its memory when it is resized to 0, so the next block is reserved up front
+        mBuffer.resize (0);
+        mBuffer.reserve (kBufferSize);
+    }
+
+    /*!
+        \brief Appends an unsigned LEB128 integer to the buffer.
+    */
+    void BinaryTraceLogSink::WriteVarInt (quint64 inValue) {
+        do {
+            char byte = char (inValue & 0x7f);
+            inValue >>= 7;
+            if (inValue) {
+                byte |= char (0x80);
+            }
+            mBuffer.append (byte);
+        } while (inValue);
+    }
+
+    /*!
+        \brief Appends the UTF-8 length and bytes of the given string to the buffer.
+    */
+    void BinaryTraceLogSink::WriteString (const QString& inString) {
+        QByteArray utf8 = inString.toUtf8 ();
+        WriteVarInt (utf8.size ());
+        mBuffer.append (utf8);
+    }
+
+    /*!
+        \brief Returns the id of the given string, a string record is written when the string is new.
+    */
+    int BinaryTraceLogSink::StringId (const QString& inString) {
+        QHash <QString, int>::const_iterator it = mStrings.find (inString);
+        if (it != mStrings.end ()) {
+            return it.value ();
+        }
+        int id = mStrings.size ();
+        mStrings.insert (inString, id);
+        mBuffer.append (char (kStringRecord));
+        WriteString (inString);
+        return id;
+    }
+
+} // namespace conan
@@ -0,0 +1,216 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains SignalLogSink related declarations
+*/
+
+
+#ifndef _SIGNALLOGSINK__17_10_26__11_04_52__H_
+#define _SIGNALLOGSINK__17_10_26__11_04_52__H_
+
+
+#include "ConanDefines.h"
+#include <QtCore/QByteArray>
+#include <QtCore/QContiguousCache>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+
+class QDateTime;
+
+
+namespace conan {
+
+    struct MethodData;
+
+    /*!
+        \brief A single logged signal emission, as passed to each SignalLogSink.
+
+        Entries that are not signal emissions, such as the session start, have spy id -1 and no
+        signal data. The signal data and thread name are owned by the logger, a sink that keeps
+        them must copy them.
+    */
+    struct CONAN_LOCAL SignalLogEntry {
+        int mSpyId;                     //!< The id of the spy that logged the emission, unique within a SignalLogger, or -1
+        const MethodData* mSignalData;  //!< Information about the signal, or 0
+        unsigned mEmitCount;            //!< The emit count of the signal, including this emission
+        qint64 mTimestamp;              //!< The time of the emission, see Clock::Now
+        const QString* mThread;         //!< The name of the thread that emitted the signal, see ObjectUtility::ThreadName; or 0
+        QString mArguments;             //!< The formatted arguments, empty when arguments are not logged
+        QString mMessage;               //!< The formatted log message
+    };
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief The destination of signal spy logs.
+
+        The SignalLogger writes each log to all its sinks, from the thread of the logger. Sinks
+        are expected to buffer their output, the logger flushes all sinks periodically.
+    */
+    class CONAN_LOCAL SignalLogSink {
+    public:
+        virtual ~SignalLogSink ();
+
+        virtual void WriteSessionStart (const QDateTime& inWallClock, qint64 inTimestamp);
+        virtual void Write (const SignalLogEntry& inEntry) = 0;
+        virtual void Flush ();
+    };
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Writes each log message using qDebug.
+    */
+    class CONAN_LOCAL DebugLogSink : public SignalLogSink {
+    public:
+        virtual void Write (const SignalLogEntry& inEntry);
+    };
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Writes log messages to a UTF-8 text file, one message per line.
+
+        Messages are buffered in memory and written in blocks. When the file exceeds its maximum
+        size it is renamed to [file name].1, an existing [file name].1 is renamed to
+        [file name].2, and so on. At most the given number of old files is kept; when no old files
+        are kept the file is never rotated and grows without limit. Lines end with '\n' on all
+        platforms.
+    */
+    class CONAN_LOCAL TextFileLogSink : public SignalLogSink {
+    public:
+        static const int kBufferSize = 64 * 1024;               //!< The number of bytes buffered before writing
+
+        TextFileLogSink (const QString& inFileName, qint64 inMaxFileSize = 16 * 1024 * 1024, int inMaxOldFiles = 4);
+        virtual ~TextFileLogSink ();
+
+        bool Open ();
+        QString ErrorString () const;
+
+        virtual void Write (const SignalLogEntry& inEntry);
+        virtual void Flush ();
+
+    private:
+        void Rotate ();
+
+        QFile mFile;                //!< The current log file
+        qint64 mMaxFileSize;        //!< The size in bytes at which the file is rotated
+        int mMaxOldFiles;           //!< The number of rotated files that is kept
+        QByteArray mBuffer;         //!< The messages that have not been written yet
+        qint64 mFileSize;           //!< The size of the file, including mBuffer
+    };
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Keeps the most recent log messages in memory.
+    */
+    class CONAN_LOCAL MemoryLogSink : public SignalLogSink {
+    public:
+        static const int kDefaultCapacity = 100000;     //!< The default number of messages kept
+
+        MemoryLogSink (int inCapacity = kDefaultCapacity);
+
+        virtual void Write (const SignalLogEntry& inEntry);
+
+        QStringList Messages () const;
+        void Clear ();
+
+    private:
+        QContiguousCache <QString> mMessages;   //!< The most recent messages, the oldest are discarded
+    };
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Writes signal emissions to a compact binary trace file.
+
+        All integers are written as unsigned LEB128 variable length integers, signed integers
+        are zigzag encoded first. Strings are written as their UTF-8 length followed by the
+        UTF-8 bytes. The file starts with a header:
+        - the 8 bytes "CONANTRC", followed by the format version byte 1
+        - the wall clock time in ms since the epoch and the monotonic time in ns at which the
+          trace was opened, as little endian 64 bit integers
+
+        The header is followed by records, each starting with a record type byte:
+        - 1, string: a string, which receives the next id in the string table, starting at 0
+        - 2, spy: the spy id, followed by the string ids of the object, address and signature
+        - 3, emission: the spy id, the signed difference in ns with the timestamp of the previous
+          emission (or the header), the emit count, and the arguments: either 0 followed by a
+          string, or a string id plus one
+
+        Strings and spies are defined before their first use. Short argument strings are stored
+        in the string table, so recurring arguments are written only once.
+    */
+    class CONAN_LOCAL BinaryTraceLogSink : public SignalLogSink {
+    public:
+        static const int kBufferSize = 64 * 1024;               //!< The number of bytes buffered before writing
+        static const int kMaxInternedArgumentsLength = 32;      //!< The maximum length of arguments that are added to the string table
+        static const int kMaxStringCount = 65536;               //!< The string table size after which no more arguments are added
+
+        BinaryTraceLogSink (const QString& inFileName);
+        virtual ~BinaryTraceLogSink ();
+
+        bool Open ();
+        QString ErrorString () const;
+
+        virtual void WriteSessionStart (const QDateTime& inWallClock, qint64 inTimestamp);
+        virtual void Write (const SignalLogEntry& inEntry);
+        virtual void Flush ();
+
+    private:
+        typedef enum RECORDTYPES {
+            kStringRecord = 1,
+            kSpyRecord,
+            kEmissionRecord
+        } RecordTypes;
+
+        void WriteVarInt (quint64 inValue);
+        void WriteString (const QString& inString);
+        int StringId (const QString& inString);
+
+        QFile mFile;                        //!< The trace file
+        QByteArray mBuffer;                 //!< The records that have not been written yet
+        QHash <QString, int> mStrings;      //!< map <string, string id>
+        QSet <int> mSpies;                  //!< The ids of all spies that have been defined
+        qint64 mPreviousTimestamp;          //!< The timestamp of the previous emission
+    };
+
+} // namespace conan
+
+
+#endif //_SIGNALLOGSINK__17_10_26__11_04_52__H_
@@ -0,0 +1,229 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains SignalSampler related definitions
+*/
+
+
+#include "SignalSampler.h"
+#include <QtCore/QRegExp>
+#include <QtCore/QStringList>
+
+
+namespace conan {
+
+    SamplingPolicy::SamplingPolicy () :
+        mEveryNth (0),
+        mMaxPerSecond (0),
+        mBurstCount (0)
+    {}
+
+    /*!
+        \brief Parses the given text into a policy, see SamplingPolicy.
+
+        Returns an empty policy and sets \a outError when the text is invalid.
+    */
+    SamplingPolicy SamplingPolicy::Parse (const QString& inText, QString* outError) {
+        SamplingPolicy policy;
+        foreach (const QString& term, inText.split (QRegExp ("\\s+"), QString::SkipEmptyParts)) {
+            int colon = term.indexOf (':');
+            QString rule = term.left (colon).toLower ();
+            bool ok = false;
+            int value = term.mid (colon + 1).toInt (&ok);
+            if (colon < 0 || !ok || value < 0) {
+                if (outError) {
+                    *outError = QString ("Expected rule:count instead of '%1'").arg (term);
+                }
+                return SamplingPolicy ();
+            }
+            if (rule == "every") {
+                policy.mEveryNth = value;
+            }
+            else if (rule == "rate") {
+                policy.mMaxPerSecond = value;
+            }
+            else if (rule == "burst") {
+                policy.mBurstCount = value;
+            }
+            else {
+                if (outError) {
+                    *outError = QString ("Unknown rule '%1', expected every, rate or burst").arg (rule);
+                }
+                return SamplingPolicy ();
+            }
+        }
+        if (outError) {
+            outError->clear ();
+        }
+        return policy;
+    }
+
+    /*!
+        \brief Returns the policy in the format accepted by Parse.
+    */
+    QString SamplingPolicy::ToString () const {
+        QStringList terms;
+        if (mEveryNth > 1) {
+            terms.push_back (QString ("every:%1").arg (mEveryNth));
+        }
+        if (mMaxPerSecond > 0) {
+            terms.push_back (QString ("rate:%1").arg (mMaxPerSecond));
+        }
+        if (mBurstCount > 0) {
+            terms.push_back (QString ("burst:%1").arg (mBurstCount));
+        }
+        return terms.join (" ");
+    }
+
+    /*!
+        \brief Returns true when the policy logs all emissions.
+    */
+    bool SamplingPolicy::IsEmpty () const {
+        return mEveryNth <= 1 && mMaxPerSecond <= 0 && mBurstCount <= 0;
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    SignalSampler::SignalSampler () :
+        mActive (0),
+        mEveryNth (0),
+        mMaxPerSecond (0),
+        mBurstCount (0),
+        mSequence (0),
+        mWindowSecond (-1),
+        mWindowCount (0),
+        mBurstRemaining (0),
+        mSampledOut (0),
+        mRateLimited (0)
+    {}
+
+    /*!
+        \brief Replaces the policy, which restarts the every and rate rules and ends the current burst.
+    */
+    void SignalSampler::SetPolicy (const SamplingPolicy& inPolicy) {
+        mActive.fetchAndStoreOrdered (0);
+        mEveryNth.fetchAndStoreOrdered (inPolicy.mEveryNth);
+        mMaxPerSecond.fetchAndStoreOrdered (inPolicy.mMaxPerSecond);
+        mBurstCount.fetchAndStoreOrdered (inPolicy.mBurstCount);
+        mSequence.fetchAndStoreOrdered (0);
+        mWindowSecond.fetchAndStoreOrdered (-1);
+        mWindowCount.fetchAndStoreOrdered (0);
+        mBurstRemaining.fetchAndStoreOrdered (0);
+        mActive.fetchAndStoreOrdered (inPolicy.IsEmpty () ? 0 : 1);
+    }
+
+    /*!
+        \brief Clears the policy and the dropped emission counts, as if the sampler was created anew.
+    */
+    void SignalSampler::Reset () {
+        SetPolicy (SamplingPolicy ());
+        mSampledOut.fetchAndStoreOrdered (0);
+        mRateLimited.fetchAndStoreOrdered (0);
+    }
+
+    /*!
+        \brief Returns the current policy.
+    */
+    SamplingPolicy SignalSampler::Policy () const {
+        SamplingPolicy policy;
+        policy.mEveryNth = mEveryNth;
+        policy.mMaxPerSecond = mMaxPerSecond;
+        policy.mBurstCount = mBurstCount;
+        return policy;
+    }
+
+    /*!
+        \brief Returns true when the policy may drop emissions.
+    */
+    bool SignalSampler::IsActive () const {
+        return mActive != 0;
+    }
+
+    /*!
+        \brief Returns true when the emission at the given time should be logged.
+    */
+    bool SignalSampler::Sample (qint64 inTimestamp) {
+        if (mActive == 0) {
+            return true;
+        }
+
+        int everyNth = mEveryNth;
+        if (everyNth > 1 && static_cast <unsigned> (mSequence.fetchAndAddRelaxed (1)) % everyNth != 0) {
+            mSampledOut.ref ();
+            return false;
+        }
+
+        int maxPerSecond = mMaxPerSecond;
+        if (maxPerSecond > 0) {
+            int second = static_cast <int> (inTimestamp / 1000000000);
+            int windowSecond = mWindowSecond;
+            // timestamps of other threads may be slightly older, they count in the current window
+            if (second > windowSecond && mWindowSecond.testAndSetOrdered (windowSecond, second)) {
+                mWindowCount.fetchAndStoreOrdered (0);
+            }
+            if (mWindowCount.fetchAndAddRelaxed (1) >= maxPerSecond) {
+                mRateLimited.ref ();
+                return false;
+            }
+        }
+
+        if (mBurstCount > 0) {
+            for (;;) {
+                int remaining = mBurstRemaining;
+                if (remaining <= 0) {
+                    mSampledOut.ref ();
+                    return false;
+                }
+                if (mBurstRemaining.testAndSetOrdered (remaining, remaining - 1)) {
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+    /*!
+        \brief Starts a burst: the next mBurstCount emissions that pass the other rules are logged.
+
+        Does nothing when the policy is not in burst mode.
+    */
+    void SignalSampler::Trigger () {
+        mBurstRemaining.fetchAndStoreOrdered (mBurstCount);
+    }
+
+    /*!
+        \brief Returns the number of emissions dropped by the every and burst rules.
+    */
+    int SignalSampler::SampledOutCount () const {
+        return mSampledOut;
+    }
+
+    /*!
+        \brief Returns the number of emissions dropped by the rate rule.
+    */
+    int SignalSampler::RateLimitedCount () const {
+        return mRateLimited;
+    }
+
+} // namespace conan
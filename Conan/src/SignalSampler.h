@@ -0,0 +1,111 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*!
+    \file
+    \brief Contains SignalSampler related declarations
+*/
+
+
+#ifndef _SIGNALSAMPLER__17_10_26__21_12_40__H_
+#define _SIGNALSAMPLER__17_10_26__21_12_40__H_
+
+
+#include "ConanDefines.h"
+#include <QtCore/QAtomicInt>
+#include <QtCore/QString>
+
+
+namespace conan {
+
+    /*!
+        \brief Selects the signal emissions that are logged by a SignalSampler.
+
+        A policy consists of terms separated by white space, each of the form rule:value:
+        - every:n, only every n-th emission is logged
+        - rate:k, at most k emissions are logged per second
+        - burst:m, only the first m emissions after each trigger are logged
+
+        An empty policy logs all emissions, f.e: every:10 rate:100
+    */
+    class CONAN_LOCAL SamplingPolicy {
+    public:
+        SamplingPolicy ();
+
+        static SamplingPolicy Parse (const QString& inText, QString* outError = 0);
+        QString ToString () const;
+        bool IsEmpty () const;
+
+        int mEveryNth;          //!< Only every n-th emission is logged, 0 or 1 logs every emission
+        int mMaxPerSecond;      //!< The maximum number of emissions logged per second, 0 when unlimited
+        int mBurstCount;        //!< The number of emissions logged after each trigger, 0 when not in burst mode
+    };
+
+
+    // --------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Decides which emissions of a signal are logged, according to a SamplingPolicy.
+
+        Sample is called by the emitting thread before any argument is converted, so dropped
+        emissions cost a few atomic operations only. The rules are applied in order: every,
+        rate, burst. Rate limiting counts emissions per second of the monotonic clock, see
+        Clock::Now; when threads race at the start of a second the limit is approximate.
+
+        Emissions dropped by the every and burst rules are counted as sampled out, emissions
+        dropped by the rate rule as rate limited. All members are atomic, so the policy can be
+        changed and bursts can be triggered from any thread.
+    */
+    class CONAN_LOCAL SignalSampler {
+    public:
+        SignalSampler ();
+
+        void SetPolicy (const SamplingPolicy& inPolicy);
+        SamplingPolicy Policy () const;
+        void Reset ();
+        bool IsActive () const;
+
+        bool Sample (qint64 inTimestamp);
+        void Trigger ();
+
+        int SampledOutCount () const;
+        int RateLimitedCount () const;
+
+    private:
+        SignalSampler (const SignalSampler&);
+        SignalSampler& operator= (const SignalSampler&);
+
+        QAtomicInt mActive;             //!< Non zero when the policy is not empty
+        QAtomicInt mEveryNth;           //!< See SamplingPolicy::mEveryNth
+        QAtomicInt mMaxPerSecond;       //!< See SamplingPolicy::mMaxPerSecond
+        QAtomicInt mBurstCount;         //!< See SamplingPolicy::mBurstCount
+        QAtomicInt mSequence;           //!< The number of emissions seen by the every rule
+        QAtomicInt mWindowSecond;       //!< The second of the monotonic clock counted by mWindowCount
+        QAtomicInt mWindowCount;        //!< The number of emissions seen by the rate rule within mWindowSecond
+        QAtomicInt mBurstRemaining;     //!< The number of emissions that remain to be logged in the current burst
+        QAtomicInt mSampledOut;         //!< The number of emissions dropped by the every and burst rules
+        QAtomicInt mRateLimited;        //!< The number of emissions dropped by the rate rule
+    };
+
+} // namespace conan
+
+
+#endif //_SIGNALSAMPLER__17_10_26__21_12_40__H_
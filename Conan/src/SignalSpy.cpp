@@ -24,6 +24,7 @@
 */
 
 
+#include "Clock.h"
 #include "ObjectUtility.h"
 #include "SignalSpy.h"
 #include <QtCore/QByteArray>
@@ -31,7 +32,10 @@
 #include <QtCore/QList>
 #include <QtCore/QMetaMethod>
 #include <QtCore/QMetaObject>
+#include <QtCore/QMutexLocker>
 #include <QtCore/QScopedPointer>
+#include <QtCore/QThread>
+#include <QtCore/QtAlgorithms>
 #include <QtCore/QtDebug>
 #include <QtCore/QVariant>
 #include <QtGui/QHeaderView>
@@ -43,134 +47,575 @@ namespace conan {
     namespace /*unnamed*/ {
 
         /*!
-            \brief Returns true when the given signal is monitored by the given spy.
+            \brief Formats the given signal arguments into the given buffer: {arg1, arg2, ...}
+
+            Each argument is formatted by the given formatter of its type, see ArgumentFormatter.
+            The type name is used for missing arguments.
+        */
+        void FormatArguments (const QVector <int>& inArgTypes, const QVector <ArgumentFormatter::Function>& inFormatters, void** inArgs, QString& outArgString) {
+            QString& argString = outArgString;
+            argString.resize (0);
+            int argCount = inArgTypes.count ();
+            if (argCount) {
+                argString.append (QLatin1Char ('{'));
+                for (int i = 0; i < argCount; ++i) {
+                    int type = inArgTypes.at (i);
+                    if (inArgs [i]) {
+                        inFormatters.at (i) (type, inArgs [i], argString);
+                    }
+                    else {
+                        argString.append (QLatin1String (QMetaType::typeName (type)));
+                    }
+                    if (i != argCount - 1) {
+                        argString.append (QLatin1String (", "));
+                    }
+                }
+                argString.append (QLatin1Char ('}'));
+            }
+        }
+
+        /*!
+            \brief Looks up the formatter of each of the given argument types.
         */
-        bool SameSignal (const QObject* inObject, const QString& inSignal, const SignalSpy* inSpy) {
-            if (inSpy->SignalData ().mObject) {
-                return inSpy->SignalData ().mObject == inObject &&
-                       inSpy->SignalData ().mSignature == inSignal;
+        QVector <ArgumentFormatter::Function> FindFormatters (const QVector <int>& inArgTypes) {
+            QVector <ArgumentFormatter::Function> formatters;
+            formatters.reserve (inArgTypes.size ());
+            foreach (int type, inArgTypes) {
+                formatters.push_back (ArgumentFormatter::Find (type));
             }
-            QString address = ObjectUtility::Address (inObject);
-            QString className = ObjectUtility::Class (inObject);
-            QString objectName = ObjectUtility::Name (inObject);
+            return formatters;
+        }
+
+        /*!
+            \brief Orders spies by their emission rate over the last second and ten seconds, the busiest first.
+        */
+        struct RankKey {
+            double mRate1s;     //!< The emission rate over the last second
+            double mRate10s;    //!< The emission rate over the last ten seconds
+            int mRow;           //!< The row of the spy
+
+            bool operator< (const RankKey& inOther) const {
+                if (mRate1s != inOther.mRate1s) {
+                    return mRate1s > inOther.mRate1s;
+                }
+                if (mRate10s != inOther.mRate10s) {
+                    return mRate10s > inOther.mRate10s;
+                }
+                return mRow < inOther.mRow;
+            }
+        };
+    }
+
+    SignalSpy::Slot::Slot () :
+        mLoggerId (-1),
+        mEmitCount (0),
+        mAttached (false),
+        mCondition (0),
+        mMatchCount (0),
+        mTriggeredActions (0)
+    {}
+
+    /*!
+        \brief Clears all data of the slot, a slot is not copyable because of its sampler.
+    */
+    void SignalSpy::Slot::Reset () {
+        mLoggerId = -1;
+        mEmitCount.fetchAndStoreOrdered (0);
+        mRate = EmissionRate ();
+        mArgTypes.clear ();
+        mSignalData = MethodData ();
+        mAttached = false;
+        mSampler.Reset ();
+        mCondition.fetchAndStoreOrdered (0);
+        mMatchCount.fetchAndStoreOrdered (0);
+        mTriggeredActions.fetchAndStoreOrdered (0);
+    }
+
+    /*!
+        \brief Creates an empty buffer, all samples are allocated up front.
+    */
+    SignalSpy::RateBuffer::RateBuffer () :
+        mSamples (new RateSample [kRateBufferCapacity]),
+        mPushed (0),
+        mPopped (0),
+        mDropped (0),
+        mOrphaned (0)
+    {}
+
+    /*!
+        \brief Adds a single emission, may only be called by the producer. Returns false when the buffer is full.
+    */
+    bool SignalSpy::RateBuffer::Push (int inSlot, qint64 inTimestamp) {
+        unsigned pushed = static_cast <unsigned> (int (mPushed));
+        unsigned popped = static_cast <unsigned> (mPopped.fetchAndAddAcquire (0));
+        if (pushed - popped >= static_cast <unsigned> (kRateBufferCapacity)) {
+            mDropped.ref ();
+            return false;
+        }
+        RateSample& sample = mSamples [pushed & (kRateBufferCapacity - 1)];
+        sample.mSlot = inSlot;
+        sample.mTimestamp = inTimestamp;
+        // publish the sample
+        mPushed.fetchAndStoreRelease (static_cast <int> (pushed + 1));
+        return true;
+    }
+
+    /*!
+        \brief Returns the oldest sample, or 0 when the buffer is empty. May only be called by the consumer.
+    */
+    const SignalSpy::RateSample* SignalSpy::RateBuffer::Front () const {
+        return Count () ? &mSamples [static_cast <unsigned> (int (mPopped)) & (kRateBufferCapacity - 1)] : 0;
+    }
 
-            return inSpy->SignalData ().mSignature == inSignal &&
-                   inSpy->SignalData ().mAddress == address &&
-                   inSpy->SignalData ().mClass == className &&
-                   inSpy->SignalData ().mName == objectName;
+    /*!
+        \brief Releases the oldest sample, may only be called by the consumer.
+    */
+    void SignalSpy::RateBuffer::Pop () {
+        if (Count ()) {
+            mPopped.fetchAndStoreRelease (static_cast <int> (static_cast <unsigned> (int (mPopped)) + 1));
         }
     }
 
     /*!
-        \brief Creates a SignalSpy that outputs emissions of the given signal (normalized signature).
+        \brief Returns the number of samples that have been pushed but not popped yet.
+    */
+    int SignalSpy::RateBuffer::Count () const {
+        unsigned pushed = static_cast <unsigned> (const_cast <QAtomicInt&> (mPushed).fetchAndAddAcquire (0));
+        unsigned popped = static_cast <unsigned> (int (mPopped));
+        return static_cast <int> (pushed - popped);
+    }
 
-        All actual logging is delegated to the given logger.
+    SignalSpy::ThreadRates::ThreadRates (const RateBufferPtr& inBuffer) :
+        mBuffer (inBuffer)
+    {}
+
+    /*!
+        \brief Called when the thread finishes, the spy removes the buffer once it has been drained.
     */
-    SignalSpy::SignalSpy (const QObject* inObject, const QString& inSignal, SignalLogger* inLogger) :
+    SignalSpy::ThreadRates::~ThreadRates () {
+        mBuffer->mOrphaned.fetchAndStoreRelease (1);
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Creates a SignalSpy without slots, all actual logging is delegated to the given logger.
+    */
+    SignalSpy::SignalSpy (SignalLogger* inLogger, QObject* inTriggerReceiver) :
         mLogger (inLogger),
-        mEmitCount (0)
+        mTriggerReceiver (inTriggerReceiver),
+        mSlotCount (0),
+        mDroppedRates (0)
     {
+        Q_ASSERT (inLogger);
+        for (int c=0; c<kMaxChunkCount; ++c) {
+            mChunks [c] = 0;
+        }
+    }
+
+    /*!
+        \brief Disconnects all slots.
+    */
+    SignalSpy::~SignalSpy () {
+        DetachAll ();
+        for (int c=0; c<kMaxChunkCount && mChunks [c]; ++c) {
+            delete [] mChunks [c];
+        }
+        qDeleteAll (mConditions);
+    }
+
+    /*!
+        \brief Called whenever a signal emission occurs, the method id is the slot of the signal.
+    */
+    int SignalSpy::qt_metacall (QMetaObject::Call inCall, int inMethodId, void **inArgs) {
+        inMethodId = QObject::qt_metacall (inCall, inMethodId, inArgs);
+        if (inMethodId < 0) {
+            return inMethodId;
+        }
+        if (inCall == QMetaObject::InvokeMetaMethod && inMethodId < kChunkSize * kMaxChunkCount) {
+            ProcessArgs (inMethodId, inArgs);
+        }
+        return -1;
+    }
+
+    /*!
+        \brief Connects to the signal with the given method index, and returns the slot of the signal.
+
+        Returns the existing slot when the signal is already attached, or -1 when the method is
+        not a signal or cannot be connected.
+    */
+    int SignalSpy::Attach (const QObject* inObject, int inSignalIndex) {
         static const int sMemberOffset = QObject::staticMetaObject.methodCount ();
 
-        Q_ASSERT (inObject && inLogger);
+        Q_ASSERT (inObject);
 
         const QMetaObject* metaObject = inObject->metaObject ();
-        int sigIndex = metaObject->indexOfMethod (inSignal.toAscii ().data ());
-        if (sigIndex < 0) {
+        if (inSignalIndex < 0 || inSignalIndex >= metaObject->methodCount () ||
+            metaObject->method (inSignalIndex).methodType () != QMetaMethod::Signal) {
+            return -1;
+        }
+        int existing = FindSlot (inObject, inSignalIndex);
+        if (existing >= 0) {
+            return existing;
+        }
+        int chunk = mSlotCount / kChunkSize;
+        if (chunk >= kMaxChunkCount) {
+            qWarning ("SignalSpy: Unable to spy on more than %d signals.", kChunkSize * kMaxChunkCount);
+            return -1;
+        }
+        if (!mChunks [chunk]) {
+            mChunks [chunk] = new Slot [kChunkSize];
+        }
+
+        // initialize all data before connecting, the signal may be emitted by another thread right away
+        int slotIndex = mSlotCount;
+        Slot& slot = GetSlot (slotIndex);
+        slot.mSignalData = MethodData (mRecords.Object (inObject), mRecords.Method (metaObject, inSignalIndex));
+        slot.mArgTypes = ArgTypes (metaObject, inSignalIndex);
+        slot.mLoggerId = mLogger->RegisterSpy (slot.mSignalData, slot.mArgTypes);
+
+        if (!QMetaObject::connect (inObject, inSignalIndex, this, sMemberOffset + slotIndex, Qt::DirectConnection, 0)) {
+            qWarning ("SignalSpy: QMetaObject::connect returned false. Unable to connect.");
+            slot.Reset ();
+            return -1;
+        }
+        slot.mAttached = true;
+        mAttachedSlots.insert (SignalKey (inObject, inSignalIndex), slotIndex);
+        ++mSlotCount;
+        return slotIndex;
+    }
+
+    /*!
+        \brief Connects to the given signal (normalized signature), and returns the slot of the signal.
+    */
+    int SignalSpy::Attach (const QObject* inObject, const QString& inSignal) {
+        Q_ASSERT (inObject);
+        int signalIndex = inObject->metaObject ()->indexOfMethod (inSignal.toAscii ().data ());
+        if (signalIndex < 0) {
             qWarning ("SignalSpy: No such signal: '%s'", inSignal.toAscii ().data ());
+            return -1;
+        }
+        return Attach (inObject, signalIndex);
+    }
+
+    /*!
+        \brief Disconnects the given slot from its signal, the slot keeps its data but is never reused.
+    */
+    void SignalSpy::Detach (int inSlot) {
+        static const int sMemberOffset = QObject::staticMetaObject.methodCount ();
+
+        if (inSlot < 0 || inSlot >= mSlotCount) {
             return;
         }
-        if (!QMetaObject::connect (inObject, sigIndex, this, sMemberOffset, Qt::DirectConnection, 0)) {
-            qWarning ("SignalSpy: QMetaObject::connect returned false. Unable to connect.");
+        Slot& slot = GetSlot (inSlot);
+        if (!slot.mAttached) {
             return;
         }
+        if (QObject* object = slot.mSignalData.Object ()) {
+            QMetaObject::disconnect (object, slot.mSignalData.MethodIndex (), this, sMemberOffset + inSlot);
+        }
+        slot.mAttached = false;
+        mAttachedSlots.remove (SignalKey (slot.mSignalData.ObjectKey (), slot.mSignalData.MethodIndex ()));
+    }
 
-        QMetaMethod method = metaObject->method (sigIndex);
-        mSignalData.mAccess = method.access ();
-        mSignalData.mAddress = ObjectUtility::Address (inObject);
-        mSignalData.mObject = const_cast <QObject*> (inObject);
-        mSignalData.mName = ObjectUtility::Name (inObject);
-        mSignalData.mClass = ObjectUtility::Class (inObject);
-        mSignalData.mSignature = method.signature ();
-        mSignalData.mSuperClass = metaObject->className ();
-        mSignalData.mMethodType = method.methodType ();
+    /*!
+        \brief Disconnects all slots from their signals.
+    */
+    void SignalSpy::DetachAll () {
+        foreach (int slot, mAttachedSlots.values ()) {
+            Detach (slot);
+        }
+    }
 
-        InitArgs (metaObject->method (sigIndex));
+    /*!
+        \brief Returns the attached slot of the signal with the given method index, or -1.
+
+        A slot whose object has been destroyed is not returned for a new object at the same address.
+    */
+    int SignalSpy::FindSlot (const QObject* inObject, int inSignalIndex) const {
+        int slot = mAttachedSlots.value (SignalKey (inObject, inSignalIndex), -1);
+        if (slot >= 0 && GetSlot (slot).mSignalData.Object () != inObject) {
+            return -1;
+        }
+        return slot;
     }
 
     /*!
-        \brief Called whenever a signal emission occurs
+        \brief Returns the number of slots, including detached slots.
     */
-    int SignalSpy::qt_metacall (QMetaObject::Call inCall, int inMethodId, void **inArgs) {
-        inMethodId = QObject::qt_metacall (inCall, inMethodId, inArgs);
-        if (inMethodId < 0) {
-            return inMethodId;
+    int SignalSpy::SlotCount () const {
+        return mSlotCount;
+    }
+
+    /*!
+        \brief Returns the id of the given slot in the logger.
+    */
+    int SignalSpy::LoggerId (int inSlot) const {
+        return GetSlot (inSlot).mLoggerId;
+    }
+
+    /*!
+        \brief Returns information about the signal of the given slot.
+    */
+    const MethodData& SignalSpy::SignalData (int inSlot) const {
+        return GetSlot (inSlot).mSignalData;
+    }
+
+    /*!
+        \brief Returns the QMetaType types for the argument list of the signal of the given slot.
+    */
+    const QVector <int>& SignalSpy::SignalArgTypes (int inSlot) const {
+        return GetSlot (inSlot).mArgTypes;
+    }
+
+    /*!
+        \brief Returns the number of monitored emissions of the signal of the given slot.
+    */
+    int SignalSpy::EmitCount (int inSlot) const {
+        return GetSlot (inSlot).mEmitCount;
+    }
+
+    /*!
+        \brief Returns a copy of the rate statistics of the emissions of the signal of the given slot, up to the last DrainRates.
+    */
+    EmissionRate SignalSpy::Rate (int inSlot) const {
+        return GetSlot (inSlot).mRate;
+    }
+
+    /*!
+        \brief Adds the emissions in the rate buffers of all threads to the rate statistics of their slots, in timestamp order.
+
+        Only the emissions that were pushed before the call are added. Buffers of finished
+        threads are removed once they have been drained.
+    */
+    void SignalSpy::DrainRates () {
+        QList <RateBufferPtr> buffers;
+        {
+            QMutexLocker locker (&mRateBuffersMutex);
+            buffers = mRateBuffers;
+        }
+
+        // the orphaned state must be read before the counts, so no samples can follow
+        QVector <bool> orphaned (buffers.size ());
+        QVector <int> remaining (buffers.size ());
+        for (int b=0; b<buffers.size (); ++b) {
+            orphaned [b] = buffers [b]->mOrphaned.fetchAndAddAcquire (0) != 0;
+            remaining [b] = buffers [b]->Count ();
+            mDroppedRates += buffers [b]->mDropped.fetchAndStoreRelaxed (0);
         }
-        if (inCall == QMetaObject::InvokeMetaMethod) {
-            if (inMethodId == 0) {
-                ProcessArgs (inArgs);
+
+        // merge the buffers, each buffer is already in timestamp order
+        forever {
+            int next = -1;
+            for (int b=0; b<buffers.size (); ++b) {
+                if (remaining [b] && (next < 0 || buffers [b]->Front ()->mTimestamp < buffers [next]->Front ()->mTimestamp)) {
+                    next = b;
+                }
+            }
+            if (next < 0) {
+                break;
             }
-            --inMethodId;
+            RateBuffer& buffer = *buffers [next];
+            const RateSample* sample = buffer.Front ();
+            GetSlot (sample->mSlot).mRate.Add (sample->mTimestamp);
+            buffer.Pop ();
+            --remaining [next];
         }
-        return inMethodId;
+
+        QMutexLocker locker (&mRateBuffersMutex);
+        for (int b=0; b<buffers.size (); ++b) {
+            if (orphaned [b] && !buffers [b]->Count ()) {
+                mRateBuffers.removeAll (buffers [b]);
+            }
+        }
+    }
+
+    /*!
+        \brief Returns the number of emissions that were not counted in the rate statistics, because the rate buffer of their thread was full.
+    */
+    quint64 SignalSpy::DroppedRateCount () const {
+        return mDroppedRates;
     }
 
     /*!
-        \brief Stores the argument types for the signal being monitored
+        \brief Returns the sampler of the given slot, which may be used from any thread.
     */
-    void SignalSpy::InitArgs (const QMetaMethod& inMember) {
-        QList <QByteArray> params = inMember.parameterTypes ();
+    SignalSampler& SignalSpy::Sampler (int inSlot) const {
+        return GetSlot (inSlot).mSampler;
+    }
+
+    /*!
+        \brief Sets the condition of the given slot, an empty condition logs all emissions.
+
+        The condition must have been parsed against the argument types of the signal of the slot.
+    */
+    void SignalSpy::SetCondition (int inSlot, const SignalCondition& inCondition) {
+        SignalCondition* condition = 0;
+        if (!inCondition.IsEmpty ()) {
+            condition = new SignalCondition (inCondition);
+            mConditions.push_back (condition);
+        }
+        GetSlot (inSlot).mCondition.fetchAndStoreOrdered (condition);
+    }
+
+    /*!
+        \brief Returns the condition of the given slot, or 0 when all emissions are logged.
+    */
+    const SignalCondition* SignalSpy::Condition (int inSlot) const {
+        return GetSlot (inSlot).mCondition;
+    }
+
+    /*!
+        \brief Returns the number of emissions of the given slot that matched its condition.
+    */
+    int SignalSpy::MatchCount (int inSlot) const {
+        return GetSlot (inSlot).mMatchCount;
+    }
+
+    /*!
+        \brief Returns the actions that were triggered by the given slot since the previous call, see SignalCondition::Actions.
+    */
+    int SignalSpy::TakeTriggeredActions (int inSlot) {
+        return GetSlot (inSlot).mTriggeredActions.fetchAndStoreOrdered (0);
+    }
+
+    /*!
+        \brief Returns the given slot, its chunk must have been allocated.
+    */
+    SignalSpy::Slot& SignalSpy::GetSlot (int inSlot) const {
+        return mChunks [inSlot / kChunkSize][inSlot % kChunkSize];
+    }
+
+    /*!
+        \brief Returns the rate buffer of the current thread, it is created on first use.
+    */
+    SignalSpy::RateBuffer& SignalSpy::LocalRates () {
+        if (!mThreadRates.hasLocalData ()) {
+            RateBufferPtr buffer (new RateBuffer ());
+            {
+                QMutexLocker locker (&mRateBuffersMutex);
+                mRateBuffers.push_back (buffer);
+            }
+            mThreadRates.setLocalData (new ThreadRates (buffer));
+        }
+        return *mThreadRates.localData ()->mBuffer;
+    }
+
+    /*!
+        \brief Returns the QMetaType types for the argument list of the given signal, computed once per method.
+    */
+    QVector <int> SignalSpy::ArgTypes (const QMetaObject* inMetaObject, int inSignalIndex) {
+        QPair <const QMetaObject*, int> key (inMetaObject, inSignalIndex);
+        QHash <QPair <const QMetaObject*, int>, QVector <int> >::const_iterator it = mArgTypes.find (key);
+        if (it != mArgTypes.end ()) {
+            return it.value ();
+        }
+        QVector <int> argTypes;
+        QList <QByteArray> params = inMetaObject->method (inSignalIndex).parameterTypes ();
         for (int i = 0; i < params.count (); ++i) {
             int tp = QMetaType::type (params.at (i).constData ());
             if (tp == QMetaType::Void)
                 qWarning ("Don't know how to handle '%s', use qRegisterMetaType to register it.",
                          params.at (i).constData ());
-            mArgTypes << tp;
+            argTypes << tp;
         }
+        mArgTypes.insert (key, argTypes);
+        return argTypes;
     }
 
     /*!
         \brief Processes the arguments of a signal emission and outputs information about that signal emission.
+
+        May be called by any thread.
     */
-    void SignalSpy::ProcessArgs (void **inArgs) {
-        mEmitCount++;
-        // build a string of all given arguments, use values of they can be converted to string otherwise use types
-        QString argString;
-        if (mArgTypes.count()) {
-            argString.append (" {");
-            QList <QVariant> list;
-            for (int i = 0; i < mArgTypes.count (); ++i) {
-                QMetaType::Type type = static_cast <QMetaType::Type>(mArgTypes.at( i));
-                QVariant param = QVariant (type, inArgs [i + 1]);
-                if (param.canConvert (QVariant::String)) {
-                    argString.append (param.toString ());
-                }
-                else {
-                    argString.append (QMetaType::typeName (type));
-                }
-                if (i != mArgTypes.count () - 1) {
-                    argString.append (", ");
-                }
+    void SignalSpy::ProcessArgs (int inSlot, void **inArgs) {
+        qint64 timestamp = Clock::Now ();
+        Slot& slot = GetSlot (inSlot);
+        unsigned emitCount = static_cast <unsigned> (slot.mEmitCount.fetchAndAddRelaxed (1)) + 1;
+        if (slot.mLoggerId < 0) {
+            return;
+        }
+        // the rate includes the emissions that are filtered by the condition or sampled out
+        LocalRates ().Push (inSlot, timestamp);
+        // skip the return value
+        void** args = inArgs + 1;
+        int actions = 0;
+        if (const SignalCondition* condition = slot.mCondition) {
+            if (!condition->Matches (args)) {
+                return;
             }
-            argString.append ("}");
+            slot.mMatchCount.ref ();
+            actions = condition->GetActions ();
+            Trigger (inSlot, actions);
+        }
+        if (mLogger->IsLoggingEnabled () && slot.mSampler.Sample (timestamp) && mLogger->GetSampler ().Sample (timestamp)) {
+            mLogger->Log (slot.mLoggerId, slot.mArgTypes, emitCount, timestamp, args);
         }
-        if (mLogger) {
-            mLogger->Log (this, argString);
+        if (actions & SignalCondition::kStopLogging) {
+            mLogger->SetLoggingEnabled (false);
         }
     }
 
     /*!
-        \brief Returns information about the signal being spied.
+        \brief Performs the immediate actions of a matching emission, and reports all actions to the trigger receiver.
+
+        Stopping logging is done by ProcessArgs, after the matching emission has been logged.
     */
-    const MethodData& SignalSpy::SignalData () const {
-        return mSignalData;
+    void SignalSpy::Trigger (int inSlot, int inActions) {
+        if (!inActions) {
+            return;
+        }
+        if (inActions & SignalCondition::kStartLogging) {
+            mLogger->SetLoggingEnabled (true);
+        }
+        if (inActions & SignalCondition::kTriggerBurst) {
+            mLogger->GetSampler ().Trigger ();
+        }
+        if (!mTriggerReceiver) {
+            return;
+        }
+        // the actions are added to the pending actions, only the first trigger since the receiver took them posts a call
+        QAtomicInt& triggeredActions = GetSlot (inSlot).mTriggeredActions;
+        int pending;
+        do {
+            pending = triggeredActions;
+        } while (!triggeredActions.testAndSetOrdered (pending, pending | inActions));
+        if (pending == 0) {
+            QMetaObject::invokeMethod (mTriggerReceiver, "SlotSpyTriggered", Qt::QueuedConnection, Q_ARG (int, inSlot));
+        }
     }
 
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    SignalLogger::Statistics::Statistics () :
+        mEmissions (0),
+        mDropped (0),
+        mSampledOut (0),
+        mRateLimited (0),
+        mTotalCost (0),
+        mMaxCost (0)
+    {}
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Creates a buffer for a thread.
+    */
+    SignalLogger::ThreadCapture::ThreadCapture (const SignalCapturePtr& inCapture) :
+        mCapture (inCapture)
+    {}
+
     /*!
-        \brief Returns the number of monitored emissions for the signal.
+        \brief Called when the thread finishes, the logger removes the buffer once it has been drained.
     */
-    int SignalSpy::EmitCount () const {
-        return mEmitCount;
+    SignalLogger::ThreadCapture::~ThreadCapture () {
+        mCapture->SetOrphaned ();
     }
 
 
@@ -182,6 +627,7 @@ namespace conan {
     */
     SignalLogger::SignalLogger () :
         mShowTimestamp (false),
+        mTimestampMode (kAbsoluteTimestamp),
         mShowObject (false),
         mShowAddress (false),
         mShowSignature (true),
@@ -191,116 +637,475 @@ namespace conan {
         mSignatureWidth (kDynamicWidth),
         mEmitCountWidth (4),
         mPrettyFormatting (false),
-        mSeparator (',')
+        mSeparator (','),
+        mCaptureEnabled (0),
+        mLoggingEnabled (1),
+        mStatisticsChanged (false),
+        mEmittingLog (false),
+        mDateTimeSecond (-1),
+        mThreadNameThread (0),
+        mAnchorTimestamp (Clock::Now ()),
+        mAnchorDateTime (QDateTime::currentDateTime ())
     {
+        mMessage.reserve (256);
+        mArguments.reserve (128);
+        mTimestamp.reserve (32);
+        CompileFormat ();
+        AddSink (new DebugLogSink ());
+        connect (&mDrainTimer, SIGNAL (timeout ()), this, SLOT (SlotDrainCapture ()));
+        mDrainTimer.start (kDrainInterval);
     }
 
     /*!
-        \brief Outputs a single signal emission for the given signal spy and signal arguments.
+        \brief Discards all captured emissions that have not been logged yet, and destroys all sinks.
     */
-    void SignalLogger::Log (SignalSpy* inSpy, const QString& inArgs) {
-        QString logMsg = BuildLogMessage (inSpy->SignalData (), inSpy->EmitCount (), inArgs);
-        qDebug () << logMsg;
+    SignalLogger::~SignalLogger () {
+        QMutexLocker locker (&mCapturesMutex);
+        foreach (const SignalCapturePtr& capture, mCaptures) {
+            while (const SignalCapture::Record* record = capture->Front ()) {
+                capture->Pop (mSpies.at (record->mSpyId).mArgTypes);
+            }
+        }
+        qDeleteAll (mSinks);
+    }
+
+    /*!
+        \brief Registers a spied signal and returns its id, the signal must not be connected to the spy yet.
 
-        // prevent recursion when the SignalSpyLog signal is being spied
-        if (inSpy->SignalData ().mObject != this) {
-            emit SignalSpyLog (logMsg);
+        The logger keeps the data of the signal, so its captured emissions can still be formatted
+        after the spy has been detached or destroyed.
+    */
+    int SignalLogger::RegisterSpy (const MethodData& inSignalData, const QVector <int>& inArgTypes) {
+        SpyInfo info;
+        info.mSignalData = inSignalData;
+        info.mArgTypes = inArgTypes;
+        info.mFormatterGeneration = ArgumentFormatter::Generation ();
+        info.mFormatters = FindFormatters (inArgTypes);
+        info.mFields [SignalLogFormat::kObject] = info.mSignalData.QualifiedName ();
+        info.mFields [SignalLogFormat::kAddress] = info.mSignalData.Address ();
+        info.mFields [SignalLogFormat::kSignature] = info.mSignalData.Signature ();
+        info.mPreviousTimestamp = -1;
+        mSpies.push_back (info);
+        return mSpies.size () - 1;
+    }
+
+    /*!
+        \brief Logs a single signal emission of the spy with the given id, may be called by any thread.
+
+        The arguments are passed as received by qt_metacall, without the return value, their
+        types are given by inArgTypes. In capture mode, or when called by another thread than
+        the thread of the logger, the arguments are copied and formatted later. Otherwise the
+        emission is formatted and logged immediately.
+    */
+    void SignalLogger::Log (int inSpyId, const QVector <int>& inArgTypes, unsigned inEmitCount, qint64 inTimestamp, void** inArgs) {
+        if (mCaptureEnabled || QThread::currentThread () != thread ()) {
+            // the statistics are collected when the buffer is drained
+            LocalCapture ().Push (inSpyId, inEmitCount, inTimestamp, inArgTypes, inArgs);
+            return;
+        }
+        // the name of the thread of the logger is looked up only once, unless the logger moved
+        if (mThreadNameThread != thread ()) {
+            mThreadNameThread = thread ();
+            mThreadName = ObjectUtility::ThreadName (mThreadNameThread);
         }
+        Output (inSpyId, inEmitCount, inTimestamp, inArgs, mThreadName);
+        AddCost (Clock::Now () - inTimestamp);
     }
 
     /*!
-        \brief Returns the log message created for the given signal emission data.
+        \brief Formats and logs an emission that was captured elsewhere, f.e. by a SignalTracer.
+
+        Must be called by the thread of the logger, in timestamp order. inThreadName is the name
+        of the thread that emitted the signal.
     */
-    QString SignalLogger::BuildLogMessage (const MethodData& inSignalData, int inEmitCount, const QString& inArgs) const {
-        QString logMsg;
-        QString separator = QString (" %1 ").arg (mSeparator);
-        if (mShowTimestamp) {
-            QString timestamp = QDateTime::currentDateTime ().toString (Qt::ISODate);
-            timestamp.replace ('T', ' ');
-            logMsg.append (timestamp);
+    void SignalLogger::LogCaptured (int inSpyId, const SignalCapture::Record& inRecord, const QString& inThreadName) {
+        Output (inSpyId, inRecord.mEmitCount, inRecord.mTimestamp, const_cast <void**> (inRecord.mArgs), inThreadName);
+        AddCost (inRecord.mCost);
+    }
+
+    /*!
+        \brief Enables or disables capture mode, captured emissions are flushed when capture mode is disabled.
+
+        Emissions from other threads than the thread of the logger are always captured.
+    */
+    void SignalLogger::SetCaptureEnabled (bool inEnabled) {
+        if (IsCaptureEnabled () == inEnabled) {
+            return;
         }
-        if (mShowObject) {
-            QString object = ObjectUtility::QualifiedName (inSignalData.mClass, inSignalData.mName);
-            if (mPrettyFormatting && mObjectWidth != kDynamicWidth) {
-                object = object.leftJustified (mObjectWidth, ' ', true);
+        mCaptureEnabled.fetchAndStoreOrdered (inEnabled ? 1 : 0);
+        if (!inEnabled) {
+            Flush ();
+        }
+    }
+
+    /*!
+        \brief Returns true when emissions are captured instead of logged immediately.
+    */
+    bool SignalLogger::IsCaptureEnabled () const {
+        return mCaptureEnabled != 0;
+    }
+
+    /*!
+        \brief Formats and logs all captured emissions of all threads, in timestamp order.
+
+        Only the emissions that were captured before the call are logged, so spying on a
+        signal that is emitted by logging, like SignalSpyLog, cannot keep the flush busy.
+        Buffers of finished threads are removed once they have been drained.
+    */
+    void SignalLogger::Flush () {
+        QList <SignalCapturePtr> captures;
+        {
+            QMutexLocker locker (&mCapturesMutex);
+            captures = mCaptures;
+        }
+
+        // the orphaned state must be read before the counts, so no records can follow
+        QVector <bool> orphaned (captures.size ());
+        QVector <int> remaining (captures.size ());
+        for (int c=0; c<captures.size (); ++c) {
+            orphaned [c] = captures [c]->IsOrphaned ();
+            remaining [c] = captures [c]->Count ();
+            if (int dropped = captures [c]->TakeDroppedCount ()) {
+                mStatistics.mDropped += dropped;
+                mStatisticsChanged = true;
+            }
+        }
+
+        // merge the buffers, each buffer is already in timestamp order
+        forever {
+            int next = -1;
+            for (int c=0; c<captures.size (); ++c) {
+                if (remaining [c] && (next < 0 || captures [c]->Front ()->mTimestamp < captures [next]->Front ()->mTimestamp)) {
+                    next = c;
+                }
             }
-            if (!logMsg.isEmpty ()) {
-                logMsg.append (separator);
+            if (next < 0) {
+                break;
             }
-            logMsg.append (object);
+            SignalCapture& capture = *captures [next];
+            const SignalCapture::Record* record = capture.Front ();
+            const SpyInfo& spy = mSpies.at (record->mSpyId);
+            Output (record->mSpyId, record->mEmitCount, record->mTimestamp, const_cast <void**> (record->mArgs), capture.ThreadName ());
+            AddCost (record->mCost);
+            capture.Pop (spy.mArgTypes);
+            --remaining [next];
         }
-        if (mShowAddress) {
-            QString address = inSignalData.mAddress;
-            if (!logMsg.isEmpty ()) {
-                logMsg.append (separator);
+
+        QMutexLocker locker (&mCapturesMutex);
+        for (int c=0; c<captures.size (); ++c) {
+            if (orphaned [c] && !captures [c]->Count ()) {
+                mCaptures.removeAll (captures [c]);
             }
-            logMsg.append (address);
         }
-        if (mShowSignature) {
-            QString signature = inSignalData.mSignature;
-            if (mPrettyFormatting && mSignatureWidth != kDynamicWidth) {
-                signature = signature.leftJustified (mSignatureWidth, ' ', true);
+    }
+
+    /*!
+        \brief Returns the time spent within the logged signal emissions.
+    */
+    const SignalLogger::Statistics& SignalLogger::GetStatistics () const {
+        return mStatistics;
+    }
+
+    /*!
+        \brief Returns the number of captured emissions that have not been logged yet.
+    */
+    int SignalLogger::PendingCount () const {
+        QMutexLocker locker (&mCapturesMutex);
+        int count = 0;
+        foreach (const SignalCapturePtr& capture, mCaptures) {
+            count += capture->Count ();
+        }
+        return count;
+    }
+
+    /*!
+        \brief Returns the sampler that applies to the emissions of all spies, which may be used from any thread.
+    */
+    SignalSampler& SignalLogger::GetSampler () {
+        return mSampler;
+    }
+
+    /*!
+        \brief Pauses or resumes logging of all spies and of the tracer, may be called by any thread.
+
+        Emissions are still counted while logging is paused.
+    */
+    void SignalLogger::SetLoggingEnabled (bool inEnabled) {
+        mLoggingEnabled.fetchAndStoreOrdered (inEnabled ? 1 : 0);
+    }
+
+    /*!
+        \brief Returns true unless logging has been paused.
+    */
+    bool SignalLogger::IsLoggingEnabled () const {
+        return mLoggingEnabled != 0;
+    }
+
+    /*!
+        \brief Adds a sink to which all logs are written, the logger takes ownership of the sink.
+
+        The wall clock time at which the logger was created is written to the sink first.
+    */
+    void SignalLogger::AddSink (SignalLogSink* inSink) {
+        if (inSink && !mSinks.contains (inSink)) {
+            mSinks.push_back (inSink);
+            inSink->WriteSessionStart (mAnchorDateTime, mAnchorTimestamp);
+        }
+    }
+
+    /*!
+        \brief Flushes, removes and destroys the given sink.
+    */
+    void SignalLogger::RemoveSink (SignalLogSink* inSink) {
+        if (mSinks.removeAll (inSink)) {
+            inSink->Flush ();
+            delete inSink;
+        }
+    }
+
+    /*!
+        \brief Flushes, removes and destroys all sinks.
+    */
+    void SignalLogger::RemoveAllSinks () {
+        while (!mSinks.isEmpty ()) {
+            RemoveSink (mSinks.first ());
+        }
+    }
+
+    /*!
+        \brief Returns all sinks to which logs are written.
+    */
+    const QList <SignalLogSink*>& SignalLogger::Sinks () const {
+        return mSinks;
+    }
+
+    /*!
+        \brief Logs the captured emissions, flushes all sinks and reports changed statistics.
+    */
+    void SignalLogger::SlotDrainCapture () {
+        Flush ();
+        foreach (SignalLogSink* sink, mSinks) {
+            sink->Flush ();
+        }
+        int sampledOut = mSampler.SampledOutCount ();
+        int rateLimited = mSampler.RateLimitedCount ();
+        if (sampledOut != mStatistics.mSampledOut || rateLimited != mStatistics.mRateLimited) {
+            mStatistics.mSampledOut = sampledOut;
+            mStatistics.mRateLimited = rateLimited;
+            mStatisticsChanged = true;
+        }
+        if (mStatisticsChanged) {
+            mStatisticsChanged = false;
+            emit SignalStatisticsChanged ();
+        }
+    }
+
+    /*!
+        \brief Returns the capture buffer of the current thread, it is created on first use.
+    */
+    SignalCapture& SignalLogger::LocalCapture () {
+        if (!mThreadCapture.hasLocalData ()) {
+            SignalCapturePtr capture (new SignalCapture ());
+            capture->SetThreadName (ObjectUtility::ThreadName (QThread::currentThread ()));
+            {
+                QMutexLocker locker (&mCapturesMutex);
+                mCaptures.push_back (capture);
             }
-            if (!logMsg.isEmpty ()) {
-                logMsg.append (separator);
+            mThreadCapture.setLocalData (new ThreadCapture (capture));
+        }
+        return *mThreadCapture.localData ()->mCapture;
+    }
+
+    /*!
+        \brief Adds the time spent within a single logged emission to the statistics.
+    */
+    void SignalLogger::AddCost (qint64 inCost) {
+        ++mStatistics.mEmissions;
+        mStatistics.mTotalCost += inCost;
+        mStatistics.mMaxCost = qMax (mStatistics.mMaxCost, inCost);
+        mStatisticsChanged = true;
+    }
+
+    /*!
+        \brief Outputs a single signal emission of the spy with the given id to all sinks.
+    */
+    void SignalLogger::Output (int inSpyId, unsigned inEmitCount, qint64 inTimestamp, void** inArgs, const QString& inThreadName) {
+        SpyInfo& spy = mSpies [inSpyId];
+        const QString* values [SignalLogFormat::kFieldCount] = {
+            &mTimestamp,
+            &spy.mFields [SignalLogFormat::kObject],
+            &spy.mFields [SignalLogFormat::kAddress],
+            &spy.mFields [SignalLogFormat::kSignature],
+            0,
+            &mArguments
+        };
+        if (mFormat.UsesField (SignalLogFormat::kTimestamp)) {
+            FormatTimestamp (inTimestamp, spy.mPreviousTimestamp, mTimestamp);
+        }
+        spy.mPreviousTimestamp = inTimestamp;
+        if (mFormat.UsesField (SignalLogFormat::kArguments)) {
+            int generation = ArgumentFormatter::Generation ();
+            if (spy.mFormatterGeneration != generation) {
+                spy.mFormatterGeneration = generation;
+                spy.mFormatters = FindFormatters (spy.mArgTypes);
             }
-            logMsg.append (signature);
+            FormatArguments (spy.mArgTypes, spy.mFormatters, inArgs, mArguments);
         }
-        if (mShowEmitCount) {
-            QString emitCount = QString::number (inEmitCount);
-            if (mPrettyFormatting && mEmitCountWidth != kDynamicWidth) {
-                emitCount = emitCount.leftJustified (mEmitCountWidth, ' ', true);
+        else {
+            mArguments.resize (0);
+        }
+        mFormat.Format (values, inEmitCount, mMessage);
+
+        SignalLogEntry entry;
+        entry.mSpyId = inSpyId;
+        entry.mSignalData = &spy.mSignalData;
+        entry.mEmitCount = inEmitCount;
+        entry.mTimestamp = inTimestamp;
+        entry.mThread = &inThreadName;
+        entry.mArguments = mArguments;
+        entry.mMessage = mMessage;
+        foreach (SignalLogSink* sink, mSinks) {
+            sink->Write (entry);
+        }
+
+        // prevent recursion when SignalSpyLog, or a signal that is emitted by one of its receivers, is being spied
+        if (!mEmittingLog) {
+            mEmittingLog = true;
+            emit SignalSpyLog (mMessage);
+            mEmittingLog = false;
+        }
+    }
+
+    /*!
+        \brief Formats the given monotonic timestamp, see Clock::Now, according to mTimestampMode.
+
+        inPreviousTimestamp is the timestamp of the previous emission of the same signal, or -1.
+        The date and time of an absolute timestamp are only formatted when the second changes,
+        all other parts are appended without allocating.
+    */
+    void SignalLogger::FormatTimestamp (qint64 inTimestamp, qint64 inPreviousTimestamp, QString& outText) const {
+        const qint64 kNanosecondsPerSecond = Q_INT64_C (1000000000);
+        outText.resize (0);
+        switch (mTimestampMode) {
+            case kAbsoluteTimestamp: {
+                // nanoseconds since the start of the second of the anchor
+                qint64 nsecs = (inTimestamp - mAnchorTimestamp) + mAnchorDateTime.time ().msec () * Q_INT64_C (1000000);
+                qint64 second = nsecs >= 0 ? nsecs / kNanosecondsPerSecond : (nsecs - kNanosecondsPerSecond + 1) / kNanosecondsPerSecond;
+                if (second != mDateTimeSecond) {
+                    QDateTime dateTime = mAnchorDateTime.addMSecs (-mAnchorDateTime.time ().msec ()).addSecs (static_cast <int> (second));
+                    mDateTime = dateTime.toString (Qt::ISODate);
+                    mDateTime.replace ('T', ' ');
+                    mDateTimeSecond = second;
+                }
+                outText.append (mDateTime);
+                outText.append ('.');
+                SignalLogFormat::AppendNumber ((nsecs - second * kNanosecondsPerSecond) / 1000, 6, outText);
+                break;
             }
-            if (!logMsg.isEmpty ()) {
-                logMsg.append (separator);
+            case kRelativeTimestamp:
+            case kDeltaTimestamp: {
+                qint64 nsecs = inTimestamp - mAnchorTimestamp;
+                if (mTimestampMode == kDeltaTimestamp) {
+                    nsecs = inPreviousTimestamp < 0 ? 0 : inTimestamp - inPreviousTimestamp;
+                    outText.append (nsecs < 0 ? '-' : '+');
+                }
+                else if (nsecs < 0) {
+                    outText.append ('-');
+                }
+                quint64 magnitude = static_cast <quint64> (nsecs < 0 ? -nsecs : nsecs);
+                SignalLogFormat::AppendNumber (magnitude / kNanosecondsPerSecond, 1, outText);
+                outText.append ('.');
+                SignalLogFormat::AppendNumber (magnitude % kNanosecondsPerSecond, 9, outText);
+                break;
             }
-            logMsg.append ('#');
-            logMsg.append (emitCount);
         }
-        if (mShowArguments && !inArgs.isEmpty ()) {
-            QString arguments = inArgs;
-            if (!logMsg.isEmpty ()) {
-                logMsg.append (separator);
-            }
-            logMsg.append (arguments);
+    }
+
+    /*!
+        \brief Compiles the log options into the format used for all log messages.
+
+        Must be called after the options have been changed. Returns false when mFormatTemplate
+        is invalid, in which case the other options are used.
+    */
+    bool SignalLogger::CompileFormat () {
+        return CompileFormat (mFormat, mObjectWidth, mSignatureWidth, &mFormatError);
+    }
+
+    /*!
+        \brief Compiles the log options, using the given object and signature width.
+    */
+    bool SignalLogger::CompileFormat (SignalLogFormat& outFormat, unsigned inObjectWidth, unsigned inSignatureWidth, QString* outError) const {
+        outError->clear ();
+        if (!mFormatTemplate.isEmpty () && outFormat.Parse (mFormatTemplate, outError)) {
+            return true;
         }
-        return logMsg;
+
+        outFormat.Clear ();
+        QString separator = QString (" %1 ").arg (mSeparator);
+        QString prefix;
+        if (mShowTimestamp) {
+            outFormat.AddField (SignalLogFormat::kTimestamp, prefix);
+            prefix = separator;
+        }
+        if (mShowObject) {
+            outFormat.AddField (SignalLogFormat::kObject, prefix, mPrettyFormatting ? inObjectWidth : kDynamicWidth);
+            prefix = separator;
+        }
+        if (mShowAddress) {
+            outFormat.AddField (SignalLogFormat::kAddress, prefix);
+            prefix = separator;
+        }
+        if (mShowSignature) {
+            outFormat.AddField (SignalLogFormat::kSignature, prefix, mPrettyFormatting ? inSignatureWidth : kDynamicWidth);
+            prefix = separator;
+        }
+        if (mShowEmitCount) {
+            outFormat.AddField (SignalLogFormat::kEmitCount, prefix + '#', mPrettyFormatting ? mEmitCountWidth : kDynamicWidth);
+            prefix = separator;
+        }
+        if (mShowArguments) {
+            // signals without arguments log no separator either
+            outFormat.AddField (SignalLogFormat::kArguments, prefix, kDynamicWidth, true);
+        }
+        return outError->isEmpty ();
     }
 
     /*!
         \brief Returns an example signal spy log based on the current log options.
     */
     QString SignalLogger::GetExampleLog () const {
-        MethodData dummySignalData1;
-        dummySignalData1.mSignature = "MySignal1()";
-        dummySignalData1.mAddress = "0x12345678";
-        dummySignalData1.mName = "DummyObject";
-        dummySignalData1.mClass = "MyObject";
-
-        MethodData dummySignalData2;
-        dummySignalData2.mSignature = "MySignal2(int,const QString&)";
-        dummySignalData2.mAddress = "0x87654321";
-        dummySignalData2.mName = "MyDummy";
-        dummySignalData2.mClass = "MyObject";
-
-        // we need to temporarily adjust the object and signature width;
-        SignalLogger* logger = const_cast <SignalLogger*> (this);
-        // store old
-        unsigned oldObjectWidth = logger->mObjectWidth;
-        unsigned oldSignatureWidth = logger->mSignatureWidth;
-        // adjust
-        logger->mObjectWidth = ObjectUtility::QualifiedName (dummySignalData1.mClass, dummySignalData1.mName).count ();
-        logger->mSignatureWidth = dummySignalData2.mSignature.count ();
-
-        QString logMsg1 = BuildLogMessage (dummySignalData1, 7, QString ());
-        QString logMsg2 = BuildLogMessage (dummySignalData2, 12, "{42, question}");
-
-        logMsg1.count ();
-        logMsg2.count ();
-        // restore
-        logger->mObjectWidth = oldObjectWidth;
-        logger->mSignatureWidth = oldSignatureWidth;
+        MethodRecordPtr dummySignal1 (new MethodRecord ());
+        dummySignal1->mSignature = "MySignal1()";
+        MethodData dummySignalData1 (ObjectRecordPtr (new ObjectRecord ("MyObject", "DummyObject", "0x12345678")), dummySignal1);
+
+        MethodRecordPtr dummySignal2 (new MethodRecord ());
+        dummySignal2->mSignature = "MySignal2(int,const QString&)";
+        MethodData dummySignalData2 (ObjectRecordPtr (new ObjectRecord ("MyObject", "MyDummy", "0x87654321")), dummySignal2);
+
+        // compile a format that aligns the example logs
+        SignalLogFormat format;
+        QString error;
+        if (!CompileFormat (format, dummySignalData1.QualifiedName ().count (), dummySignalData2.Signature ().count (), &error)) {
+            return QString ("Invalid format template: %1").arg (error);
+        }
+
+        QString timestamp;
+        FormatTimestamp (mAnchorTimestamp + Q_INT64_C (1500000), mAnchorTimestamp, timestamp);
+        QString object1 = dummySignalData1.QualifiedName ();
+        QString address1 = dummySignalData1.Address ();
+        QString signature1 = dummySignalData1.Signature ();
+        QString arguments1;
+        const QString* values1 [SignalLogFormat::kFieldCount] = { &timestamp, &object1, &address1, &signature1, 0, &arguments1 };
+        QString object2 = dummySignalData2.QualifiedName ();
+        QString address2 = dummySignalData2.Address ();
+        QString signature2 = dummySignalData2.Signature ();
+        QString arguments2 = "{42, question}";
+        const QString* values2 [SignalLogFormat::kFieldCount] = { &timestamp, &object2, &address2, &signature2, 0, &arguments2 };
 
+        QString logMsg1;
+        QString logMsg2;
+        format.Format (values1, 7, logMsg1);
+        format.Format (values2, 12, logMsg2);
         return logMsg1 + '\n' + logMsg2;
     }
 
@@ -308,19 +1113,37 @@ namespace conan {
     // ------------------------------------------------------------------------------------------------
 
 
-    SignalSpyModel::SignalSpyModel (QObject* inParent)
-        : QAbstractTableModel (inParent) {
+    SignalSpyModel::SpyStatistics::SpyStatistics () :
+        mRank (0)
+    {
+        for (int v=0; v<kColumnCount - kFirstStatisticColumn; ++v) {
+            mValues [v] = 0;
+        }
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    SignalSpyModel::SignalSpyModel (QObject* inParent) :
+        QAbstractTableModel (inParent),
+        mLogger (new SignalLogger ()),
+        mSignalSpy (new SignalSpy (mLogger, this))
+    {
+        connect (&mRefreshTimer, SIGNAL (timeout ()), this, SLOT (SlotRefreshStatistics ()));
+        mRefreshTimer.start (kRefreshInterval);
     }
 
     SignalSpyModel::~SignalSpyModel () {
-        foreach (SignalSpy* spy, mSignalSpies) {
-            spy->deleteLater ();
-        }
-        mSignalSpies.clear ();
+        // the spy may be processing an emission, it is deleted when control returns to the event loop
+        mSignalSpy->DetachAll ();
+        // the spy logs through the logger until then, so the logger is destroyed as child of the spy
+        mLogger->setParent (mSignalSpy);
+        mSignalSpy->deleteLater ();
     }
 
     SignalLogger& SignalSpyModel::GetLogger () {
-        return mLogger;
+        return *mLogger;
     }
 
     /*!
@@ -328,11 +1151,8 @@ namespace conan {
     */
     bool SignalSpyModel::ContainsSignalSpy (const QObject* inObject, const QString& inSignal) const {
         if (inObject && !inSignal.isEmpty ()) {
-            foreach (SignalSpy* spy, mSignalSpies) {
-                if (SameSignal (inObject, inSignal, spy)) {
-                    return true;
-                }
-            }
+            int signalIndex = inObject->metaObject ()->indexOfMethod (inSignal.toAscii ().data ());
+            return signalIndex >= 0 && mSignalSpy->FindSlot (inObject, signalIndex) >= 0;
         }
         return false;
     }
@@ -341,31 +1161,54 @@ namespace conan {
         \brief Creates a signal spy that monitors the given signal (normalized signature).
     */
     void SignalSpyModel::CreateSignalSpy (const QObject* inObject, const QString& inSignal) {
-        if (ContainsSignalSpy (inObject, inSignal)) {
+        if (!inObject || ContainsSignalSpy (inObject, inSignal)) {
             return;
         }
-        QScopedPointer <SignalSpy> spy (new SignalSpy (inObject, inSignal, &mLogger));
-        if (spy->SignalData ().mObject) {
-            mLogger.mObjectWidth = qMax <unsigned> (mLogger.mObjectWidth, ObjectUtility::QualifiedName (spy->SignalData ().mClass, spy->SignalData ().mName).count ());
-            mLogger.mSignatureWidth = qMax <unsigned> (mLogger.mSignatureWidth, spy->SignalData ().mSignature.count ());
+        int slot = mSignalSpy->Attach (inObject, inSignal);
+        if (slot >= 0) {
+            InsertSlots (QVector <int> () << slot);
+        }
+    }
+
+    /*!
+        \brief Creates signal spies for all signals of the given objects that are not monitored yet,
+        and returns the number of created spies.
 
-            beginInsertRows (QModelIndex (), rowCount (), rowCount ());
-            mSignalSpies.push_back (spy.take ());
-            endInsertRows ();
+        All spies are inserted at once, so this is suitable for all instances of a class or a
+        complete object hierarchy.
+    */
+    int SignalSpyModel::CreateSignalSpies (const QList <const QObject*>& inObjects) {
+        QVector <int> createdSlots;
+        foreach (const QObject* object, inObjects) {
+            if (!object) {
+                continue;
+            }
+            const QMetaObject* metaObject = object->metaObject ();
+            for (int m=0; m<metaObject->methodCount (); ++m) {
+                if (metaObject->method (m).methodType () != QMetaMethod::Signal || mSignalSpy->FindSlot (object, m) >= 0) {
+                    continue;
+                }
+                int slot = mSignalSpy->Attach (object, m);
+                if (slot >= 0) {
+                    createdSlots.push_back (slot);
+                }
+            }
         }
+        InsertSlots (createdSlots);
+        return createdSlots.size ();
     }
 
     /*!
         \brief Destroyes the signal spy that monitors the given signal (normalized signature).
     */
     void SignalSpyModel::DestroySignalSpy (const QObject* inObject, const QString& inSignal) {
-        int row = 0;
-        foreach (SignalSpy* spy, mSignalSpies) {
-            if (SameSignal (inObject, inSignal, spy)) {
-                removeRows (row, 1);
-                break;
-            }
-            ++row;
+        if (!inObject) {
+            return;
+        }
+        int signalIndex = inObject->metaObject ()->indexOfMethod (inSignal.toAscii ().data ());
+        int row = mSlots.indexOf (mSignalSpy->FindSlot (inObject, signalIndex));
+        if (signalIndex >= 0 && row >= 0) {
+            removeRows (row, 1);
         }
     }
 
@@ -373,7 +1216,7 @@ namespace conan {
         \brief Returns the number of signal spies.
     */
     int SignalSpyModel::rowCount (const QModelIndex& /*inParent*/) const {
-        return static_cast <int> (mSignalSpies.size ());
+        return mSlots.size ();
     }
 
     /*!
@@ -395,21 +1238,40 @@ namespace conan {
     */
     QVariant SignalSpyModel::data (const QModelIndex& inIndex, int inRole) const {
         if (inIndex.isValid () && inRole == Qt::DisplayRole) {
-            SignalSpy* spy = mSignalSpies [inIndex.row ()];
+            const MethodData& signalData = mSignalSpy->SignalData (mSlots [inIndex.row ()]);
             switch (inIndex.column ()) {
                 case kSignature:
-                    return spy->SignalData ().mSignature;
+                    return signalData.Signature ();
                 case kObject:
-                    return ObjectUtility::QualifiedName (spy->SignalData ().mClass, spy->SignalData ().mName);
+                    return signalData.QualifiedName ();
                 case kAddress:
-                    if (spy->SignalData ().mObject) {
-                        return spy->SignalData ().mAddress;
+                    if (signalData.Object ()) {
+                        return signalData.Address ();
                     }
                     else {
-                        return spy->SignalData ().mAddress + " (destroyed)";
+                        return signalData.Address () + " (destroyed)";
                     }
                 case kSuperClass:
-                    return spy->SignalData ().mSuperClass;
+                    return signalData.SuperClass ();
+                case kSampling:
+                    return mSignalSpy->Sampler (mSlots [inIndex.row ()]).Policy ().ToString ();
+                case kCondition:
+                    return GetCondition (inIndex.row ());
+                case kEmitCount:
+                case kPeakRate:
+                case kSampledOut:
+                case kRateLimited:
+                case kMatches:
+                    return qRound64 (Statistic (inIndex.row (), inIndex.column ()));
+                case kRate1s:
+                case kRate10s:
+                case kRate60s:
+                    return qRound64 (Statistic (inIndex.row (), inIndex.column ()) * 10) / 10.0;
+                case kMedianInterval:
+                case kP99Interval: {
+                    double interval = Statistic (inIndex.row (), inIndex.column ());
+                    return interval < 0 ? QVariant () : QVariant (qRound64 (interval * 1000) / 1000.0);
+                }
                 default:
                     return QVariant ();
             }
@@ -431,6 +1293,67 @@ namespace conan {
                     return QString ("Address");
                 case kSuperClass:
                     return QString ("Declared in");
+                case kEmitCount:
+                    return QString ("Emissions");
+                case kRate1s:
+                    return QString ("Rate 1s");
+                case kRate10s:
+                    return QString ("Rate 10s");
+                case kRate60s:
+                    return QString ("Rate 60s");
+                case kPeakRate:
+                    return QString ("Peak rate");
+                case kMedianInterval:
+                    return QString ("Interval p50 (ms)");
+                case kP99Interval:
+                    return QString ("Interval p99 (ms)");
+                case kSampling:
+                    return QString ("Sampling");
+                case kSampledOut:
+                    return QString ("Sampled out");
+                case kRateLimited:
+                    return QString ("Rate limited");
+                case kCondition:
+                    return QString ("Condition");
+                case kMatches:
+                    return QString ("Matches");
+                default:
+                    return QVariant ();
+            }
+        }
+        if (inOrientation == Qt::Horizontal && inRole == Qt::ToolTipRole) {
+            switch (inSection) {
+                case kRate1s:
+                case kRate10s:
+                case kRate60s:
+                case kPeakRate:
+                case kMedianInterval:
+                case kP99Interval: {
+                    QString toolTip;
+                    if (inSection == kPeakRate) {
+                        toolTip = QString ("The highest number of emissions within a single second, including those that were not logged");
+                    }
+                    else if (inSection == kMedianInterval || inSection == kP99Interval) {
+                        toolTip = QString ("The time between consecutive emissions, including those that were not logged");
+                    }
+                    else {
+                        toolTip = QString ("The average number of emissions per second, including those that were not logged");
+                    }
+                    if (quint64 dropped = mSignalSpy->DroppedRateCount ()) {
+                        toolTip += QString ("\n%1 emissions were not counted because a rate buffer was full").arg (dropped);
+                    }
+                    return toolTip;
+                }
+                case kSampling:
+                    return QString ("The sampling policy, f.e: every:10 rate:100 burst:50");
+                case kSampledOut:
+                    return QString ("The number of emissions dropped by the every and burst rules");
+                case kRateLimited:
+                    return QString ("The number of emissions dropped by the rate rule");
+                case kCondition:
+                    return QString ("The condition of the logged emissions, f.e: arg0>1000 do:snapshot");
+                case kMatches:
+                    return QString ("The number of emissions that matched the condition");
                 default:
                     return QVariant ();
             }
@@ -447,23 +1370,238 @@ namespace conan {
         }
         beginRemoveRows (QModelIndex (), inRow, inRow + inCount - 1);
         for (int r=0; r<inCount; r++) {
-            mSignalSpies [inRow + r]->deleteLater ();
+            mSignalSpy->Detach (mSlots [inRow + r]);
         }
-        QVector <SignalSpy*>::iterator first = mSignalSpies.begin () + inRow;
-        QVector <SignalSpy*>::iterator last = first + inCount;
-        mSignalSpies.erase (first, last);
+        mSlots.remove (inRow, inCount);
+        mStatistics.remove (inRow, inCount);
         endRemoveRows ();
 
-        // update logger object and signature width options
-        mLogger.mObjectWidth = SignalLogger::kDynamicWidth;
-        mLogger.mSignatureWidth = SignalLogger::kDynamicWidth;
+        UpdateLoggerWidths ();
+        return true;
+    }
+
+    /*!
+        \brief Appends a row for each of the given slots.
+    */
+    void SignalSpyModel::InsertSlots (const QVector <int>& inSlots) {
+        if (inSlots.isEmpty ()) {
+            return;
+        }
+        beginInsertRows (QModelIndex (), rowCount (), rowCount () + inSlots.size () - 1);
+        foreach (int slot, inSlots) {
+            mSlots.push_back (slot);
+            mStatistics.push_back (SpyStatistics ());
+            mStatistics.back ().mRank = mStatistics.size () - 1;
+        }
+        endInsertRows ();
+
+        UpdateLoggerWidths ();
+    }
+
+    /*!
+        \brief Updates the logger object and signature width options to the widest spy.
+    */
+    void SignalSpyModel::UpdateLoggerWidths () {
+        mLogger->mObjectWidth = SignalLogger::kDynamicWidth;
+        mLogger->mSignatureWidth = SignalLogger::kDynamicWidth;
+
+        foreach (int slot, mSlots) {
+            const MethodData& signalData = mSignalSpy->SignalData (slot);
+            mLogger->mObjectWidth = qMax <unsigned> (mLogger->mObjectWidth, signalData.QualifiedName ().count ());
+            mLogger->mSignatureWidth = qMax <unsigned> (mLogger->mSignatureWidth, signalData.Signature ().count ());
+        }
+        mLogger->CompileFormat ();
+    }
+
+    /*!
+        \brief Returns the sampling policy of the spy in the given row.
+    */
+    SamplingPolicy SignalSpyModel::GetSamplingPolicy (int inRow) const {
+        return mSignalSpy->Sampler (mSlots [inRow]).Policy ();
+    }
+
+    /*!
+        \brief Applies the given sampling policy to the spies in the given rows.
+    */
+    void SignalSpyModel::SetSamplingPolicy (const QList <int>& inRows, const SamplingPolicy& inPolicy) {
+        foreach (int row, inRows) {
+            mSignalSpy->Sampler (mSlots [row]).SetPolicy (inPolicy);
+            emit dataChanged (index (row, kSampling), index (row, kSampling));
+        }
+    }
+
+    /*!
+        \brief Starts a burst for the spies in the given rows whose sampling policy has a burst rule.
+    */
+    void SignalSpyModel::TriggerBurst (const QList <int>& inRows) {
+        foreach (int row, inRows) {
+            mSignalSpy->Sampler (mSlots [row]).Trigger ();
+        }
+    }
+
+    /*!
+        \brief Returns the condition of the spy in the given row, or an empty string when all emissions are logged.
+    */
+    QString SignalSpyModel::GetCondition (int inRow) const {
+        const SignalCondition* condition = mSignalSpy->Condition (mSlots [inRow]);
+        return condition ? condition->ToString () : QString ();
+    }
+
+    /*!
+        \brief Applies the given condition to the spies in the given rows, see SignalCondition.
+
+        The condition is parsed against the arguments of the signal of each row. No condition is
+        applied and false is returned when the condition is invalid for any of the rows.
+    */
+    bool SignalSpyModel::SetCondition (const QList <int>& inRows, const QString& inCondition, QString* outError) {
+        QVector <SignalCondition> conditions;
+        foreach (int row, inRows) {
+            QString error;
+            const MethodData& signalData = mSignalSpy->SignalData (mSlots [row]);
+            conditions.push_back (SignalCondition::Parse (inCondition, mSignalSpy->SignalArgTypes (mSlots [row]), &error));
+            if (!error.isEmpty ()) {
+                if (outError) {
+                    *outError = signalData.Signature () + ": " + error;
+                }
+                return false;
+            }
+        }
+        for (int r=0; r<inRows.size (); ++r) {
+            int row = inRows [r];
+            mSignalSpy->SetCondition (mSlots [row], conditions [r]);
+            emit dataChanged (index (row, kCondition), index (row, kCondition));
+        }
+        if (outError) {
+            outError->clear ();
+        }
+        return true;
+    }
 
-        foreach (SignalSpy* spy, mSignalSpies) {
-            mLogger.mObjectWidth = qMax <unsigned> (mLogger.mObjectWidth, ObjectUtility::QualifiedName (spy->SignalData ().mClass, spy->SignalData ().mName).count ());
-            mLogger.mSignatureWidth = qMax <unsigned> (mLogger.mSignatureWidth, spy->SignalData ().mSignature.count ());
+    /*!
+        \brief Returns the sampled value of the given statistics column for the given row.
+
+        Intervals are in ms, or -1 when the signal was emitted less than twice.
+    */
+    double SignalSpyModel::Statistic (int inRow, int inColumn) const {
+        if (inRow < 0 || inRow >= mStatistics.size () || inColumn < kFirstStatisticColumn || inColumn >= kColumnCount) {
+            return 0;
+        }
+        return mStatistics [inRow].mValues [inColumn - kFirstStatisticColumn];
+    }
+
+    /*!
+        \brief Returns the rank of the spy in the given row by its emission rate, the busiest spy has rank 0.
+    */
+    int SignalSpyModel::Rank (int inRow) const {
+        return mStatistics [inRow].mRank;
+    }
+
+    /*!
+        \brief Samples the statistics of all spies, and reports the statistics columns as changed when any value changed.
+    */
+    void SignalSpyModel::SlotRefreshStatistics () {
+        mSignalSpy->DrainRates ();
+        if (mSlots.isEmpty ()) {
+            return;
+        }
+        qint64 now = Clock::Now ();
+        bool changed = false;
+        QVector <RankKey> ranking (mSlots.size ());
+        for (int r=0; r<mSlots.size (); ++r) {
+            EmissionRate rate = mSignalSpy->Rate (mSlots [r]);
+            qint64 median = rate.IntervalPercentile (50);
+            qint64 p99 = rate.IntervalPercentile (99);
+
+            double values [kColumnCount - kFirstStatisticColumn];
+            values [kEmitCount - kFirstStatisticColumn] = mSignalSpy->EmitCount (mSlots [r]);
+            values [kRate1s - kFirstStatisticColumn] = rate.Rate (1, now);
+            values [kRate10s - kFirstStatisticColumn] = rate.Rate (10, now);
+            values [kRate60s - kFirstStatisticColumn] = rate.Rate (60, now);
+            values [kPeakRate - kFirstStatisticColumn] = rate.PeakRate ();
+            values [kMedianInterval - kFirstStatisticColumn] = median < 0 ? -1 : median / 1000000.0;
+            values [kP99Interval - kFirstStatisticColumn] = p99 < 0 ? -1 : p99 / 1000000.0;
+            values [kSampledOut - kFirstStatisticColumn] = mSignalSpy->Sampler (mSlots [r]).SampledOutCount ();
+            values [kRateLimited - kFirstStatisticColumn] = mSignalSpy->Sampler (mSlots [r]).RateLimitedCount ();
+            values [kMatches - kFirstStatisticColumn] = mSignalSpy->MatchCount (mSlots [r]);
+
+            SpyStatistics& statistics = mStatistics [r];
+            for (int v=0; v<kColumnCount - kFirstStatisticColumn; ++v) {
+                if (statistics.mValues [v] != values [v]) {
+                    statistics.mValues [v] = values [v];
+                    changed = true;
+                }
+            }
+            ranking [r].mRate1s = values [kRate1s - kFirstStatisticColumn];
+            ranking [r].mRate10s = values [kRate10s - kFirstStatisticColumn];
+            ranking [r].mRow = r;
+        }
+        qSort (ranking);
+        for (int k=0; k<ranking.size (); ++k) {
+            mStatistics [ranking [k].mRow].mRank = k;
+        }
+        if (changed) {
+            emit dataChanged (index (0, kFirstStatisticColumn), index (rowCount () - 1, kColumnCount - 1));
+        }
+    }
+
+    /*!
+        \brief Called by the signal spy when the condition of the given slot triggered actions.
+    */
+    void SignalSpyModel::SlotSpyTriggered (int inSlot) {
+        int actions = mSignalSpy->TakeTriggeredActions (inSlot);
+        if (actions) {
+            emit SignalSpyTriggered (mSlots.indexOf (inSlot), actions);
+        }
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    SignalSpyFilterProxyModel::SignalSpyFilterProxyModel (QObject* inParent) :
+        QSortFilterProxyModel (inParent), mTopMode (false)
+    {
+    }
+
+    /*!
+        \brief Returns true when only the busiest spies are shown.
+    */
+    bool SignalSpyFilterProxyModel::IsTopMode () const {
+        return mTopMode;
+    }
+
+    /*!
+        \brief Returns true if the item indicated by the given source row and parent should be included in the model; otherwise returns false.
+    */
+    bool SignalSpyFilterProxyModel::filterAcceptsRow (int inSourceRow, const QModelIndex& /*inSourceParent*/) const {
+        if (!mTopMode) {
+            return true;
+        }
+        if (const SignalSpyModel* model = dynamic_cast <SignalSpyModel*> (sourceModel ())) {
+            return model->Rank (inSourceRow) < kTopCount && model->Statistic (inSourceRow, SignalSpyModel::kRate60s) > 0;
         }
         return true;
     }
-}
 
+    /*!
+        \brief Returns true if the value of the item referred to by the given index left is less than the value of the item referred to by the given index right, otherwise returns false.
 
+        Statistics columns are compared by value, so empty intervals sort before all others.
+    */
+    bool SignalSpyFilterProxyModel::lessThan (const QModelIndex& inLeft, const QModelIndex& inRight) const {
+        if (inLeft.column () >= SignalSpyModel::kFirstStatisticColumn) {
+            if (const SignalSpyModel* model = dynamic_cast <SignalSpyModel*> (sourceModel ())) {
+                return model->Statistic (inLeft.row (), inLeft.column ()) < model->Statistic (inRight.row (), inRight.column ());
+            }
+        }
+        return QSortFilterProxyModel::lessThan (inLeft, inRight);
+    }
+
+    /*!
+        \brief Enables or disables top mode, in which only the kTopCount busiest spies are shown.
+    */
+    void SignalSpyFilterProxyModel::SlotEnableTopMode (bool inEnable) {
+        mTopMode = inEnable;
+        invalidateFilter ();
+    }
+}
@@ -28,11 +28,31 @@
 #define _SIGNALSPY__31_03_09__01_53_37__H_
 
 
+#include "ArgumentFormatter.h"
 #include "ConnectionModel.h"
+#include "EmissionRate.h"
+#include "MethodTable.h"
+#include "SignalCapture.h"
+#include "SignalCondition.h"
+#include "SignalLogFormat.h"
+#include "SignalLogSink.h"
+#include "SignalSampler.h"
 #include <QtCore/QAbstractTableModel>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QAtomicPointer>
+#include <QtCore/QDateTime>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
 #include <QtCore/QObject>
+#include <QtCore/QPair>
 #include <QtCore/QPointer>
+#include <QtCore/QScopedArrayPointer>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QTimer>
 #include <QtCore/QVector>
+#include <QtGui/QSortFilterProxyModel>
 #include <QtGui/QTableView>
 
 
@@ -43,28 +63,149 @@ namespace conan {
     /*!
         \brief The SignalSpy class enables introspection of signal emission.
 
-        SignalSpy can connect to any signal of any object and output each emission using qDebug.
-        Note that this class is an adaptation of the existing QSignalSpy class.
+        SignalSpy can connect to any number of signals of any objects and output each emission
+        through a SignalLogger. Note that this class is an adaptation of the existing QSignalSpy
+        class: it overrides qt_metacall once, and each attached (object, signal) pair is
+        connected to its own slot index. A slot is a small table entry that shares its object
+        and method records with all other slots of the same object and method, see MethodTable.
+
+        Slots are allocated in chunks of kChunkSize that are never moved or freed, and a slot
+        is never reused after it has been detached. The spy uses direct connections, so
+        emissions are processed by the emitting thread. The emit count and the sampler of a slot
+        are atomic, and all other slot data is immutable once the slot has been connected.
+        Attaching and detaching is only done by the thread of the spy.
+
+        The emitting thread pushes the timestamp of each emission into a rate buffer of its own,
+        which is created on its first emission. DrainRates folds the buffers of all threads into
+        the rate statistics of the slots, in timestamp order, on the thread of the spy, so
+        emitting threads never take a lock. An emission that does not fit into a full buffer is
+        counted in the emit count, but not in the rate statistics.
+
+        Every emission is counted in the emit count and the rate statistics of its slot, see
+        EmissionRate, but it is only logged when it matches the condition of its slot, see
+        SignalCondition, when logging is enabled, and when both the sampler of its slot and the
+        sampler of the logger accept it, see SignalSampler. The condition and sampling are
+        decided on the raw arguments, before any argument is converted.
+
+        A condition can trigger actions. Starting and stopping logging and starting a burst are
+        performed immediately by the emitting thread. All actions are also reported to the
+        trigger receiver, by a queued call of its SlotSpyTriggered (int slot). Calls are
+        coalesced per slot until the receiver takes the actions, see TakeTriggeredActions.
+        Conditions are immutable, a replaced condition is kept until the spy is destroyed.
     */
     class CONAN_LOCAL SignalSpy : public QObject
     {
     public:
-        SignalSpy (const QObject* inObject, const QString& inSignal, SignalLogger* inLogger);
+        static const int kChunkSize = 256;          //!< The number of slots that are allocated at once
+        static const int kMaxChunkCount = 4096;     //!< Limits the number of slots to kChunkSize * kMaxChunkCount
+        static const int kRateBufferCapacity = 8192;    //!< The number of emissions in the rate buffer of each thread
+
+        SignalSpy (SignalLogger* inLogger, QObject* inTriggerReceiver = 0);
+        virtual ~SignalSpy ();
 
         int qt_metacall (QMetaObject::Call inCall, int inMethodId, void **inArgs);
 
-        const MethodData& SignalData () const;
-        int EmitCount () const;
+        int Attach (const QObject* inObject, int inSignalIndex);
+        int Attach (const QObject* inObject, const QString& inSignal);
+        void Detach (int inSlot);
+        void DetachAll ();
+        int FindSlot (const QObject* inObject, int inSignalIndex) const;
+
+        int SlotCount () const;
+        int LoggerId (int inSlot) const;
+        const MethodData& SignalData (int inSlot) const;
+        const QVector <int>& SignalArgTypes (int inSlot) const;
+        int EmitCount (int inSlot) const;
+        EmissionRate Rate (int inSlot) const;
+        void DrainRates ();
+        quint64 DroppedRateCount () const;
+        SignalSampler& Sampler (int inSlot) const;
+
+        void SetCondition (int inSlot, const SignalCondition& inCondition);
+        const SignalCondition* Condition (int inSlot) const;
+        int MatchCount (int inSlot) const;
+        int TakeTriggeredActions (int inSlot);
 
     private:
-        void InitArgs (const QMetaMethod& inMember);
-        void ProcessArgs (void **inArgs);
+        /*!
+            \brief A single attached signal.
+        */
+        struct CONAN_LOCAL Slot {
+            Slot ();
+
+            void Reset ();
+
+            int mLoggerId;              //!< The id of the slot in the logger, or -1 when the slot is not connected
+            QAtomicInt mEmitCount;      //!< The number of times the signal has been emitted
+            EmissionRate mRate;         //!< The rate statistics of all emissions, including those that were not logged, see DrainRates
+            QVector <int> mArgTypes;    //!< The QMetaType types for the argument list of the signal, shared per method
+            MethodData mSignalData;     //!< Information about the signal being spied
+            bool mAttached;             //!< True while the slot is connected to its signal
+            SignalSampler mSampler;     //!< Decides which emissions are logged
+            QAtomicPointer <SignalCondition> mCondition;    //!< The condition of the emissions that are logged, or 0
+            QAtomicInt mMatchCount;     //!< The number of emissions that matched mCondition
+            QAtomicInt mTriggeredActions;   //!< The actions of mCondition that have not been handled by the trigger receiver yet
+        };
+
+        /*!
+            \brief A single emission, as pushed into a rate buffer.
+        */
+        struct CONAN_LOCAL RateSample {
+            int mSlot;                  //!< The slot of the emitted signal
+            qint64 mTimestamp;          //!< The time of the emission, see Clock::Now
+        };
+
+        /*!
+            \brief The lock free single producer, single consumer ring of emissions of a single thread, see SignalCapture.
+        */
+        struct CONAN_LOCAL RateBuffer {
+            RateBuffer ();
+
+            bool Push (int inSlot, qint64 inTimestamp);
+            const RateSample* Front () const;
+            void Pop ();
+            int Count () const;
+
+            QScopedArrayPointer <RateSample> mSamples;  //!< The preallocated samples, kRateBufferCapacity is a power of two
+            QAtomicInt mPushed;                         //!< The number of pushed samples, only written by the producer
+            QAtomicInt mPopped;                         //!< The number of popped samples, only written by the consumer
+            QAtomicInt mDropped;                        //!< The number of emissions that did not fit since the last drain
+            QAtomicInt mOrphaned;                       //!< Non zero when the producer will not push any more samples
+        };
+
+        typedef QSharedPointer <RateBuffer> RateBufferPtr;
+
+        /*!
+            \brief The rate buffer of a single thread, orphans the buffer when the thread finishes.
+        */
+        struct CONAN_LOCAL ThreadRates {
+            ThreadRates (const RateBufferPtr& inBuffer);
+            ~ThreadRates ();
+
+            RateBufferPtr mBuffer;      //!< The buffer, shared with the spy which drains it
+        };
+
+        typedef QPair <const void*, int> SignalKey;
+
+        Slot& GetSlot (int inSlot) const;
+        RateBuffer& LocalRates ();
+        QVector <int> ArgTypes (const QMetaObject* inMetaObject, int inSignalIndex);
+        void ProcessArgs (int inSlot, void **inArgs);
+        void Trigger (int inSlot, int inActions);
 
     private:
-        SignalLogger* mLogger;      //!< Performs the actual logging of each signal emission
-        QList <int> mArgTypes;      //!< The QMetaType types for the argument list of the signal
-        MethodData mSignalData;     //!< Information about the signal being spied
-        unsigned mEmitCount;        //!< The number of times the signal has been emitted
+        SignalLogger* mLogger;                                          //!< Performs the actual logging of each signal emission
+        QObject* mTriggerReceiver;                                      //!< Handles the actions of matching emissions, or 0
+        QList <SignalCondition*> mConditions;                           //!< All conditions that have been set, including replaced conditions
+        Slot* mChunks [kMaxChunkCount];                                 //!< The allocated slot chunks, 0 when not allocated yet
+        int mSlotCount;                                                 //!< The number of used slots
+        MethodTable mRecords;                                           //!< Shares the object and method records of all slots
+        QHash <QPair <const QMetaObject*, int>, QVector <int> > mArgTypes;   //!< map <(meta object, signal index), argument types>
+        QHash <SignalKey, int> mAttachedSlots;                          //!< map <(object address, signal index), slot> of all attached slots
+        QList <RateBufferPtr> mRateBuffers;                             //!< The rate buffers of all threads
+        QMutex mRateBuffersMutex;                                       //!< Protects mRateBuffers
+        QThreadStorage <ThreadRates*> mThreadRates;                     //!< The rate buffer of the current thread
+        quint64 mDroppedRates;                                          //!< The number of emissions that were not counted in the rate statistics
     };
 
 
@@ -79,9 +220,38 @@ namespace conan {
 
         Each individual part of the log can be enabled or disabled. Furthermore, the width of each
         part can be fixed to a custom value or kept dynamic. Fixed fields are truncated when the
-        text is too long or padded with spaces when the text is too short.
-
-        All logging is performed using qDebug calls.
+        text is too long or padded with spaces when the text is too short. Alternatively, the
+        order and layout of the fields can be defined by a template, see SignalLogFormat.
+
+        Emissions are timestamped with the monotonic clock, see Clock::Now, when they are
+        captured. The timestamp field shows either the wall clock time, the time since the
+        logger was created, or the time since the previous emission of the same signal. The
+        wall clock time at which the logger was created is written to each sink once, so logs
+        with relative timestamps can be correlated with other logs.
+
+        The options are compiled into a SignalLogFormat by CompileFormat, which must be called
+        after the options have been changed. Log messages are formatted into a reusable buffer.
+        Arguments are formatted by the ArgumentFormatter of their type, which is looked up once
+        per spy.
+
+        Each log is written to all sinks of the logger, see SignalLogSink. By default the logger
+        has a single DebugLogSink, which performs all logging using qDebug calls. Sinks are
+        flushed at the same cadence at which captured emissions are drained.
+
+        By default each emission is formatted and logged immediately, from within the emission.
+        In capture mode an emission only copies its raw arguments into a SignalCapture buffer,
+        the buffer is drained and formatted periodically or on demand by Flush. The time spent
+        within each emission is measured in both modes.
+
+        Emissions from threads other than the thread of the logger are always captured. Each
+        thread pushes into its own buffer, which is created on its first emission, so emitting
+        threads never contend with each other or take a lock. The thread of the logger drains
+        all buffers at a fixed cadence and merges them in timestamp order. Registering spies,
+        formatting, the options and the statistics are only used by the thread of the logger.
+
+        The sampler of the logger applies a sampling policy to the emissions of all spies and of
+        the SignalTracer, in addition to the sampler of each spy, see SignalSampler. Logging of
+        all spies and of the tracer can be paused from any thread, see SetLoggingEnabled.
     */
     class CONAN_LOCAL SignalLogger : public QObject
     {
@@ -89,21 +259,97 @@ namespace conan {
 
     public:
         static const unsigned kDynamicWidth = 0;    //!< Indicates a dynamic field width
+        static const int kDrainInterval = 100;      //!< The interval in ms at which captured emissions are formatted
+
+        //! \brief The formats of the timestamp field
+        typedef enum TIMESTAMPMODES {
+            kAbsoluteTimestamp,     //!< The wall clock time with microsecond resolution, f.e: 2011-03-31 01:53:37.123456
+            kRelativeTimestamp,     //!< The time since the logger was created in seconds, with nanosecond resolution
+            kDeltaTimestamp         //!< The time since the previous emission of the same signal in seconds, f.e: +0.000250000
+        } TimestampModes;
+
+        /*!
+            \brief Measures the time spent within signal emissions.
+        */
+        struct CONAN_LOCAL Statistics {
+            Statistics ();
+
+            quint64 mEmissions;     //!< The number of logged emissions
+            quint64 mDropped;       //!< The number of emissions dropped because the capture buffer was full
+            int mSampledOut;        //!< The number of emissions dropped by the every and burst rules of the sampler of the logger
+            int mRateLimited;       //!< The number of emissions dropped by the rate rule of the sampler of the logger
+            qint64 mTotalCost;      //!< The total time spent within emissions, in ns
+            qint64 mMaxCost;        //!< The longest time spent within a single emission, in ns
+        };
 
         SignalLogger ();
+        virtual ~SignalLogger ();
 
-        void Log (SignalSpy* inSpy, const QString& inArgs);
+        int RegisterSpy (const MethodData& inSignalData, const QVector <int>& inArgTypes);
+        void Log (int inSpyId, const QVector <int>& inArgTypes, unsigned inEmitCount, qint64 inTimestamp, void** inArgs);
+        void LogCaptured (int inSpyId, const SignalCapture::Record& inRecord, const QString& inThreadName);
         QString GetExampleLog () const;
+        bool CompileFormat ();
+
+        void SetCaptureEnabled (bool inEnabled);
+        bool IsCaptureEnabled () const;
+        void Flush ();
+
+        const Statistics& GetStatistics () const;
+        int PendingCount () const;
+        SignalSampler& GetSampler ();
+
+        void SetLoggingEnabled (bool inEnabled);
+        bool IsLoggingEnabled () const;
+
+        void AddSink (SignalLogSink* inSink);
+        void RemoveSink (SignalLogSink* inSink);
+        void RemoveAllSinks ();
+        const QList <SignalLogSink*>& Sinks () const;
+
+    private slots:
+        void SlotDrainCapture ();
 
     private:
-        QString BuildLogMessage (const MethodData& inSignalData, int inEmitCount, const QString& inArgs) const;
+        typedef QSharedPointer <SignalCapture> SignalCapturePtr;
+
+        /*!
+            \brief The data of a registered spy that is required to format its emissions.
+        */
+        struct CONAN_LOCAL SpyInfo {
+            MethodData mSignalData;     //!< Information about the signal being spied
+            QVector <int> mArgTypes;    //!< The QMetaType types for the argument list of the signal
+            QVector <ArgumentFormatter::Function> mFormatters;  //!< The formatter of each argument
+            int mFormatterGeneration;   //!< The ArgumentFormatter::Generation at which mFormatters were looked up
+            QString mFields [SignalLogFormat::kFieldCount]; //!< The constant log fields: object, address and signature
+            qint64 mPreviousTimestamp;  //!< The timestamp of the previous logged emission, or -1
+        };
+
+        /*!
+            \brief The capture buffer of a single thread, orphans the buffer when the thread finishes.
+        */
+        struct CONAN_LOCAL ThreadCapture {
+            ThreadCapture (const SignalCapturePtr& inCapture);
+            ~ThreadCapture ();
+
+            SignalCapturePtr mCapture;  //!< The buffer, shared with the logger which drains it
+        };
+
+        SignalCapture& LocalCapture ();
+        void AddCost (qint64 inCost);
+        void Output (int inSpyId, unsigned inEmitCount, qint64 inTimestamp, void** inArgs, const QString& inThreadName);
+        bool CompileFormat (SignalLogFormat& outFormat, unsigned inObjectWidth, unsigned inSignatureWidth, QString* outError) const;
+        void FormatTimestamp (qint64 inTimestamp, qint64 inPreviousTimestamp, QString& outText) const;
 
     signals:
         //! \brief Subscribe to all signal spy log messages. Never ever connect a spy to this signal!!!
         void SignalSpyLog (const QString& msg);
+        //! \brief Emitted periodically when the statistics have changed.
+        void SignalStatisticsChanged ();
 
     public:
         bool mShowTimestamp;        //!< Controls timestamp field
+        TimestampModes mTimestampMode;  //!< Controls the format of the timestamp field
         bool mShowObject;           //!< Controls object field
         bool mShowAddress;          //!< Controls address field
         bool mShowSignature;        //!< Controls signal signature field
@@ -116,6 +362,32 @@ namespace conan {
 
         bool mPrettyFormatting;     //!< indicates if log message fields should be alligned between logs
         QChar mSeparator;           //!< the character used for seperating log message fields
+        QString mFormatTemplate;    //!< a template that overrides all options above when not empty, see SignalLogFormat
+
+    private:
+        QVector <SpyInfo> mSpies;                       //!< All registered spies, indexed by spy id
+        QList <SignalLogSink*> mSinks;                  //!< All sinks to which logs are written, owned by the logger
+        QList <SignalCapturePtr> mCaptures;             //!< The capture buffers of all threads
+        mutable QMutex mCapturesMutex;                  //!< Protects mCaptures
+        QThreadStorage <ThreadCapture*> mThreadCapture; //!< The capture buffer of the current thread
+        QAtomicInt mCaptureEnabled;                     //!< Non zero when emissions are captured instead of logged immediately
+        QAtomicInt mLoggingEnabled;                     //!< Non zero when emissions are logged at all
+        QTimer mDrainTimer;                             //!< Periodically drains mCaptures and reports the statistics
+        Statistics mStatistics;                         //!< Measures the time spent within emissions
+        SignalSampler mSampler;                         //!< Decides which emissions of all spies are logged
+        bool mStatisticsChanged;                        //!< Indicates if mStatistics changed since the last report
+        bool mEmittingLog;                              //!< True while SignalSpyLog is being emitted
+        SignalLogFormat mFormat;                        //!< The compiled log options
+        QString mFormatError;                           //!< The reason why mFormatTemplate is invalid, or empty
+        QString mMessage;                               //!< The buffer into which log messages are formatted
+        QString mArguments;                             //!< The buffer into which arguments are formatted
+        QString mTimestamp;                             //!< The buffer into which timestamps are formatted
+        mutable QString mDateTime;                      //!< The formatted wall clock time of mDateTimeSecond, without fraction
+        mutable qint64 mDateTimeSecond;                 //!< The second since mAnchorDateTime of mDateTime, or -1
+        const QThread* mThreadNameThread;               //!< The thread whose name is mThreadName, or 0
+        QString mThreadName;                            //!< The name of the thread of the logger, for emissions that are logged immediately
+        qint64 mAnchorTimestamp;                        //!< A monotonic timestamp, see Clock::Now
+        QDateTime mAnchorDateTime;                      //!< The wall clock time at mAnchorTimestamp, with millisecond resolution
     };
 
 
@@ -125,20 +397,48 @@ namespace conan {
     /*!
         \brief A model for displaying all available signal spies.
 
-        Provides functions for creating and destroying SignalSpy objects. In addition all created
-        spies will share the same SignalLogger, thus providing consistent logging across all spies.
+        Provides functions for creating and destroying signal spies, either for a single signal
+        or for all signals of one or more objects at once. Each row is a slot of a single
+        SignalSpy, so all spies share the same SignalLogger, thus providing consistent logging
+        across all spies.
+
+        The sampling and condition columns show the sampling policy and the condition of each
+        spy, see SignalSampler and SignalCondition. The statistics columns show the emit count,
+        the emission rate statistics, the number of emissions dropped by
+        the sampler and the number of emissions that matched the condition of each spy. Every
+        emission is counted, including the emissions that were not logged. The statistics
+        are sampled from the spy every kRefreshInterval ms, and changes are reported by
+        a single dataChanged for all rows. Each spy is ranked by its emission rate over the last
+        second, the busiest spy first.
     */
     class CONAN_LOCAL SignalSpyModel : public QAbstractTableModel
     {
+        Q_OBJECT
+
     public:
         typedef enum COLUMNS {
             kSignature,
             kObject,
             kAddress,
             kSuperClass,
-            kColumnCount
+            kSampling,
+            kCondition,
+            kEmitCount,
+            kRate1s,
+            kRate10s,
+            kRate60s,
+            kPeakRate,
+            kMedianInterval,
+            kP99Interval,
+            kSampledOut,
+            kRateLimited,
+            kMatches,
+            kColumnCount,
+            kFirstStatisticColumn = kEmitCount
         } Columns;
 
+        static const int kRefreshInterval = 250;    //!< The interval in ms at which the statistics columns are updated
+
     public:
         SignalSpyModel (QObject* inParent = 0);
         virtual ~SignalSpyModel ();
@@ -147,8 +447,16 @@ namespace conan {
 
         bool ContainsSignalSpy (const QObject* inObject, const QString& inSignal) const;
         void CreateSignalSpy (const QObject* inObject, const QString& inSignal);
+        int CreateSignalSpies (const QList <const QObject*>& inObjects);
         void DestroySignalSpy (const QObject* inObject, const QString& inSignal);
 
+        SamplingPolicy GetSamplingPolicy (int inRow) const;
+        void SetSamplingPolicy (const QList <int>& inRows, const SamplingPolicy& inPolicy);
+        void TriggerBurst (const QList <int>& inRows);
+
+        QString GetCondition (int inRow) const;
+        bool SetCondition (const QList <int>& inRows, const QString& inCondition, QString* outError = 0);
+
         // qt overrides
         virtual int rowCount (const QModelIndex& inParent = QModelIndex ()) const;
         virtual int columnCount (const QModelIndex& inParent = QModelIndex ()) const;
@@ -157,9 +465,67 @@ namespace conan {
         virtual QVariant headerData (int inSection, Qt::Orientation inOrientation, int inRole = Qt::DisplayRole) const;
         virtual bool removeRows (int inRow, int inCount, const QModelIndex& inParent = QModelIndex ());
 
+        double Statistic (int inRow, int inColumn) const;
+        int Rank (int inRow) const;
+
+    signals:
+        //! \brief Emitted when the condition of the spy in the given row triggered actions, see SignalCondition::Actions; the row is -1 when the spy has been destroyed.
+        void SignalSpyTriggered (int inRow, int inActions);
+
+    private slots:
+        void SlotRefreshStatistics ();
+        void SlotSpyTriggered (int inSlot);
+
+    private:
+        void InsertSlots (const QVector <int>& inSlots);
+        void UpdateLoggerWidths ();
+
+        /*!
+            \brief The statistics columns of a single spy, as sampled by SlotRefreshStatistics.
+        */
+        struct CONAN_LOCAL SpyStatistics {
+            SpyStatistics ();
+
+            double mValues [kColumnCount - kFirstStatisticColumn];  //!< The value of each statistics column, intervals in ms or -1
+            int mRank;                                              //!< The rank of the spy by its emission rate, starting at 0
+        };
+
+        SignalLogger* mLogger;              //!< Used by all signal spies for consistent log formatting, destroyed together with mSignalSpy
+        SignalSpy* mSignalSpy;              //!< Monitors the signals of all rows
+        QVector <int> mSlots;               //!< The slot in mSignalSpy of each row
+        QVector <SpyStatistics> mStatistics;//!< The sampled statistics of each row
+        QTimer mRefreshTimer;               //!< Periodically samples the statistics
+    };
+
+
+    // --------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Provides sorting and filtering functionality specific to the SignalSpyModel.
+
+        Statistics columns are sorted by value. In top mode only the kTopCount busiest spies
+        that emitted within the last minute are shown.
+    */
+    class CONAN_LOCAL SignalSpyFilterProxyModel : public QSortFilterProxyModel {
+        Q_OBJECT
+
+    public:
+        static const int kTopCount = 20;    //!< The number of spies shown in top mode
+
+        SignalSpyFilterProxyModel (QObject* inParent = 0);
+        bool IsTopMode () const;
+
+    protected:
+        // qt overrides
+        virtual bool filterAcceptsRow (int inSourceRow, const QModelIndex &inSourceParent) const;
+        virtual bool lessThan (const QModelIndex& inLeft, const QModelIndex& inRight) const;
+
+    public slots:
+        void SlotEnableTopMode (bool inEnable);
+
     private:
-        QVector <SignalSpy*> mSignalSpies;  //!< Contains all created signal spies
-        SignalLogger mLogger;               //!< Used by all signal spies for consistent log formatting
+        bool mTopMode;  //!< Controls top mode filtering
     };
 }
 
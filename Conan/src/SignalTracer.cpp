@@ -0,0 +1,542 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains SignalTracer related definitions
+*/
+
+
+#include "Clock.h"
+#include "ObjectUtility.h"
+#include "SignalSpy.h"
+#include "SignalTracer.h"
+#include <QtCore/QCoreApplication>
+#include <QtCore/QMetaMethod>
+#include <QtCore/QMetaObject>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QThread>
+
+
+namespace conan {
+
+    /*!
+        \brief Creates an empty filter, which matches all emissions.
+    */
+    SignalTraceFilter::SignalTraceFilter ()
+    {}
+
+    /*!
+        \brief Parses the given filter text, see SignalTraceFilter.
+
+        Returns an empty filter and sets outError when the text contains an unknown field.
+    */
+    SignalTraceFilter SignalTraceFilter::Parse (const QString& inText, QString* outError) {
+        SignalTraceFilter filter;
+        foreach (const QString& term, inText.split (QRegExp ("\\s+"), QString::SkipEmptyParts)) {
+            int colon = term.indexOf (':');
+            QString field = term.left (colon).toLower ();
+            QString value = term.mid (colon + 1);
+            if (colon < 0 || value.isEmpty ()) {
+                if (outError) {
+                    *outError = QString ("Expected field:value instead of '%1'").arg (term);
+                }
+                return SignalTraceFilter ();
+            }
+            if (field == "class") {
+                filter.mClasses.push_back (value);
+            }
+            else if (field == "signal") {
+                filter.mSignals.push_back (QRegExp (value, Qt::CaseSensitive, QRegExp::Wildcard));
+            }
+            else if (field == "thread") {
+                filter.mThreads.push_back (value);
+            }
+            else {
+                if (outError) {
+                    *outError = QString ("Unknown field '%1', expected class, signal or thread").arg (field);
+                }
+                return SignalTraceFilter ();
+            }
+        }
+        if (outError) {
+            outError->clear ();
+        }
+        return filter;
+    }
+
+    /*!
+        \brief Returns true when the filter matches all emissions.
+    */
+    bool SignalTraceFilter::IsEmpty () const {
+        return mClasses.isEmpty () && mSignals.isEmpty () && mThreads.isEmpty () && mRoots.isEmpty ();
+    }
+
+    /*!
+        \brief Returns true when the class and signal filters accept the given signal.
+    */
+    bool SignalTraceFilter::MatchesSignal (const QMetaObject* inMetaObject, int inMethodIndex) const {
+        if (!mClasses.isEmpty ()) {
+            const QMetaObject* metaObject = inMetaObject;
+            while (metaObject && !mClasses.contains (QLatin1String (metaObject->className ()))) {
+                metaObject = metaObject->superClass ();
+            }
+            if (!metaObject) {
+                return false;
+            }
+        }
+        if (!mSignals.isEmpty ()) {
+            QString signature = QLatin1String (inMetaObject->method (inMethodIndex).signature ());
+            QString name = signature.left (signature.indexOf ('('));
+            foreach (const QRegExp& pattern, mSignals) {
+                if (pattern.exactMatch (name)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        return true;
+    }
+
+    /*!
+        \brief Returns true when the thread filter accepts the current thread.
+    */
+    bool SignalTraceFilter::MatchesThread () const {
+        if (mThreads.isEmpty ()) {
+            return true;
+        }
+        QThread* thread = QThread::currentThread ();
+        bool isMain = QCoreApplication::instance () && QCoreApplication::instance ()->thread () == thread;
+        foreach (const QString& name, mThreads) {
+            if ((isMain && name.compare ("main", Qt::CaseInsensitive) == 0) ||
+                name.compare (thread->objectName (), Qt::CaseInsensitive) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    QAtomicPointer <SignalTracer> SignalTracer::sEnabledTracer;
+
+    SignalTracer::Statistics::Statistics () :
+        mTraced (0),
+        mFiltered (0),
+        mDropped (0),
+        mOverflowed (0),
+        mTracedCost (0),
+        mFilteredCost (0)
+    {}
+
+    SignalTracer::TracedSignal::TracedSignal () :
+        mSender (0),
+        mEmitCount (0),
+        mLoggerId (-1)
+    {}
+
+    SignalTracer::ThreadBuffer::ThreadBuffer () :
+        mCapture (0),
+        mFiltered (0),
+        mFilteredCost (0),
+        mOverflowed (0),
+        mOrphaned (0)
+    {}
+
+    /*!
+        \brief Destroys the capture buffer, which must have been drained.
+    */
+    SignalTracer::ThreadBuffer::~ThreadBuffer () {
+        delete Capture ();
+    }
+
+    /*!
+        \brief Returns the capture buffer as published by the producer, or 0 when the thread did not trace any emission yet.
+    */
+    SignalCapture* SignalTracer::ThreadBuffer::Capture () const {
+        return const_cast <QAtomicPointer <SignalCapture>&> (mCapture).fetchAndAddAcquire (0);
+    }
+
+    /*!
+        \brief Creates the state of a thread.
+    */
+    SignalTracer::ThreadState::ThreadState (const ThreadBufferPtr& inBuffer) :
+        mBuffer (inBuffer),
+        mGeneration (-1),
+        mThreadAccepted (false),
+        mSuspended (false),
+        mPendingCost (0)
+    {}
+
+    /*!
+        \brief Called when the thread finishes, the tracer removes the buffer once it has been drained.
+    */
+    SignalTracer::ThreadState::~ThreadState () {
+        mBuffer->mOrphaned.fetchAndStoreRelease (1);
+    }
+
+    /*!
+        \brief Returns the capture buffer of the thread, it is created and published on the first traced emission.
+    */
+    SignalCapture& SignalTracer::ThreadState::LocalCapture () {
+        SignalCapture* capture = mBuffer->mCapture;
+        if (!capture) {
+            capture = new SignalCapture ();
+            capture->SetThreadName (ObjectUtility::ThreadName (QThread::currentThread ()));
+            mBuffer->mCapture.fetchAndStoreRelease (capture);
+        }
+        return *capture;
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Creates a disabled tracer that writes all traced emissions to the given logger.
+    */
+    SignalTracer::SignalTracer (SignalLogger* inLogger, QObject* inParent) :
+        QObject (inParent),
+        mLogger (inLogger),
+        mGeneration (0),
+        mSignalCount (0),
+        mDrainTimer (this),
+        mStatisticsChanged (false)
+    {
+        Q_ASSERT (inLogger);
+        for (int c=0; c<kMaxChunkCount; ++c) {
+            mChunks [c] = 0;
+        }
+        // never trace the emissions that are caused by tracing itself
+        mIgnored << this << &mDrainTimer << mLogger;
+        foreach (const QObject* child, mLogger->children ()) {
+            mIgnored << child;
+        }
+        connect (&mDrainTimer, SIGNAL (timeout ()), this, SLOT (SlotDrain ()));
+    }
+
+    /*!
+        \brief Disables the tracer and discards all captured emissions that have not been logged yet.
+    */
+    SignalTracer::~SignalTracer () {
+        SetEnabled (false);
+        QMutexLocker locker (&mMutex);
+        foreach (const ThreadBufferPtr& buffer, mBuffers) {
+            if (SignalCapture* capture = buffer->Capture ()) {
+                while (const SignalCapture::Record* record = capture->Front ()) {
+                    capture->Pop (GetSignal (record->mSpyId).mArgTypes);
+                }
+            }
+        }
+        for (int c=0; c<kMaxChunkCount && mChunks [c]; ++c) {
+            delete [] mChunks [c];
+        }
+    }
+
+    /*!
+        \brief Enables or disables tracing, captured emissions are flushed when tracing is disabled.
+
+        Only one tracer can be enabled at a time. The callback must be registered with Qt
+        separately, see priv::SetSignalSpyCallbacks.
+    */
+    void SignalTracer::SetEnabled (bool inEnabled) {
+        if (inEnabled) {
+            sEnabledTracer.fetchAndStoreOrdered (this);
+            mDrainTimer.start (SignalLogger::kDrainInterval);
+        }
+        else {
+            sEnabledTracer.testAndSetOrdered (this, 0);
+            mDrainTimer.stop ();
+            Flush ();
+        }
+    }
+
+    /*!
+        \brief Returns true when this tracer receives the callbacks.
+    */
+    bool SignalTracer::IsEnabled () const {
+        return sEnabledTracer == this;
+    }
+
+    /*!
+        \brief Replaces the filter, the new filter applies to all following emissions.
+    */
+    void SignalTracer::SetFilter (const SignalTraceFilter& inFilter) {
+        QMutexLocker locker (&mMutex);
+        mFilter = inFilter;
+        mGeneration.ref ();
+    }
+
+    /*!
+        \brief Returns the current filter.
+    */
+    const SignalTraceFilter& SignalTracer::Filter () const {
+        return mFilter;
+    }
+
+    /*!
+        \brief Returns the cost of tracing since the tracer was created.
+    */
+    const SignalTracer::Statistics& SignalTracer::GetStatistics () const {
+        return mStatistics;
+    }
+
+    /*!
+        \brief Writes all captured emissions to the logger, merged in timestamp order.
+
+        Only the emissions that were captured before the call are logged. Buffers of finished
+        threads are removed once they have been drained.
+    */
+    void SignalTracer::Flush () {
+        // emissions caused by logging are not traced
+        ThreadState& state = LocalState ();
+        state.mSuspended = true;
+
+        QList <ThreadBufferPtr> buffers;
+        {
+            QMutexLocker locker (&mMutex);
+            buffers = mBuffers;
+        }
+        // the orphaned state must be read before the counts, so no records can follow
+        QVector <bool> orphaned (buffers.size ());
+        QVector <SignalCapture*> captures (buffers.size ());
+        QVector <int> remaining (buffers.size ());
+        for (int b=0; b<buffers.size (); ++b) {
+            ThreadBuffer& buffer = *buffers [b];
+            orphaned [b] = buffer.mOrphaned.fetchAndAddAcquire (0) != 0;
+            captures [b] = buffer.Capture ();
+            remaining [b] = captures [b] ? captures [b]->Count () : 0;
+            int filtered = buffer.mFiltered.fetchAndStoreRelaxed (0);
+            int filteredCost = buffer.mFilteredCost.fetchAndStoreRelaxed (0);
+            int overflowed = buffer.mOverflowed.fetchAndStoreRelaxed (0);
+            int dropped = captures [b] ? captures [b]->TakeDroppedCount () : 0;
+            if (filtered || overflowed || dropped) {
+                mStatistics.mFiltered += filtered;
+                mStatistics.mFilteredCost += filteredCost * Q_INT64_C (1000);
+                mStatistics.mOverflowed += overflowed;
+                mStatistics.mDropped += dropped;
+                mStatisticsChanged = true;
+            }
+        }
+        // merge the buffers, each buffer is already in timestamp order
+        forever {
+            int next = -1;
+            for (int b=0; b<buffers.size (); ++b) {
+                if (remaining [b] && (next < 0 || captures [b]->Front ()->mTimestamp < captures [next]->Front ()->mTimestamp)) {
+                    next = b;
+                }
+            }
+            if (next < 0) {
+                break;
+            }
+            SignalCapture& capture = *captures [next];
+            const SignalCapture::Record* record = capture.Front ();
+            TracedSignal& traced = GetSignal (record->mSpyId);
+            if (traced.mLoggerId < 0) {
+                traced.mLoggerId = mLogger->RegisterSpy (traced.mSignalData, traced.mArgTypes);
+            }
+            mLogger->LogCaptured (traced.mLoggerId, *record, capture.ThreadName ());
+            ++mStatistics.mTraced;
+            mStatistics.mTracedCost += record->mCost;
+            mStatisticsChanged = true;
+            capture.Pop (traced.mArgTypes);
+            --remaining [next];
+        }
+
+        // remove the drained buffers of finished threads
+        {
+            QMutexLocker locker (&mMutex);
+            for (int b=0; b<buffers.size (); ++b) {
+                if (orphaned [b] && (!captures [b] || !captures [b]->Count ())) {
+                    mBuffers.removeAll (buffers [b]);
+                }
+            }
+            // retire the signals of destroyed senders, so an object at a reused address gets a new traced signal
+            for (int s=0; s<mSignalCount; ++s) {
+                TracedSignal& traced = GetSignal (s);
+                if (traced.mSender && !traced.mSignalData.Object ()) {
+                    traced.mSender.fetchAndStoreOrdered (0);
+                }
+            }
+        }
+        state.mSuspended = false;
+    }
+
+    /*!
+        \brief The signal begin callback of Qt, called at the start of every signal emission by the emitting thread.
+
+        The arguments are passed as received by qt_metacall, including the return value.
+    */
+    void SignalTracer::SignalBegin (QObject* inSender, int inMethodIndex, void** inArgs) {
+        qint64 start = Clock::Now ();
+        if (SignalTracer* tracer = sEnabledTracer) {
+            tracer->Trace (inSender, inMethodIndex, inArgs, start);
+        }
+    }
+
+    /*!
+        \brief Logs the captured emissions, and reports changed statistics.
+    */
+    void SignalTracer::SlotDrain () {
+        Flush ();
+        if (mStatisticsChanged) {
+            mStatisticsChanged = false;
+            emit SignalStatisticsChanged ();
+        }
+    }
+
+    /*!
+        \brief Returns the state of the current thread, it is created on first use.
+    */
+    SignalTracer::ThreadState& SignalTracer::LocalState () {
+        if (!mThreadState.hasLocalData ()) {
+            ThreadBufferPtr buffer (new ThreadBuffer ());
+            {
+                QMutexLocker locker (&mMutex);
+                mBuffers.push_back (buffer);
+            }
+            mThreadState.setLocalData (new ThreadState (buffer));
+        }
+        return *mThreadState.localData ();
+    }
+
+    /*!
+        \brief Filters a single emission and captures it when it passes, see SignalBegin.
+    */
+    void SignalTracer::Trace (QObject* inSender, int inMethodIndex, void** inArgs, qint64 inStart) {
+        ThreadState& state = LocalState ();
+        if (state.mSuspended || !inSender) {
+            return;
+        }
+        // refresh the decisions of this thread after the filter changed
+        int generation = mGeneration;
+        if (state.mGeneration != generation) {
+            QMutexLocker locker (&mMutex);
+            state.mGeneration = mGeneration;
+            state.mThreadAccepted = mFilter.MatchesThread ();
+            state.mRoots = mFilter.mRoots;
+            state.mDecisions.clear ();
+        }
+
+        bool accepted = state.mThreadAccepted;
+        if (accepted) {
+            MethodKey key (inSender->metaObject (), inMethodIndex);
+            QHash <MethodKey, bool>::iterator decision = state.mDecisions.find (key);
+            if (decision == state.mDecisions.end ()) {
+                QMutexLocker locker (&mMutex);
+                decision = state.mDecisions.insert (key, mFilter.MatchesSignal (key.first, inMethodIndex));
+            }
+            accepted = decision.value () && !mIgnored.contains (inSender) && InHierarchy (inSender, state.mRoots);
+        }
+        if (!accepted) {
+            state.mPendingCost += Clock::Now () - inStart;
+            state.mBuffer->mFiltered.ref ();
+            if (state.mPendingCost >= 1000) {
+                state.mBuffer->mFilteredCost.fetchAndAddRelaxed (static_cast <int> (state.mPendingCost / 1000));
+                state.mPendingCost %= 1000;
+            }
+            return;
+        }
+
+        SignalKey key (inSender, inMethodIndex);
+        int signal = state.mSignals.value (key, -1);
+        // compares the raw address, the sender is retired by the gui thread once it has been destroyed
+        if (signal < 0 || static_cast <const QObject*> (GetSignal (signal).mSender) != inSender) {
+            signal = FindOrAddSignal (inSender, inMethodIndex);
+            if (signal < 0) {
+                state.mBuffer->mOverflowed.ref ();
+                return;
+            }
+            state.mSignals.insert (key, signal);
+        }
+        TracedSignal& traced = GetSignal (signal);
+        unsigned emitCount = static_cast <unsigned> (traced.mEmitCount.fetchAndAddRelaxed (1)) + 1;
+        if (!mLogger->IsLoggingEnabled () || !mLogger->GetSampler ().Sample (inStart)) {
+            return;
+        }
+        // skip the return value
+        state.LocalCapture ().Push (signal, emitCount, inStart, traced.mArgTypes, inArgs + 1);
+    }
+
+    /*!
+        \brief Returns true when the given sender is part of one of the given hierarchies, or when there are no hierarchies.
+    */
+    bool SignalTracer::InHierarchy (const QObject* inSender, const QList <const QObject*>& inRoots) {
+        if (inRoots.isEmpty ()) {
+            return true;
+        }
+        for (const QObject* object = inSender; object; object = object->parent ()) {
+            if (inRoots.contains (object)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*!
+        \brief Returns the traced signal of the given sender and method index, it is created on first use.
+
+        Returns -1 when the maximum number of traced signals has been reached, the caller counts
+        the emission in Statistics::mOverflowed.
+    */
+    int SignalTracer::FindOrAddSignal (const QObject* inSender, int inMethodIndex) {
+        QMutexLocker locker (&mMutex);
+        SignalKey key (inSender, inMethodIndex);
+        int signal = mSignalIndex.value (key, -1);
+        if (signal >= 0 && static_cast <const QObject*> (GetSignal (signal).mSender) == inSender) {
+            return signal;
+        }
+        int chunk = mSignalCount / kChunkSize;
+        if (chunk >= kMaxChunkCount) {
+            return -1;
+        }
+        if (!mChunks [chunk]) {
+            mChunks [chunk] = new TracedSignal [kChunkSize];
+        }
+        signal = mSignalCount++;
+        TracedSignal& traced = GetSignal (signal);
+        const QMetaObject* metaObject = inSender->metaObject ();
+        traced.mSignalData = MethodData (mRecords.Object (inSender), mRecords.Method (metaObject, inMethodIndex));
+        traced.mSender.fetchAndStoreOrdered (inSender);
+
+        MethodKey methodKey (metaObject, inMethodIndex);
+        if (!mArgTypes.contains (methodKey)) {
+            QVector <int> argTypes;
+            foreach (const QByteArray& type, metaObject->method (inMethodIndex).parameterTypes ()) {
+                argTypes << QMetaType::type (type.constData ());
+            }
+            mArgTypes.insert (methodKey, argTypes);
+        }
+        traced.mArgTypes = mArgTypes.value (methodKey);
+        mSignalIndex.insert (key, signal);
+        return signal;
+    }
+
+    /*!
+        \brief Returns the given traced signal, its chunk must have been allocated.
+    */
+    SignalTracer::TracedSignal& SignalTracer::GetSignal (int inSignal) const {
+        return mChunks [inSignal / kChunkSize][inSignal % kChunkSize];
+    }
+
+} // namespace conan
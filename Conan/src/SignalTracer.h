@@ -0,0 +1,236 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains SignalTracer related declarations
+*/
+
+
+#ifndef _SIGNALTRACER__17_10_26__19_27_14__H_
+#define _SIGNALTRACER__17_10_26__19_27_14__H_
+
+
+#include "ConnectionModel.h"
+#include "MethodTable.h"
+#include "SignalCapture.h"
+#include <QtCore/QAtomicInt>
+#include <QtCore/QAtomicPointer>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QPair>
+#include <QtCore/QRegExp>
+#include <QtCore/QSet>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QStringList>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
+
+
+namespace conan {
+
+    class SignalLogger;
+
+    /*!
+        \brief Selects the signal emissions that are traced by a SignalTracer.
+
+        A filter consists of terms separated by white space, each of the form field:value:
+        - class:name, the class of the sender or one of its base classes is named name
+        - signal:pattern, the name of the signal matches the wildcard pattern, f.e: *Changed
+        - thread:name, the emitting thread has the given object name, or is the main thread for 'main'
+
+        Terms of the same field are alternatives, terms of different fields must all match. In
+        addition the tracer can be limited to the object hierarchies of one or more root objects.
+        An empty filter matches all emissions.
+    */
+    class CONAN_LOCAL SignalTraceFilter {
+    public:
+        SignalTraceFilter ();
+
+        static SignalTraceFilter Parse (const QString& inText, QString* outError = 0);
+
+        bool IsEmpty () const;
+        bool MatchesSignal (const QMetaObject* inMetaObject, int inMethodIndex) const;
+        bool MatchesThread () const;
+
+        QStringList mClasses;               //!< The accepted class names, empty accepts all classes
+        QList <QRegExp> mSignals;           //!< The accepted signal name patterns, empty accepts all signals
+        QStringList mThreads;               //!< The accepted thread names, empty accepts all threads
+        QList <const QObject*> mRoots;      //!< The accepted object hierarchies, empty accepts all objects, never dereferenced
+    };
+
+
+    // --------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Traces the signal emissions of the whole process through the signal spy callbacks of Qt.
+
+        Qt calls a single global callback at the start of every signal emission, see
+        priv::SetSignalSpyCallbacks. While the tracer is enabled, SignalBegin filters each
+        emission and captures the emissions that pass into a SignalCapture buffer of the
+        emitting thread, without creating a SignalSpy or a connection. The buffer is created on
+        the first emission of the thread that passes the filter. The tracer drains all
+        buffers periodically in timestamp order and writes the emissions to its SignalLogger.
+
+        Filtering is done in order of cost: the thread, the class and the signal are decided
+        once per thread for each thread and each signal of each class. The hierarchy filter walks
+        the parents of the sender, so it is only applied to emissions that passed the other
+        filters. The time spent within the callback is measured, both for filtered and for
+        captured emissions, see Statistics.
+
+        Each distinct (sender, signal) pair is registered once, after which emitting threads find
+        it in a cache of their own. Emissions of the tracer and its logger are never traced.
+        Only one tracer can be enabled at a time. Traced emissions are only captured while logging
+        of the logger is enabled, and they are sampled by the sampler of the logger, see
+        SignalLogger::GetSampler.
+    */
+    class CONAN_LOCAL SignalTracer : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        static const int kChunkSize = 256;          //!< The number of traced signals that are allocated at once
+        static const int kMaxChunkCount = 4096;     //!< Limits the number of traced signals to kChunkSize * kMaxChunkCount
+
+        /*!
+            \brief Measures the cost of tracing.
+        */
+        struct CONAN_LOCAL Statistics {
+            Statistics ();
+
+            quint64 mTraced;            //!< The number of traced emissions
+            quint64 mFiltered;          //!< The number of emissions rejected by the filter
+            quint64 mDropped;           //!< The number of emissions dropped because a capture buffer was full
+            quint64 mOverflowed;        //!< The number of emissions dropped because kChunkSize * kMaxChunkCount signals are traced
+            qint64 mTracedCost;         //!< The total time spent capturing traced emissions, in ns
+            qint64 mFilteredCost;       //!< The total time spent rejecting filtered emissions, in ns
+        };
+
+        SignalTracer (SignalLogger* inLogger, QObject* inParent = 0);
+        virtual ~SignalTracer ();
+
+        void SetEnabled (bool inEnabled);
+        bool IsEnabled () const;
+        void SetFilter (const SignalTraceFilter& inFilter);
+        const SignalTraceFilter& Filter () const;
+
+        const Statistics& GetStatistics () const;
+        void Flush ();
+
+        static void SignalBegin (QObject* inSender, int inMethodIndex, void** inArgs);
+
+    signals:
+        //! \brief Emitted periodically when the statistics have changed.
+        void SignalStatisticsChanged ();
+
+    private slots:
+        void SlotDrain ();
+
+    private:
+        /*!
+            \brief A single traced (sender, signal) pair.
+        */
+        struct CONAN_LOCAL TracedSignal {
+            TracedSignal ();
+
+            QAtomicPointer <const QObject> mSender; //!< The address of the sender, never dereferenced; 0 once the sender was destroyed
+            MethodData mSignalData;     //!< Information about the signal, set once under mMutex and read by the gui thread
+            QVector <int> mArgTypes;    //!< The QMetaType types for the argument list of the signal
+            QAtomicInt mEmitCount;      //!< The number of traced emissions
+            int mLoggerId;              //!< The id of the signal in the logger, or -1 when not registered yet
+        };
+
+        /*!
+            \brief The capture buffer and filter counters of a single thread, shared with the tracer.
+
+            The capture buffer is only created on the first traced emission of the thread, so
+            threads whose emissions are all filtered do not allocate one.
+        */
+        struct CONAN_LOCAL ThreadBuffer {
+            ThreadBuffer ();
+            ~ThreadBuffer ();
+
+            SignalCapture* Capture () const;
+
+            QAtomicPointer <SignalCapture> mCapture;    //!< The captured emissions, the signal id is the index of the TracedSignal; 0 until the first traced emission
+            QAtomicInt mFiltered;       //!< The number of filtered emissions since the last drain
+            QAtomicInt mFilteredCost;   //!< The time spent on filtered emissions since the last drain, in us
+            QAtomicInt mOverflowed;     //!< The number of emissions since the last drain whose signal could not be traced
+            QAtomicInt mOrphaned;       //!< Non zero when the thread will not trace any more emissions
+        };
+
+        typedef QSharedPointer <ThreadBuffer> ThreadBufferPtr;
+        typedef QPair <const QMetaObject*, int> MethodKey;
+        typedef QPair <const void*, int> SignalKey;
+
+        /*!
+            \brief The private state of a single emitting thread, orphans the buffer when the thread finishes.
+        */
+        struct CONAN_LOCAL ThreadState {
+            ThreadState (const ThreadBufferPtr& inBuffer);
+            ~ThreadState ();
+
+            SignalCapture& LocalCapture ();
+
+            ThreadBufferPtr mBuffer;            //!< The buffer, shared with the tracer which drains it
+            int mGeneration;                    //!< The filter generation of mDecisions, mThreadAccepted and mRoots
+            bool mThreadAccepted;               //!< True when the thread passes the filter
+            QList <const QObject*> mRoots;      //!< A copy of the hierarchy filter
+            bool mSuspended;                    //!< True while emissions of this thread are not traced
+            qint64 mPendingCost;                //!< Filter time in ns that has not been added to mBuffer yet
+            QHash <MethodKey, bool> mDecisions; //!< map <(meta object, method index), accepted by the filter>
+            QHash <SignalKey, int> mSignals;    //!< map <(sender, method index), traced signal>
+        };
+
+        ThreadState& LocalState ();
+        void Trace (QObject* inSender, int inMethodIndex, void** inArgs, qint64 inStart);
+        static bool InHierarchy (const QObject* inSender, const QList <const QObject*>& inRoots);
+        int FindOrAddSignal (const QObject* inSender, int inMethodIndex);
+        TracedSignal& GetSignal (int inSignal) const;
+
+    private:
+        static QAtomicPointer <SignalTracer> sEnabledTracer;    //!< The tracer that receives the callbacks, or 0
+
+        SignalLogger* mLogger;                          //!< Performs the actual logging of each traced emission
+        SignalTraceFilter mFilter;                      //!< The current filter
+        QAtomicInt mGeneration;                         //!< Incremented whenever mFilter changes
+        mutable QMutex mMutex;                          //!< Protects mFilter, the traced signals and the buffers
+        TracedSignal* mChunks [kMaxChunkCount];         //!< The allocated traced signal chunks, 0 when not allocated yet
+        int mSignalCount;                               //!< The number of traced signals
+        QHash <SignalKey, int> mSignalIndex;            //!< map <(sender, method index), traced signal>
+        MethodTable mRecords;                           //!< Shares the object and method records of all traced signals
+        QHash <MethodKey, QVector <int> > mArgTypes;    //!< map <(meta object, method index), argument types>
+        QList <ThreadBufferPtr> mBuffers;               //!< The buffers of all threads
+        QThreadStorage <ThreadState*> mThreadState;     //!< The state of the current thread
+        QSet <const void*> mIgnored;                    //!< Objects whose emissions are never traced
+        QTimer mDrainTimer;                             //!< Periodically drains mBuffers
+        Statistics mStatistics;                         //!< Measures the cost of tracing
+        bool mStatisticsChanged;                        //!< Indicates if mStatistics changed since the last report
+    };
+
+} // namespace conan
+
+
+#endif //_SIGNALTRACER__17_10_26__19_27_14__H_
@@ -0,0 +1,519 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains SlotProfiler related definitions
+*/
+
+
+#include "Clock.h"
+#include "SlotProfiler.h"
+#include <QtCore/QMetaObject>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+#include <QtCore/QTextStream>
+
+
+namespace conan {
+
+    namespace /*unnamed*/ {
+        /*!
+            \brief Returns the given text as a CSV field, quoted when it contains a separator, a quote or a line break.
+        */
+        QString CsvField (const QString& inText) {
+            if (inText.contains (',') || inText.contains ('"') || inText.contains ('\n')) {
+                return '"' + QString (inText).replace ("\"", "\"\"") + '"';
+            }
+            return inText;
+        }
+    } // unnamed namespace
+
+
+    /*!
+        \brief Creates an empty profile without a slot.
+    */
+    SlotProfile::SlotProfile () :
+        mSenderClass (0),
+        mReceiverClass (0),
+        mCalls (0),
+        mWallTotal (0),
+        mCpuTotal (0)
+    {}
+
+    /*!
+        \brief Counts a single invocation with the given wall clock and CPU time in ns.
+    */
+    void SlotProfile::Add (qint64 inWallTime, qint64 inCpuTime) {
+        ++mCalls;
+        mWallTotal += inWallTime;
+        mCpuTotal += inCpuTime;
+        mWallTimes.Add (inWallTime);
+        mCpuTimes.Add (inCpuTime);
+    }
+
+    /*!
+        \brief Adds the invocations of the given profile, and takes over its signal and slot when this profile has none.
+    */
+    void SlotProfile::Merge (const SlotProfile& inOther) {
+        if (!mSlot) {
+            mSenderClass = inOther.mSenderClass;
+            mSignal = inOther.mSignal;
+            mReceiverClass = inOther.mReceiverClass;
+            mSlot = inOther.mSlot;
+        }
+        mCalls += inOther.mCalls;
+        mWallTotal += inOther.mWallTotal;
+        mCpuTotal += inOther.mCpuTotal;
+        mWallTimes.Merge (inOther.mWallTimes);
+        mCpuTimes.Merge (inOther.mCpuTimes);
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    QAtomicPointer <SlotProfiler> SlotProfiler::sEnabledProfiler;
+
+    SlotProfiler::ThreadProfile::ThreadProfile () :
+        mOrphaned (0)
+    {}
+
+    /*!
+        \brief Creates the state of a thread.
+    */
+    SlotProfiler::ThreadState::ThreadState (const ThreadProfilePtr& inProfile) :
+        mProfile (inProfile),
+        mGeneration (-1)
+    {}
+
+    /*!
+        \brief Called when the thread finishes, the profiler removes the profile once it has been collected.
+    */
+    SlotProfiler::ThreadState::~ThreadState () {
+        mProfile->mOrphaned.fetchAndStoreOrdered (1);
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Creates a disabled profiler.
+    */
+    SlotProfiler::SlotProfiler () :
+        mGeneration (0)
+    {}
+
+    /*!
+        \brief Disables the profiler.
+    */
+    SlotProfiler::~SlotProfiler () {
+        SetEnabled (false);
+    }
+
+    /*!
+        \brief Enables or disables profiling.
+
+        Only one profiler can be enabled at a time. The callbacks must be registered with Qt
+        separately, see priv::SetSignalSpyCallbacks. Invocations that are in progress while the
+        profiler is enabled are not measured.
+    */
+    void SlotProfiler::SetEnabled (bool inEnabled) {
+        if (inEnabled) {
+            mGeneration.ref ();
+            sEnabledProfiler.fetchAndStoreOrdered (this);
+        }
+        else {
+            sEnabledProfiler.testAndSetOrdered (this, 0);
+        }
+    }
+
+    /*!
+        \brief Returns true when this profiler receives the callbacks.
+    */
+    bool SlotProfiler::IsEnabled () const {
+        return sEnabledProfiler == this;
+    }
+
+    /*!
+        \brief Moves the invocations that were measured since the previous call into the given profiles.
+
+        Returns true when any invocation was added. Profiles of finished threads are removed
+        once they have been collected.
+    */
+    bool SlotProfiler::Collect (Profiles& ioProfiles) {
+        QList <ThreadProfilePtr> profiles;
+        {
+            QMutexLocker locker (&mMutex);
+            profiles = mProfiles;
+        }
+        bool changed = false;
+        foreach (const ThreadProfilePtr& profile, profiles) {
+            // the orphaned state must be read first, so no invocations can follow
+            bool orphaned = profile->mOrphaned != 0;
+            Profiles collected;
+            {
+                QMutexLocker locker (&profile->mMutex);
+                collected.swap (profile->mProfiles);
+            }
+            for (Profiles::const_iterator p=collected.constBegin (); p!=collected.constEnd (); ++p) {
+                ioProfiles [p.key ()].Merge (p.value ());
+                changed = true;
+            }
+            if (orphaned) {
+                QMutexLocker locker (&mMutex);
+                mProfiles.removeAll (profile);
+            }
+        }
+        return changed;
+    }
+
+    /*!
+        \brief The signal begin callback of Qt, pushes the emission onto the stack of the thread.
+    */
+    void SlotProfiler::SignalBegin (QObject* inSender, int inMethodIndex, void** /*inArgs*/) {
+        if (SlotProfiler* profiler = sEnabledProfiler) {
+            Emission emission;
+            emission.mSender = inSender;
+            emission.mSignal = MethodKey (inSender->metaObject (), inMethodIndex);
+            profiler->LocalState ().mEmissions.push_back (emission);
+        }
+    }
+
+    /*!
+        \brief The signal end callback of Qt, pops the emission from the stack of the thread.
+
+        Emissions above it on the stack, which did not end because of an exception, are popped as well.
+    */
+    void SlotProfiler::SignalEnd (QObject* inSender, int inMethodIndex) {
+        if (SlotProfiler* profiler = sEnabledProfiler) {
+            QVector <Emission>& emissions = profiler->LocalState ().mEmissions;
+            for (int e=emissions.size ()-1; e>=0; --e) {
+                if (emissions [e].mSender == inSender && emissions [e].mSignal.second == inMethodIndex) {
+                    emissions.resize (e);
+                    break;
+                }
+            }
+        }
+    }
+
+    /*!
+        \brief The slot begin callback of Qt, starts measuring the invocation.
+    */
+    void SlotProfiler::SlotBegin (QObject* inReceiver, int inMethodIndex, void** /*inArgs*/) {
+        if (SlotProfiler* profiler = sEnabledProfiler) {
+            ThreadState& state = profiler->LocalState ();
+            Invocation invocation;
+            invocation.mReceiver = inReceiver;
+            invocation.mEdge.first = state.mEmissions.isEmpty () ? MethodKey (0, -1) : state.mEmissions.last ().mSignal;
+            invocation.mEdge.second = MethodKey (inReceiver->metaObject (), inMethodIndex);
+            invocation.mCpuStart = Clock::ThreadCpuNow ();
+            invocation.mWallStart = Clock::Now ();
+            state.mInvocations.push_back (invocation);
+        }
+    }
+
+    /*!
+        \brief The slot end callback of Qt, adds the invocation to the profile of the thread.
+
+        The receiver may have been destroyed by the slot, so it is only compared.
+    */
+    void SlotProfiler::SlotEnd (QObject* inReceiver, int inMethodIndex) {
+        if (SlotProfiler* profiler = sEnabledProfiler) {
+            qint64 wallEnd = Clock::Now ();
+            qint64 cpuEnd = Clock::ThreadCpuNow ();
+            ThreadState& state = profiler->LocalState ();
+            for (int i=state.mInvocations.size ()-1; i>=0; --i) {
+                const Invocation& invocation = state.mInvocations [i];
+                if (invocation.mReceiver != inReceiver || invocation.mEdge.second.second != inMethodIndex) {
+                    continue;
+                }
+                {
+                    QMutexLocker locker (&state.mProfile->mMutex);
+                    Profiles::iterator profile = state.mProfile->mProfiles.find (invocation.mEdge);
+                    if (profile == state.mProfile->mProfiles.end ()) {
+                        SlotProfile added;
+                        const MethodKey& signal = invocation.mEdge.first;
+                        if (signal.first) {
+                            added.mSenderClass = signal.first->className ();
+                            added.mSignal = MethodRecordPtr (new MethodRecord (signal.first, signal.second));
+                        }
+                        const MethodKey& slot = invocation.mEdge.second;
+                        added.mReceiverClass = slot.first->className ();
+                        added.mSlot = MethodRecordPtr (new MethodRecord (slot.first, slot.second));
+                        profile = state.mProfile->mProfiles.insert (invocation.mEdge, added);
+                    }
+                    profile->Add (wallEnd - invocation.mWallStart, cpuEnd - invocation.mCpuStart);
+                }
+                state.mInvocations.resize (i);
+                break;
+            }
+        }
+    }
+
+    /*!
+        \brief Returns the state of the current thread, it is created on first use.
+
+        The stacks are cleared when the profiler was enabled again, as the callbacks of the
+        emissions and invocations on the stacks may have been missed.
+    */
+    SlotProfiler::ThreadState& SlotProfiler::LocalState () {
+        if (!mThreadState.hasLocalData ()) {
+            ThreadProfilePtr profile (new ThreadProfile ());
+            {
+                QMutexLocker locker (&mMutex);
+                mProfiles.push_back (profile);
+            }
+            mThreadState.setLocalData (new ThreadState (profile));
+        }
+        ThreadState& state = *mThreadState.localData ();
+        int generation = mGeneration;
+        if (state.mGeneration != generation) {
+            state.mGeneration = generation;
+            state.mEmissions.clear ();
+            state.mInvocations.clear ();
+        }
+        return state;
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Creates an empty model, which groups by slot.
+    */
+    SlotProfileModel::SlotProfileModel (QObject* inParent) :
+        QAbstractTableModel (inParent),
+        mGroupBySignal (false),
+        mRefreshTimer (this)
+    {
+        connect (&mRefreshTimer, SIGNAL (timeout ()), this, SLOT (SlotRefresh ()));
+        mRefreshTimer.start (kRefreshInterval);
+    }
+
+    /*!
+        \brief Returns the profiler whose invocations are listed.
+    */
+    SlotProfiler& SlotProfileModel::GetProfiler () {
+        return mProfiler;
+    }
+
+    /*!
+        \brief Lists each (signal, slot) edge in a row of its own when true, otherwise lists each slot.
+    */
+    void SlotProfileModel::SetGroupBySignal (bool inGroupBySignal) {
+        if (mGroupBySignal == inGroupBySignal) {
+            return;
+        }
+        beginResetModel ();
+        mGroupBySignal = inGroupBySignal;
+        mRows.clear ();
+        mRowIndex.clear ();
+        endResetModel ();
+        for (SlotProfiler::Profiles::const_iterator e=mEdges.constBegin (); e!=mEdges.constEnd (); ++e) {
+            AddToRows (e.key (), e.value ());
+        }
+    }
+
+    /*!
+        \brief Returns true when each row is a (signal, slot) edge.
+    */
+    bool SlotProfileModel::IsGroupBySignal () const {
+        return mGroupBySignal;
+    }
+
+    /*!
+        \brief Discards all measured invocations.
+    */
+    void SlotProfileModel::Clear () {
+        SlotProfiler::Profiles discarded;
+        mProfiler.Collect (discarded);
+        beginResetModel ();
+        mEdges.clear ();
+        mRows.clear ();
+        mRowIndex.clear ();
+        endResetModel ();
+    }
+
+    /*!
+        \brief Writes all rows to the given stream as comma separated values, with the column titles on the first line.
+
+        Times are written in the units of the column titles.
+    */
+    void SlotProfileModel::Export (QTextStream& ioStream) const {
+        QStringList fields;
+        for (int c=0; c<kColumnCount; ++c) {
+            fields.push_back (CsvField (headerData (c, Qt::Horizontal).toString ()));
+        }
+        ioStream << fields.join (",") << '\n';
+        foreach (const SlotProfile& profile, mRows) {
+            fields.clear ();
+            for (int c=0; c<kColumnCount; ++c) {
+                fields.push_back (CsvField (Value (profile, c).toString ()));
+            }
+            ioStream << fields.join (",") << '\n';
+        }
+    }
+
+    int SlotProfileModel::rowCount (const QModelIndex& inParent) const {
+        return inParent.isValid () ? 0 : mRows.size ();
+    }
+
+    int SlotProfileModel::columnCount (const QModelIndex& inParent) const {
+        return inParent.isValid () ? 0 : kColumnCount;
+    }
+
+    /*!
+        \brief Returns the data stored under the given role for the item referred to by the index.
+    */
+    QVariant SlotProfileModel::data (const QModelIndex& inIndex, int inRole) const {
+        if (inIndex.isValid () && inRole == Qt::DisplayRole) {
+            return Value (mRows [inIndex.row ()], inIndex.column ());
+        }
+        return QVariant ();
+    }
+
+    /*!
+        \brief Returns the data for the given role and section in the header with the specified orientation.
+    */
+    QVariant SlotProfileModel::headerData (int inSection, Qt::Orientation inOrientation, int inRole) const {
+        if (inOrientation == Qt::Horizontal && inRole == Qt::DisplayRole) {
+            switch (inSection) {
+                case kSlot:
+                    return QString ("Slot");
+                case kReceiver:
+                    return QString ("Receiver");
+                case kSignal:
+                    return QString ("Signal");
+                case kCalls:
+                    return QString ("Calls");
+                case kWallTotal:
+                    return QString ("Wall total (ms)");
+                case kWallMedian:
+                    return QString ("Wall p50 (us)");
+                case kWallP99:
+                    return QString ("Wall p99 (us)");
+                case kCpuTotal:
+                    return QString ("CPU total (ms)");
+                case kCpuMedian:
+                    return QString ("CPU p50 (us)");
+                case kCpuP99:
+                    return QString ("CPU p99 (us)");
+                default:
+                    return QVariant ();
+            }
+        }
+        if (inOrientation == Qt::Horizontal && inRole == Qt::ToolTipRole) {
+            switch (inSection) {
+                case kSignal:
+                    return QString ("The signal that invoked the slot, only when grouped by signal");
+                case kWallTotal:
+                case kWallMedian:
+                case kWallP99:
+                    return QString ("The wall clock time spent within the slot, including nested emissions");
+                case kCpuTotal:
+                case kCpuMedian:
+                case kCpuP99:
+                    return QString ("The CPU time the invoking thread spent within the slot, including nested emissions");
+                default:
+                    return QVariant ();
+            }
+        }
+        return QVariant ();
+    }
+
+    /*!
+        \brief Adds the invocations that were measured since the previous refresh.
+    */
+    void SlotProfileModel::SlotRefresh () {
+        SlotProfiler::Profiles collected;
+        if (!mProfiler.Collect (collected)) {
+            return;
+        }
+        int rowCount = mRows.size ();
+        for (SlotProfiler::Profiles::const_iterator c=collected.constBegin (); c!=collected.constEnd (); ++c) {
+            mEdges [c.key ()].Merge (c.value ());
+            AddToRows (c.key (), c.value ());
+        }
+        // new rows have been inserted already
+        if (rowCount) {
+            emit dataChanged (index (0, kCalls), index (rowCount - 1, kColumnCount - 1));
+        }
+    }
+
+    /*!
+        \brief Adds the given profile of an edge to the row of the edge or of its slot, the row is inserted when needed.
+    */
+    void SlotProfileModel::AddToRows (const SlotProfiler::EdgeKey& inEdge, const SlotProfile& inProfile) {
+        SlotProfiler::EdgeKey rowKey = mGroupBySignal ? inEdge : SlotProfiler::EdgeKey (SlotProfiler::MethodKey (0, -1), inEdge.second);
+        QHash <SlotProfiler::EdgeKey, int>::const_iterator row = mRowIndex.find (rowKey);
+        if (row != mRowIndex.end ()) {
+            mRows [row.value ()].Merge (inProfile);
+            return;
+        }
+        SlotProfile profile = inProfile;
+        if (!mGroupBySignal) {
+            profile.mSenderClass = 0;
+            profile.mSignal = MethodRecordPtr ();
+        }
+        beginInsertRows (QModelIndex (), mRows.size (), mRows.size ());
+        mRowIndex.insert (rowKey, mRows.size ());
+        mRows.push_back (profile);
+        endInsertRows ();
+    }
+
+    /*!
+        \brief Returns the value of the given column for the given profile, times in ms for totals and in us for percentiles.
+    */
+    QVariant SlotProfileModel::Value (const SlotProfile& inProfile, int inColumn) const {
+        switch (inColumn) {
+            case kSlot:
+                return QString::fromLatin1 (inProfile.mSlot->mSignature);
+            case kReceiver:
+                return QString::fromLatin1 (inProfile.mReceiverClass);
+            case kSignal:
+                if (!inProfile.mSignal) {
+                    return QVariant ();
+                }
+                return QString ("%1::%2").arg (inProfile.mSenderClass).arg (inProfile.mSignal->mSignature);
+            case kCalls:
+                return inProfile.mCalls;
+            case kWallTotal:
+                return qRound64 (inProfile.mWallTotal / 1000.0) / 1000.0;
+            case kCpuTotal:
+                return qRound64 (inProfile.mCpuTotal / 1000.0) / 1000.0;
+            case kWallMedian:
+            case kWallP99:
+            case kCpuMedian:
+            case kCpuP99: {
+                const DurationHistogram& times = (inColumn == kWallMedian || inColumn == kWallP99) ? inProfile.mWallTimes : inProfile.mCpuTimes;
+                qint64 time = times.Percentile ((inColumn == kWallMedian || inColumn == kCpuMedian) ? 50 : 99);
+                return time < 0 ? QVariant () : QVariant (qRound64 (time / 10.0) / 100.0);
+            }
+            default:
+                return QVariant ();
+        }
+    }
+
+} // namespace conan
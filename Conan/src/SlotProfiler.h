@@ -0,0 +1,229 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains SlotProfiler related declarations
+*/
+
+
+#ifndef _SLOTPROFILER__17_10_26__20_24_05__H_
+#define _SLOTPROFILER__17_10_26__20_24_05__H_
+
+
+#include "DurationHistogram.h"
+#include "MethodTable.h"
+#include <QtCore/QAbstractTableModel>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QAtomicPointer>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QPair>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
+
+
+class QTextStream;
+
+
+namespace conan {
+
+    /*!
+        \brief The execution time statistics of a slot, invoked by a single signal or by any signal.
+
+        Times are inclusive, they contain the time spent in nested emissions and slots.
+    */
+    struct CONAN_LOCAL SlotProfile {
+        SlotProfile ();
+
+        void Add (qint64 inWallTime, qint64 inCpuTime);
+        void Merge (const SlotProfile& inOther);
+
+        const char* mSenderClass;       //!< The class name of the sender, or 0 for any sender
+        MethodRecordPtr mSignal;        //!< The signal that invoked the slot, or 0 for any signal
+        const char* mReceiverClass;     //!< The class name of the receiver
+        MethodRecordPtr mSlot;          //!< The invoked slot
+        quint64 mCalls;                 //!< The number of invocations
+        qint64 mWallTotal;              //!< The total wall clock time, in ns
+        qint64 mCpuTotal;               //!< The total CPU time of the invoking thread, in ns
+        DurationHistogram mWallTimes;   //!< The wall clock time of each invocation
+        DurationHistogram mCpuTimes;    //!< The CPU time of each invocation
+    };
+
+
+    // --------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Measures the wall clock and thread CPU time of every slot invocation through the signal spy callbacks of Qt.
+
+        Qt calls the slot begin and end callbacks around each slot that is invoked by a direct
+        connection, in the thread of the emission. Slots of queued connections are invoked
+        without callbacks and are not measured. The signal begin and end callbacks maintain a
+        stack of emissions per thread, so each invocation is attributed to the signal that
+        caused it, see priv::SetSignalSpyCallbacks.
+
+        Invocations are aggregated per thread, per (sender class, signal, receiver class, slot)
+        edge, under a mutex that is only contended while the profile is being collected. Only
+        one profiler can be enabled at a time.
+    */
+    class CONAN_LOCAL SlotProfiler {
+    public:
+        typedef QPair <const QMetaObject*, int> MethodKey;
+        typedef QPair <MethodKey, MethodKey> EdgeKey;   //!< (sender class, signal), (receiver class, slot)
+        typedef QHash <EdgeKey, SlotProfile> Profiles;
+
+        SlotProfiler ();
+        ~SlotProfiler ();
+
+        void SetEnabled (bool inEnabled);
+        bool IsEnabled () const;
+        bool Collect (Profiles& ioProfiles);
+
+        static void SignalBegin (QObject* inSender, int inMethodIndex, void** inArgs);
+        static void SignalEnd (QObject* inSender, int inMethodIndex);
+        static void SlotBegin (QObject* inReceiver, int inMethodIndex, void** inArgs);
+        static void SlotEnd (QObject* inReceiver, int inMethodIndex);
+
+    private:
+        Q_DISABLE_COPY (SlotProfiler)
+
+        /*!
+            \brief The aggregated invocations of a single thread since the last collect.
+        */
+        struct CONAN_LOCAL ThreadProfile {
+            ThreadProfile ();
+
+            QMutex mMutex;              //!< Protects mProfiles
+            Profiles mProfiles;         //!< The aggregated invocations
+            QAtomicInt mOrphaned;       //!< Set when the thread finished
+        };
+
+        typedef QSharedPointer <ThreadProfile> ThreadProfilePtr;
+
+        //! \brief An emission in progress
+        struct CONAN_LOCAL Emission {
+            const void* mSender;        //!< The sender, never dereferenced
+            MethodKey mSignal;          //!< The class of the sender and the signal
+        };
+
+        //! \brief A slot invocation in progress
+        struct CONAN_LOCAL Invocation {
+            const void* mReceiver;      //!< The receiver, never dereferenced as it may be destroyed by the slot
+            EdgeKey mEdge;              //!< The invoking signal and the slot
+            qint64 mWallStart;          //!< The monotonic time at which the slot was invoked
+            qint64 mCpuStart;           //!< The CPU time of the thread at which the slot was invoked
+        };
+
+        /*!
+            \brief The private state of a single thread, orphans the profile when the thread finishes.
+        */
+        struct CONAN_LOCAL ThreadState {
+            ThreadState (const ThreadProfilePtr& inProfile);
+            ~ThreadState ();
+
+            ThreadProfilePtr mProfile;          //!< The profile, shared with the profiler which collects it
+            int mGeneration;                    //!< The profiler generation of the stacks
+            QVector <Emission> mEmissions;      //!< The emissions in progress, the innermost last
+            QVector <Invocation> mInvocations;  //!< The slot invocations in progress, the innermost last
+        };
+
+        ThreadState& LocalState ();
+
+    private:
+        static QAtomicPointer <SlotProfiler> sEnabledProfiler;  //!< The profiler that receives the callbacks, or 0
+
+        QAtomicInt mGeneration;                         //!< Incremented whenever the profiler is enabled, invalidates the stacks
+        QMutex mMutex;                                  //!< Protects mProfiles
+        QList <ThreadProfilePtr> mProfiles;             //!< The profiles of all threads
+        QThreadStorage <ThreadState*> mThreadState;     //!< The state of the current thread
+    };
+
+
+    // --------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief A model that lists the execution time statistics of the slots measured by a SlotProfiler.
+
+        Each row is either a slot, aggregated over all signals that invoked it, or a single
+        (signal, slot) edge. The profile is collected every kRefreshInterval ms; new rows are
+        appended and changes are reported by a single dataChanged for all rows. Numeric columns
+        return numbers, so the model can be sorted by a QSortFilterProxyModel.
+    */
+    class CONAN_LOCAL SlotProfileModel : public QAbstractTableModel
+    {
+        Q_OBJECT
+
+    public:
+        typedef enum COLUMNS {
+            kSlot,
+            kReceiver,
+            kSignal,
+            kCalls,
+            kWallTotal,
+            kWallMedian,
+            kWallP99,
+            kCpuTotal,
+            kCpuMedian,
+            kCpuP99,
+            kColumnCount
+        } Columns;
+
+        static const int kRefreshInterval = 1000;   //!< The interval in ms at which the profile is collected
+
+    public:
+        SlotProfileModel (QObject* inParent = 0);
+
+        SlotProfiler& GetProfiler ();
+        void SetGroupBySignal (bool inGroupBySignal);
+        bool IsGroupBySignal () const;
+        void Clear ();
+        void Export (QTextStream& ioStream) const;
+
+        // qt overrides
+        virtual int rowCount (const QModelIndex& inParent = QModelIndex ()) const;
+        virtual int columnCount (const QModelIndex& inParent = QModelIndex ()) const;
+        virtual QVariant data (const QModelIndex& inIndex, int inRole = Qt::DisplayRole) const;
+        virtual QVariant headerData (int inSection, Qt::Orientation inOrientation, int inRole = Qt::DisplayRole) const;
+
+    private slots:
+        void SlotRefresh ();
+
+    private:
+        void AddToRows (const SlotProfiler::EdgeKey& inEdge, const SlotProfile& inProfile);
+        QVariant Value (const SlotProfile& inProfile, int inColumn) const;
+
+        SlotProfiler mProfiler;                         //!< Measures the slot invocations
+        SlotProfiler::Profiles mEdges;                  //!< The collected profile of each edge
+        QVector <SlotProfile> mRows;                    //!< The profile of each row
+        QHash <SlotProfiler::EdgeKey, int> mRowIndex;   //!< map <edge or slot, row>
+        bool mGroupBySignal;                            //!< When true each row is an edge, otherwise a slot
+        QTimer mRefreshTimer;                           //!< Periodically collects the profile
+    };
+
+} // namespace conan
+
+
+#endif //_SLOTPROFILER__17_10_26__20_24_05__H_
@@ -0,0 +1,430 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains TraceRecorder related definitions
+*/
+
+
+#include "Clock.h"
+#include "ObjectUtility.h"
+#include "TraceRecorder.h"
+#include <QtCore/QCoreApplication>
+#include <QtCore/QMetaMethod>
+#include <QtCore/QMetaObject>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QThread>
+
+
+namespace conan {
+
+    namespace /*unnamed*/ {
+        /*!
+            \brief Appends the given text as a JSON string, including the quotes.
+        */
+        void AppendJsonString (const QByteArray& inText, QByteArray& ioBuffer) {
+            ioBuffer.append ('"');
+            for (int c=0; c<inText.size (); ++c) {
+                char character = inText [c];
+                if (character == '"' || character == '\\') {
+                    ioBuffer.append ('\\');
+                }
+                if (static_cast <unsigned char> (character) < 0x20) {
+                    ioBuffer.append (' ');
+                    continue;
+                }
+                ioBuffer.append (character);
+            }
+            ioBuffer.append ('"');
+        }
+    } // unnamed namespace
+
+
+    QAtomicPointer <TraceRecorder> TraceRecorder::sRecorder;
+
+    /*!
+        \brief Creates the buffer of a thread.
+    */
+    TraceRecorder::ThreadBuffer::ThreadBuffer (int inThreadId, const QString& inThreadName) :
+        mThreadId (inThreadId),
+        mThreadName (inThreadName),
+        mOrphaned (0),
+        mNameWritten (false)
+    {}
+
+    /*!
+        \brief Creates the state of a thread.
+    */
+    TraceRecorder::ThreadState::ThreadState (const ThreadBufferPtr& inBuffer) :
+        mBuffer (inBuffer),
+        mGeneration (-1),
+        mDepth (0)
+    {}
+
+    /*!
+        \brief Called when the thread finishes, the recorder removes the buffer once it has been drained.
+    */
+    TraceRecorder::ThreadState::~ThreadState () {
+        mBuffer->mOrphaned.fetchAndStoreOrdered (1);
+    }
+
+
+    // ------------------------------------------------------------------------------------------------
+
+
+    /*!
+        \brief Creates a recorder that does not record.
+    */
+    TraceRecorder::TraceRecorder (QObject* inParent) :
+        QObject (inParent),
+        mGeneration (0),
+        mNextThreadId (0),
+        mStartTimestamp (0),
+        mFirstEvent (true),
+        mEventCount (0),
+        mDrainTimer (this)
+    {
+        mBuffer.reserve (kBufferSize);
+        connect (&mDrainTimer, SIGNAL (timeout ()), this, SLOT (SlotDrain ()));
+    }
+
+    /*!
+        \brief Stops recording.
+    */
+    TraceRecorder::~TraceRecorder () {
+        Stop ();
+    }
+
+    /*!
+        \brief Starts recording to the given file, which is overwritten. Returns false when the file could not be created.
+
+        The callbacks must be registered with Qt separately, see priv::SetSignalSpyCallbacks.
+        Emissions and invocations that are in progress when recording starts are not recorded.
+    */
+    bool TraceRecorder::Start (const QString& inFileName) {
+        Stop ();
+        mFile.setFileName (inFileName);
+        if (!mFile.open (QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+        mProcessFields = "\"pid\":" + QByteArray::number (QCoreApplication::applicationPid ());
+        mStartTimestamp = Clock::Now ();
+        mFirstEvent = true;
+        mEventCount = 0;
+        mBuffer = "[";
+        WriteMetadata ("process_name", -1, QCoreApplication::applicationName ().isEmpty () ? QString ("Qt application") : QCoreApplication::applicationName ());
+        {
+            // discard the events that were pushed after the previous recording stopped
+            QMutexLocker locker (&mMutex);
+            foreach (const ThreadBufferPtr& buffer, mBuffers) {
+                QMutexLocker bufferLocker (&buffer->mMutex);
+                buffer->mEvents.clear ();
+                buffer->mNameWritten = false;
+            }
+        }
+        mGeneration.ref ();
+        sRecorder.fetchAndStoreOrdered (this);
+        mDrainTimer.start (kDrainInterval);
+        return true;
+    }
+
+    /*!
+        \brief Writes all recorded events, completes the file and closes it.
+    */
+    void TraceRecorder::Stop () {
+        if (!mFile.isOpen ()) {
+            return;
+        }
+        sRecorder.testAndSetOrdered (this, 0);
+        mDrainTimer.stop ();
+        Drain ();
+        mBuffer.append ("\n]\n");
+        WriteBuffer ();
+        mFile.close ();
+        emit SignalEventsWritten ();
+    }
+
+    /*!
+        \brief Returns true while events are recorded.
+    */
+    bool TraceRecorder::IsRecording () const {
+        return mFile.isOpen ();
+    }
+
+    /*!
+        \brief Returns the name of the current or the most recent trace file.
+    */
+    QString TraceRecorder::FileName () const {
+        return mFile.fileName ();
+    }
+
+    /*!
+        \brief Returns a description of the last file error.
+    */
+    QString TraceRecorder::ErrorString () const {
+        return mFile.errorString ();
+    }
+
+    /*!
+        \brief Returns the number of events written to the current or the most recent trace file.
+    */
+    quint64 TraceRecorder::EventCount () const {
+        return mEventCount;
+    }
+
+    /*!
+        \brief The signal begin callback of Qt.
+    */
+    void TraceRecorder::SignalBegin (QObject* inSender, int inMethodIndex, void** /*inArgs*/) {
+        if (TraceRecorder* recorder = sRecorder) {
+            recorder->Push (inSender, inMethodIndex, false, true);
+        }
+    }
+
+    /*!
+        \brief The signal end callback of Qt.
+    */
+    void TraceRecorder::SignalEnd (QObject* inSender, int inMethodIndex) {
+        if (TraceRecorder* recorder = sRecorder) {
+            recorder->Push (inSender, inMethodIndex, false, false);
+        }
+    }
+
+    /*!
+        \brief The slot begin callback of Qt.
+    */
+    void TraceRecorder::SlotBegin (QObject* inReceiver, int inMethodIndex, void** /*inArgs*/) {
+        if (TraceRecorder* recorder = sRecorder) {
+            recorder->Push (inReceiver, inMethodIndex, true, true);
+        }
+    }
+
+    /*!
+        \brief The slot end callback of Qt, the receiver may have been destroyed by the slot.
+    */
+    void TraceRecorder::SlotEnd (QObject* inReceiver, int inMethodIndex) {
+        if (TraceRecorder* recorder = sRecorder) {
+            recorder->Push (inReceiver, inMethodIndex, true, false);
+        }
+    }
+
+    /*!
+        \brief Writes the recorded events.
+    */
+    void TraceRecorder::SlotDrain () {
+        quint64 eventCount = mEventCount;
+        Drain ();
+        if (mEventCount != eventCount) {
+            emit SignalEventsWritten ();
+        }
+    }
+
+    /*!
+        \brief Returns the state of the current thread, it is created on first use.
+
+        The depth is reset when recording started again, as the end events of the emissions
+        and invocations that were in progress must not be written.
+    */
+    TraceRecorder::ThreadState& TraceRecorder::LocalState () {
+        if (!mThreadState.hasLocalData ()) {
+            QThread* thread = QThread::currentThread ();
+            int threadId = mNextThreadId.fetchAndAddRelaxed (1) + 1;
+            QString threadName = thread->objectName ();
+            if (QCoreApplication::instance () && QCoreApplication::instance ()->thread () == thread) {
+                threadName = "main";
+            }
+            else if (threadName.isEmpty ()) {
+                threadName = QString ("thread %1").arg (threadId);
+            }
+            ThreadBufferPtr buffer (new ThreadBuffer (threadId, threadName));
+            {
+                QMutexLocker locker (&mMutex);
+                mBuffers.push_back (buffer);
+            }
+            mThreadState.setLocalData (new ThreadState (buffer));
+        }
+        ThreadState& state = *mThreadState.localData ();
+        int generation = mGeneration;
+        if (state.mGeneration != generation) {
+            state.mGeneration = generation;
+            state.mDepth = 0;
+        }
+        return state;
+    }
+
+    /*!
+        \brief Appends a begin or end event to the buffer of the current thread.
+    */
+    void TraceRecorder::Push (QObject* inObject, int inMethodIndex, bool inIsSlot, bool inBegin) {
+        TraceEvent event;
+        event.mTimestamp = Clock::Now ();
+        ThreadState& state = LocalState ();
+        if (inBegin) {
+            ++state.mDepth;
+        }
+        else if (state.mDepth > 0) {
+            --state.mDepth;
+        }
+        else {
+            // the begin event was not recorded
+            return;
+        }
+        // the receiver of an end event may have been destroyed
+        event.mClass = inBegin ? inObject->metaObject () : 0;
+        event.mObject = inObject;
+        event.mMethodIndex = inMethodIndex;
+        event.mIsSlot = inIsSlot;
+        QMutexLocker locker (&state.mBuffer->mMutex);
+        state.mBuffer->mEvents.push_back (event);
+    }
+
+    /*!
+        \brief Writes the events of all threads, and removes the buffers of finished threads once they have been written.
+
+        Events of different threads are not merged, the trace viewers sort them by timestamp.
+    */
+    void TraceRecorder::Drain () {
+        QList <ThreadBufferPtr> buffers;
+        {
+            QMutexLocker locker (&mMutex);
+            buffers = mBuffers;
+        }
+        foreach (const ThreadBufferPtr& buffer, buffers) {
+            // the orphaned state must be read first, so no events can follow
+            bool orphaned = buffer->mOrphaned != 0;
+            QVector <TraceEvent> events;
+            {
+                QMutexLocker locker (&buffer->mMutex);
+                events.swap (buffer->mEvents);
+            }
+            if (!events.isEmpty () && !buffer->mNameWritten) {
+                WriteMetadata ("thread_name", buffer->mThreadId, buffer->mThreadName);
+                buffer->mNameWritten = true;
+            }
+            foreach (const TraceEvent& event, events) {
+                WriteEvent (*buffer, event);
+            }
+            if (orphaned) {
+                QMutexLocker locker (&mMutex);
+                mBuffers.removeAll (buffer);
+            }
+        }
+        WriteBuffer ();
+    }
+
+    /*!
+        \brief Appends a single begin or end event, f.e:
+        {"name":"QAbstractButton::clicked(bool)","cat":"signal","ph":"B","ts":1250.125,"pid":42,"tid":1,"args":{"object":"0x0012ff40"}}
+    */
+    void TraceRecorder::WriteEvent (const ThreadBuffer& inBuffer, const TraceEvent& inEvent) {
+        WriteSeparator ();
+        mBuffer.append ('{');
+        if (inEvent.mClass) {
+            mBuffer.append (EventFields (inEvent));
+            mBuffer.append (",\"ph\":\"B\"");
+        }
+        else {
+            mBuffer.append ("\"ph\":\"E\"");
+        }
+        // microseconds with nanosecond resolution
+        qint64 timestamp = qMax <qint64> (inEvent.mTimestamp - mStartTimestamp, 0);
+        QByteArray fraction = QByteArray::number (timestamp % 1000);
+        mBuffer.append (",\"ts\":");
+        mBuffer.append (QByteArray::number (timestamp / 1000));
+        mBuffer.append ('.');
+        mBuffer.append (QByteArray (3 - fraction.size (), '0'));
+        mBuffer.append (fraction);
+        mBuffer.append (',');
+        mBuffer.append (mProcessFields);
+        mBuffer.append (",\"tid\":");
+        mBuffer.append (QByteArray::number (inBuffer.mThreadId));
+        if (inEvent.mClass) {
+            mBuffer.append (",\"args\":{\"object\":\"");
+            mBuffer.append (ObjectUtility::Address (static_cast <const QObject*> (inEvent.mObject)).toLatin1 ());
+            mBuffer.append ("\"}");
+        }
+        mBuffer.append ('}');
+        ++mEventCount;
+        if (mBuffer.size () >= kBufferSize) {
+            WriteBuffer ();
+        }
+    }
+
+    /*!
+        \brief Appends a metadata event that names the process, or the thread with the given id when it is not -1.
+    */
+    void TraceRecorder::WriteMetadata (const char* inName, int inThreadId, const QString& inValue) {
+        WriteSeparator ();
+        mBuffer.append ("{\"name\":\"");
+        mBuffer.append (inName);
+        mBuffer.append ("\",\"ph\":\"M\",");
+        mBuffer.append (mProcessFields);
+        if (inThreadId >= 0) {
+            mBuffer.append (",\"tid\":");
+            mBuffer.append (QByteArray::number (inThreadId));
+        }
+        mBuffer.append (",\"args\":{\"name\":");
+        AppendJsonString (inValue.toUtf8 (), mBuffer);
+        mBuffer.append ("}}");
+    }
+
+    /*!
+        \brief Separates the next event from the previous event, one event per line.
+    */
+    void TraceRecorder::WriteSeparator () {
+        mBuffer.append (mFirstEvent ? "\n" : ",\n");
+        mFirstEvent = false;
+    }
+
+    /*!
+        \brief Writes the buffered events to the file.
+    */
+    void TraceRecorder::WriteBuffer () {
+        if (mBuffer.isEmpty ()) {
+            return;
+        }
+        if (mFile.isOpen ()) {
+            mFile.write (mBuffer);
+            mFile.flush ();
+        }
+        // a qt 4 QByteArray releases its memory when it is resized to 0, so the next block is reserved up front
+        mBuffer.resize (0);
+        mBuffer.reserve (kBufferSize);
+    }
+
+    /*!
+        \brief Returns the formatted name and category fields of the given begin event, they are formatted on first use.
+    */
+    const QByteArray& TraceRecorder::EventFields (const TraceEvent& inEvent) {
+        // a signal that is connected to another signal is invoked as a slot as well
+        int key = inEvent.mIsSlot ? -1 - inEvent.mMethodIndex : inEvent.mMethodIndex;
+        QByteArray& fields = mEventFields [MethodKey (inEvent.mClass, key)];
+        if (fields.isEmpty ()) {
+            QByteArray name = QByteArray (inEvent.mClass->className ()) + "::" + inEvent.mClass->method (inEvent.mMethodIndex).signature ();
+            fields = "\"name\":";
+            AppendJsonString (name, fields);
+            fields.append (inEvent.mIsSlot ? ",\"cat\":\"slot\"" : ",\"cat\":\"signal\"");
+        }
+        return fields;
+    }
+
+} // namespace conan
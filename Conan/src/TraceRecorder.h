@@ -0,0 +1,170 @@
+/*!
+    Conan - Connection Analyzer for Qt
+    Copyright (C) 2008 - 2011 Elmar de Koning, edekoning@gmail.com
+
+    This file is part of Conan.
+
+    Conan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Conan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Conan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*!
+    \file
+    \brief Contains TraceRecorder related declarations
+*/
+
+
+#ifndef _TRACERECORDER__17_10_26__21_02_48__H_
+#define _TRACERECORDER__17_10_26__21_02_48__H_
+
+
+#include "ConanDefines.h"
+#include <QtCore/QAtomicInt>
+#include <QtCore/QAtomicPointer>
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QPair>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
+
+
+namespace conan {
+
+    /*!
+        \brief Records all signal emissions and slot invocations of the application to a Chrome trace file.
+
+        The file uses the JSON array format of the Trace Event Format, which can be opened by
+        chrome://tracing and by Perfetto. Each emission and each slot invoked by a direct
+        connection is written as a begin event and an end event on the thread that emitted
+        it, so slots are nested within the emission that invoked them, and emissions caused
+        by a slot are nested within that slot. Events are named after the class and the
+        signature of the signal or slot, the address of the object is written as an argument.
+
+        The callbacks of Qt append events to a buffer per thread, see priv::SetSignalSpyCallbacks.
+        The recorder drains the buffers every kDrainInterval ms and writes the events to the file
+        in blocks, so the trace is never kept in memory. Each event is only formatted when it is
+        written. The closing bracket is written when recording stops, the trace viewers also
+        accept a file without it, f.e. after a crash.
+
+        Only one recorder can record at a time.
+    */
+    class CONAN_LOCAL TraceRecorder : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        static const int kDrainInterval = 100;      //!< The interval in ms at which the buffers are written
+        static const int kBufferSize = 64 * 1024;   //!< The number of bytes buffered before writing
+
+        TraceRecorder (QObject* inParent = 0);
+        virtual ~TraceRecorder ();
+
+        bool Start (const QString& inFileName);
+        void Stop ();
+        bool IsRecording () const;
+        QString FileName () const;
+        QString ErrorString () const;
+        quint64 EventCount () const;
+
+        static void SignalBegin (QObject* inSender, int inMethodIndex, void** inArgs);
+        static void SignalEnd (QObject* inSender, int inMethodIndex);
+        static void SlotBegin (QObject* inReceiver, int inMethodIndex, void** inArgs);
+        static void SlotEnd (QObject* inReceiver, int inMethodIndex);
+
+    signals:
+        //! \brief Emitted after events have been written.
+        void SignalEventsWritten ();
+
+    private slots:
+        void SlotDrain ();
+
+    private:
+        typedef QPair <const QMetaObject*, int> MethodKey;
+
+        /*!
+            \brief A single begin or end event, formatted when it is written.
+        */
+        struct CONAN_LOCAL TraceEvent {
+            qint64 mTimestamp;              //!< The time of the event, see Clock::Now
+            const QMetaObject* mClass;      //!< The class of the object, 0 for an end event
+            const void* mObject;            //!< The sender or receiver, never dereferenced
+            int mMethodIndex;               //!< The signal or slot
+            bool mIsSlot;                   //!< True for a slot invocation, false for an emission
+        };
+
+        /*!
+            \brief The events of a single thread that have not been written yet.
+        */
+        struct CONAN_LOCAL ThreadBuffer {
+            ThreadBuffer (int inThreadId, const QString& inThreadName);
+
+            QMutex mMutex;                  //!< Protects mEvents
+            QVector <TraceEvent> mEvents;   //!< The events in timestamp order
+            const int mThreadId;            //!< The tid of all events of the thread
+            const QString mThreadName;      //!< The name of the thread in the trace
+            QAtomicInt mOrphaned;           //!< Set when the thread finished
+            bool mNameWritten;              //!< Indicates if the thread name has been written to the current file
+        };
+
+        typedef QSharedPointer <ThreadBuffer> ThreadBufferPtr;
+
+        /*!
+            \brief The private state of a single thread, orphans the buffer when the thread finishes.
+        */
+        struct CONAN_LOCAL ThreadState {
+            ThreadState (const ThreadBufferPtr& inBuffer);
+            ~ThreadState ();
+
+            ThreadBufferPtr mBuffer;        //!< The buffer, shared with the recorder which drains it
+            int mGeneration;                //!< The recording generation of mDepth
+            int mDepth;                     //!< The number of begin events without an end event
+        };
+
+        ThreadState& LocalState ();
+        void Push (QObject* inObject, int inMethodIndex, bool inIsSlot, bool inBegin);
+        void Drain ();
+        void WriteEvent (const ThreadBuffer& inBuffer, const TraceEvent& inEvent);
+        void WriteMetadata (const char* inName, int inThreadId, const QString& inValue);
+        void WriteSeparator ();
+        void WriteBuffer ();
+        const QByteArray& EventFields (const TraceEvent& inEvent);
+
+    private:
+        static QAtomicPointer <TraceRecorder> sRecorder;    //!< The recorder that receives the callbacks, or 0
+
+        QAtomicInt mGeneration;                     //!< Incremented whenever recording starts, invalidates the depths
+        QAtomicInt mNextThreadId;                   //!< The tid of the next thread that records an event
+        QMutex mMutex;                              //!< Protects mBuffers
+        QList <ThreadBufferPtr> mBuffers;           //!< The buffers of all threads
+        QThreadStorage <ThreadState*> mThreadState; //!< The state of the current thread
+        QFile mFile;                                //!< The trace file
+        QByteArray mBuffer;                         //!< The formatted events that have not been written yet
+        QByteArray mProcessFields;                  //!< The formatted pid field
+        QHash <MethodKey, QByteArray> mEventFields; //!< map <(class, method index or -1 - slot index), formatted name and category fields>
+        qint64 mStartTimestamp;                     //!< The time at which recording started, the origin of the trace
+        bool mFirstEvent;                           //!< True when no event has been written to the file yet
+        quint64 mEventCount;                        //!< The number of events written to the file
+        QTimer mDrainTimer;                         //!< Periodically drains mBuffers
+    };
+
+} // namespace conan
+
+
+#endif //_TRACERECORDER__17_10_26__21_02_48__H_